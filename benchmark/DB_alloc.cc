@@ -0,0 +1,56 @@
+#include "DB_alloc.hh"
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+
+namespace bench {
+
+__thread slab_pool::thread_pool *slab_pool::pool_;
+slab_pool::thread_pool *slab_pool::all_pools_;
+
+slab_pool::thread_pool *slab_pool::make_pool() {
+    auto p = new thread_pool;
+    memset(p, 0, sizeof(*p));
+    thread_pool *head;
+    do {
+        head = all_pools_;
+        p->next_pool = head;
+    } while (!bool_cmpxchg(&all_pools_, head, p));
+    return p;
+}
+
+void slab_pool::new_slab(thread_pool& p, int c) {
+    void *slab = nullptr;
+    always_assert(posix_memalign(&slab, class_size, slab_size) == 0,
+                  "cannot allocate slab");
+    p.slab_next[c] = static_cast<char *>(slab);
+    p.slab_end[c] = p.slab_next[c] + slab_size;
+    p.stats.slab_bytes += slab_size;
+}
+
+slab_pool::stats_type slab_pool::stats() {
+    stats_type s;
+    memset(&s, 0, sizeof(s));
+    acquire_fence();
+    for (thread_pool *p = all_pools_; p; p = p->next_pool) {
+        s.allocs += p->stats.allocs;
+        s.reuses += p->stats.reuses;
+        s.frees += p->stats.frees;
+        s.live_bytes += p->stats.live_bytes;
+        s.slab_bytes += p->stats.slab_bytes;
+    }
+    return s;
+}
+
+void slab_pool::print_stats(std::ostream& os) {
+    stats_type s = stats();
+    os << "Slab pools: " << s.live() << " live objects, "
+       << s.live_bytes << " live bytes, "
+       << s.slab_bytes << " slab bytes, "
+       << std::fixed << std::setprecision(1) << 100 * s.reuse_rate() << "% of "
+       << s.allocs << " allocations reused" << std::endl;
+    os.unsetf(std::ios::floatfield);
+}
+
+}; // namespace bench
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <new>
+#include <utility>
+
+#include "compiler.hh"
+#include "Transaction.hh"
+
+namespace bench {
+
+// Per-thread slab pools for table elements (index internal_elems and MVCC
+// history nodes).
+//
+// Objects are rounded up to a multiple of the cache line size, which
+// selects their size class, and carved from slab_size slabs owned by the
+// allocating thread. A freed object goes onto the free list of the freeing
+// thread. Objects unlinked from a live table are freed with rcu_destroy, so
+// the free happens in the RCU callback, run by the retiring thread once no
+// transaction can still see the object. Slabs are never returned to the
+// system. Objects larger than max_size use the global allocator.
+class slab_pool {
+public:
+    static constexpr size_t class_size = CACHE_LINE_SIZE;
+    static constexpr int nclasses = 32;
+    static constexpr size_t max_size = class_size * nclasses;
+    static constexpr size_t slab_size = size_t(64) << 10;
+
+    struct stats_type {
+        uint64_t allocs;
+        uint64_t reuses;      // allocations served from a free list
+        uint64_t frees;
+        uint64_t live_bytes;
+        uint64_t slab_bytes;
+
+        uint64_t live() const {
+            return allocs - frees;
+        }
+        double reuse_rate() const {
+            return allocs ? double(reuses) / allocs : 0;
+        }
+    };
+
+    static void *allocate(size_t size) {
+        if (size > max_size)
+            return ::operator new(size);
+        thread_pool& p = pool();
+        int c = size_class(size);
+        ++p.stats.allocs;
+        p.stats.live_bytes += class_bytes(c);
+        if (free_object *o = p.free[c]) {
+            p.free[c] = o->next;
+            ++p.stats.reuses;
+            return o;
+        }
+        if (size_t(p.slab_end[c] - p.slab_next[c]) < class_bytes(c))
+            new_slab(p, c);
+        void *o = p.slab_next[c];
+        p.slab_next[c] += class_bytes(c);
+        return o;
+    }
+
+    static void deallocate(void *ptr, size_t size) {
+        if (size > max_size) {
+            ::operator delete(ptr);
+            return;
+        }
+        thread_pool& p = pool();
+        int c = size_class(size);
+        auto o = static_cast<free_object *>(ptr);
+        o->next = p.free[c];
+        p.free[c] = o;
+        ++p.stats.frees;
+        p.stats.live_bytes -= class_bytes(c);
+    }
+
+    template <typename T, typename... Args>
+    static T *make(Args&&... args) {
+        static_assert(alignof(T) <= class_size, "over-aligned type");
+        return new (allocate(sizeof(T))) T(std::forward<Args>(args)...);
+    }
+
+    template <typename T>
+    static void destroy(T *x) {
+        if (x) {
+            x->~T();
+            deallocate(x, sizeof(T));
+        }
+    }
+
+    // destroys x once concurrent transactions can no longer reach it
+    template <typename T>
+    static void rcu_destroy(T *x) {
+        Transaction::rcu_call(destroy_callback<T>, x);
+    }
+
+    // sums over all threads; counters of running threads may be stale
+    static stats_type stats();
+    static void print_stats(std::ostream& os);
+
+private:
+    struct free_object {
+        free_object *next;
+    };
+
+    struct thread_pool {
+        free_object *free[nclasses];
+        char *slab_next[nclasses];
+        char *slab_end[nclasses];
+        stats_type stats;
+        thread_pool *next_pool;
+    };
+
+    static __thread thread_pool *pool_;
+    static thread_pool *all_pools_;
+
+    static int size_class(size_t size) {
+        return int((size + class_size - 1) / class_size) - 1;
+    }
+    static size_t class_bytes(int c) {
+        return size_t(c + 1) * class_size;
+    }
+
+    static thread_pool& pool() {
+        if (unlikely(!pool_))
+            pool_ = make_pool();
+        return *pool_;
+    }
+    static thread_pool *make_pool();
+    static void new_slab(thread_pool& p, int c);
+
+    template <typename T>
+    static void destroy_callback(void *x) {
+        destroy(static_cast<T *>(x));
+    }
+};
+
+}; // namespace bench
@@ -0,0 +1,325 @@
+#include "DB_checkpoint.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace bench {
+
+namespace {
+
+typedef db_checkpointer::epoch_type epoch_type;
+
+const char ckpt_prefix[] = "/sto_ckpt.";
+const char ckpt_meta[] = "/sto_ckpt.meta";
+const char log_prefix[] = "/sto_log.";
+
+void write_all(int fd, const char *data, size_t len) {
+    while (len) {
+        ssize_t r = ::write(fd, data, len);
+        always_assert(r > 0, "checkpoint write failed");
+        data += r;
+        len -= r;
+    }
+}
+
+bool read_file(const std::string& fname, std::vector<char>& out) {
+    int fd = ::open(fname.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    off_t len = ::lseek(fd, 0, SEEK_END);
+    ::lseek(fd, 0, SEEK_SET);
+    out.resize(len);
+    size_t off = 0;
+    while (off < out.size()) {
+        ssize_t r = ::read(fd, out.data() + off, out.size() - off);
+        always_assert(r > 0, "checkpoint read failed");
+        off += r;
+    }
+    ::close(fd);
+    return true;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point t) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+}
+
+// replay partition of an entry; all entries for a key go to the same thread
+unsigned entry_partition(const TLogEntryHeader& h, const char *key, unsigned nparts) {
+    uint64_t x = 14695981039346656037ULL ^ h.log_id;
+    for (uint32_t i = 0; i < h.key_length; ++i)
+        x = (x ^ (unsigned char) key[i]) * 1099511628211ULL;
+    return unsigned(x % nparts);
+}
+
+struct log_record {
+    uint64_t tid;
+    const char *entries;
+    uint32_t nentries;
+};
+
+} // anonymous namespace
+
+checkpoint_writer::checkpoint_writer(const std::string& fname)
+    : fd_(::open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)), buf_(), rows_(0), bytes_(0) {
+    always_assert(fd_ >= 0, "cannot open checkpoint file");
+}
+
+checkpoint_writer::~checkpoint_writer() {
+    if (fd_ >= 0)
+        close();
+}
+
+void checkpoint_writer::put_row(uint32_t log_id, const void *key, uint32_t klen,
+                                const void *value, uint32_t vlen) {
+    char *p = buf_.extend(sizeof(TLogEntryHeader) + klen + vlen);
+    auto eh = reinterpret_cast<TLogEntryHeader *>(p);
+    eh->log_id = log_id;
+    eh->type = TLogEntryHeader::put_row;
+    eh->cell = 0;
+    eh->key_length = klen;
+    eh->value_length = vlen;
+    memcpy(p + sizeof(TLogEntryHeader), key, klen);
+    memcpy(p + sizeof(TLogEntryHeader) + klen, value, vlen);
+    ++rows_;
+    if (buf_.size() >= flush_threshold)
+        flush();
+}
+
+void checkpoint_writer::flush() {
+    write_all(fd_, buf_.data(), buf_.size());
+    bytes_ += buf_.size();
+    buf_.clear();
+}
+
+void checkpoint_writer::close() {
+    flush();
+    fdatasync(fd_);
+    ::close(fd_);
+    fd_ = -1;
+}
+
+void db_checkpointer::add_table(uint32_t log_id, parts_function parts,
+                                scan_function scan, replay_function replay) {
+    if (parts)
+        tables_.push_back(table_info{log_id, parts, scan});
+    if (replay_.size() <= log_id)
+        replay_.resize(log_id + 1);
+    replay_[log_id] = replay;
+}
+
+void db_checkpointer::replay_entry(const TLogEntryHeader& h, const char *key, const char *value) const {
+    always_assert(h.log_id < replay_.size() && replay_[h.log_id], "replay: unknown log id");
+    replay_[h.log_id](h, key, value);
+}
+
+epoch_type db_checkpointer::checkpoint(const std::string& dir, int nthreads, int first_thread_id) {
+    always_assert(nthreads > 0 && first_thread_id + nthreads <= TThread::max_threads(),
+                  "checkpoint thread ids out of range");
+    auto t0 = std::chrono::steady_clock::now();
+
+    // wait for transactions that started before the checkpoint epoch
+    epoch_type start_epoch = Transaction::global_epochs.global_epoch;
+    for (int i = 0; i != TThread::max_threads(); ++i) {
+        while (true) {
+            epoch_type e = Transaction::tinfo[i].epoch;
+            if (e == 0 || Transaction::signed_epoch_type(e - start_epoch) >= 0)
+                break;
+            usleep(1000);
+        }
+    }
+
+    struct work_unit {
+        size_t table;
+        int part;
+        int nparts;
+    };
+    std::vector<work_unit> work;
+    for (size_t i = 0; i < tables_.size(); ++i) {
+        int n = tables_[i].parts(nthreads);
+        for (int p = 0; p < n; ++p)
+            work.push_back(work_unit{i, p, n});
+    }
+
+    unsigned next = 0;
+    std::vector<uint64_t> rows(nthreads, 0), bytes(nthreads, 0);
+    std::vector<std::thread> thrs;
+    for (int i = 0; i < nthreads; ++i) {
+        thrs.emplace_back([&, i] () {
+            TThread::set_id(first_thread_id + i);
+            if (thread_init_)
+                thread_init_();
+            // keeps the rows we scan from being reclaimed
+            Transaction::tinfo[TThread::id()].epoch = Transaction::global_epochs.global_epoch;
+
+            checkpoint_writer w(dir + ckpt_prefix + std::to_string(i));
+            unsigned k;
+            while ((k = fetch_and_add(&next, 1)) < work.size()) {
+                auto& u = work[k];
+                tables_[u.table].scan(u.part, u.nparts, w);
+            }
+            w.close();
+            Transaction::rcu_quiesce();
+            rows[i] = w.rows();
+            bytes[i] = w.bytes();
+        });
+    }
+    for (auto& t : thrs)
+        t.join();
+
+    epoch_type end_epoch = Transaction::global_epochs.global_epoch;
+    if (Logger::enabled())
+        Logger::wait_durable(end_epoch);
+
+    std::string meta = dir + ckpt_meta;
+    std::string tmp = meta + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "w");
+    always_assert(f, "cannot open checkpoint metadata");
+    fprintf(f, "%llu %llu %d\n", (unsigned long long) start_epoch,
+            (unsigned long long) end_epoch, nthreads);
+    fflush(f);
+    fsync(fileno(f));
+    fclose(f);
+    always_assert(rename(tmp.c_str(), meta.c_str()) == 0, "cannot install checkpoint metadata");
+
+    ckpt_rows_ = ckpt_bytes_ = 0;
+    for (int i = 0; i < nthreads; ++i) {
+        ckpt_rows_ += rows[i];
+        ckpt_bytes_ += bytes[i];
+    }
+    ckpt_time_ = seconds_since(t0);
+    return start_epoch;
+}
+
+bool db_checkpointer::recover(const std::string& dir, int nthreads, int first_thread_id) {
+    always_assert(nthreads > 0 && first_thread_id + nthreads <= TThread::max_threads(),
+                  "recovery thread ids out of range");
+
+    unsigned long long start_epoch, end_epoch;
+    int nfiles;
+    FILE *f = fopen((dir + ckpt_meta).c_str(), "r");
+    if (!f)
+        return false;
+    int n = fscanf(f, "%llu %llu %d", &start_epoch, &end_epoch, &nfiles);
+    fclose(f);
+    if (n != 3)
+        return false;
+
+    auto t0 = std::chrono::steady_clock::now();
+    unsigned next = 0;
+    std::vector<uint64_t> rows(nthreads, 0);
+    std::vector<std::thread> thrs;
+    for (int i = 0; i < nthreads; ++i) {
+        thrs.emplace_back([&, i] () {
+            TThread::set_id(first_thread_id + i);
+            if (thread_init_)
+                thread_init_();
+            std::vector<char> data;
+            int k;
+            while ((k = int(fetch_and_add(&next, 1))) < nfiles) {
+                bool ok = read_file(dir + ckpt_prefix + std::to_string(k), data);
+                always_assert(ok, "missing checkpoint file");
+                size_t off = 0;
+                while (off + sizeof(TLogEntryHeader) <= data.size()) {
+                    auto eh = reinterpret_cast<const TLogEntryHeader *>(data.data() + off);
+                    const char *key = data.data() + off + sizeof(TLogEntryHeader);
+                    replay_entry(*eh, key, key + eh->key_length);
+                    off += sizeof(TLogEntryHeader) + eh->key_length + eh->value_length;
+                    ++rows[i];
+                }
+            }
+        });
+    }
+    for (auto& t : thrs)
+        t.join();
+    load_rows_ = 0;
+    for (auto r : rows)
+        load_rows_ += r;
+    load_time_ = seconds_since(t0);
+
+    replay_logs(dir, start_epoch, nthreads, first_thread_id);
+    return true;
+}
+
+void db_checkpointer::replay_logs(const std::string& dir, epoch_type start_epoch,
+                                  int nthreads, int first_thread_id) {
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<std::vector<char>> files;
+    std::vector<char> data;
+    for (int i = 0; read_file(dir + log_prefix + std::to_string(i), data); ++i) {
+        files.emplace_back();
+        files.back().swap(data);
+    }
+
+    // every log file holds all records of epochs up to its last marker
+    epoch_type durable = ~epoch_type(0);
+    std::vector<std::pair<epoch_type, log_record>> records;
+    for (auto& fdata : files) {
+        epoch_type marker = 0;
+        size_t off = 0;
+        while (off + sizeof(TLogRecordHeader) <= fdata.size()) {
+            auto h = reinterpret_cast<const TLogRecordHeader *>(fdata.data() + off);
+            if (off + sizeof(TLogRecordHeader) + h->length > fdata.size())
+                break;
+            if (h->tid == 0 && h->nentries == 0)
+                marker = h->epoch;
+            else
+                records.push_back({h->epoch, log_record{h->tid, fdata.data() + off + sizeof(TLogRecordHeader),
+                                                        h->nentries}});
+            off += sizeof(TLogRecordHeader) + h->length;
+        }
+        durable = std::min(durable, marker);
+    }
+    if (files.empty())
+        durable = 0;
+
+    std::vector<log_record> replay;
+    for (auto& r : records)
+        if (r.first >= start_epoch && r.first <= durable)
+            replay.push_back(r.second);
+    std::sort(replay.begin(), replay.end(), [] (const log_record& a, const log_record& b) {
+        return a.tid < b.tid;
+    });
+
+    std::vector<std::thread> thrs;
+    for (int i = 0; i < nthreads; ++i) {
+        thrs.emplace_back([&, i] () {
+            TThread::set_id(first_thread_id + i);
+            if (thread_init_)
+                thread_init_();
+            for (auto& r : replay) {
+                const char *p = r.entries;
+                for (uint32_t j = 0; j < r.nentries; ++j) {
+                    auto eh = reinterpret_cast<const TLogEntryHeader *>(p);
+                    const char *key = p + sizeof(TLogEntryHeader);
+                    if (entry_partition(*eh, key, nthreads) == unsigned(i))
+                        replay_entry(*eh, key, key + eh->key_length);
+                    p += sizeof(TLogEntryHeader) + eh->key_length + eh->value_length;
+                }
+            }
+        });
+    }
+    for (auto& t : thrs)
+        t.join();
+
+    replay_records_ = replay.size();
+    replay_time_ = seconds_since(t0);
+}
+
+void db_checkpointer::print_checkpoint_stats() const {
+    std::cout << "Checkpoint: " << ckpt_rows_ << " rows, " << ckpt_bytes_ << " bytes in "
+              << ckpt_time_ << " s (" << (ckpt_bytes_ / ckpt_time_ / (1 << 20)) << " MB/s)" << std::endl;
+}
+
+void db_checkpointer::print_recovery_stats() const {
+    std::cout << "Recovery: loaded " << load_rows_ << " rows in " << load_time_ << " s ("
+              << (load_rows_ / load_time_) << " rows/s), replayed " << replay_records_
+              << " log records in " << replay_time_ << " s" << std::endl;
+}
+
+}; // namespace bench
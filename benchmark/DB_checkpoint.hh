@@ -0,0 +1,218 @@
+#pragma once
+
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "compiler.hh"
+#include "Logger.hh"
+#include "Transaction.hh"
+
+// Parallel fuzzy checkpoints and recovery for the benchmark indexes.
+//
+// A checkpoint is taken while transactions keep running. The checkpointer
+// records the global epoch E at which it starts and waits until no thread is
+// still running a transaction that began before E; after that every commit
+// not reflected in the scan has a log record with epoch >= E. The tables are
+// then scanned by N threads, each writing its own partition file
+// (dir/sto_ckpt.<n>), using the log entry format of Logger.hh (put_row
+// entries only, no record headers). When the scan finishes at epoch F, the
+// checkpointer waits for F to become durable (if logging is on) and writes
+// dir/sto_ckpt.meta, which makes the checkpoint valid.
+//
+// Recovery bulk-loads the partition files in parallel through the
+// non-transactional index interface, then replays the durable log records of
+// epochs >= E in commit TID order. Replay is parallel too: entries are
+// partitioned by (log id, key) so that updates to a key stay ordered.
+//
+// A checkpoint taken without logging is only consistent if no transaction is
+// running; threads that stop running transactions must call
+// Transaction::rcu_quiesce() so the checkpointer does not wait for them.
+
+namespace bench {
+
+// Serialization of row values in checkpoints and log records. The default
+// copies the bytes of the value; values that contain pointers or virtual
+// tables specialize this.
+template <typename V>
+struct row_codec {
+    static constexpr uint32_t size = sizeof(V);
+
+    static void encode(const V& value, char *buf) {
+        memcpy(buf, static_cast<const void *>(&value), sizeof(V));
+    }
+    static void decode(const char *buf, V& value) {
+        memcpy(static_cast<void *>(&value), buf, sizeof(V));
+    }
+    // applies a logged single-cell write to a row (used by tables whose
+    // rows log their own cells, see ycsb_value)
+    static void decode_cell(const char *buf, uint32_t len, int cell, V& value) {
+        (void)buf, (void)len, (void)cell, (void)value;
+        always_assert(false, "row type does not support cell replay");
+    }
+};
+
+// keys are plain structs; copy them out of possibly unaligned buffers
+template <typename K>
+class key_buffer {
+public:
+    explicit key_buffer(const char *buf) {
+        memcpy(&storage_, buf, sizeof(K));
+    }
+    const K& key() const {
+        return *reinterpret_cast<const K *>(&storage_);
+    }
+private:
+    typename std::aligned_storage<sizeof(K), alignof(K)>::type storage_;
+};
+
+// a decoded row value; row types without a default constructor must be
+// trivially copyable and are decoded into raw storage
+template <typename V>
+class row_buffer {
+public:
+    explicit row_buffer(const char *buf) {
+        construct(std::is_default_constructible<V>());
+        row_codec<V>::decode(buf, value());
+    }
+    ~row_buffer() {
+        value().~V();
+    }
+    row_buffer(const row_buffer&) = delete;
+    row_buffer& operator=(const row_buffer&) = delete;
+
+    V& value() {
+        return *reinterpret_cast<V *>(&storage_);
+    }
+private:
+    typename std::aligned_storage<sizeof(V), alignof(V)>::type storage_;
+
+    void construct(std::true_type) {
+        new (&storage_) V;
+    }
+    void construct(std::false_type) {
+        static_assert(std::is_trivially_copyable<V>::value, "row type cannot be decoded");
+    }
+};
+
+template <typename K, typename V>
+inline void log_put_row(TLogRecord& rec, uint32_t log_id, const K& key, const V& value) {
+    char buf[row_codec<V>::size];
+    row_codec<V>::encode(value, buf);
+    rec.put_row(log_id, &key, sizeof(K), buf, row_codec<V>::size);
+}
+
+template <typename K, typename V>
+inline void log_put_cell(TLogRecord& rec, uint32_t log_id, int cell, const K& key, const V& value) {
+    char buf[row_codec<V>::size];
+    row_codec<V>::encode(value, buf);
+    rec.put_cell(log_id, cell, &key, sizeof(K), buf, row_codec<V>::size);
+}
+
+// One partition file of a checkpoint.
+class checkpoint_writer {
+public:
+    explicit checkpoint_writer(const std::string& fname);
+    ~checkpoint_writer();
+
+    void put_row(uint32_t log_id, const void *key, uint32_t klen,
+                 const void *value, uint32_t vlen);
+
+    template <typename K, typename V>
+    void put_row(uint32_t log_id, const K& key, const V& value) {
+        char buf[row_codec<V>::size];
+        row_codec<V>::encode(value, buf);
+        put_row(log_id, &key, sizeof(K), buf, row_codec<V>::size);
+    }
+
+    // flushes, fsyncs and closes the file
+    void close();
+
+    uint64_t rows() const {
+        return rows_;
+    }
+    uint64_t bytes() const {
+        return bytes_;
+    }
+
+private:
+    static constexpr size_t flush_threshold = 1 << 20;
+
+    int fd_;
+    TLogBuffer buf_;
+    uint64_t rows_;
+    uint64_t bytes_;
+
+    void flush();
+};
+
+class db_checkpointer {
+public:
+    typedef Logger::epoch_type epoch_type;
+    typedef std::function<int(int)> parts_function;
+    typedef std::function<void(int, int, checkpoint_writer&)> scan_function;
+    typedef std::function<void(const TLogEntryHeader&, const char *, const char *)> replay_function;
+
+    db_checkpointer() : thread_init_(), tables_(), replay_(),
+                        ckpt_rows_(), ckpt_bytes_(), ckpt_time_(),
+                        load_rows_(), replay_records_(), load_time_(), replay_time_() {}
+
+    // called on every checkpoint and recovery thread after its TThread id
+    // is set, e.g. to initialize per-thread index state
+    void set_thread_init(std::function<void()> f) {
+        thread_init_ = f;
+    }
+
+    // Registers an index. Table must provide log_id(), checkpoint_parts(n),
+    // checkpoint_scan(part, nparts, writer) and replay_entry(header, key, value).
+    template <typename Table>
+    void add_table(Table& table) {
+        Table *t = &table;
+        add_table(t->log_id(),
+                  [t] (int n) { return t->checkpoint_parts(n); },
+                  [t] (int part, int nparts, checkpoint_writer& w) { t->checkpoint_scan(part, nparts, w); },
+                  [t] (const TLogEntryHeader& h, const char *k, const char *v) { t->replay_entry(h, k, v); });
+    }
+    // Registers anything else that has a log id. parts may be empty if the
+    // object is checkpointed by some other scan function.
+    void add_table(uint32_t log_id, parts_function parts, scan_function scan, replay_function replay);
+
+    // Takes a checkpoint of all registered tables into dir with nthreads
+    // threads, using TThread ids [first_thread_id, first_thread_id + nthreads).
+    // Returns the checkpoint start epoch.
+    epoch_type checkpoint(const std::string& dir, int nthreads, int first_thread_id);
+
+    // Loads the checkpoint in dir and replays dir/sto_log.*. Returns false
+    // if there is no valid checkpoint.
+    bool recover(const std::string& dir, int nthreads, int first_thread_id);
+
+    void print_checkpoint_stats() const;
+    void print_recovery_stats() const;
+
+private:
+    struct table_info {
+        uint32_t log_id;
+        parts_function parts;
+        scan_function scan;
+    };
+
+    std::function<void()> thread_init_;
+    std::vector<table_info> tables_;
+    std::vector<replay_function> replay_; // indexed by log id
+
+    uint64_t ckpt_rows_;
+    uint64_t ckpt_bytes_;
+    double ckpt_time_;
+    uint64_t load_rows_;
+    uint64_t replay_records_;
+    double load_time_;
+    double replay_time_;
+
+    void replay_entry(const TLogEntryHeader& h, const char *key, const char *value) const;
+    void replay_logs(const std::string& dir, epoch_type start_epoch, int nthreads, int first_thread_id);
+};
+
+}; // namespace bench
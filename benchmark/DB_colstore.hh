@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+
+#include "compiler.hh"
+#include "VersionSelector.hh"
+
+namespace bench {
+
+// Column-major copy of the rows of a table whose row type has a column
+// layout (see ver_sel::ColGroups). Each column group is kept in its own
+// array, addressed by the slot the table gave the row, so a scan reads
+// only the groups it needs, at a fixed stride. Slots are allocated in
+// chunks of chunk_rows: a chunk holds a live flag per slot and one
+// cache-line-aligned array per group. Slots are not reused.
+//
+// The copy is not transactional. The table stores a row when a write to
+// it installs, and a scan may see the groups of a row as of different
+// commits.
+template <typename RowType>
+class column_store {
+public:
+    typedef ver_sel::ColGroups<RowType> groups_type;
+    static constexpr int num_groups = groups_type::num_groups;
+    template <int G>
+    using group_type = typename std::tuple_element<G, typename groups_type::group_types>::type;
+
+    static constexpr unsigned chunk_shift = 12;
+    static constexpr size_t chunk_rows = size_t(1) << chunk_shift;
+    static constexpr size_t max_chunks = size_t(1) << 18;
+
+    column_store()
+        : nslots_(0), chunks_(new char *[max_chunks]()) {
+        size_t off = align(chunk_rows);
+        init_offsets(off, std::integral_constant<int, 0>());
+        chunk_bytes_ = off;
+    }
+    ~column_store() {
+        for (size_t c = 0; c != max_chunks; ++c)
+            free(chunks_[c]);
+        delete[] chunks_;
+    }
+    column_store(const column_store&) = delete;
+    column_store& operator=(const column_store&) = delete;
+
+    // a new slot; it holds no row until set_live
+    size_t add() {
+        size_t slot = fetch_and_add(&nslots_, size_t(1));
+        always_assert(slot < max_chunks * chunk_rows, "column store is full");
+        char *&c = chunks_[slot >> chunk_shift];
+        if (!c) {
+            void *mem = nullptr;
+            always_assert(posix_memalign(&mem, CACHE_LINE_SIZE, chunk_bytes_) == 0,
+                          "cannot allocate column chunk");
+            memset(mem, 0, chunk_bytes_);
+            if (!bool_cmpxchg(&c, static_cast<char *>(nullptr), static_cast<char *>(mem)))
+                free(mem);
+        }
+        return slot;
+    }
+
+    size_t size() const {
+        acquire_fence();
+        return nslots_;
+    }
+
+    void store(size_t slot, const RowType& row) {
+        store_groups(chunk(slot), slot & slot_mask, row, std::integral_constant<int, 0>());
+    }
+    void load(size_t slot, RowType& row) const {
+        load_groups(chunk(slot), slot & slot_mask, row, std::integral_constant<int, 0>());
+    }
+    template <int G>
+    const group_type<G>& group(size_t slot) const {
+        return group_array<G>(chunk(slot))[slot & slot_mask];
+    }
+
+    // a slot turns live after the row stored in it
+    void set_live(size_t slot, bool live) {
+        fence();
+        chunk(slot)[slot & slot_mask] = live;
+    }
+    bool live(size_t slot) const {
+        return chunk(slot)[slot & slot_mask];
+    }
+
+    // Calls f(first, values, live, n) for runs of slots first, ..., first
+    // + n - 1 in one chunk: values[i] is group G of slot first + i, and
+    // live[i] is nonzero if that slot holds a row.
+    template <int G, typename F>
+    void scan_chunks(F f) const {
+        size_t n = size();
+        for (size_t first = 0; first < n; first += chunk_rows) {
+            const char *c = chunks_[first >> chunk_shift];
+            acquire_fence();
+            if (c)
+                f(first, group_array<G>(c), reinterpret_cast<const uint8_t *>(c),
+                  std::min(n - first, chunk_rows));
+        }
+    }
+    // calls f(value) for group G of every live row
+    template <int G, typename F>
+    void scan(F f) const {
+        scan_chunks<G>([&] (size_t, const group_type<G> *values, const uint8_t *live, size_t n) {
+            for (size_t i = 0; i != n; ++i)
+                if (live[i])
+                    f(values[i]);
+        });
+    }
+
+private:
+    static constexpr size_t slot_mask = chunk_rows - 1;
+
+    size_t nslots_;
+    char **chunks_;
+    size_t chunk_bytes_;
+    size_t offsets_[num_groups + 1];
+
+    static size_t align(size_t n) {
+        return (n + CACHE_LINE_SIZE - 1) & ~size_t(CACHE_LINE_SIZE - 1);
+    }
+    char *chunk(size_t slot) const {
+        return chunks_[slot >> chunk_shift];
+    }
+    template <int G>
+    group_type<G> *group_array(char *c) const {
+        return reinterpret_cast<group_type<G> *>(c + offsets_[G]);
+    }
+    template <int G>
+    const group_type<G> *group_array(const char *c) const {
+        return reinterpret_cast<const group_type<G> *>(c + offsets_[G]);
+    }
+
+    template <int G>
+    void init_offsets(size_t& off, std::integral_constant<int, G>) {
+        static_assert(std::is_trivially_copyable<group_type<G>>::value,
+                      "column groups are copied as bytes");
+        offsets_[G] = off;
+        off += align(chunk_rows * sizeof(group_type<G>));
+        init_offsets(off, std::integral_constant<int, G + 1>());
+    }
+    void init_offsets(size_t&, std::integral_constant<int, num_groups>) {}
+
+    template <int G>
+    void store_groups(char *c, size_t i, const RowType& row, std::integral_constant<int, G>) {
+        groups_type::store(group_array<G>(c)[i], row);
+        store_groups(c, i, row, std::integral_constant<int, G + 1>());
+    }
+    void store_groups(char *, size_t, const RowType&, std::integral_constant<int, num_groups>) {}
+
+    template <int G>
+    void load_groups(const char *c, size_t i, RowType& row, std::integral_constant<int, G>) const {
+        groups_type::load(row, group_array<G>(c)[i]);
+        load_groups(c, i, row, std::integral_constant<int, G + 1>());
+    }
+    void load_groups(const char *, size_t, RowType&, std::integral_constant<int, num_groups>) const {}
+};
+
+}; // namespace bench
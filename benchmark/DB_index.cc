@@ -1,5 +1,22 @@
 #include "DB_index.hh"
 
+#include <iomanip>
+
 volatile mrcu_epoch_type active_epoch = 1;
 volatile uint64_t globalepoch = 1;
 volatile bool recovering = false;
+
+namespace bench {
+
+uint64_t load_report::rows_;
+
+void load_report::print(std::ostream& os) const {
+    uint64_t n = rows_loaded();
+    double t = seconds();
+    os << "Loaded " << n << " rows in "
+       << std::fixed << std::setprecision(3) << t << " s, "
+       << std::setprecision(0) << (t > 0 ? n / t : 0) << " rows/s" << std::endl;
+    os.unsetf(std::ios::floatfield);
+}
+
+}; // namespace bench
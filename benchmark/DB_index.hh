@@ -3,6 +3,11 @@
 #include "compiler.hh"
 
 #include "Sto.hh"
+#include "Logger.hh"
+#include "DB_alloc.hh"
+#include "DB_checkpoint.hh"
+#include "DB_colstore.hh"
+#include "DB_mvcc.hh"
 
 #include "masstree.hh"
 #include "kvthread.hh"
@@ -13,6 +18,10 @@
 #include "masstree_scan.hh"
 #include "string.hh"
 
+#include <algorithm>
+#include <chrono>
+#include <ostream>
+#include <string>
 #include <vector>
 #include "VersionSelector.hh"
 
@@ -36,6 +45,12 @@ public:
         item.add_write();
         return true;
     }
+    static bool select_for_update(TransProxy& item, TMvccVersion& vers) {
+        if (!item.observe(vers))
+            return false;
+        item.add_write();
+        return true;
+    }
     template <bool Opaque>
     static bool select_for_update(TransProxy& item, TSwissVersion<Opaque>& vers) {
         return item.acquire_write(vers);
@@ -65,6 +80,12 @@ public:
         item.add_write(val);
         return true;
     }
+    template <typename T>
+    static bool select_for_overwrite(TransProxy& item, TMvccVersion& vers, const T& val) {
+        (void)vers;
+        item.add_write(val);
+        return true;
+    }
     template <bool Opaque, typename T>
     static bool select_for_overwrite(TransProxy& item, TSwissVersion<Opaque>& vers, const T& val) {
         return item.acquire_write(vers, val);
@@ -82,11 +103,12 @@ struct get_occ_version {
 
 template <typename DBParams>
 struct get_version {
-    typedef typename std::conditional<DBParams::TicToc, TicTocVersion<>,
+    typedef typename std::conditional<DBParams::MVCC, TMvccVersion,
+            typename std::conditional<DBParams::TicToc, TicTocVersion<>,
             typename std::conditional<DBParams::Adaptive, TLockVersion<true /* adaptive */>,
             typename std::conditional<DBParams::TwoPhaseLock, TLockVersion<false>,
             typename std::conditional<DBParams::Swiss, TSwissVersion<DBParams::Opaque>,
-            typename get_occ_version<DBParams>::type>::type>::type>::type>::type type;
+            typename get_occ_version<DBParams>::type>::type>::type>::type>::type>::type type;
 };
 
 template <typename DBParams>
@@ -97,7 +119,11 @@ public:
 
     integer_box()
         : vers(Sto::initialized_tid() | TransactionTid::nonopaque_bit),
-          value() {}
+          value(), log_id_(Logger::next_log_id()) {}
+
+    uint32_t log_id() const {
+        return log_id_;
+    }
 
     integer_box& operator=(int_type x) {
         value = x;
@@ -131,16 +157,64 @@ public:
     void unlock(TransItem& item) override {
         vers.cp_unlock(item);
     }
+    void log_redo(TransItem& item, TLogRecord& rec) override {
+        rec.put_row(log_id_, uint64_t(0), int_type(value + item.write_value<int_type>()));
+    }
+
+    // checkpoint and recovery (see DB_checkpoint.hh)
+    int checkpoint_parts(int) const {
+        return 1;
+    }
+    void checkpoint_scan(int, int, checkpoint_writer& w) {
+        w.put_row(log_id_, uint64_t(0), int_type(value));
+    }
+    void replay_entry(const TLogEntryHeader& h, const char *, const char *val) {
+        assert(h.type == TLogEntryHeader::put_row);
+        (void)h;
+        memcpy(&value, val, sizeof(value));
+    }
 
 private:
 
     version_type vers;
     int_type value;
+    uint32_t log_id_;
+};
+
+// Loader time and throughput: counts the rows bulk loaders load from the
+// report's construction until print.
+class load_report {
+public:
+    load_report()
+        : rows_begin_(rows()), start_(std::chrono::steady_clock::now()) {}
+
+    uint64_t rows_loaded() const {
+        return rows() - rows_begin_;
+    }
+    double seconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    }
+    void print(std::ostream& os) const;
+
+    // called by loaders as they finish
+    static void count(uint64_t n) {
+        fetch_and_add(&rows_, n);
+    }
+    static uint64_t rows() {
+        acquire_fence();
+        return rows_;
+    }
+
+private:
+    uint64_t rows_begin_;
+    std::chrono::steady_clock::time_point start_;
+
+    static uint64_t rows_;
 };
 
 // unordered index implemented as hashtable
 template <typename K, typename V, typename DBParams>
-class unordered_index : public TObject {
+class unordered_index : public TObjectBatched<unordered_index<K, V, DBParams>> {
 public:
     typedef K key_type;
     typedef V value_type;
@@ -155,15 +229,21 @@ public:
 
     static constexpr bool index_read_my_write = DBParams::RdMyWr;
 
+    // rows stored inline in a bucket; size tables for a few rows per bucket
+    static constexpr int bucket_slots = 5;
+    // keys select_rows looks up together
+    static constexpr int select_batch = 16;
+
 private:
-    // our hashtable is an array of linked lists. 
-    // an internal_elem is the node type for these linked lists
+    // an internal_elem holds one row; elements that overflow their bucket
+    // are linked through next
     struct internal_elem {
         internal_elem *next;
         key_type key;
         version_type version;
         value_type value;
         bool deleted;
+        typename get_mvcc_history<value_type, DBParams>::type history;
 
         internal_elem(const key_type& k, const value_type& val, bool mark_valid)
             : next(nullptr), key(k),
@@ -175,23 +255,68 @@ private:
         }
     };
 
+    // A bucket fills a cache line. Its first bucket_slots elements are
+    // stored inline, each with a one-byte fingerprint of its key's hash in
+    // tags, so a lookup compares the fingerprints of all slots at once and
+    // usually touches a single element. Elements that do not fit are
+    // chained from overflow. Elements never move between slots and the
+    // overflow chain, so a concurrent lookup cannot miss a key that stays
+    // in the bucket.
     struct bucket_entry {
-        internal_elem *head;
         // this is the bucket version number, which is incremented on insert
         // we use it to make sure that an unsuccessful key lookup will still be
         // unsuccessful at commit time (because this will always be true if no
         // new inserts have occurred in this bucket)
         bucket_version_type version;
-        bucket_entry() : head(nullptr), version(0) {}
+        // byte i is slot i's fingerprint, or 0 if the slot is free
+        uint64_t tags;
+        internal_elem *slots[bucket_slots];
+        internal_elem *overflow;
+        bucket_entry() : version(0), tags(0), slots(), overflow(nullptr) {}
+    } __attribute__((aligned(CACHE_LINE_SIZE)));
+    static_assert(sizeof(bucket_entry) == CACHE_LINE_SIZE, "bucket_entry must fill a cache line");
+
+    // The hashtable itself, an array of bucket_entry's. A resize allocates
+    // the next table and moves the buckets over a few at a time (see
+    // help_resize): a bucket whose elements have moved carries moved_bit in
+    // its version, and lookups continue in the next table. Moving a bucket
+    // changes its version, so absent-key reads that observed it abort. The
+    // next table has twice or half as many buckets, so the elements of a
+    // bucket stay within a known set of buckets (see checkpoint_bucket).
+    struct bucket_table {
+        size_t nbuckets;
+        bucket_table *next;
+        bucket_entry *buckets;
+        // written during a resize, away from the fields lookups read
+        char pad_[CACHE_LINE_SIZE];
+        size_t migrate_next;   // next bucket to move
+        size_t migrated;       // buckets moved
+
+        explicit bucket_table(size_t n)
+            : nbuckets(n), next(nullptr), migrate_next(0), migrated(0) {
+            void *mem = nullptr;
+            always_assert(posix_memalign(&mem, CACHE_LINE_SIZE, n * sizeof(bucket_entry)) == 0,
+                          "cannot allocate hashtable buckets");
+            buckets = static_cast<bucket_entry *>(mem);
+            for (size_t i = 0; i != n; ++i)
+                new (&buckets[i]) bucket_entry();
+        }
+        ~bucket_table() {
+            free(buckets);
+        }
+        bucket_table(const bucket_table&) = delete;
+        bucket_table& operator=(const bucket_table&) = delete;
+        bucket_entry& bucket(size_t h) {
+            return buckets[h % nbuckets];
+        }
     };
-
-    typedef std::vector<bucket_entry> MapType;
-    // this is the hashtable itself, an array of bucket_entry's
-    MapType map_;
+    // the oldest table; the last bucket moved out of it retires it
+    bucket_table *table_;
     Hash hasher_;
     Pred pred_;
 
     uint64_t key_gen_;
+    uint32_t log_id_;
 
     // used to mark whether a key is a bucket (for bucket version checks)
     // or a pointer (which will always have the lower 3 bits as 0)
@@ -200,24 +325,75 @@ private:
     static constexpr TransItem::flags_type insert_bit = TransItem::user0_bit;
     static constexpr TransItem::flags_type delete_bit = TransItem::user0_bit<<1;
 
+    static constexpr typename bucket_version_type::type moved_bit = TransactionTid::user_bit;
+    // buckets moved by each operation during a resize
+    static constexpr size_t resize_step = 4;
+    // an insert that makes an overflow chain this long samples the load
+    // factor, and doubles the table if it is above bucket_slots - 1
+    static constexpr size_t resize_overflow_length = 4;
+    static constexpr size_t resize_sample = 64;
+
+    // fingerprint bytes: all ones in the low bits, all high bits, and the
+    // bytes that belong to slots
+    static constexpr uint64_t tag_lsbs = 0x0101010101010101ULL;
+    static constexpr uint64_t tag_msbs = 0x8080808080808080ULL;
+    static constexpr uint64_t slot_tags = (uint64_t(1) << (8 * bucket_slots)) - 1;
+
 public:
     typedef std::tuple<bool, bool, uintptr_t, const value_type*> sel_return_type;
     typedef std::tuple<bool, bool>                               ins_return_type;
     typedef std::tuple<bool, bool>                               del_return_type;
 
     unordered_index(size_t size, Hash h = Hash(), Pred p = Pred()) :
-            map_(), hasher_(h), pred_(p), key_gen_(0) {
-        map_.resize(size);
+            table_(new bucket_table(std::max(size, size_t(1)))), hasher_(h), pred_(p),
+            key_gen_(0), log_id_(Logger::next_log_id()) {
+    }
+    ~unordered_index() {
+        delete table_->next;
+        delete table_;
+    }
+    unordered_index(const unordered_index&) = delete;
+    unordered_index& operator=(const unordered_index&) = delete;
+
+    uint32_t log_id() const {
+        return log_id_;
     }
 
     inline size_t hash(const key_type& k) const {
         return hasher_(k);
     }
+    // the number of buckets, or the target number during a resize
     inline size_t nbuckets() const {
-        return map_.size();
+        bucket_table *t = table_;
+        return t->next ? t->next->nbuckets : t->nbuckets;
+    }
+    bool resizing() const {
+        return table_->next != nullptr;
     }
-    inline size_t find_bucket_idx(const key_type& k) const {
-        return hash(k) % nbuckets();
+
+    // Starts moving the table to n buckets, which must be twice or half the
+    // current number. Operations on the table move the buckets over; the
+    // calling thread can finish the job with finish_resize. Returns false
+    // if a resize is already running.
+    bool resize(size_t n) {
+        bucket_table *t = table_;
+        if (t->next)
+            return false;
+        always_assert(n == t->nbuckets * 2 || (n * 2 == t->nbuckets && n != 0),
+                      "unordered_index can only double or halve");
+        bucket_table *next = new bucket_table(n);
+        if (!bool_cmpxchg(&t->next, (bucket_table *) nullptr, next)) {
+            delete next;
+            return false;
+        }
+        return true;
+    }
+    // moves the remaining buckets of a running resize
+    void finish_resize() {
+        bucket_table *t = table_;
+        if (t->next)
+            while (migrate(t, t->nbuckets))
+                /* do nothing */;
     }
 
     uint64_t gen_key() {
@@ -228,14 +404,40 @@ public:
     // will need to row back transaction if success == false
     sel_return_type
     select_row(const key_type& k, bool for_update = false) {
-        bucket_entry& buck = map_[find_bucket_idx(k)];
-        bucket_version_type buck_vers = buck.version;
+        help_resize();
+        size_t h = hash(k);
+        bucket_version_type buck_vers;
+        bucket_entry& buck = find_bucket(h, buck_vers);
         fence();
-        internal_elem *e = find_in_bucket(buck, k);
+        return select_in_bucket(buck, buck_vers, find_in_bucket(buck, k, h), for_update);
+    }
+
+    // Selects the rows with keys[0], ..., keys[n-1], storing what
+    // select_row(keys[i], for_update) would return in results[i]. The keys
+    // are looked up select_batch at a time: all their buckets, then all
+    // their rows, are prefetched before any is used, so the cache misses of
+    // the lookups overlap. Returns false if the transaction must abort.
+    bool select_rows(const key_type *keys, int n, bool for_update, sel_return_type *results) {
+        help_resize();
+        for (int first = 0; first < n; first += select_batch) {
+            int count = std::min(n - first, int(select_batch));
+            if (!select_batch_rows(keys + first, count, for_update, results + first))
+                return false;
+        }
+        return true;
+    }
+
+private:
+    sel_return_type
+    select_in_bucket(bucket_entry& buck, bucket_version_type buck_vers, internal_elem *e, bool for_update) {
+        if (DBParams::MVCC && !for_update && Sto::transaction()->readonly_snapshot())
+            return select_untracked(e);
 
         if (e) {
             // if found, return pointer to the row
             auto item = Sto::item(this, e);
+            if (DBParams::MVCC && !for_update && !item.has_write())
+                return select_snapshot(item, e);
             if (is_phantom(e, item))
                 goto abort;
 
@@ -267,6 +469,32 @@ public:
         return sel_return_type(false, false, 0, nullptr);
     }
 
+    bool select_batch_rows(const key_type *keys, int n, bool for_update, sel_return_type *results) {
+        size_t h[select_batch];
+        bucket_entry *bucks[select_batch];
+        bucket_version_type buck_vers[select_batch];
+        internal_elem *elems[select_batch];
+        for (int i = 0; i != n; ++i) {
+            h[i] = hash(keys[i]);
+            ::prefetch(&table_->bucket(h[i]));
+        }
+        for (int i = 0; i != n; ++i)
+            bucks[i] = &find_bucket(h[i], buck_vers[i]);
+        fence();
+        for (int i = 0; i != n; ++i) {
+            elems[i] = find_in_bucket(*bucks[i], keys[i], h[i]);
+            if (elems[i])
+                ::prefetch(&elems[i]->version);
+        }
+        for (int i = 0; i != n; ++i) {
+            results[i] = select_in_bucket(*bucks[i], buck_vers[i], elems[i], for_update);
+            if (!std::get<0>(results[i]))
+                return false;
+        }
+        return true;
+    }
+
+public:
     // this method is only to be used after calling select_row() with for_update set to true
     // otherwise behavior is undefined
     // update_row() takes ownership of the row pointer (new_row) passed in, and the row to be updated (table_row)
@@ -285,10 +513,10 @@ public:
     // WILL NOT be deallocated until commit/abort time
     ins_return_type
     insert_row(const key_type& k, value_type *vptr, bool overwrite = false) {
-        bucket_entry& buck = map_[find_bucket_idx(k)];
-
-        buck.version.lock_exclusive();
-        internal_elem *e = find_in_bucket(buck, k);
+        help_resize();
+        size_t h = hash(k);
+        bucket_entry& buck = lock_bucket(h);
+        internal_elem *e = find_in_bucket(buck, k, h);
 
         if (e) {
             buck.version.unlock_exclusive();
@@ -324,18 +552,20 @@ public:
         } else {
             // insert the new row to the table and take note of bucket version changes
             auto buck_vers_0 = bucket_version_type(buck.version.unlocked_value());
-            insert_in_bucket(buck, k, vptr, false);
-            internal_elem *new_head = buck.head;
+            internal_elem *new_elem = insert_in_bucket(buck, k, h, vptr, false);
+            size_t overflow = new_elem == buck.overflow ? chain_length(new_elem) : 0;
             auto buck_vers_1 = bucket_version_type(buck.version.unlocked_value());
 
             buck.version.unlock_exclusive();
+            if (overflow == resize_overflow_length)
+                maybe_grow();
 
             // update bucket version in the read set (if any) since it's changed by ourselves
             auto bucket_item = Sto::item(this, make_bucket_key(buck));
             if (bucket_item.has_read())
                 bucket_item.update_read(buck_vers_0, buck_vers_1);
 
-            auto item = Sto::item(this, new_head);
+            auto item = Sto::item(this, new_elem);
             // XXX adding write is probably unnecessary, am I right?
             item.template add_write<value_type *>(vptr);
             item.add_flags(insert_bit);
@@ -352,11 +582,13 @@ public:
     // until commit time
     del_return_type
     delete_row(const key_type& k) {
-        bucket_entry& buck = map_[find_bucket_idx(k)];
-        bucket_version_type buck_vers = buck.version;
+        help_resize();
+        size_t h = hash(k);
+        bucket_version_type buck_vers;
+        bucket_entry& buck = find_bucket(h, buck_vers);
         fence();
 
-        internal_elem *e = find_in_bucket(buck, k);
+        internal_elem *e = find_in_bucket(buck, k, h);
         if (e) {
             auto item = Sto::item(this, e);
             bool valid = e->valid();
@@ -405,6 +637,9 @@ public:
     }
 
     bool check(TransItem& item, Transaction& txn) override {
+        // snapshot reads of read-only transactions need no validation
+        if (DBParams::MVCC && txn.read_only_at_snapshot())
+            return true;
         if (is_bucket(item)) {
             bucket_entry &buck = *bucket_address(item);
             return buck.version.cp_check_version(txn, item);
@@ -414,13 +649,30 @@ public:
         }
     }
 
+    void prefetch(const TransItem& item) const override {
+        if (is_bucket(item))
+            ::prefetch(&bucket_address(item)->version);
+        else
+            ::prefetch(&item.key<internal_elem *>()->version);
+    }
+
     void install(TransItem& item, Transaction& txn) override {
         assert(!is_bucket(item));
         internal_elem *el = item.key<internal_elem*>();
+        if (DBParams::MVCC && !has_insert(item))
+            el->history.push(0, el->value, el->version.value(), txn.commit_tid());
         if (has_delete(item)) {
-            el->deleted = true;
-            fence();
-            txn.set_version(el->version);
+            if (DBParams::MVCC) {
+                // snapshot readers take the version of a deleted row as the
+                // deletion TID
+                txn.set_version(el->version);
+                fence();
+                el->deleted = true;
+            } else {
+                el->deleted = true;
+                fence();
+                txn.set_version(el->version);
+            }
             return;
         }
         if (!has_insert(item)) {
@@ -441,11 +693,28 @@ public:
         el->version.cp_unlock(item);
     }
 
+    void log_redo(TransItem& item, TLogRecord& rec) override {
+        assert(!is_bucket(item));
+        internal_elem *el = item.key<internal_elem *>();
+        if (has_delete(item)) {
+            if (!has_insert(item))
+                rec.remove(log_id_, el->key);
+        } else if (has_insert(item)) {
+            log_put_row(rec, log_id_, el->key, el->value);
+        } else {
+            log_put_row(rec, log_id_, el->key, *item.write_value<value_type *>());
+        }
+    }
+
     void cleanup(TransItem& item, bool committed) override {
         if (committed ? has_delete(item) : has_insert(item)) {
             assert(!is_bucket(item));
             internal_elem *el = item.key<internal_elem *>();
             assert(!el->valid() || el->deleted);
+            // the element stays locked; this keeps snapshot readers that
+            // still hold it from waiting for the lock
+            el->deleted = true;
+            fence();
             _remove(el);
             item.clear_needs_unlock();
         }
@@ -453,86 +722,343 @@ public:
 
     // non-transactional methods
     value_type* nontrans_get(const key_type& k) {
-        bucket_entry& buck = map_[find_bucket_idx(k)];
-        internal_elem *el = find_in_bucket(buck, k);
+        size_t h = hash(k);
+        bucket_version_type buck_vers;
+        bucket_entry& buck = find_bucket(h, buck_vers);
+        internal_elem *el = find_in_bucket(buck, k, h);
         if (el == nullptr)
             return nullptr;
         return &el->value;
     }
+    // nontrans_get for keys[0], ..., keys[n-1], with the lookups' cache
+    // misses overlapped as in select_rows
+    void nontrans_get(const key_type *keys, int n, value_type **values) {
+        for (int first = 0; first < n; first += select_batch) {
+            int count = std::min(n - first, int(select_batch));
+            size_t h[select_batch];
+            for (int i = 0; i != count; ++i) {
+                h[i] = hash(keys[first + i]);
+                ::prefetch(&table_->bucket(h[i]));
+            }
+            for (int i = 0; i != count; ++i) {
+                bucket_version_type buck_vers;
+                bucket_entry& buck = find_bucket(h[i], buck_vers);
+                internal_elem *el = find_in_bucket(buck, keys[first + i], h[i]);
+                values[first + i] = el ? &el->value : nullptr;
+                if (el)
+                    ::prefetch(&el->value);
+            }
+        }
+    }
     void nontrans_put(const key_type& k, const value_type& v) {
-        bucket_entry& buck = map_[find_bucket_idx(k)];
-        buck.version.lock_exclusive();
-        internal_elem *el = find_in_bucket(buck, k);
-        if (el == nullptr) {
-            internal_elem *new_head = new internal_elem(k, v, true);
-            new_head->next = buck.head;
-            buck.head = new_head;
-        } else {
+        size_t h = hash(k);
+        bucket_entry& buck = lock_bucket(h);
+        internal_elem *el = find_in_bucket(buck, k, h);
+        if (el == nullptr)
+            insert_in_bucket(buck, k, h, &v, true);
+        else
             copy_row(el, &v);
-        }
         buck.version.unlock_exclusive();
     }
 
+    // The interface of ordered_index::bulk_loader. Hashing spreads any key
+    // order over the buckets, so rows may come in any order.
+    class bulk_loader {
+    public:
+        explicit bulk_loader(unordered_index& table)
+            : table_(table), n_(0), counted_(0) {}
+        ~bulk_loader() {
+            finish();
+        }
+        bulk_loader(const bulk_loader&) = delete;
+        bulk_loader& operator=(const bulk_loader&) = delete;
+
+        void add(const key_type& k, const value_type& v) {
+            table_.nontrans_put(k, v);
+            ++n_;
+        }
+        // returns the number of rows loaded
+        size_t finish() {
+            load_report::count(n_ - counted_);
+            counted_ = n_;
+            return n_;
+        }
+
+    private:
+        unordered_index& table_;
+        size_t n_;
+        size_t counted_;
+    };
+
+    // checkpoint and recovery (see DB_checkpoint.hh)
+    int checkpoint_parts(int nthreads) const {
+        return std::max(1, std::min(nthreads, int(table_->nbuckets)));
+    }
+    // writes the committed rows of a contiguous range of buckets; the caller
+    // holds an RCU epoch so chained elements and tables are not reclaimed
+    // under us
+    void checkpoint_scan(int part, int nparts, checkpoint_writer& w) {
+        bucket_table *t = table_;
+        size_t first = t->nbuckets * part / nparts;
+        size_t last = t->nbuckets * (part + 1) / nparts;
+        std::vector<internal_elem *> elems;
+        for (size_t i = first; i < last; ++i)
+            checkpoint_bucket(t, i, t->nbuckets, i, elems, w);
+    }
+    void replay_entry(const TLogEntryHeader& h, const char *key, const char *val) {
+        key_buffer<key_type> kb(key);
+        if (h.type == TLogEntryHeader::put_row) {
+            row_buffer<value_type> rb(val);
+            nontrans_put(kb.key(), rb.value());
+        } else if (h.type == TLogEntryHeader::put_cell) {
+            value_type *v = nontrans_get(kb.key());
+            always_assert(v, "replay: cell update of a missing row");
+            row_codec<value_type>::decode_cell(val, h.value_length, h.cell, *v);
+        } else
+            remove(kb.key());
+    }
+
 private:
+    // read-only snapshot transactions track nothing
+    sel_return_type select_untracked(internal_elem *e) {
+        if (!e)
+            return sel_return_type(true, false, 0, nullptr);
+        const value_type *vptr = mvcc_read_row(e->version, e->value, e->deleted, e->history, invalid_bit);
+        if (!vptr)
+            return sel_return_type(true, false, 0, nullptr);
+        return sel_return_type(true, true, reinterpret_cast<uintptr_t>(e), vptr);
+    }
+
+    sel_return_type select_snapshot(TransProxy& item, internal_elem *e) {
+        TransactionTid::type seen;
+        const value_type *vptr = mvcc_read_latest(e->version, e->value, e->deleted, invalid_bit, seen);
+        // validated unless the transaction stays read-only at its snapshot
+        TMvccVersion seen_version(seen);
+        if (!item.observe(seen_version))
+            return sel_return_type(false, false, 0, nullptr);
+        if (!vptr)
+            return sel_return_type(true, false, 0, nullptr);
+        return sel_return_type(true, true, reinterpret_cast<uintptr_t>(e), vptr);
+    }
+
     // remove a k-v node during transactions (with locks)
     void _remove(internal_elem *el) {
-        bucket_entry& buck = map_[find_bucket_idx(el->key)];
-        buck.version.lock_exclusive();
-        internal_elem *prev = nullptr;
-        internal_elem *curr = buck.head;
-        while (curr != nullptr && curr != el) {
-            prev = curr;
-            curr = curr->next;
-        }
-        assert(curr);
-        if (prev != nullptr)
-            prev->next = curr->next;
-        else
-            buck.head = curr->next;
+        help_resize();
+        bucket_entry& buck = lock_bucket(hash(el->key));
+        unlink_from_bucket(buck, el);
         buck.version.unlock_exclusive();
-        Transaction::rcu_delete(curr);
+        slab_pool::rcu_destroy(el);
     }
     // non-transactional remove by key
     bool remove(const key_type& k) {
-        bucket_entry& buck = map_[find_bucket_idx(k)];
-        buck.version.lock_exclusive();
-        internal_elem *prev = nullptr;
-        internal_elem *curr = buck.head;
-        while (curr != nullptr && !pred_(curr->key, k)) {
-            prev = curr;
-            curr = curr->next;
-        }
-        if (curr == nullptr) {
-            buck.version.unlock_exclusive();
-            return false;
-        }
-        if (prev != nullptr)
-            prev->next = curr->next;
-        else
-            buck.head = curr->next;
+        size_t h = hash(k);
+        bucket_entry& buck = lock_bucket(h);
+        internal_elem *el = find_in_bucket(buck, k, h);
+        if (el)
+            unlink_from_bucket(buck, el);
         buck.version.unlock_exclusive();
-        delete curr;
-        return true;
+        slab_pool::destroy(el);
+        return el != nullptr;
     }
     // insert a k-v node to a bucket
-    void insert_in_bucket(bucket_entry& buck, const key_type& k, const value_type *v, bool valid) {
+    internal_elem *insert_in_bucket(bucket_entry& buck, const key_type& k, size_t h,
+                                    const value_type *v, bool valid) {
         assert(buck.version.is_locked());
-
-        internal_elem *new_head = new internal_elem(k, v ? *v : value_type(), valid);
-        internal_elem *curr_head = buck.head;
-
-        new_head->next = curr_head;
-        buck.head = new_head;
-
+        internal_elem *new_elem = slab_pool::make<internal_elem>(k, v ? *v : value_type(), valid);
+        link_into_bucket(buck, new_elem, h);
         buck.version.inc_nonopaque();
+        return new_elem;
+    }
+    // adds el to a free slot, or to the overflow chain
+    static void link_into_bucket(bucket_entry& buck, internal_elem *el, size_t h) {
+        uint64_t free_slots = ~buck.tags & tag_msbs & slot_tags;
+        if (free_slots) {
+            int i = __builtin_ctzll(free_slots) >> 3;
+            buck.slots[i] = el;
+            release_fence();
+            buck.tags |= uint64_t(tag_of(h)) << (8 * i);
+        } else {
+            el->next = buck.overflow;
+            release_fence();
+            buck.overflow = el;
+        }
     }
-    // find a key's k-v node (internal_elem) within a bucket
-    internal_elem *find_in_bucket(const bucket_entry& buck, const key_type& k) {
-        internal_elem *curr = buck.head;
+    // removes el, which must be in the bucket
+    static void unlink_from_bucket(bucket_entry& buck, internal_elem *el) {
+        for (int i = 0; i != bucket_slots; ++i)
+            if (buck.slots[i] == el) {
+                buck.tags &= ~(uint64_t(0xFF) << (8 * i));
+                release_fence();
+                buck.slots[i] = nullptr;
+                return;
+            }
+        internal_elem **pprev = &buck.overflow;
+        while (*pprev != el) {
+            assert(*pprev);
+            pprev = &(*pprev)->next;
+        }
+        *pprev = el->next;
+    }
+    // find a key's k-v node (internal_elem) within a bucket; h is the key's hash
+    internal_elem *find_in_bucket(const bucket_entry& buck, const key_type& k, size_t h) {
+        // bytes equal to the fingerprint get their high bit set in matches
+        // (with possible false positives, which the key comparison rejects)
+        uint64_t x = buck.tags ^ (tag_lsbs * tag_of(h));
+        uint64_t matches = (x - tag_lsbs) & ~x & tag_msbs & slot_tags;
+        acquire_fence();
+        for (; matches; matches &= matches - 1) {
+            internal_elem *e = buck.slots[__builtin_ctzll(matches) >> 3];
+            if (e && pred_(e->key, k))
+                return e;
+        }
+        internal_elem *curr = buck.overflow;
         while (curr && !pred_(curr->key, k))
             curr = curr->next;
         return curr;
     }
+    // the fingerprint of hash h; its high bit is set, so it is never 0
+    static uint8_t tag_of(size_t h) {
+        return 0x80 | ((uint64_t(h) * 0x9E3779B97F4A7C15ULL) >> 57);
+    }
+    static size_t chain_length(const internal_elem *e) {
+        size_t n = 0;
+        for (; e; e = e->next)
+            ++n;
+        return n;
+    }
+    static size_t bucket_size(const bucket_entry& buck) {
+        return __builtin_popcountll(buck.tags & tag_msbs) + chain_length(buck.overflow);
+    }
+
+    // the bucket for hash h, and its version; the version may be locked
+    bucket_entry& find_bucket(size_t h, bucket_version_type& vers) {
+        bucket_table *t = table_;
+        while (true) {
+            bucket_entry& buck = t->bucket(h);
+            vers = buck.version;
+            if (!(vers.value() & moved_bit))
+                return buck;
+            t = t->next;
+        }
+    }
+    // locks and returns the bucket for hash h
+    bucket_entry& lock_bucket(size_t h) {
+        bucket_table *t = table_;
+        while (true) {
+            bucket_entry& buck = t->bucket(h);
+            buck.version.lock_exclusive();
+            if (!(buck.version.value() & moved_bit))
+                return buck;
+            buck.version.unlock_exclusive();
+            t = t->next;
+        }
+    }
+
+    // resizing
+    void help_resize() {
+        bucket_table *t = table_;
+        if (unlikely(t->next != nullptr))
+            migrate(t, resize_step);
+    }
+    // called after an insert made a long chain
+    void maybe_grow() {
+        bucket_table *t = table_;
+        if (t->next)
+            return;
+        size_t n = 0;
+        for (size_t i = 0; i != resize_sample; ++i)
+            n += bucket_size(t->buckets[t->nbuckets * i / resize_sample]);
+        if (n > resize_sample * (bucket_slots - 1))
+            resize(t->nbuckets * 2);
+    }
+    // moves up to count buckets of t to the next table; returns false if
+    // there are none left to move
+    bool migrate(bucket_table *t, size_t count) {
+        bucket_table *next = t->next;
+        for (size_t i = 0; i != count; ++i) {
+            if (t->migrate_next >= t->nbuckets)
+                return false;
+            size_t b = fetch_and_add(&t->migrate_next, size_t(1));
+            if (b >= t->nbuckets)
+                return false;
+            migrate_bucket(t->buckets[b], next);
+            if (fetch_and_add(&t->migrated, size_t(1)) + 1 == t->nbuckets) {
+                table_ = next;
+                Transaction::rcu_delete(t);
+                return false;
+            }
+        }
+        return true;
+    }
+    // The next table is not resizing while t is. Readers still walking the
+    // overflow chain may follow a moved element into its new chain, and so
+    // miss a key, but they observed the bucket version, which changes.
+    void migrate_bucket(bucket_entry& buck, bucket_table *next) {
+        buck.version.lock_exclusive();
+        for (int i = 0; i != bucket_slots; ++i)
+            if (buck.slots[i])
+                migrate_elem(buck.slots[i], next);
+        internal_elem *e = buck.overflow;
+        while (e) {
+            internal_elem *e_next = e->next;
+            migrate_elem(e, next);
+            e = e_next;
+        }
+        buck.tags = 0;
+        for (int i = 0; i != bucket_slots; ++i)
+            buck.slots[i] = nullptr;
+        buck.overflow = nullptr;
+        buck.version.inc_nonopaque();
+        buck.version.value() |= moved_bit;
+        buck.version.unlock_exclusive();
+    }
+    void migrate_elem(internal_elem *e, bucket_table *next) {
+        size_t h = hash(e->key);
+        bucket_entry& dest = next->bucket(h);
+        dest.version.lock_exclusive();
+        e->next = nullptr;
+        link_into_bucket(dest, e, h);
+        dest.version.unlock_exclusive();
+    }
+
+    // Checkpoints the rows of bucket i of t whose hashes are rem modulo mod.
+    // The bucket is read like a seqlock; if it has moved, its rows are in
+    // the buckets of the next table that take the same hashes.
+    void checkpoint_bucket(bucket_table *t, size_t i, size_t mod, size_t rem,
+                           std::vector<internal_elem *>& elems, checkpoint_writer& w) {
+        bucket_entry& buck = t->buckets[i];
+        while (true) {
+            auto v = buck.version.value();
+            if (TransactionTid::is_locked(v)) {
+                relax_fence();
+                continue;
+            }
+            if (v & moved_bit) {
+                bucket_table *next = t->next;
+                if (next->nbuckets > t->nbuckets) {
+                    checkpoint_bucket(next, i, mod, rem, elems, w);
+                    checkpoint_bucket(next, i + t->nbuckets, mod, rem, elems, w);
+                } else
+                    checkpoint_bucket(next, i % next->nbuckets, mod, rem, elems, w);
+                return;
+            }
+            acquire_fence();
+            elems.clear();
+            for (int s = 0; s != bucket_slots; ++s)
+                if (internal_elem *e = buck.slots[s])
+                    elems.push_back(e);
+            for (internal_elem *e = buck.overflow; e; e = e->next)
+                elems.push_back(e);
+            acquire_fence();
+            if (buck.version.value() == v)
+                break;
+        }
+        for (internal_elem *e : elems) {
+            if (e->valid() && !e->deleted
+                && (t->nbuckets == mod || hash(e->key) % mod == rem))
+                w.put_row(log_id_, e->key, e->value);
+        }
+    }
 
     static bool has_delete(const TransItem& item) {
         return item.flags() & delete_bit;
@@ -565,8 +1091,14 @@ private:
 
 enum class RowAccess : int { None = 0, ObserveExists, ObserveValue, UpdateValue };
 
+// row of a secondary_index: the rid of the indexed row in the base table
+struct index_entry_row {
+    enum class NamedColumn : int { rid = 0 };
+    uintptr_t rid;
+};
+
 template <typename K, typename V, typename DBParams>
-class ordered_index : public TObject {
+class ordered_index : public TObjectBatched<ordered_index<K, V, DBParams>> {
 public:
     typedef K key_type;
     typedef V value_type;
@@ -579,19 +1111,53 @@ public:
     static constexpr TransItem::flags_type delete_bit = TransItem::user0_bit << 1u;
     static constexpr TransItem::flags_type row_update_bit = TransItem::user0_bit << 2u;
     static constexpr TransItem::flags_type row_cell_bit = TransItem::user0_bit << 3u;
+    // the write value holds a whole row (update_row or an overwriting insert)
+    static constexpr TransItem::flags_type row_value_bit = TransItem::user0_bit << 4u;
     static constexpr uintptr_t internode_bit = 1;
 
+    typedef DBParams db_params;
     typedef typename value_type::NamedColumn NamedColumn;
     typedef IndexValueContainer<V, version_type> value_container_type;
 
     static constexpr bool value_is_small = is_small<V>::value;
 
     static constexpr bool index_read_my_write = DBParams::RdMyWr;
+    // keys select_rows looks up together
+    static constexpr int select_batch = 16;
+    // deleted rows unlinked together (see retire)
+    static constexpr int garbage_batch = 64;
+    // leaf conflicts are resolved by key range (see read_range)
+    static constexpr bool track_ranges = !DBParams::Opaque;
+
+    // rows with a column layout are also kept column-major (see column_store)
+    typedef column_store<V> column_store_type;
+    static constexpr bool column_layout = column_store_type::num_groups > 0;
+
+    // the row's slot in the column store
+    template <bool Columns, typename Dummy = void>
+    struct column_slot {
+        size_t slot() const {
+            return 0;
+        }
+        void set_slot(size_t) {}
+    };
+    template <typename Dummy>
+    struct column_slot<true, Dummy> {
+        size_t slot_;
 
-    struct internal_elem {
+        size_t slot() const {
+            return slot_;
+        }
+        void set_slot(size_t s) {
+            slot_ = s;
+        }
+    };
+
+    struct internal_elem : public column_slot<column_layout> {
         key_type key;
         value_container_type row_container;
         bool deleted;
+        typename get_mvcc_history<value_type, DBParams>::type history;
 
         internal_elem(const key_type& k, const value_type& v, bool valid)
             : key(k),
@@ -660,15 +1226,20 @@ public:
         }
     };
 
+    // MVCC tables version whole rows, so every column maps to cell 0
+    static int column_to_cell(int col_id) {
+        return DBParams::MVCC ? 0 : value_container_type::map(col_id);
+    }
+
     static std::vector<cell_access_t>
-    column_to_cell_accesses(std::function<int(int)> c_c_map, std::initializer_list<column_access_t> accesses) {
+    column_to_cell_accesses(std::initializer_list<column_access_t> accesses) {
         // pair: {accessed, for update}
         std::vector<std::pair<bool, bool>> all_cells(value_container_type::num_versions, {false, false});
         // the returned list
         std::vector<cell_access_t> cell_accesses;
 
         for (auto ca : accesses) {
-            int cell_id = c_c_map(ca.col_id);
+            int cell_id = column_to_cell(ca.col_id);
             all_cells[cell_id].first = true;
             all_cells[cell_id].second |= ca.update;
         }
@@ -701,6 +1272,23 @@ public:
 
     static __thread typename table_params::threadinfo_type *ti;
 
+    // A secondary index on this table (see secondary_index). insert_row,
+    // update_row and delete_row maintain the indexes in the modifying
+    // transaction and fail if an index operation fails; nontrans_put and
+    // recovery maintain them non-transactionally.
+    class index_hook {
+    public:
+        virtual ~index_hook() {}
+        virtual bool insert_entry(const key_type& k, const value_type& v, uintptr_t rid) = 0;
+        virtual bool update_entry(const key_type& k, const value_type& old_v,
+                                  const value_type& new_v, uintptr_t rid) = 0;
+        virtual bool delete_entry(const key_type& k, const value_type& v) = 0;
+        virtual void nontrans_insert_entry(const key_type& k, const value_type& v, uintptr_t rid) = 0;
+        virtual void nontrans_remove_entry(const key_type& k, const value_type& v) = 0;
+        // entries of rows a bulk_loader loaded, in any order
+        virtual void nontrans_load_entries(const std::vector<uintptr_t>& rids) = 0;
+    };
+
     ordered_index(size_t init_size) {
         this->table_init();
         (void)init_size;
@@ -708,12 +1296,64 @@ public:
     ordered_index() {
         this->table_init();
     }
+    // tables are moved only while no transaction runs
+    ordered_index(ordered_index&& x)
+        : table_(x.table_), key_gen_(x.key_gen_), log_id_(x.log_id_),
+          indexes_(std::move(x.indexes_)), columns_(x.columns_), owner_(x.owner_) {
+        owner_->table = this;
+        x.columns_ = nullptr;
+        x.owner_ = nullptr;
+    }
+    // no transaction may use the table, nor reclaim its rows, concurrently
+    ~ordered_index() {
+        delete columns_;
+        if (!owner_)
+            return;
+        if (garbage_ && garbage_->owner == owner_)
+            flush_garbage();
+        owner_->table = nullptr;
+        release_owner(owner_);
+    }
+    ordered_index(const ordered_index&) = delete;
+    ordered_index& operator=(const ordered_index&) = delete;
 
     void table_init() {
         if (ti == nullptr)
             ti = threadinfo::make(threadinfo::TI_MAIN, -1);
         table_.initialize(*ti);
         key_gen_ = 0;
+        log_id_ = Logger::next_log_id();
+        columns_ = column_layout ? new column_store_type : nullptr;
+        owner_ = new garbage_owner{this, 1};
+    }
+
+    uint32_t log_id() const {
+        return log_id_;
+    }
+
+    // indexes must be added before the table is populated
+    void add_index(index_hook *idx) {
+        indexes_.push_back(idx);
+    }
+
+    // the key of row rid
+    static const key_type& row_key(uintptr_t rid) {
+        return reinterpret_cast<internal_elem *>(rid)->key;
+    }
+    // the row rid as last installed; for rows no transaction writes
+    static const value_type& nontrans_row(uintptr_t rid) {
+        return reinterpret_cast<internal_elem *>(rid)->row_container.row;
+    }
+
+    // The column-major copy of the committed rows, for scans that read a
+    // few column groups of many rows; null unless the row type has a
+    // column layout. Reading it is not transactional (see column_store).
+    const column_store_type *columns() const {
+        return columns_;
+    }
+    // the column store slot of row rid
+    static size_t column_slot_of(uintptr_t rid) {
+        return reinterpret_cast<internal_elem *>(rid)->slot();
     }
 
     static void thread_init() {
@@ -730,19 +1370,28 @@ public:
     uint64_t gen_key() {
         return fetch_and_add(&key_gen_, 1);
     }
+    // used after recovery to continue where the recovered keys end
+    void set_key_gen(uint64_t next) {
+        key_gen_ = next;
+    }
 
     sel_return_type
     select_row(const key_type& key, RowAccess acc) {
+        pin_snapshot();
         unlocked_cursor_type lp(table_, key);
         bool found = lp.find_unlocked(*ti);
         internal_elem *e = lp.value();
         if (found) {
-            return select_row(reinterpret_cast<uintptr_t>(e), acc);
-        } else {
-            if (!register_internode_version(lp.node(), lp.full_version_value()))
-                goto abort;
-            return sel_return_type(true, false, 0, nullptr);
+            auto ret = select_row(reinterpret_cast<uintptr_t>(e), acc);
+            // the absence of a deleted row's key is tracked at the leaf
+            if (!std::get<0>(ret) || std::get<1>(ret) || !e->deleted)
+                return ret;
         }
+        if (untracked(acc != RowAccess::UpdateValue))
+            return sel_return_type(true, false, 0, nullptr);
+        if (!register_absent_key(lp.node(), lp.full_version_value(), key, found ? e : nullptr))
+            goto abort;
+        return sel_return_type(true, false, 0, nullptr);
 
     abort:
         return sel_return_type(false, false, 0, nullptr);
@@ -750,26 +1399,53 @@ public:
 
     sel_return_type
     select_row(const key_type& key, std::initializer_list<column_access_t> accesses) {
+        pin_snapshot();
         unlocked_cursor_type lp(table_, key);
         bool found = lp.find_unlocked(*ti);
         internal_elem *e = lp.value();
         if (found) {
-            return select_row(reinterpret_cast<uintptr_t>(e), accesses);
-        } else {
-            if (!register_internode_version(lp.node(), lp.full_version_value()))
-                goto abort;
-            return sel_return_type(true, false, 0, nullptr);
+            auto ret = select_row(reinterpret_cast<uintptr_t>(e), accesses);
+            // the absence of a deleted row's key is tracked at the leaf
+            if (!std::get<0>(ret) || std::get<1>(ret) || !e->deleted)
+                return ret;
         }
+        if (untracked(!any_update(accesses)))
+            return sel_return_type(true, false, 0, nullptr);
+        if (!register_absent_key(lp.node(), lp.full_version_value(), key, found ? e : nullptr))
+            goto abort;
+        return sel_return_type(true, false, 0, nullptr);
 
     abort:
         return sel_return_type(false, false, 0, nullptr);
     }
 
+    // Selects the rows with keys[0], ..., keys[n-1], storing what
+    // select_row(keys[i], access) would return in results[i]. The keys are
+    // looked up select_batch at a time, in key order, and the rows found
+    // are prefetched before any is selected, so the rows' cache misses
+    // overlap. Returns false if the transaction must abort.
+    bool select_rows(const key_type *keys, int n, RowAccess access, sel_return_type *results) {
+        return select_rows_batched(keys, n, access, results);
+    }
+    bool select_rows(const key_type *keys, int n, std::initializer_list<column_access_t> accesses,
+                     sel_return_type *results) {
+        return select_rows_batched(keys, n, accesses, results);
+    }
+
     sel_return_type
     select_row(uintptr_t rid, RowAccess access) {
         auto e = reinterpret_cast<internal_elem *>(rid);
         bool ok = true;
+        if (untracked(access == RowAccess::ObserveExists || access == RowAccess::ObserveValue))
+            return select_untracked(e);
         TransProxy row_item = Sto::item(this, item_key_t::row_item_key(e));
+        bool snapshot = DBParams::MVCC && (access == RowAccess::ObserveExists || access == RowAccess::ObserveValue)
+                        && !row_item.has_write();
+
+        if (is_absent(e, snapshot))
+            return sel_return_type(true, false, 0, nullptr);
+        if (snapshot)
+            return select_snapshot(row_item, e);
 
         if (is_phantom(e, row_item))
             goto abort;
@@ -803,6 +1479,10 @@ public:
 
         if (!ok)
             goto abort;
+        // deleted since the check above
+        fence();
+        if (e->deleted)
+            goto abort;
 
         return sel_return_type(true, true, rid, &(e->row_container.row));
 
@@ -813,15 +1493,24 @@ public:
     sel_return_type
     select_row(uintptr_t rid, std::initializer_list<column_access_t> accesses) {
         auto e = reinterpret_cast<internal_elem *>(rid);
+        if (untracked(!any_update(accesses)))
+            return select_untracked(e);
         TransProxy row_item = Sto::item(this, item_key_t::row_item_key(e));
 
         // Translate from column accesses to cell accesses
         // all buffered writes are only stored in the wdata_ of the row item (to avoid redundant copies)
-        auto cell_accesses = column_to_cell_accesses(value_container_type::map, accesses);
+        auto cell_accesses = column_to_cell_accesses(accesses);
 
         std::vector<TransProxy> cell_items;
         bool any_has_write;
         bool ok;
+
+        bool snapshot = DBParams::MVCC && !any_update(cell_accesses) && !row_item.has_write();
+        if (is_absent(e, snapshot))
+            return sel_return_type(true, false, 0, nullptr);
+        if (snapshot)
+            return select_snapshot(row_item, e);
+
         std::tie(any_has_write, cell_items) = extract_item_list(cell_accesses, e);
 
         if (is_phantom(e, row_item))
@@ -844,6 +1533,9 @@ public:
         ok = access_all(cell_accesses, cell_items, e);
         if (!ok)
             goto abort;
+        fence();
+        if (e->deleted)
+            goto abort;
 
         return sel_return_type(true, true, rid, &(e->row_container.row));
 
@@ -851,16 +1543,23 @@ public:
         return sel_return_type(false, false, 0, nullptr);
     }
 
-    void update_row(uintptr_t rid, value_type *new_row) {
-        auto row_item = Sto::item(this, item_key_t::row_item_key(reinterpret_cast<internal_elem *>(rid)));
+    // returns false if maintaining a secondary index failed. new_row must
+    // not be the row select_row returned if an indexed column changes.
+    bool update_row(uintptr_t rid, value_type *new_row) {
+        auto e = reinterpret_cast<internal_elem *>(rid);
+        auto row_item = Sto::item(this, item_key_t::row_item_key(e));
+        if (!indexes_.empty() && !indexes_update(row_item, e, *new_row))
+            return false;
         if (value_is_small) {
             row_item.add_write(*new_row);
         } else {
             row_item.add_write(new_row);
         }
+        row_item.add_flags(row_value_bit);
         // Just update the pointer, don't set the actual write flag
         // we don't want to confuse installs at commit time
         //row_item.clear_write();
+        return true;
     }
 
     // insert assumes common case where the row doesn't exist in the table
@@ -880,6 +1579,8 @@ public:
             // It should be trivial for a cell item to find the corresponding row item
             // and figure out if the row-level version is locked.
             internal_elem *e = lp.value();
+            if (e->deleted)
+                return insert_new(lp, key, vptr, true);
             lp.finish(0, *ti);
 
             TransProxy row_item = Sto::item(this, item_key_t::row_item_key(e));
@@ -889,12 +1590,15 @@ public:
 
             if (index_read_my_write) {
                 if (has_delete(row_item)) {
+                    if (!indexes_.empty() && !indexes_insert(key, *vptr, e))
+                        goto abort;
                     auto proxy = row_item.clear_flags(delete_bit).clear_write();
 
                     if (value_is_small)
                         proxy.add_write(*vptr);
                     else
                         proxy.add_write(vptr);
+                    proxy.add_flags(row_value_bit);
 
                     return ins_return_type(true, false);
                 }
@@ -902,12 +1606,15 @@ public:
 
             if (overwrite) {
                 bool ok;
+                if (!indexes_.empty() && !indexes_update(row_item, e, *vptr))
+                    goto abort;
                 if (value_is_small)
                     ok = version_adapter::select_for_overwrite(row_item, e->version(), *vptr);
                 else
                     ok = version_adapter::select_for_overwrite(row_item, e->version(), vptr);
                 if (!ok)
                     goto abort;
+                row_item.add_flags(row_value_bit);
                 if (index_read_my_write) {
                     if (has_insert(row_item)) {
                         copy_row(e, vptr);
@@ -919,42 +1626,8 @@ public:
                     goto abort;
             }
 
-        } else {
-            auto e = new internal_elem(key, vptr ? *vptr : value_type(),
-                                       false /*!valid*/);
-            lp.value() = e;
-
-            node_type *node;
-            nodeversion_value_type orig_nv;
-            nodeversion_value_type new_nv;
-
-            bool split_right = (lp.node() != lp.original_node());
-            if (split_right) {
-                node = lp.original_node();
-                orig_nv = lp.original_version_value();
-                new_nv = lp.updated_version_value();
-            } else {
-                node = lp.node();
-                orig_nv = lp.previous_full_version_value();
-                new_nv = lp.next_full_version_value(1);
-            }
-
-            fence();
-            lp.finish(1, *ti);
-            //fence();
-
-            TransProxy row_item = Sto::item(this, item_key_t::row_item_key(e));
-            //if (value_is_small)
-            //    item.add_write<value_type>(*vptr);
-            //else
-            //    item.add_write<value_type *>(vptr);
-            row_item.add_write();
-            row_item.add_flags(insert_bit);
-
-            // update the node version already in the read set and modified by split
-            if (!update_internode_version(node, orig_nv, new_nv))
-                goto abort;
-        }
+        } else
+            return insert_new(lp, key, vptr, false);
 
         return ins_return_type(true, found);
 
@@ -965,7 +1638,8 @@ public:
     del_return_type
     delete_row(const key_type& key) {
         unlocked_cursor_type lp(table_, key);
-        bool found = lp.find_unlocked(*ti);
+        bool present = lp.find_unlocked(*ti);
+        bool found = present && !lp.value()->deleted;
         if (found) {
             internal_elem *e = lp.value();
             TransProxy row_item = Sto::item(this, item_key_t::row_item_key(e));
@@ -977,6 +1651,8 @@ public:
                 if (has_delete(row_item))
                     return del_return_type(true, false);
                 if (!e->valid() && has_insert(row_item)) {
+                    if (!indexes_delete(row_item, e))
+                        goto abort;
                     row_item.add_flags(delete_bit);
                     return del_return_type(true, true);
                 }
@@ -989,9 +1665,12 @@ public:
             fence();
             if (e->deleted)
                 goto abort;
+            if (!indexes_delete(row_item, e))
+                goto abort;
             row_item.add_flags(delete_bit);
         } else {
-            if (!register_internode_version(lp.node(), lp.full_version_value()))
+            if (!register_absent_key(lp.node(), lp.full_version_value(), key,
+                                     present ? lp.value() : nullptr))
                 goto abort;
         }
 
@@ -1002,19 +1681,40 @@ public:
     }
 
     template <typename Callback, bool Reverse>
-    bool range_scan(const key_type& begin, const key_type& end, Callback callback,
+    bool range_scan(const key_type& begin, const key_type& end, Callback scan_callback,
                     std::initializer_list<column_access_t> accesses, bool phantom_protection = true, int limit = -1) {
         assert((limit == -1) || (limit > 0));
+        scan_limit left(limit);
+        auto callback = [&] (const key_type& k, const value_type& v) {
+            left.count();
+            return scan_callback(k, v);
+        };
         auto node_callback = [&] (leaf_type* node,
             typename unlocked_cursor_type::nodeversion_value_type version) {
             return ((!phantom_protection) || register_internode_version(node, version));
         };
 
-        auto cell_accesses = column_to_cell_accesses(value_container_type::map, accesses);
+        auto cell_accesses = column_to_cell_accesses(accesses);
+        bool snapshot = DBParams::MVCC && !any_update(cell_accesses);
+        bool no_tracking = untracked(snapshot);
+        if (no_tracking)
+            phantom_protection = false;
+        range_tracker range(this, phantom_protection, begin, end, Reverse);
 
         auto value_callback = [&] (const lcdf::Str& key, internal_elem *e, bool& ret) {
+            if (no_tracking)
+                return scan_untracked(key, e, callback, ret);
+            range.visit(e);
             TransProxy row_item = index_read_my_write ? Sto::item(this, item_key_t::row_item_key(e))
                                                       : Sto::fresh_item(this, item_key_t::row_item_key(e));
+            bool snapshot_read = snapshot && !row_item.has_write();
+
+            if (is_absent(e, snapshot_read)) {
+                ret = true;
+                return true;
+            }
+            if (snapshot_read)
+                return scan_snapshot(key, row_item, e, callback, ret);
 
             bool any_has_write;
             std::vector<TransProxy> cell_items;
@@ -1045,7 +1745,8 @@ public:
             //}
 
             // skip invalid (inserted but yet committed) values, but do not abort
-            if (!e->valid()) {
+            fence();
+            if (!e->valid() || e->deleted) {
                 ret = true;
                 return true;
             }
@@ -1055,26 +1756,50 @@ public:
         };
 
         range_scanner<decltype(node_callback), decltype(value_callback), Reverse>
-            scanner(end, node_callback, value_callback);
+            scanner(end, node_callback, value_callback, left);
+        pin_snapshot();
         if (Reverse)
-            table_.rscan(begin, true, scanner, limit, *ti);
+            table_.rscan(begin, true, scanner, -1, *ti);
         else
-            table_.scan(begin, true, scanner, limit, *ti);
+            table_.scan(begin, true, scanner, -1, *ti);
+        range.finish(left.reached());
         return scanner.scan_succeeded_;
     }
 
     template <typename Callback, bool Reverse>
-    bool range_scan(const key_type& begin, const key_type& end, Callback callback,
+    bool range_scan(const key_type& begin, const key_type& end, Callback scan_callback,
                     RowAccess access, bool phantom_protection = true, int limit = -1) {
         assert((limit == -1) || (limit > 0));
+        scan_limit left(limit);
+        auto callback = [&] (const key_type& k, const value_type& v) {
+            left.count();
+            return scan_callback(k, v);
+        };
         auto node_callback = [&] (leaf_type* node,
                                   typename unlocked_cursor_type::nodeversion_value_type version) {
             return ((!phantom_protection) || register_internode_version(node, version));
         };
 
+        bool snapshot = DBParams::MVCC && access != RowAccess::None;
+        bool no_tracking = untracked(snapshot);
+        if (no_tracking)
+            phantom_protection = false;
+        range_tracker range(this, phantom_protection, begin, end, Reverse);
+
         auto value_callback = [&] (const lcdf::Str& key, internal_elem *e, bool& ret) {
+            if (no_tracking)
+                return scan_untracked(key, e, callback, ret);
+            range.visit(e);
             TransProxy row_item = index_read_my_write ? Sto::item(this, item_key_t::row_item_key(e))
                                                       : Sto::fresh_item(this, item_key_t::row_item_key(e));
+            bool snapshot_read = snapshot && !row_item.has_write();
+
+            if (is_absent(e, snapshot_read)) {
+                ret = true;
+                return true;
+            }
+            if (snapshot_read)
+                return scan_snapshot(key, row_item, e, callback, ret);
 
             if (index_read_my_write) {
                 if (has_delete(row_item)) {
@@ -1107,7 +1832,8 @@ public:
                 return false;
 
             // skip invalid (inserted but yet committed) values, but do not abort
-            if (!e->valid()) {
+            fence();
+            if (!e->valid() || e->deleted) {
                 ret = true;
                 return true;
             }
@@ -1117,39 +1843,245 @@ public:
         };
 
         range_scanner<decltype(node_callback), decltype(value_callback), Reverse>
-                scanner(end, node_callback, value_callback);
+                scanner(end, node_callback, value_callback, left);
+        pin_snapshot();
         if (Reverse)
-            table_.rscan(begin, true, scanner, limit, *ti);
+            table_.rscan(begin, true, scanner, -1, *ti);
         else
-            table_.scan(begin, true, scanner, limit, *ti);
+            table_.scan(begin, true, scanner, -1, *ti);
+        range.finish(left.reached());
         return scanner.scan_succeeded_;
     }
 
-    value_type *nontrans_get(const key_type& k) {
-        unlocked_cursor_type lp(table_, k);
-        bool found = lp.find_unlocked(*ti);
-        if (found) {
-            internal_elem *e = lp.value();
-            return &(e->row_container.row);
-        } else
-            return nullptr;
-    }
+    // Scans like the range_scan above, but calls callback only for the rows
+    // that pass filter(key, row). The filter may read only the columns in
+    // filter_columns (none if it looks at the key alone): a row it rejects
+    // is tracked by those columns' cells, and a row it accepts also by the
+    // cells of accesses. Phantoms are still caught at the leaves. limit
+    // counts the rows filtered, not the rows accepted.
+    template <typename Filter, typename Callback, bool Reverse>
+    bool range_scan(const key_type& begin, const key_type& end, Filter filter, Callback callback,
+                    std::initializer_list<column_access_t> filter_columns,
+                    std::initializer_list<column_access_t> accesses,
+                    bool phantom_protection = true, int limit = -1) {
+        assert((limit == -1) || (limit > 0));
+        auto node_callback = [&] (leaf_type* node,
+                                  typename unlocked_cursor_type::nodeversion_value_type version) {
+            return ((!phantom_protection) || register_internode_version(node, version));
+        };
+
+        auto filter_cells = column_to_cell_accesses(filter_columns);
+        auto cell_accesses = column_to_cell_accesses(accesses);
+        always_assert(!any_update(filter_cells), "range_scan filters only read");
+        bool snapshot = DBParams::MVCC && !any_update(cell_accesses);
+        bool no_tracking = untracked(snapshot);
+        if (no_tracking)
+            phantom_protection = false;
+        range_tracker range(this, phantom_protection, begin, end, Reverse);
+
+        scan_limit left(limit);
+        auto filtered_callback = [&] (const key_type& k, const value_type& v) {
+            left.count();
+            return !filter(k, v) || callback(k, v);
+        };
+
+        auto value_callback = [&] (const lcdf::Str& key, internal_elem *e, bool& ret) {
+            if (no_tracking)
+                return scan_untracked(key, e, filtered_callback, ret);
+            range.visit(e);
+            if (is_absent(e, snapshot)) {
+                ret = true;
+                return true;
+            }
+
+            // rows this transaction wrote are filtered by their new values
+            if (index_read_my_write) {
+                if (auto own = Sto::check_item(this, item_key_t::row_item_key(e))) {
+                    TransProxy row_item = own.get();
+                    if (has_delete(row_item.item())) {
+                        ret = true;
+                        return true;
+                    }
+                    if (row_item.has_write()) {
+                        if (has_insert(row_item.item()))
+                            ret = filtered_callback(key_type(key), e->row_container.row);
+                        else
+                            ret = filtered_callback(key_type(key), *(row_item.template raw_write_value<value_type *>()));
+                        return true;
+                    }
+                }
+            }
+            if (snapshot) {
+                TransProxy row_item = Sto::item(this, item_key_t::row_item_key(e));
+                return scan_snapshot(key, row_item, e, filtered_callback, ret);
+            }
+
+            if (!access_cells(filter_cells, e))
+                return false;
+            // skip invalid (inserted but yet committed) values, but do not
+            // abort; the row version tells if the insert commits
+            if (!e->valid()) {
+                if (!Sto::item(this, item_key_t::row_item_key(e)).observe(e->version()))
+                    return false;
+                fence();
+                if (!e->valid()) {
+                    ret = true;
+                    return true;
+                }
+            }
+            fence();
+            if (e->deleted) {
+                ret = true;
+                return true;
+            }
+
+            left.count();
+            if (!filter(key_type(key), e->row_container.row)) {
+                ret = true;
+                return true;
+            }
+            if (!access_cells(cell_accesses, e))
+                return false;
+            ret = callback(key_type(key), e->row_container.row);
+            return true;
+        };
+
+        range_scanner<decltype(node_callback), decltype(value_callback), Reverse>
+                scanner(end, node_callback, value_callback, left);
+        pin_snapshot();
+        if (Reverse)
+            table_.rscan(begin, true, scanner, -1, *ti);
+        else
+            table_.scan(begin, true, scanner, -1, *ti);
+        range.finish(left.reached());
+        return scanner.scan_succeeded_;
+    }
+
+    value_type *nontrans_get(const key_type& k) {
+        unlocked_cursor_type lp(table_, k);
+        bool found = lp.find_unlocked(*ti);
+        if (found && !lp.value()->deleted) {
+            internal_elem *e = lp.value();
+            return &(e->row_container.row);
+        } else
+            return nullptr;
+    }
 
     void nontrans_put(const key_type& k, const value_type& v) {
         cursor_type lp(table_, k);
         bool found = lp.find_insert(*ti);
-        if (found) {
-            internal_elem *e = lp.value();
+        internal_elem *e = found ? lp.value() : nullptr;
+        if (e && e->deleted) {
+            // the deleted row is left to its garbage list
+            e = slab_pool::make<internal_elem>(k, v, true);
+            columns_add(e);
+            lp.value() = e;
+            lp.finish(0, *ti);
+        } else if (found) {
+            for (auto idx : indexes_)
+                idx->nontrans_remove_entry(k, e->row_container.row);
             if (value_is_small)
                 e->row_container.row = v;
             else
                copy_row(e, &v);
             lp.finish(0, *ti);
         } else {
-            internal_elem *e = new internal_elem(k, v, true);
+            e = slab_pool::make<internal_elem>(k, v, true);
+            columns_add(e);
             lp.value() = e;
             lp.finish(1, *ti);
         }
+        columns_put(e);
+        for (auto idx : indexes_)
+            idx->nontrans_insert_entry(k, v, reinterpret_cast<uintptr_t>(e));
+    }
+
+    // Loads rows in ascending key order into a table no transaction uses
+    // yet; loaders on different threads may fill one table, typically each
+    // a range of its keys. Unlike nontrans_put, a loaded key must be new:
+    // each row is inserted at the right edge of the keys loaded before it,
+    // where Masstree splits leaves sequentially, leaving them full rather
+    // than half full. Secondary index entries are collected, sorted, and
+    // loaded the same way when the loader finishes.
+    class bulk_loader {
+    public:
+        explicit bulk_loader(ordered_index& table)
+            : table_(table), n_(0), counted_(0) {}
+        ~bulk_loader() {
+            finish();
+        }
+        bulk_loader(const bulk_loader&) = delete;
+        bulk_loader& operator=(const bulk_loader&) = delete;
+
+        void add(const key_type& k, const value_type& v) {
+            Str key(k);
+            always_assert(n_ == 0 || Str(last_key_.data(), last_key_.length()).compare(key) < 0,
+                          "bulk loaded keys must be ascending");
+            internal_elem *e = table_.load_row(k, v);
+            if (!table_.indexes_.empty())
+                rids_.push_back(reinterpret_cast<uintptr_t>(e));
+            last_key_.assign(key.data(), key.length());
+            ++n_;
+        }
+        // loads the pending index entries; returns the number of rows loaded
+        size_t finish() {
+            if (!rids_.empty()) {
+                for (auto idx : table_.indexes_)
+                    idx->nontrans_load_entries(rids_);
+                rids_.clear();
+            }
+            load_report::count(n_ - counted_);
+            counted_ = n_;
+            return n_;
+        }
+
+    private:
+        ordered_index& table_;
+        std::string last_key_;
+        size_t n_;
+        size_t counted_;
+        std::vector<uintptr_t> rids_;
+    };
+
+    // returns false if k was not found; secondary indexes are not updated
+    bool nontrans_remove(const key_type& k) {
+        return _remove(k);
+    }
+
+    // checkpoint and recovery (see DB_checkpoint.hh)
+    int checkpoint_parts(int) const {
+        return 1;
+    }
+    void checkpoint_scan(int, int, checkpoint_writer& w) {
+        checkpoint_scanner scanner(log_id_, w);
+        table_.scan(Str(), true, scanner, -1, *ti);
+    }
+    void replay_entry(const TLogEntryHeader& h, const char *key, const char *val) {
+        key_buffer<key_type> kb(key);
+        if (h.type == TLogEntryHeader::remove) {
+            if (!indexes_.empty()) {
+                if (value_type *row = nontrans_get(kb.key()))
+                    for (auto idx : indexes_)
+                        idx->nontrans_remove_entry(kb.key(), *row);
+            }
+            _remove(kb.key());
+            return;
+        }
+        row_buffer<value_type> rb(val);
+        if (h.type == TLogEntryHeader::put_cell) {
+            unlocked_cursor_type lp(table_, kb.key());
+            if (lp.find_unlocked(*ti)) {
+                internal_elem *e = lp.value();
+                for (auto idx : indexes_)
+                    idx->nontrans_remove_entry(kb.key(), e->row_container.row);
+                e->row_container.install_cell(h.cell, &rb.value());
+                columns_put(e);
+                for (auto idx : indexes_)
+                    idx->nontrans_insert_entry(kb.key(), e->row_container.row, reinterpret_cast<uintptr_t>(e));
+                return;
+            }
+        }
+        nontrans_put(kb.key(), rb.value());
     }
 
     // TObject interface methods
@@ -1164,11 +2096,16 @@ public:
     }
 
     bool check(TransItem& item, Transaction& txn) override {
+        // snapshot reads of read-only transactions need no validation
+        if (DBParams::MVCC && txn.read_only_at_snapshot())
+            return true;
         if (is_internode(item)) {
             node_type *n = get_internode_address(item);
             auto curr_nv = static_cast<leaf_type *>(n)->full_version_value();
             auto read_nv = item.template read_value<decltype(curr_nv)>();
-            return (curr_nv == read_nv);
+            if (curr_nv == read_nv)
+                return true;
+            return track_ranges && check_ranges(txn);
         } else {
             auto key = item.key<item_key_t>();
             auto e = key.internal_elem_ptr();
@@ -1179,6 +2116,20 @@ public:
         }
     }
 
+    void prefetch(const TransItem& item) const override {
+        uintptr_t k = item.key<uintptr_t>();
+        if (k & internode_bit) {
+            ::prefetch(reinterpret_cast<const void *>(k & ~internode_bit));
+        } else {
+            auto key = item.key<item_key_t>();
+            auto e = key.internal_elem_ptr();
+            if (key.is_row_item())
+                ::prefetch(&e->version());
+            else
+                ::prefetch(&e->row_container.version_at(key.cell_num()));
+        }
+    }
+
     void install(TransItem& item, Transaction& txn) override {
         assert(!is_internode(item));
         auto key = item.key<item_key_t>();
@@ -1186,12 +2137,16 @@ public:
 
         if (key.is_row_item()) {
             //assert(e->version.is_locked());
+            if (DBParams::MVCC && !has_insert(item))
+                e->history.push(0, e->row_container.row, e->version().value(), txn.commit_tid());
             if (has_delete(item)) {
                 if (!has_insert(item)) {
                     assert(e->valid() && !e->deleted);
                     txn.set_version(e->version());
+                    fence();
                     e->deleted = true;
                     fence();
+                    columns_remove(e);
                 }
                 return;
             }
@@ -1210,6 +2165,9 @@ public:
                     } else {
                         copy_row(e, vptr);
                     }
+                } else if (has_row_cell(item) && DBParams::MVCC) {
+                    // every column is in cell 0
+                    copy_row(e, vptr);
                 } else if (has_row_cell(item)) {
                     // install only the difference part
                     // not sure if works when there are more than 1 minor version fields
@@ -1217,6 +2175,7 @@ public:
                     e->row_container.install_cell(0, vptr);
                 }
             }
+            columns_put(e);
 
             // like in the hashtable (unordered_index), no need for the hacks
             // treating opacity as a special case
@@ -1232,6 +2191,7 @@ public:
                     vptr = row_item.template raw_write_value<value_type *>();
 
                 e->row_container.install_cell(key.cell_num(), vptr);
+                columns_put(e);
             }
 
             txn.set_version_unlock(e->row_container.version_at(key.cell_num()), item);
@@ -1248,27 +2208,88 @@ public:
             e->row_container.version_at(key.cell_num()).cp_unlock(item);
     }
 
+    void log_redo(TransItem& item, TLogRecord& rec) override {
+        assert(!is_internode(item));
+        auto key = item.key<item_key_t>();
+        auto e = key.internal_elem_ptr();
+
+        if (key.is_row_item()) {
+            if (has_delete(item)) {
+                if (!has_insert(item))
+                    rec.remove(log_id_, e->key);
+                return;
+            }
+            if (has_insert(item)) {
+                log_put_row(rec, log_id_, e->key, e->row_container.row);
+                return;
+            }
+
+            value_type *vptr;
+            if (value_is_small)
+                vptr = &(item.write_value<value_type>());
+            else
+                vptr = item.write_value<value_type *>();
+
+            if (has_row_update(item))
+                log_put_row(rec, log_id_, e->key, *vptr);
+            else if (has_row_cell(item))
+                log_put_cell(rec, log_id_, 0, e->key, *vptr);
+        } else {
+            // row-level updates are logged in full by the row item
+            auto row_item = Sto::item(this, item_key_t::row_item_key(e));
+            if (!has_row_update(row_item)) {
+                value_type *vptr;
+                if (value_is_small)
+                    vptr = &(row_item.template raw_write_value<value_type>());
+                else
+                    vptr = row_item.template raw_write_value<value_type *>();
+                log_put_cell(rec, log_id_, key.cell_num(), e->key, *vptr);
+            }
+        }
+    }
+
     void cleanup(TransItem& item, bool committed) override {
         if (committed ? has_delete(item) : has_insert(item)) {
             auto key = item.key<item_key_t>();
             assert(key.is_row_item());
             internal_elem *e = key.internal_elem_ptr();
-            bool ok = _remove(e->key);
-            if (!ok) {
-                std::cout << committed << "," << has_delete(item) << "," << has_insert(item) << std::endl;
-                always_assert(false, "insert-bit exclusive ownership violated");
-            }
-            item.clear_needs_unlock();
+            // see unordered_index::cleanup
+            e->deleted = true;
+            fence();
+            retire(e);
+            // the row stays readable: unlock a deleted row's version
+            if (has_insert(item))
+                item.clear_needs_unlock();
         }
     }
 
 protected:
+    // counts down the rows a range_scan returns. Deleted rows stay in the
+    // tree until reclaimed, so masstree's own scan limit, which counts
+    // every key, could end a scan before it returned any row.
+    class scan_limit {
+    public:
+        explicit scan_limit(int limit) : left_(limit) {}
+
+        void count() {
+            if (left_ > 0)
+                --left_;
+        }
+        bool reached() const {
+            return left_ == 0;
+        }
+
+    private:
+        int left_;
+    };
+
     template <typename NodeCallback, typename ValueCallback, bool Reverse>
     class range_scanner {
     public:
-        range_scanner(const Str upper, NodeCallback ncb, ValueCallback vcb) :
+        range_scanner(const Str upper, NodeCallback ncb, ValueCallback vcb,
+                      const scan_limit& limit) :
             boundary_(upper), boundary_compar_(false), scan_succeeded_(true),
-            node_callback_(ncb), value_callback_(vcb) {}
+            node_callback_(ncb), value_callback_(vcb), limit_(limit) {}
 
         template <typename ITER, typename KEY>
         void check(const ITER& iter, const KEY& key) {
@@ -1312,7 +2333,7 @@ protected:
             } else {
                 if (!visited)
                     scan_succeeded_ = false;
-                return visited;
+                return visited && !limit_.reached();
             }
         }
 
@@ -1322,11 +2343,369 @@ protected:
 
         NodeCallback node_callback_;
         ValueCallback value_callback_;
+        const scan_limit& limit_;
+    };
+
+    class checkpoint_scanner {
+    public:
+        checkpoint_scanner(uint32_t log_id, checkpoint_writer& w)
+            : log_id_(log_id), writer_(w) {}
+
+        template <typename ITER>
+        void visit_leaf(const ITER&, const Masstree::key<uint64_t>&, threadinfo&) {}
+
+        bool visit_value(const Masstree::key<uint64_t>&, internal_elem *e, threadinfo&) {
+            if (e->valid() && !e->deleted)
+                writer_.put_row(log_id_, e->key, e->row_container.row);
+            return true;
+        }
+
+        uint32_t log_id_;
+        checkpoint_writer& writer_;
     };
 
 private:
     table_type table_;
     uint64_t key_gen_;
+    uint32_t log_id_;
+    std::vector<index_hook *> indexes_;
+    column_store_type *columns_;
+
+    // A new row gets its column slot when it is created; the slot turns
+    // live when the row's insert installs, and is dropped when its delete
+    // does. Every install stores the whole row.
+    void columns_add(internal_elem *e) {
+        if (column_layout)
+            e->set_slot(columns_->add());
+    }
+    void columns_put(internal_elem *e) {
+        if (column_layout) {
+            columns_->store(e->slot(), e->row_container.row);
+            columns_->set_live(e->slot(), true);
+        }
+    }
+    void columns_remove(internal_elem *e) {
+        if (column_layout)
+            columns_->set_live(e->slot(), false);
+    }
+
+    // bulk_loader's insert: skips nontrans_put's replace and index work
+    internal_elem *load_row(const key_type& k, const value_type& v) {
+        cursor_type lp(table_, k);
+        bool found = lp.find_insert(*ti);
+        always_assert(!found, "bulk loaded key is already present");
+        internal_elem *e = slab_pool::make<internal_elem>(k, v, true);
+        columns_add(e);
+        columns_put(e);
+        lp.value() = e;
+        lp.finish(1, *ti);
+        return e;
+    }
+
+    // Rows are not unlinked when their delete commits (or their insert
+    // aborts): cleanup marks them deleted and retires them to this thread's
+    // garbage list, and readers take a deleted row's key as absent until an
+    // insert replaces the row or reclaim unlinks it. A full list, one begun
+    // in an earlier epoch, or one of another table is handed to RCU, which
+    // runs reclaim on this thread once the epoch ends. Under MVCC a deleted
+    // row stays while a snapshot that predates the delete may still read it.
+    //
+    // Lists reach their table through its garbage_owner, which lives until
+    // the table and all its pending lists are gone; the rows of a destroyed
+    // table are freed without unlinking.
+    struct garbage_owner {
+        ordered_index *table;
+        int refs;
+    };
+    struct garbage_list {
+        garbage_owner *owner;
+        Transaction::epoch_type epoch;
+        int n;
+        internal_elem *rows[garbage_batch];
+
+        garbage_list(garbage_owner *o)
+            : owner(o), epoch(Transaction::global_epochs.global_epoch), n(0) {
+            fetch_and_add(&owner->refs, 1);
+        }
+    };
+    garbage_owner *owner_;
+    static __thread garbage_list *garbage_;
+
+    void retire(internal_elem *e) {
+        garbage_list *g = garbage_;
+        if (g && g->owner != owner_) {
+            flush_garbage();
+            g = nullptr;
+        }
+        if (!g)
+            g = garbage_ = slab_pool::make<garbage_list>(owner_);
+        g->rows[g->n] = e;
+        ++g->n;
+        if (g->n == garbage_batch || g->epoch != Transaction::global_epochs.global_epoch)
+            flush_garbage();
+    }
+
+    static void flush_garbage() {
+        garbage_list *g = garbage_;
+        garbage_ = nullptr;
+        Transaction::rcu_call(reclaim, g);
+    }
+
+    static void reclaim(void *arg) {
+        auto g = static_cast<garbage_list *>(arg);
+        ordered_index *table = g->owner->table;
+        if (table) {
+            // neighboring keys share the upper levels of their descents
+            std::sort(g->rows, g->rows + g->n, [] (internal_elem *a, internal_elem *b) {
+                return Str(a->key).compare(Str(b->key)) < 0;
+            });
+            for (int i = 0; i != g->n; ++i) {
+                internal_elem *e = g->rows[i];
+                if (DBParams::MVCC && e->valid()
+                    && mvcc_history<value_type>::tid(e->version().value())
+                       >= Transaction::global_epochs.min_snapshot_tid)
+                    table->retire(e);
+                else
+                    table->unlink(e);
+            }
+        } else {
+            for (int i = 0; i != g->n; ++i)
+                slab_pool::destroy(g->rows[i]);
+        }
+        release_owner(g->owner);
+        slab_pool::destroy(g);
+    }
+
+    static void release_owner(garbage_owner *o) {
+        if (fetch_and_add(&o->refs, -1) == 1)
+            delete o;
+    }
+
+    void unlink(internal_elem *e) {
+        cursor_type lp(table_, e->key);
+        // an insert may have replaced the row
+        if (lp.find_locked(*ti) && lp.value() == e)
+            lp.finish(-1, *ti);
+        else
+            lp.finish(0, *ti);
+        slab_pool::rcu_destroy(e);
+    }
+
+    // Phantom protection tracks the versions of the leaves a transaction
+    // read, but any insert into a leaf, or split of it, changes its version.
+    // So reads that track a leaf also record the key range they covered (one
+    // key for an absent row) and the rows they found there. When a leaf
+    // changed, check_ranges scans the transaction's ranges on the table
+    // again, and the transaction aborts only if some range gained or lost a
+    // row. A range's rows are summarized by their count and a sum of hashes
+    // of their addresses, which RCU keeps from being reused while the
+    // transaction runs; deleted rows count until they are unlinked, and the
+    // transaction's own inserts never count. Opaque transactions check
+    // leaves during execution and keep plain leaf versions.
+    struct range_rows {
+        int n;
+        uint64_t sum;
+
+        bool operator==(const range_rows& x) const {
+            return n == x.n && sum == x.sum;
+        }
+    };
+    struct read_range {
+        key_type lo;
+        key_type hi;
+        bool lo_inclusive;
+        bool hi_inclusive;
+        range_rows rows;
+        read_range *next;
+    };
+    // a transaction's ranges on the table, stashed in its range_set_key() item
+    struct read_range_set {
+        read_range *head;
+        int state;          // 0: not checked, 1: unchanged, -1: changed
+    };
+
+    // records the range a range_scan covers
+    class range_tracker {
+    public:
+        range_tracker(ordered_index *table, bool active, const key_type& begin,
+                      const key_type& end, bool reverse)
+            : table_(table), range_(nullptr), reverse_(reverse), last_(nullptr) {
+            if (track_ranges && active) {
+                if (reverse)
+                    range_ = table->add_read_range(end, false, begin, true);
+                else
+                    range_ = table->add_read_range(begin, true, end, false);
+            }
+        }
+
+        void visit(internal_elem *e) {
+            if (range_) {
+                table_->count_row(range_->rows, e);
+                last_ = e;
+            }
+        }
+
+        // a scan cut short by its limit covered the keys up to its last row
+        void finish(bool cut_short) {
+            if (range_ && cut_short) {
+                if (reverse_) {
+                    range_->lo = last_->key;
+                    range_->lo_inclusive = true;
+                } else {
+                    range_->hi = last_->key;
+                    range_->hi_inclusive = true;
+                }
+            }
+        }
+
+    private:
+        ordered_index *table_;
+        read_range *range_;
+        bool reverse_;
+        internal_elem *last_;
+    };
+
+    // counts the rows of a read_range again (see check_ranges)
+    class range_checker {
+    public:
+        range_checker(const ordered_index *table, const read_range& r)
+            : table_(table), range_(r), rows_{0, 0} {}
+
+        template <typename ITER>
+        void visit_leaf(const ITER&, const Masstree::key<uint64_t>&, threadinfo&) {}
+
+        bool visit_value(const Masstree::key<uint64_t>& key, internal_elem *e, threadinfo&) {
+            int cmp = key.full_string().compare(Str(range_.hi));
+            if (cmp > 0 || (cmp == 0 && !range_.hi_inclusive))
+                return false;
+            table_->count_row(rows_, e);
+            return true;
+        }
+
+        const ordered_index *table_;
+        const read_range& range_;
+        range_rows rows_;
+    };
+
+    uintptr_t range_set_key() const {
+        return reinterpret_cast<uintptr_t>(this) | internode_bit;
+    }
+
+    read_range *add_read_range(const key_type& lo, bool lo_inclusive,
+                               const key_type& hi, bool hi_inclusive) {
+        TransProxy item = Sto::item(this, range_set_key());
+        read_range_set *rs = item.template stash_value<read_range_set *>(nullptr);
+        if (!rs) {
+            rs = Sto::tx_alloc<read_range_set>();
+            rs->head = nullptr;
+            rs->state = 0;
+            item.set_stash(rs);
+        }
+        read_range *r = Sto::tx_alloc<read_range>();
+        new (r) read_range{lo, hi, lo_inclusive, hi_inclusive, range_rows{0, 0}, rs->head};
+        rs->head = r;
+        return r;
+    }
+
+    // tracks the absence of key at leaf node; e is the key's deleted row, if any
+    bool register_absent_key(node_type *node, nodeversion_value_type nv,
+                             const key_type& key, internal_elem *e) {
+        if (!register_internode_version(node, nv))
+            return false;
+        if (track_ranges) {
+            read_range *r = add_read_range(key, true, key, true);
+            if (e)
+                count_row(r->rows, e);
+        }
+        return true;
+    }
+
+    void count_row(range_rows& rows, internal_elem *e) const {
+        if (!e->valid()) {
+            auto item = Sto::check_item(this, item_key_t::row_item_key(e));
+            if (item && has_insert(item.get().item()))
+                return;
+        }
+        uint64_t h = reinterpret_cast<uintptr_t>(e);
+        h = (h ^ (h >> 33)) * 0xff51afd7ed558ccdULL;
+        h = (h ^ (h >> 33)) * 0xc4ceb9fe1a85ec53ULL;
+        ++rows.n;
+        rows.sum += h ^ (h >> 33);
+    }
+
+    // true if no range this transaction read on the table changed
+    bool check_ranges(Transaction& txn) {
+        auto item = txn.check_item(this, range_set_key());
+        read_range_set *rs = item ? item.get().template stash_value<read_range_set *>(nullptr) : nullptr;
+        if (!rs)
+            return false;
+        if (rs->state == 0) {
+            TXP_INCREMENT(txp_leaf_conflicts);
+            rs->state = 1;
+            for (read_range *r = rs->head; r && rs->state > 0; r = r->next) {
+                range_checker checker(this, *r);
+                table_.scan(r->lo, r->lo_inclusive, checker, -1, *ti);
+                if (!(checker.rows_ == r->rows))
+                    rs->state = -1;
+            }
+            if (rs->state > 0)
+                TXP_INCREMENT(txp_leaf_false_conflicts);
+        }
+        return rs->state > 0;
+    }
+
+    // inserts a new row at lp, which is locked on an empty slot or on a
+    // deleted row (replace)
+    ins_return_type insert_new(cursor_type& lp, const key_type& key, value_type *vptr, bool replace) {
+        auto e = slab_pool::make<internal_elem>(key, vptr ? *vptr : value_type(),
+                                                false /*!valid*/);
+        columns_add(e);
+        lp.value() = e;
+
+        node_type *node;
+        nodeversion_value_type orig_nv;
+        nodeversion_value_type new_nv;
+
+        bool split_right = (lp.node() != lp.original_node());
+        if (replace) {
+            // readers of the deleted row tracked the key's absence at the leaf
+            node = lp.node();
+            orig_nv = lp.previous_full_version_value();
+            node->mark_insert();
+            new_nv = lp.next_full_version_value(0);
+        } else if (split_right) {
+            node = lp.original_node();
+            orig_nv = lp.original_version_value();
+            new_nv = lp.updated_version_value();
+        } else {
+            node = lp.node();
+            orig_nv = lp.previous_full_version_value();
+            new_nv = lp.next_full_version_value(1);
+        }
+
+        fence();
+        lp.finish(replace ? 0 : 1, *ti);
+        //fence();
+
+        TransProxy row_item = Sto::item(this, item_key_t::row_item_key(e));
+        //if (value_is_small)
+        //    item.add_write<value_type>(*vptr);
+        //else
+        //    item.add_write<value_type *>(vptr);
+        row_item.add_write();
+        row_item.add_flags(insert_bit);
+
+        // update the node version already in the read set and modified by split
+        if (!update_internode_version(node, orig_nv, new_nv))
+            goto abort;
+        if (!indexes_insert(key, e->row_container.row, e))
+            goto abort;
+
+        return ins_return_type(true, false);
+
+    abort:
+        return ins_return_type(false, false);
+    }
 
     std::pair<bool, std::vector<TransProxy>>
     extract_item_list(const std::vector<cell_access_t>& cell_accesses, internal_elem *e) {
@@ -1361,6 +2740,153 @@ private:
         return true;
     }
 
+    // access_all without collecting the items
+    bool access_cells(const std::vector<cell_access_t>& cell_accesses, internal_elem *e) {
+        for (auto& access : cell_accesses) {
+            auto item = Sto::item(this, item_key_t(e, access.cell_id));
+            if (access.update) {
+                if (!version_adapter::select_for_update(item, e->row_container.version_at(access.cell_id)))
+                    return false;
+                if (item.item().template key<item_key_t>().is_row_item())
+                    item.item().add_flags(row_cell_bit);
+            } else {
+                if (!item.observe(e->row_container.version_at(access.cell_id)))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename Access>
+    bool select_rows_batched(const key_type *keys, int n, Access access, sel_return_type *results) {
+        for (int first = 0; first < n; first += select_batch) {
+            int count = std::min(n - first, int(select_batch));
+            if (!select_batch_rows(keys + first, count, access, results + first))
+                return false;
+        }
+        return true;
+    }
+    template <typename Access>
+    bool select_batch_rows(const key_type *keys, int n, Access access, sel_return_type *results) {
+        pin_snapshot();
+        // neighboring keys share the upper levels of their descents
+        int order[select_batch];
+        for (int i = 0; i != n; ++i)
+            order[i] = i;
+        std::sort(order, order + n, [keys] (int a, int b) {
+            return Str(keys[a]).compare(Str(keys[b])) < 0;
+        });
+
+        // found rows, and the leaves that track absent keys
+        internal_elem *elems[select_batch];
+        leaf_type *leaves[select_batch];
+        nodeversion_value_type leaf_versions[select_batch];
+        for (int j = 0; j != n; ++j) {
+            int i = order[j];
+            unlocked_cursor_type lp(table_, keys[i]);
+            if (lp.find_unlocked(*ti)) {
+                elems[i] = lp.value();
+                ::prefetch(&elems[i]->version());
+            } else
+                elems[i] = nullptr;
+            leaves[i] = lp.node();
+            leaf_versions[i] = lp.full_version_value();
+        }
+
+        for (int i = 0; i != n; ++i) {
+            if (elems[i]) {
+                results[i] = select_row(reinterpret_cast<uintptr_t>(elems[i]), access);
+                if (!std::get<0>(results[i]))
+                    return false;
+                if (std::get<1>(results[i]) || !elems[i]->deleted)
+                    continue;
+            }
+            if (!untracked(!any_update(access))
+                && !register_absent_key(leaves[i], leaf_versions[i], keys[i], elems[i]))
+                return false;
+            results[i] = sel_return_type(true, false, 0, nullptr);
+        }
+        return true;
+    }
+
+    // true if a read that can be served from a snapshot (snapshot_read)
+    // should not be tracked: the transaction is a read-only snapshot one
+    // Snapshot reads of rows a lookup found are consistent only if the
+    // snapshot was taken before the lookup: a row deleted, and its key
+    // inserted again, before a later snapshot would read as absent.
+    static void pin_snapshot() {
+        if (DBParams::MVCC)
+            Sto::transaction()->snapshot_tid();
+    }
+
+    static bool untracked(bool snapshot_read) {
+        return DBParams::MVCC && snapshot_read && Sto::transaction()->readonly_snapshot();
+    }
+
+    static const value_type *read_untracked(internal_elem *e) {
+        return mvcc_read_row(e->version(), e->row_container.row, e->deleted, e->history, invalid_bit);
+    }
+
+    sel_return_type select_untracked(internal_elem *e) {
+        const value_type *vptr = read_untracked(e);
+        if (!vptr)
+            return sel_return_type(true, false, 0, nullptr);
+        return sel_return_type(true, true, reinterpret_cast<uintptr_t>(e), vptr);
+    }
+
+    template <typename Callback>
+    static bool scan_untracked(const lcdf::Str& key, internal_elem *e, Callback& callback, bool& ret) {
+        const value_type *vptr = read_untracked(e);
+        ret = vptr ? callback(key_type(key), *vptr) : true;
+        return true;
+    }
+
+    bool observe_snapshot(TransProxy& row_item, internal_elem *e, const value_type *& vptr) {
+        TransactionTid::type seen;
+        vptr = mvcc_read_latest(e->version(), e->row_container.row, e->deleted, invalid_bit, seen);
+        // validated unless the transaction stays read-only at its snapshot
+        TMvccVersion seen_version(seen);
+        return row_item.observe(seen_version);
+    }
+
+    sel_return_type select_snapshot(TransProxy& row_item, internal_elem *e) {
+        const value_type *vptr;
+        if (!observe_snapshot(row_item, e, vptr))
+            return sel_return_type(false, false, 0, nullptr);
+        if (!vptr)
+            return sel_return_type(true, false, 0, nullptr);
+        return sel_return_type(true, true, reinterpret_cast<uintptr_t>(e), vptr);
+    }
+
+    // rows missing at the snapshot are skipped
+    template <typename Callback>
+    bool scan_snapshot(const lcdf::Str& key, TransProxy& row_item, internal_elem *e,
+                       Callback& callback, bool& ret) {
+        const value_type *vptr;
+        if (!observe_snapshot(row_item, e, vptr))
+            return false;
+        ret = vptr ? callback(key_type(key), *vptr) : true;
+        return true;
+    }
+
+    static bool any_update(const std::vector<cell_access_t>& cell_accesses) {
+        for (auto& ca : cell_accesses) {
+            if (ca.update)
+                return true;
+        }
+        return false;
+    }
+    static bool any_update(RowAccess access) {
+        return access == RowAccess::UpdateValue;
+    }
+    static bool any_update(std::initializer_list<column_access_t> accesses) {
+        for (auto& ca : accesses) {
+            if (ca.update)
+                return true;
+        }
+        return false;
+    }
+
     static bool has_insert(const TransItem& item) {
         return (item.flags() & insert_bit) != 0;
     }
@@ -1376,6 +2902,43 @@ private:
     static bool is_phantom(internal_elem *e, const TransItem& item) {
         return (!e->valid() && !has_insert(item));
     }
+    // a deleted row is absent, but a snapshot read sees the value it had
+    // if it was deleted after the snapshot
+    static bool is_absent(internal_elem *e, bool snapshot_read) {
+        return e->deleted && !(snapshot_read && e->valid());
+    }
+
+    // the row as this transaction sees it (before its pending write)
+    static const value_type& visible_row(TransProxy& row_item, internal_elem *e) {
+        if (has_insert(row_item) || !row_item.has_flag(row_value_bit))
+            return e->row_container.row;
+        if (value_is_small)
+            return row_item.template raw_write_value<value_type>();
+        return *row_item.template raw_write_value<value_type *>();
+    }
+
+    bool indexes_insert(const key_type& k, const value_type& v, internal_elem *e) {
+        for (auto idx : indexes_)
+            if (!idx->insert_entry(k, v, reinterpret_cast<uintptr_t>(e)))
+                return false;
+        return true;
+    }
+    bool indexes_update(TransProxy& row_item, internal_elem *e, const value_type& new_row) {
+        const value_type& old_row = visible_row(row_item, e);
+        for (auto idx : indexes_)
+            if (!idx->update_entry(e->key, old_row, new_row, reinterpret_cast<uintptr_t>(e)))
+                return false;
+        return true;
+    }
+    bool indexes_delete(TransProxy& row_item, internal_elem *e) {
+        if (indexes_.empty())
+            return true;
+        const value_type& row = visible_row(row_item, e);
+        for (auto idx : indexes_)
+            if (!idx->delete_entry(e->key, row))
+                return false;
+        return true;
+    }
 
     bool register_internode_version(node_type *node, nodeversion_value_type nodeversion) {
         TransProxy item = Sto::item(this, get_internode_key(node));
@@ -1394,7 +2957,8 @@ private:
             item.update_read(prev_nv, new_nv);
             return true;
         }
-        return false;
+        // the leaf changed since the read: check_ranges decides at commit
+        return track_ranges;
     }
 
     bool _remove(const key_type& key) {
@@ -1403,7 +2967,11 @@ private:
         if (found) {
             internal_elem *el = lp.value();
             lp.finish(-1, *ti);
-            Transaction::rcu_delete(el);
+            // deleted rows belong to a garbage list
+            if (!el->deleted) {
+                columns_remove(el);
+                slab_pool::rcu_destroy(el);
+            }
         } else {
             // XXX is this correct?
             lp.finish(0, *ti);
@@ -1433,4 +3001,105 @@ template <typename K, typename V, typename DBParams>
 __thread typename ordered_index<K, V, DBParams>::table_params::threadinfo_type
 *ordered_index<K, V, DBParams>::ti;
 
+template <typename K, typename V, typename DBParams>
+__thread typename ordered_index<K, V, DBParams>::garbage_list
+*ordered_index<K, V, DBParams>::garbage_;
+
+// A secondary index on the ordered_index Base, maintained by the writes to
+// Base in the same transaction. Extract()(k, v) returns the index key of
+// base row (k, v); index keys must be unique (append the base key to a
+// non-unique attribute). Each entry holds the rid of its base row, so a
+// lookup is one descent of the index plus Base::select_row(rid).
+// The index is neither logged nor checkpointed: recovering Base rebuilds it.
+template <typename IK, typename Base, typename Extract>
+class secondary_index : public ordered_index<IK, index_entry_row, typename Base::db_params>,
+                        public Base::index_hook {
+public:
+    typedef ordered_index<IK, index_entry_row, typename Base::db_params> index_type;
+    typedef typename Base::key_type base_key_type;
+    typedef typename Base::value_type base_value_type;
+
+    explicit secondary_index(Base& base)
+        : base_(base) {
+        base.add_index(this);
+    }
+
+    Base& base() {
+        return base_;
+    }
+
+    // selects the base row with index key ik
+    typename Base::sel_return_type select_base_row(const IK& ik, RowAccess access) {
+        uintptr_t rid;
+        if (!lookup(ik, rid))
+            return typename Base::sel_return_type(false, false, 0, nullptr);
+        if (!rid)
+            return typename Base::sel_return_type(true, false, 0, nullptr);
+        return base_.select_row(rid, access);
+    }
+    typename Base::sel_return_type
+    select_base_row(const IK& ik, std::initializer_list<typename Base::column_access_t> accesses) {
+        uintptr_t rid;
+        if (!lookup(ik, rid))
+            return typename Base::sel_return_type(false, false, 0, nullptr);
+        if (!rid)
+            return typename Base::sel_return_type(true, false, 0, nullptr);
+        return base_.select_row(rid, accesses);
+    }
+
+    bool insert_entry(const base_key_type& k, const base_value_type& v, uintptr_t rid) override {
+        index_entry_row entry{rid};
+        bool success, found;
+        std::tie(success, found) = this->insert_row(Extract()(k, v), &entry);
+        return success && !found;
+    }
+    bool update_entry(const base_key_type& k, const base_value_type& old_v,
+                      const base_value_type& new_v, uintptr_t rid) override {
+        IK old_ik = Extract()(k, old_v);
+        IK new_ik = Extract()(k, new_v);
+        if (lcdf::Str(old_ik) == lcdf::Str(new_ik))
+            return true;
+        return delete_entry(k, old_v) && insert_entry(k, new_v, rid);
+    }
+    bool delete_entry(const base_key_type& k, const base_value_type& v) override {
+        bool success;
+        std::tie(success, std::ignore) = this->delete_row(Extract()(k, v));
+        return success;
+    }
+    void nontrans_insert_entry(const base_key_type& k, const base_value_type& v, uintptr_t rid) override {
+        this->nontrans_put(Extract()(k, v), index_entry_row{rid});
+    }
+    void nontrans_remove_entry(const base_key_type& k, const base_value_type& v) override {
+        this->nontrans_remove(Extract()(k, v));
+    }
+    void nontrans_load_entries(const std::vector<uintptr_t>& rids) override {
+        std::vector<std::pair<IK, uintptr_t>> entries;
+        entries.reserve(rids.size());
+        for (uintptr_t rid : rids)
+            entries.emplace_back(Extract()(Base::row_key(rid), Base::nontrans_row(rid)), rid);
+        std::sort(entries.begin(), entries.end(), [] (const std::pair<IK, uintptr_t>& a,
+                                                      const std::pair<IK, uintptr_t>& b) {
+            return lcdf::Str(a.first).compare(lcdf::Str(b.first)) < 0;
+        });
+        typename index_type::bulk_loader loader(*this);
+        for (auto& entry : entries)
+            loader.add(entry.first, index_entry_row{entry.second});
+    }
+
+    void log_redo(TransItem&, TLogRecord&) override {
+    }
+
+private:
+    Base& base_;
+
+    // rid is 0 if ik is absent; false if the lookup must abort
+    bool lookup(const IK& ik, uintptr_t& rid) {
+        bool success, found;
+        const index_entry_row *entry;
+        std::tie(success, found, std::ignore, entry) = this->select_row(ik, RowAccess::ObserveExists);
+        rid = success && found ? entry->rid : 0;
+        return success;
+    }
+};
+
 }; // namespace bench
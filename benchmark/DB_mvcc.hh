@@ -0,0 +1,223 @@
+#pragma once
+
+#include "compiler.hh"
+#include "Transaction.hh"
+#include "DB_alloc.hh"
+
+#include <type_traits>
+
+// Multi-version storage for the benchmark tables (DBParams::MVCC).
+//
+// A record keeps its latest committed value in place, guarded by its
+// TMvccVersion, plus a history of the values it replaced, newest first. A
+// writer pushes the old value while it holds the record's lock, before the
+// overwrite. Each node records the commit TID of the old value (tid) and of
+// the write that replaced it (replaced_tid); a transaction with snapshot S
+// (Transaction::snapshot_tid()) sees the node iff tid < S <= replaced_tid.
+// Snapshots fall on epoch boundaries (see Transaction::assign_commit_tid),
+// and only read-only snapshot transactions read the history; transactions
+// that may write read the latest values. No running snapshot is older than
+// global_epochs.min_snapshot_tid, so nodes replaced before it are trimmed
+// from the tail on the next write and reclaimed through RCU.
+//
+// A record whose value is split into cells under one lock (ycsb_value) keeps
+// one history for all of them; each node names its cell.
+
+namespace bench {
+
+template <typename T>
+class mvcc_history {
+public:
+    typedef TransactionTid::type tid_type;
+
+    struct node {
+        tid_type tid;
+        tid_type replaced_tid;
+        node *older;
+        node *newer;
+        int cell;
+        T value;
+
+        node(int c, const T& v, tid_type t, tid_type rt)
+            : tid(t), replaced_tid(rt), older(nullptr), newer(nullptr), cell(c), value(v) {}
+    };
+
+    mvcc_history() : head_(nullptr), tail_(nullptr) {}
+    // the history stays with the record; copies of the value start empty
+    mvcc_history(const mvcc_history&) : head_(nullptr), tail_(nullptr) {}
+    mvcc_history& operator=(const mvcc_history&) {
+        return *this;
+    }
+    ~mvcc_history() {
+        while (head_) {
+            node *n = head_;
+            head_ = n->older;
+            slab_pool::destroy(n);
+        }
+    }
+
+    static tid_type tid(tid_type version) {
+        return version & ~(TransactionTid::increment_value - 1);
+    }
+
+    // Called by the lock holder before it overwrites the value of cell, last
+    // written at old_version, in a commit with TID new_tid.
+    void push(int cell, const T& value, tid_type old_version, tid_type new_tid) {
+        trim(Transaction::global_epochs.min_snapshot_tid);
+        node *n = slab_pool::make<node>(cell, value, tid(old_version), tid(new_tid));
+        n->older = head_;
+        if (head_)
+            head_->newer = n;
+        else
+            tail_ = n;
+        release_fence();
+        head_ = n;
+    }
+
+    // Returns the value cell had at snapshot if it has been overwritten
+    // since, nullptr otherwise.
+    const node *find(int cell, tid_type snapshot) const {
+        const node *found = nullptr;
+        const node *n = head_;
+        acquire_fence();
+        for (; n && n->replaced_tid >= snapshot; n = n->older) {
+            if (n->cell == cell)
+                found = n;
+        }
+        return found;
+    }
+
+private:
+    node *head_;
+    node *tail_;
+
+    // nodes are ordered by replaced_tid, so the unneeded ones form a suffix
+    void trim(tid_type min_snapshot) {
+        node *n = tail_;
+        while (n && n->replaced_tid < min_snapshot)
+            n = n->newer;
+        node *cut = n ? n->older : head_;
+        if (!cut)
+            return;
+        if (n)
+            n->older = nullptr;
+        else
+            head_ = nullptr;
+        tail_ = n;
+        while (cut) {
+            node *older = cut->older;
+            slab_pool::rcu_destroy(cut);
+            cut = older;
+        }
+    }
+};
+
+// Stand-in for mvcc_history in tables that are not multi-versioned.
+template <typename T>
+class mvcc_no_history {
+public:
+    typedef TransactionTid::type tid_type;
+    typedef typename mvcc_history<T>::node node;
+
+    void push(int, const T&, tid_type, tid_type) {
+        always_assert(false, "table is not multi-versioned");
+    }
+    const node *find(int, tid_type) const {
+        return nullptr;
+    }
+};
+
+template <typename T, typename DBParams>
+struct get_mvcc_history {
+    typedef typename std::conditional<DBParams::MVCC, mvcc_history<T>, mvcc_no_history<T>>::type type;
+};
+
+// Reads a row at the snapshot of a read-only snapshot transaction
+// (Transaction::start_readonly_snapshot). The row's value is guarded by
+// vers; a deleting commit sets deleted after installing its version, and
+// rows whose insert has not committed carry invalid_bit. Returns the
+// visible value (a transaction-private copy of the latest value, or a
+// history node), or nullptr if the row does not exist at the snapshot.
+//
+// An ordered_index keeps deleted rows until no snapshot predates the
+// delete, but a key deleted and inserted again after the snapshot reads as
+// absent; rows removed from an unordered_index are missed.
+template <typename T, typename Version, typename History>
+const T *mvcc_read_row(const Version& vers, const T& value, const bool& deleted,
+                       const History& history, TransactionTid::type invalid_bit) {
+    typedef TransactionTid::type tid_type;
+    tid_type snapshot = Sto::transaction()->snapshot_tid();
+    while (true) {
+        // a deleting commit installs its version before it sets deleted
+        // and unlocks after: a row seen deleted is read at that version
+        tid_type v = vers.value();
+        acquire_fence();
+        bool del = deleted;
+        if (del) {
+            acquire_fence();
+            v = vers.value();
+        }
+        if (TransactionTid::is_locked(v) && !del) {
+            // a commit may be installing a TID below our snapshot
+            relax_fence();
+            continue;
+        }
+        if (v & invalid_bit)
+            return nullptr;
+        if (mvcc_history<T>::tid(v) < snapshot) {
+            if (del)
+                return nullptr;
+            T *copy = Sto::tx_alloc(&value);
+            acquire_fence();
+            if (vers.value() != v)
+                continue;
+            return copy;
+        }
+        // no history means the row was inserted after the snapshot
+        auto n = history.find(0, snapshot);
+        if (n && n->tid < snapshot)
+            return &n->value;
+        return nullptr;
+    }
+}
+
+// Reads the latest committed value of a row for a transaction that may
+// write. seen is set to the version the read validates against. The
+// transaction's reads stay consistent with its snapshot (and need no
+// validation if it ends up writing nothing) as long as they only return
+// values committed before it; a newer value marks the transaction as past
+// its snapshot.
+template <typename T, typename Version>
+const T *mvcc_read_latest(const Version& vers, const T& value, const bool& deleted,
+                          TransactionTid::type invalid_bit, TransactionTid::type& seen) {
+    typedef TransactionTid::type tid_type;
+    Transaction *txn = Sto::transaction();
+    tid_type snapshot = txn->snapshot_tid();
+    while (true) {
+        // see mvcc_read_row
+        tid_type v = vers.value();
+        acquire_fence();
+        bool del = deleted;
+        if (del) {
+            acquire_fence();
+            v = vers.value();
+        }
+        if (TransactionTid::is_locked(v) && !del) {
+            relax_fence();
+            continue;
+        }
+        T *copy = nullptr;
+        if (!del && !(v & invalid_bit)) {
+            copy = Sto::tx_alloc(&value);
+            acquire_fence();
+            if (vers.value() != v)
+                continue;
+        }
+        if (mvcc_history<T>::tid(v) >= snapshot)
+            txn->read_past_snapshot();
+        seen = v;
+        return copy;
+    }
+}
+
+}; // namespace bench
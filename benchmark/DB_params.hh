@@ -3,10 +3,10 @@
 namespace db_params {
 
 // Benchmark parameters
-constexpr const char *db_params_id_names[] = {"none", "default", "opaque", "2pl", "adaptive", "swiss", "tictoc"};
+constexpr const char *db_params_id_names[] = {"none", "default", "opaque", "2pl", "adaptive", "swiss", "tictoc", "mvcc"};
 
 enum class db_params_id : int {
-    None = 0, Default, Opaque, TwoPL, Adaptive, Swiss, TicToc
+    None = 0, Default, Opaque, TwoPL, Adaptive, Swiss, TicToc, MVCC
 };
 
 inline std::ostream &operator<<(std::ostream &os, const db_params_id &id) {
@@ -17,7 +17,7 @@ inline std::ostream &operator<<(std::ostream &os, const db_params_id &id) {
 inline db_params_id parse_dbid(const char *id_string) {
     if (id_string == nullptr)
         return db_params_id::None;
-    for (size_t i = 0; i < sizeof(db_params_id_names); ++i) {
+    for (size_t i = 0; i < sizeof(db_params_id_names) / sizeof(db_params_id_names[0]); ++i) {
         if (strcmp(id_string, db_params_id_names[i]) == 0) {
             auto selected = static_cast<db_params_id>(i);
             std::cout << "Selected \"" << selected << "\" as DB concurrency control." << std::endl;
@@ -36,6 +36,7 @@ public:
     static constexpr bool Opaque = false;
     static constexpr bool Swiss = false;
     static constexpr bool TicToc = false;
+    static constexpr bool MVCC = false;
 };
 
 class db_opaque_params : public db_default_params {
@@ -68,6 +69,12 @@ public:
     static constexpr bool TicToc = true;
 };
 
+class db_mvcc_params : public db_default_params {
+public:
+    static constexpr db_params_id Id = db_params_id::MVCC;
+    static constexpr bool MVCC = true;
+};
+
 class constants {
 public:
     static constexpr double million = 1000000.0;
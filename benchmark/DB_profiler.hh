@@ -3,6 +3,7 @@
 #include "SystemProfiler.hh"
 #include "Transaction.hh"
 #include "DB_params.hh"
+#include "DB_alloc.hh"
 
 namespace bench {
 
@@ -38,6 +39,7 @@ public:
 
         // print STO stats
         Transaction::print_stats();
+        slab_pool::print_stats(std::cout);
     }
 
 private:
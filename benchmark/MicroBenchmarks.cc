@@ -24,7 +24,9 @@ enum {
     opt_perf,
     opt_dump,
     opt_gran,
-    opt_insm
+    opt_insm,
+    opt_cscale,
+    opt_cm
 };
 
 static const Clp_Option options[] = {
@@ -42,7 +44,9 @@ static const Clp_Option options[] = {
     { "perf",        'p', opt_perf,   Clp_NoVal,       Clp_Negate | Clp_Optional },
     { "dump",        'd', opt_dump,   Clp_NoVal,       Clp_Negate | Clp_Optional },
     { "granule",     'g', opt_gran,   Clp_ValUnsigned, Clp_Optional },
-    { "measure",     'm', opt_insm,   Clp_NoVal,       Clp_Negate | Clp_Optional }
+    { "measure",     'm', opt_insm,   Clp_NoVal,       Clp_Negate | Clp_Optional },
+    { "commitscale", 'c', opt_cscale, Clp_NoVal,       Clp_Negate | Clp_Optional },
+    { "cm",          'C', opt_cm,     Clp_ValString,   Clp_Optional }
 };
 
 inline void print_usage(const char *prog) {
@@ -64,7 +68,11 @@ inline void print_usage(const char *prog) {
        << "  --perf (-p), spawn perf profiler after the benchmark starts executing, default off" << std::endl
        << "  --dump (-d), dump the trace of all generated transactions (not functional for now)" << std::endl
        << "  --granule (-g) select the granularity of concurrency control" << std::endl
-       << "  --measure (-m), enable instantaneous measurements of throughput and optimistic read rates, default off" << std::endl;
+       << "  --measure (-m), enable instantaneous measurements of throughput and optimistic read rates, default off" << std::endl
+       << "  --commitscale (-c), measure commit throughput of non-conflicting transactions at 1, 2, 4, ..." << std::endl
+       << "      up to nthreads threads, with and without a shared commit counter, default off" << std::endl
+       << "  --cm=STRING (-C), contention management policy. Accepted options are:" << std::endl
+       << "      timestamp (default), greedy, karma, polka, wound_wait, backoff" << std::endl;
 
     std::cout << ss.str() << std::flush;
 }
@@ -147,6 +155,7 @@ int main(int argc, const char *argv[]) {
     params.profiler = false;
     params.granules = 1;
     params.ins_measure = false;
+    params.commit_scaling = false;
 
     Clp_Parser *clp = Clp_NewParser(argc, argv, arraysize(options), options);
 
@@ -208,6 +217,14 @@ int main(int argc, const char *argv[]) {
             case opt_insm:
                 params.ins_measure = !clp->negated;
                 break;
+            case opt_cscale:
+                params.commit_scaling = !clp->negated;
+                break;
+            case opt_cm: {
+                ContentionManager::policy_type policy;
+                always_assert(ContentionManager::parse_policy(clp->val.s, policy), "invalid contention manager");
+                ContentionManager::set_policy(policy);}
+                break;
             default:
                 print_usage(argv[0]);
                 ret = 1;
@@ -223,12 +240,22 @@ int main(int argc, const char *argv[]) {
     if (ret != 0)
         return ret;
 
+    if (int(params.nthreads) > TThread::max_threads())
+        TThread::set_max_threads(params.nthreads);
+
     auto freq = determine_cpu_freq();
     if (freq == 0.0)
         return 1;
     tpcc::constants::processor_tsc_frequency = freq;
     params.proc_frequency_hz = (uint64_t)(freq * tpcc::constants::billion);
 
+    if (params.commit_scaling) {
+        ubench::CommitScalingTester t;
+        t.execute();
+        Transaction::print_stats();
+        return 0;
+    }
+
     always_assert(params.datatype == ubench::DsType::masstree, "Only Masstree is currently supported");
 
     switch (params.granules) {
@@ -13,6 +13,7 @@
 #include "DB_params.hh"
 
 #include "Micro_structs.hh"
+#include "TBox.hh"
 
 #include "sampling.hh"
 #include "PlatformFeatures.hh"
@@ -54,6 +55,7 @@ struct UBenchParams {
     bool profiler;
     uint32_t granules;
     bool ins_measure;
+    bool commit_scaling;
 };
 
 inline std::ostream& operator<<(std::ostream& os, const UBenchParams& p) {
@@ -455,5 +457,79 @@ using MtZipfTesterDefault = TesterSelector<DsType::masstree, WLZipfRW<wl_default
 template <int G, typename DBParams>
 using MtZipfTesterMeasure = TesterSelector<DsType::masstree, WLZipfRW<wl_measurement_params<G>>, DBParams>;
 
+// Measures how commit throughput scales with the number of threads. Each
+// thread repeatedly increments its own TBox, so transactions never conflict
+// and the only shared state on the commit path is whatever the commit
+// protocol itself touches. Every thread count is run twice: once as is, and
+// once with a fetch-and-add on a shared counter in each transaction, which
+// is what assigning commit TIDs from a global counter costs.
+class CommitScalingTester {
+public:
+    CommitScalingTester() : counter_() {}
+
+    void execute() {
+        std::vector<uint32_t> counts;
+        for (uint32_t n = 1; n < params.nthreads; n *= 2)
+            counts.push_back(n);
+        counts.push_back(params.nthreads);
+
+        pthread_t advancer;
+        pthread_create(&advancer, NULL, Transaction::epoch_advancer, NULL);
+        pthread_detach(advancer);
+
+        std::cout << "threads  per-thread-tid(txns/s)  shared-counter(txns/s)" << std::endl;
+        for (auto n : counts) {
+            double local = run(n, false);
+            double shared = run(n, true);
+            std::cout << n << "  " << (uint64_t)local << "  " << (uint64_t)shared << std::endl;
+        }
+        Transaction::global_epochs.run = false;
+    }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) shared_counter {
+        uint64_t value;
+    };
+    shared_counter counter_;
+
+    double run(uint32_t nthreads, bool shared) {
+        std::vector<std::thread> thread_pool;
+        std::vector<uint64_t> txn_cnts(nthreads, 0);
+        uint64_t start_tsc = read_tsc();
+        for (auto i = 0u; i < nthreads; ++i)
+            thread_pool.emplace_back(&CommitScalingTester::run_thread, this,
+                                     (int)i, shared, start_tsc, std::ref(txn_cnts[i]));
+        uint64_t total_txns = 0;
+        for (auto i = 0u; i < nthreads; ++i) {
+            thread_pool[i].join();
+            total_txns += txn_cnts[i];
+        }
+        return total_txns / params.time_limit;
+    }
+
+    void run_thread(int thread_id, bool shared, uint64_t start_tsc, uint64_t& txn_cnt) {
+        TThread::set_id(thread_id);
+        set_affinity(thread_id);
+
+        uint64_t ticks_to_wait = (uint64_t)(params.time_limit * (double)(params.proc_frequency_hz));
+        // allocated by this thread, away from the other threads' boxes
+        TBox<int64_t> *box = new TBox<int64_t>(0);
+        uint64_t local_txn_cnt = 0;
+        while (read_tsc() - start_tsc < ticks_to_wait) {
+            for (int i = 0; i < 64; ++i) {
+                TRANSACTION {
+                    if (shared)
+                        fetch_and_add(&counter_.value, TransactionTid::increment_value);
+                    *box = *box + 1;
+                } RETRY(true);
+            }
+            local_txn_cnt += 64;
+        }
+        Transaction::rcu_quiesce();
+        delete box;
+        txn_cnt = local_txn_cnt;
+    }
+};
+
 };
 
@@ -60,6 +60,9 @@ int main(int argc, const char * const *argv) {
     if (ret_code != 0)
         return ret_code;
 
+    if (p.num_threads > TThread::max_threads())
+        TThread::set_max_threads(p.num_threads);
+
     auto freq = determine_cpu_freq();
     if (freq ==  0.0)
         return -1;
@@ -135,7 +135,7 @@ private:
 
     int num_runners;
     uint64_t tsc_elapse_limit;
-    predicate_db<DBParams, DBRow> db;
+    predicate_db<DBParams, DBRow>& db;
 };
 
 };
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <algorithm>
 #include <thread>
+#include <chrono>
 
 #include "TPCC_bench.hh"
 #include "TPCC_txns.hh"
@@ -19,24 +20,59 @@ const char *tpcc_input_generator::last_names[] = {
         "BAR", "OUGHT", "ABLE", "PRI", "PRES",
         "ESE", "ANTI", "CALLY", "ATION", "EING"};
 
+bool tpcc_txn_mix::parse(const char *s) {
+    uint64_t p[num_types];
+    uint64_t sum = 0;
+    for (int t = 0; t < num_types; ++t) {
+        char *end;
+        if (!s || !isdigit((unsigned char) *s))
+            return false;
+        p[t] = strtoul(s, &end, 10);
+        if (*end != (t == num_types - 1 ? '\0' : ','))
+            return false;
+        sum += p[t];
+        s = end + 1;
+    }
+    if (sum != 100)
+        return false;
+    std::copy(p, p + num_types, pct);
+    return true;
+}
+
+void tpcc_txn_stats::print(std::ostream& os, double seconds) const {
+    for (int t = 0; t < tpcc_txn_mix::num_types; ++t) {
+        os << std::left << std::setw(14) << tpcc_txn_mix::name(t) << std::right
+           << std::setw(10) << commits[t] << " commits, "
+           << std::fixed << std::setprecision(1) << commits[t] / seconds << " txns/sec, "
+           << aborts[t] << " aborts" << std::endl;
+        os.unsetf(std::ios::floatfield);
+    }
+}
+
 template <typename DBParams>
 tpcc_db<DBParams>::tpcc_db(int num_whs) : oid_gen_() {
     //constexpr size_t num_districts = NUM_DISTRICTS_PER_WAREHOUSE;
     //constexpr size_t num_customers = NUM_CUSTOMERS_PER_DISTRICT * NUM_DISTRICTS_PER_WAREHOUSE;
 
     tbl_its_ = new it_table_type(999983/*NUM_ITEMS * 2*/);
+    // the secondary indexes refer to their base tables, which must not move
+    tbl_cus_.reserve(num_whs);
+    tbl_ods_.reserve(num_whs);
+    tbl_cni_.reserve(num_whs);
+    tbl_oci_.reserve(num_whs);
     for (auto i = 0; i < num_whs; ++i) {
         tbl_whs_.emplace_back();
         tbl_dts_.emplace_back(999983/*num_districts * 2*/);
-        tbl_cni_.emplace_back(999983/*num_customers * 2*/);
         tbl_cus_.emplace_back(999983/*num_customers * 2*/);
-        tbl_oci_.emplace_back(999983/*num_customers * 2*/);
+        tbl_cni_.emplace_back(tbl_cus_.back());
         tbl_ods_.emplace_back(999983/*num_customers * 10 * 2*/);
+        tbl_oci_.emplace_back(tbl_ods_.back());
         tbl_ols_.emplace_back(999983/*num_customers * 100 * 2*/);
         tbl_nos_.emplace_back(999983/*num_customers * 10 * 2*/);
         tbl_sts_.emplace_back(999983/*NUM_ITEMS * 2*/);
         tbl_hts_.emplace_back(999983/*num_customers * 2*/);
     }
+    wh_log_id_ = Logger::next_log_id();
 }
 
 template <typename DBParams>
@@ -67,9 +103,62 @@ void tpcc_db<DBParams>::thread_init_all() {
         t.thread_init();
 }
 
+template <typename DBParams>
+void tpcc_db<DBParams>::register_checkpoint(bench::db_checkpointer& ckp) {
+    ckp.set_thread_init([this] () { thread_init_all(); });
+
+    // warehouse rows are kept in a vector; ytd is checkpointed by its box
+    ckp.add_table(wh_log_id_,
+        [] (int) { return 1; },
+        [this] (int, int, bench::checkpoint_writer& w) {
+            for (uint64_t wid = 1; wid <= tbl_whs_.size(); ++wid)
+                w.put_row(wh_log_id_, wid, get_warehouse(wid).cv);
+        },
+        [this] (const TLogEntryHeader&, const char *key, const char *val) {
+            bench::key_buffer<uint64_t> kb(key);
+            bench::row_codec<warehouse_const_value>::decode(val, get_warehouse(kb.key()).cv);
+        });
+    for (auto& wv : tbl_whs_)
+        ckp.add_table(wv.ytd);
+
+    ckp.add_table(*tbl_its_);
+    // the secondary indexes are rebuilt by recovering their base tables
+    for (auto& t : tbl_dts_)
+        ckp.add_table(t);
+    for (auto& t : tbl_cus_)
+        ckp.add_table(t);
+    for (auto& t : tbl_ods_)
+        ckp.add_table(t);
+    for (auto& t : tbl_ols_)
+        ckp.add_table(t);
+    for (auto& t : tbl_nos_)
+        ckp.add_table(t);
+    for (auto& t : tbl_sts_)
+        ckp.add_table(t);
+    for (auto& t : tbl_hts_)
+        ckp.add_table(t);
+}
+
+template <typename DBParams>
+void tpcc_db<DBParams>::recovery_fixup() {
+    for (uint64_t wid = 1; wid <= (uint64_t)num_warehouses(); ++wid) {
+        for (uint64_t did = 1; did <= NUM_DISTRICTS_PER_WAREHOUSE; ++did) {
+            uint64_t oid = 1;
+            while (tbl_orders(wid).nontrans_get(order_key(wid, did, oid)))
+                ++oid;
+            oid_gen_.set_next(wid, did, oid);
+        }
+        uint64_t hid = 0;
+        while (tbl_histories(wid).nontrans_get(history_key(hid)))
+            ++hid;
+        tbl_histories(wid).set_key_gen(hid);
+    }
+}
+
 // @section: db prepopulation functions
 template<typename DBParams>
 void tpcc_prepopulator<DBParams>::fill_items(uint64_t iid_begin, uint64_t iid_xend) {
+    typename tpcc_db<DBParams>::it_table_type::bulk_loader items(db.tbl_items());
     for (auto iid = iid_begin; iid < iid_xend; ++iid) {
         item_key ik(iid);
         item_value iv;
@@ -85,7 +174,7 @@ void tpcc_prepopulator<DBParams>::fill_items(uint64_t iid_begin, uint64_t iid_xe
             (void)placed;
         }
 
-        db.tbl_items().nontrans_put(ik, iv);
+        items.add(ik, iv);
     }
 }
 
@@ -107,6 +196,7 @@ void tpcc_prepopulator<DBParams>::fill_warehouses() {
 
 template<typename DBParams>
 void tpcc_prepopulator<DBParams>::expand_warehouse(uint64_t wid) {
+    typename tpcc_db<DBParams>::st_table_type::bulk_loader stocks(db.tbl_stocks(wid));
     for (uint64_t iid = 1; iid <= NUM_ITEMS; ++iid) {
         stock_key sk(wid, iid);
         stock_value sv;
@@ -125,9 +215,10 @@ void tpcc_prepopulator<DBParams>::expand_warehouse(uint64_t wid) {
             (void)placed;
         }
 
-        db.tbl_stocks(wid).nontrans_put(sk, sv);
+        stocks.add(sk, sv);
     }
 
+    typename tpcc_db<DBParams>::dt_table_type::bulk_loader districts(db.tbl_districts(wid));
     for (uint64_t did = 1; did <= NUM_DISTRICTS_PER_WAREHOUSE; ++did) {
         district_key dk(wid, did);
         district_value dv;
@@ -142,13 +233,13 @@ void tpcc_prepopulator<DBParams>::expand_warehouse(uint64_t wid) {
         dv.d_ytd = 3000000;
         //dv.d_next_o_id = 3001;
 
-        db.tbl_districts(wid).nontrans_put(dk, dv);
-
+        districts.add(dk, dv);
     }
 }
 
 template<typename DBParams>
 void tpcc_prepopulator<DBParams>::expand_districts(uint64_t wid) {
+    typename tpcc_db<DBParams>::cu_table_type::bulk_loader customers(db.tbl_customers(wid));
     for (uint64_t did = 1; did <= NUM_DISTRICTS_PER_WAREHOUSE; ++did) {
         for (uint64_t cid = 1; cid <= NUM_CUSTOMERS_PER_DISTRICT; ++cid) {
             customer_key ck(wid, did, cid);
@@ -174,18 +265,15 @@ void tpcc_prepopulator<DBParams>::expand_districts(uint64_t wid) {
             cv.c_delivery_cnt = 0;
             cv.c_data = random_a_string(300, 500);
 
-            db.tbl_customers(wid).nontrans_put(ck, cv);
-
-            customer_idx_key cik(wid, did, cv.c_last, cv.c_first);
-            customer_idx_value civ(cid);
-
-            db.tbl_customer_index(wid).nontrans_put(cik, civ);
+            // the customer index is loaded when the loader finishes
+            customers.add(ck, cv);
         }
     }
 }
 
 template<typename DBParams>
 void tpcc_prepopulator<DBParams>::expand_customers(uint64_t wid) {
+    typename tpcc_db<DBParams>::ht_table_type::bulk_loader histories(db.tbl_histories(wid));
     for (uint64_t did = 1; did <= NUM_DISTRICTS_PER_WAREHOUSE; ++did) {
         for (uint64_t cid = 1; cid <= NUM_CUSTOMERS_PER_DISTRICT; ++cid) {
             history_value hv;
@@ -198,10 +286,13 @@ void tpcc_prepopulator<DBParams>::expand_customers(uint64_t wid) {
             hv.h_data = random_a_string(12, 24);
 
             history_key hk(db.tbl_histories(wid).gen_key());
-            db.tbl_histories(wid).nontrans_put(hk, hv);
+            histories.add(hk, hv);
         }
     }
 
+    typename tpcc_db<DBParams>::od_table_type::bulk_loader orders(db.tbl_orders(wid));
+    typename tpcc_db<DBParams>::ol_table_type::bulk_loader orderlines(db.tbl_orderlines(wid));
+    typename tpcc_db<DBParams>::no_table_type::bulk_loader neworders(db.tbl_neworders(wid));
     for (uint64_t did = 1; did <= NUM_DISTRICTS_PER_WAREHOUSE; ++did) {
         std::vector<uint64_t> cid_perm;
         for (uint64_t n = 1; n <= NUM_CUSTOMERS_PER_DISTRICT; ++n)
@@ -219,10 +310,7 @@ void tpcc_prepopulator<DBParams>::expand_customers(uint64_t wid) {
             ov.o_ol_cnt = (uint32_t) ig.random(5, 15);
             ov.o_all_local = 1;
 
-            order_cidx_key ock(wid, did, ov.o_c_id, oid);
-
-            db.tbl_orders(wid).nontrans_put(ok, ov);
-            db.tbl_order_customer_index(wid).nontrans_put(ock, {});
+            orders.add(ok, ov);
 
             for (uint64_t on = 1; on <= ov.o_ol_cnt; ++on) {
                 orderline_key olk(wid, did, oid, on);
@@ -235,12 +323,12 @@ void tpcc_prepopulator<DBParams>::expand_customers(uint64_t wid) {
                 olv.ol_amount = (oid < 2101) ? 0 : (int) ig.random(1, 999999);
                 olv.ol_dist_info = random_a_string(24, 24);
 
-                db.tbl_orderlines(wid).nontrans_put(olk, olv);
+                orderlines.add(olk, olv);
             }
 
             if (oid >= 2101) {
                 order_key nok(wid, did, oid);
-                db.tbl_neworders(wid).nontrans_put(nok, {});
+                neworders.add(nok, {});
             }
         }
     }
@@ -255,10 +343,11 @@ void tpcc_prepopulator<DBParams>::run() {
     // set affinity so that the warehouse is filled at the corresponding numa node
     set_affinity(worker_id - 1);
 
-    if (worker_id == 1) {
-        fill_items(1, 100001);
+    // the workers split the items by key range
+    uint64_t nworkers = ig.num_warehouses();
+    fill_items(1 + NUM_ITEMS * (worker_id - 1) / nworkers, 1 + NUM_ITEMS * worker_id / nworkers);
+    if (worker_id == 1)
         fill_warehouses();
-    }
 
     // barrier
     r = pthread_barrier_wait(&sync_barrier);
@@ -331,7 +420,8 @@ void tpcc_prepopulator<DBParams>::random_shuffle(std::vector<uint64_t> &v) {
 
 // @section: clp parser definitions
 enum {
-    opt_dbid = 1, opt_nwhs, opt_nthrs, opt_time, opt_perf, opt_pfcnt
+    opt_dbid = 1, opt_nwhs, opt_nthrs, opt_time, opt_perf, opt_pfcnt, opt_log, opt_nlog,
+    opt_ckpt, opt_nckpt, opt_recover, opt_cm, opt_mix
 };
 
 static const Clp_Option options[] = {
@@ -340,7 +430,14 @@ static const Clp_Option options[] = {
     { "nthreads",     't', opt_nthrs, Clp_ValInt,    Clp_Optional },
     { "time",         'l', opt_time,  Clp_ValDouble, Clp_Optional },
     { "perf",         'p', opt_perf,  Clp_NoVal,     Clp_Optional },
-    { "perf-counter", 'c', opt_pfcnt, Clp_NoVal,     Clp_Negate| Clp_Optional }
+    { "perf-counter", 'c', opt_pfcnt, Clp_NoVal,     Clp_Negate| Clp_Optional },
+    { "log",          'g', opt_log,   Clp_ValString, Clp_Negate| Clp_Optional },
+    { "log-threads",  'G', opt_nlog,  Clp_ValInt,    Clp_Optional },
+    { "checkpoint",   'k', opt_ckpt,  Clp_ValString, Clp_Negate| Clp_Optional },
+    { "ckpt-threads", 'K', opt_nckpt, Clp_ValInt,    Clp_Optional },
+    { "recover",      'r', opt_recover, Clp_ValString, Clp_Optional },
+    { "cm",           'C', opt_cm,    Clp_ValString, Clp_Optional },
+    { "mix",          'x', opt_mix,   Clp_ValString, Clp_Optional }
 };
 
 // @endsection: clp parser definitions
@@ -370,12 +467,11 @@ public:
     }
 
     static void tpcc_runner_thread(tpcc_db<DBParams>& db, db_profiler& prof, int runner_id, uint64_t w_start,
-                                   uint64_t w_end, double time_limit, uint64_t& txn_cnt) {
-        tpcc_runner<DBParams> runner(runner_id, db, w_start, w_end);
+                                   uint64_t w_end, double time_limit, const tpcc_txn_mix& mix,
+                                   tpcc_txn_stats& txn_stats) {
+        tpcc_runner<DBParams> runner(runner_id, db, w_start, w_end, mix);
         typedef typename tpcc_runner<DBParams>::txn_type txn_type;
 
-        uint64_t local_cnt = 0;
-
         ::TThread::set_id(runner_id);
         set_affinity(runner_id);
         db.thread_init_all();
@@ -389,15 +485,22 @@ public:
                 break;
 
             txn_type t = runner.next_transaction();
+            size_t aborts = 0;
             switch (t) {
                 case txn_type::new_order:
-                    runner.run_txn_neworder();
+                    aborts = runner.run_txn_neworder();
                     break;
                 case txn_type::payment:
-                    runner.run_txn_payment();
+                    aborts = runner.run_txn_payment();
                     break;
                 case txn_type::order_status:
-                    runner.run_txn_orderstatus();
+                    aborts = runner.run_txn_orderstatus();
+                    break;
+                case txn_type::delivery:
+                    aborts = runner.run_txn_delivery();
+                    break;
+                case txn_type::stock_level:
+                    aborts = runner.run_txn_stocklevel();
                     break;
                 default:
                     fprintf(stderr, "r:%d unknown txn type\n", runner_id);
@@ -405,18 +508,21 @@ public:
                     break;
             };
 
-            ++local_cnt;
+            runner.record(t, aborts);
         }
 
-        txn_cnt = local_cnt;
+        // don't hold up a checkpoint waiting for this thread
+        Transaction::rcu_quiesce();
+        txn_stats = runner.stats();
     }
 
-    static uint64_t run_benchmark(tpcc_db<DBParams>& db, db_profiler& prof, int num_runners, double time_limit) {
+    static uint64_t run_benchmark(tpcc_db<DBParams>& db, db_profiler& prof, int num_runners, double time_limit,
+                                  const tpcc_txn_mix& mix) {
         int q = db.num_warehouses() / num_runners;
         int r = db.num_warehouses() % num_runners;
 
         std::vector<std::thread> runner_thrs;
-        std::vector<uint64_t> txn_cnts(size_t(num_runners), 0);
+        std::vector<tpcc_txn_stats> txn_stats(static_cast<size_t>(num_runners));
 
         if (q == 0) {
             q = num_runners / db.num_warehouses();
@@ -429,7 +535,7 @@ public:
                 }
                 fprintf(stdout, "runner %d: [%d, %d]\n", i, wid, wid);
                 runner_thrs.emplace_back(tpcc_runner_thread, std::ref(db), std::ref(prof),
-                                         i, wid, wid, time_limit, std::ref(txn_cnts[i]));
+                                         i, wid, wid, time_limit, std::cref(mix), std::ref(txn_stats[i]));
             }
         } else {
             int last_xend = 1;
@@ -442,7 +548,8 @@ public:
                 }
                 fprintf(stdout, "runner %d: [%d, %d]\n", i, last_xend, next_xend - 1);
                 runner_thrs.emplace_back(tpcc_runner_thread, std::ref(db), std::ref(prof),
-                                         i, last_xend, next_xend - 1, time_limit, std::ref(txn_cnts[i]));
+                                         i, last_xend, next_xend - 1, time_limit, std::cref(mix),
+                                         std::ref(txn_stats[i]));
                 last_xend = next_xend;
             }
 
@@ -452,10 +559,11 @@ public:
         for (auto &t : runner_thrs)
             t.join();
 
-        uint64_t total_txn_cnt = 0;
-        for (auto& cnt : txn_cnts)
-            total_txn_cnt += cnt;
-        return total_txn_cnt;
+        tpcc_txn_stats total;
+        for (auto& s : txn_stats)
+            total += s;
+        total.print(std::cout, time_limit);
+        return total.total_commits();
     }
 
     static int execute(int argc, const char *const *argv) {
@@ -463,9 +571,18 @@ public:
 
         bool spawn_perf = false;
         bool counter_mode = false;
+        bool enable_log = false;
+        std::string log_dir = ".";
+        int num_loggers = 1;
+        bool enable_ckpt = false;
+        std::string ckpt_dir = ".";
+        int num_ckpt_threads = 1;
+        bool recover = false;
+        std::string recover_dir = ".";
         int num_warehouses = 1;
         int num_threads = 1;
         double time_limit = 10.0;
+        tpcc_txn_mix mix;
 
         Clp_Parser *clp = Clp_NewParser(argc, argv, arraysize(options), options);
 
@@ -474,6 +591,7 @@ public:
         while (!clp_stop && ((opt = Clp_Next(clp)) != Clp_Done)) {
             switch (opt) {
                 case opt_dbid:
+                case opt_cm:
                     break;
                 case opt_nwhs:
                     num_warehouses = clp->val.i;
@@ -490,6 +608,35 @@ public:
                 case opt_pfcnt:
                     counter_mode = !clp->negated;
                     break;
+                case opt_log:
+                    enable_log = !clp->negated;
+                    if (clp->have_val)
+                        log_dir = clp->val.s;
+                    break;
+                case opt_nlog:
+                    num_loggers = clp->val.i;
+                    break;
+                case opt_ckpt:
+                    enable_ckpt = !clp->negated;
+                    if (clp->have_val)
+                        ckpt_dir = clp->val.s;
+                    break;
+                case opt_nckpt:
+                    num_ckpt_threads = clp->val.i;
+                    break;
+                case opt_recover:
+                    recover = true;
+                    if (clp->have_val)
+                        recover_dir = clp->val.s;
+                    break;
+                case opt_mix:
+                    if (!mix.parse(clp->val.s)) {
+                        std::cout << "Invalid transaction mix: " << clp->val.s << std::endl;
+                        print_usage(argv[0]);
+                        ret = 1;
+                        clp_stop = true;
+                    }
+                    break;
                 default:
                     print_usage(argv[0]);
                     ret = 1;
@@ -502,6 +649,10 @@ public:
         if (ret != 0)
             return ret;
 
+        // checkpoint threads use ids after the runners'
+        if (num_threads + num_ckpt_threads > TThread::max_threads())
+            TThread::set_max_threads(num_threads + num_ckpt_threads);
+
         auto profiler_mode = counter_mode ?
                              Profiler::perf_mode::counters : Profiler::perf_mode::record;
 
@@ -518,14 +669,66 @@ public:
         db_profiler prof(spawn_perf);
         tpcc_db<DBParams> db(num_warehouses);
 
-        std::cout << "Prepopulating database..." << std::endl;
-        prepopulate_db(db);
-        std::cout << "Prepopulation complete." << std::endl;
+        bench::db_checkpointer ckp;
+        db.register_checkpoint(ckp);
+
+        if (recover) {
+            std::cout << "Recovering database from " << recover_dir << "..." << std::endl;
+            if (!ckp.recover(recover_dir, num_threads, 0)) {
+                std::cerr << "No valid checkpoint in " << recover_dir << std::endl;
+                return 1;
+            }
+            db.recovery_fixup();
+            ckp.print_recovery_stats();
+        } else {
+            std::cout << "Prepopulating database..." << std::endl;
+            bench::load_report load;
+            prepopulate_db(db);
+            std::cout << "Prepopulation complete." << std::endl;
+            load.print(std::cout);
+        }
+
+        pthread_t advancer;
+        if (enable_log) {
+            std::cout << "Info: Redo logging to " << log_dir << " with "
+                      << num_loggers << " logger thread(s)" << std::endl;
+            Logger::start(log_dir, num_loggers);
+        }
+        // MVCC snapshots and history trimming follow the global epoch
+        bool run_advancer = enable_log || enable_ckpt || DBParams::MVCC;
+        if (run_advancer)
+            pthread_create(&advancer, nullptr, Transaction::epoch_advancer, nullptr);
+
+        // With logging, the checkpoint is taken halfway through the run
+        // (fuzzy); otherwise after the run, when the database is quiescent.
+        std::thread ckpt_thr;
+        if (enable_ckpt && enable_log) {
+            ckpt_thr = std::thread([&] () {
+                std::this_thread::sleep_for(std::chrono::duration<double>(time_limit / 2));
+                ckp.checkpoint(ckpt_dir, num_ckpt_threads, num_threads);
+            });
+        }
 
         prof.start(profiler_mode);
-        auto num_trans = run_benchmark(db, prof, num_threads, time_limit);
+        auto num_trans = run_benchmark(db, prof, num_threads, time_limit, mix);
         prof.finish(num_trans);
 
+        if (ckpt_thr.joinable())
+            ckpt_thr.join();
+        else if (enable_ckpt)
+            ckp.checkpoint(ckpt_dir, num_ckpt_threads, num_threads);
+        if (enable_ckpt)
+            ckp.print_checkpoint_stats();
+
+        if (run_advancer) {
+            Transaction::global_epochs.run = false;
+            pthread_join(advancer, nullptr);
+        }
+        if (enable_log) {
+            Logger::stop();
+            Logger::print_stats();
+        }
+
         return 0;
     }
 }; // class tpcc_access
@@ -540,7 +743,7 @@ static inline void print_usage(const char *argv_0) {
     ss << "Usage of " << std::string(argv_0) << ":" << std::endl
        << "  --dbid=<STRING> (or -i<STRING>)" << std::endl
        << "    Specify the type of DB concurrency control used. Can be one of the followings:" << std::endl
-       << "      default, opaque, 2pl, adaptive, swiss, tictoc" << std::endl
+       << "      default, opaque, 2pl, adaptive, swiss, tictoc, mvcc" << std::endl
        << "  --nwarehouses=<NUM> (or -w<NUM>)" << std::endl
        << "    Specify the number of warehouses (default 1)." << std::endl
        << "  --nthreads=<NUM> (or -t<NUM>)" << std::endl
@@ -550,7 +753,24 @@ static inline void print_usage(const char *argv_0) {
        << "  --perf (or -p)" << std::endl
        << "    Spawns perf profiler in record mode for the duration of the benchmark run." << std::endl
        << "  --perf-counter (or -c)" << std::endl
-       << "    Spawns perf profiler in counter mode for the duration of the benchmark run." << std::endl;
+       << "    Spawns perf profiler in counter mode for the duration of the benchmark run." << std::endl
+       << "  --log[=<DIR>] (or -g[<DIR>])" << std::endl
+       << "    Enable epoch-based redo logging to files in DIR (default current directory)." << std::endl
+       << "  --log-threads=<NUM> (or -G<NUM>)" << std::endl
+       << "    Specify the number of logger threads (default 1)." << std::endl
+       << "  --checkpoint[=<DIR>] (or -k[<DIR>])" << std::endl
+       << "    Write a checkpoint to DIR (default current directory): in the middle of the run" << std::endl
+       << "    if logging is enabled, otherwise at the end." << std::endl
+       << "  --ckpt-threads=<NUM> (or -K<NUM>)" << std::endl
+       << "    Specify the number of checkpoint threads (default 1)." << std::endl
+       << "  --recover[=<DIR>] (or -r[<DIR>])" << std::endl
+       << "    Load the database from the checkpoint and logs in DIR instead of prepopulating it." << std::endl
+       << "  --cm=<STRING> (or -C<STRING>)" << std::endl
+       << "    Specify the contention management policy. Can be one of the followings:" << std::endl
+       << "      timestamp (default), greedy, karma, polka, wound_wait, backoff" << std::endl
+       << "  --mix=<NO,P,OS,D,SL> (or -x<NO,P,OS,D,SL>)" << std::endl
+       << "    Specify the percentages of new-order, payment, order-status, delivery and" << std::endl
+       << "    stock-level transactions, which add up to 100 (default 45,43,4,4,4)." << std::endl;
     std::cout << ss.str() << std::flush;
 }
 
@@ -558,8 +778,9 @@ double constants::processor_tsc_frequency;
 
 int main(int argc, const char *const *argv) {
     db_params_id dbid = db_params_id::Default;
+    ContentionManager::policy_type cm_policy = ContentionManager::policy_type::timestamp;
     int ret_code = 0;
-   
+
     Clp_Parser *clp = Clp_NewParser(argc, argv, arraysize(options), options);
 
     int opt;
@@ -576,6 +797,15 @@ int main(int argc, const char *const *argv) {
                 clp_stop = true;
             }
             break;
+        case opt_cm:
+            if (!ContentionManager::parse_policy(clp->val.s, cm_policy)) {
+                std::cout << "Unsupported contention manager: "
+                    << ((clp->val.s == nullptr) ? "" : std::string(clp->val.s)) << std::endl;
+                print_usage(argv[0]);
+                ret_code = 1;
+                clp_stop = true;
+            }
+            break;
         default:
             break;
         }
@@ -584,6 +814,7 @@ int main(int argc, const char *const *argv) {
     Clp_DeleteParser(clp);
     if (ret_code != 0)
         return ret_code;
+    ContentionManager::set_policy(cm_policy);
 
     auto cpu_freq = determine_cpu_freq();
     if (cpu_freq == 0.0)
@@ -610,6 +841,9 @@ int main(int argc, const char *const *argv) {
     case db_params_id::TicToc:
         ret_code = tpcc_access<db_tictoc_params>::execute(argc, argv);
         break;
+    case db_params_id::MVCC:
+        ret_code = tpcc_access<db_mvcc_params>::execute(argc, argv);
+        break;
     default:
         std::cerr << "unknown db config parameter id" << std::endl;
         ret_code = 1;
@@ -18,6 +18,7 @@
 
 #include "DB_index.hh"
 #include "DB_params.hh"
+#include "DB_checkpoint.hh"
 
 #define A_GEN_CUSTOMER_ID           1023
 #define A_GEN_ITEM_ID               8191
@@ -117,13 +118,16 @@ public:
     template <typename K, typename V>
     using OIndex = ordered_index<K, V, DBParams>;
 
+    template <typename K, typename Base, typename Extract>
+    using SIndex = secondary_index<K, Base, Extract>;
+
     // partitioned according to warehouse id
     typedef std::vector<warehouse_value>                 wh_table_type;
     typedef OIndex<district_key, district_value>         dt_table_type;
-    typedef OIndex<customer_idx_key, customer_idx_value> ci_table_type;
     typedef OIndex<customer_key, customer_value>         cu_table_type;
-    typedef OIndex<order_cidx_key, bench::dummy_row>     oi_table_type;
     typedef OIndex<order_key, order_value>               od_table_type;
+    typedef SIndex<customer_idx_key, cu_table_type, customer_idx_extract> ci_table_type;
+    typedef SIndex<order_cidx_key, od_table_type, order_cidx_extract>     oi_table_type;
     typedef OIndex<orderline_key, orderline_value>       ol_table_type;
     typedef OIndex<order_key, bench::dummy_row>          no_table_type;
     typedef OIndex<item_key, item_value>                 it_table_type;
@@ -135,6 +139,11 @@ public:
     inline ~tpcc_db();
     void thread_init_all();
 
+    // registers all tables with a checkpointer
+    void register_checkpoint(bench::db_checkpointer& ckp);
+    // rebuilds in-memory state that is not stored in tables after recovery
+    void recovery_fixup();
+
     int num_warehouses() const {
         return int(tbl_whs_.size());
     }
@@ -191,10 +200,56 @@ private:
     std::vector<ht_table_type> tbl_hts_;
 
     tpcc_oid_generator oid_gen_;
+    // log id of the constant part of the warehouse table
+    uint32_t wh_log_id_;
 
     friend class tpcc_access<DBParams>;
 };
 
+// percentages of new-order, payment, order-status, delivery and
+// stock-level transactions
+struct tpcc_txn_mix {
+    static constexpr int num_types = 5;
+    uint64_t pct[num_types];
+
+    tpcc_txn_mix()
+        : pct{45, 43, 4, 4, 4} {}
+
+    // parses "NO,P,OS,D,SL"; the percentages must add up to 100
+    bool parse(const char *s);
+
+    static const char *name(int type) {
+        static const char *const names[num_types] = {
+            "new-order", "payment", "order-status", "delivery", "stock-level"
+        };
+        return names[type];
+    }
+};
+
+// committed transactions and their aborted attempts, by type
+struct tpcc_txn_stats {
+    uint64_t commits[tpcc_txn_mix::num_types];
+    uint64_t aborts[tpcc_txn_mix::num_types];
+
+    tpcc_txn_stats()
+        : commits(), aborts() {}
+
+    tpcc_txn_stats& operator+=(const tpcc_txn_stats& x) {
+        for (int t = 0; t < tpcc_txn_mix::num_types; ++t) {
+            commits[t] += x.commits[t];
+            aborts[t] += x.aborts[t];
+        }
+        return *this;
+    }
+    uint64_t total_commits() const {
+        uint64_t n = 0;
+        for (int t = 0; t < tpcc_txn_mix::num_types; ++t)
+            n += commits[t];
+        return n;
+    }
+    void print(std::ostream& os, double seconds) const;
+};
+
 template <typename DBParams>
 class tpcc_runner {
 public:
@@ -206,23 +261,34 @@ public:
         stock_level
     };
 
-    tpcc_runner(int id, tpcc_db<DBParams>& database, uint64_t w_start, uint64_t w_end)
+    tpcc_runner(int id, tpcc_db<DBParams>& database, uint64_t w_start, uint64_t w_end,
+                const tpcc_txn_mix& txn_mix = tpcc_txn_mix())
         : ig(id, database.num_warehouses()), db(database), runner_id(id),
-          w_id_start(w_start), w_id_end(w_end) {}
+          w_id_start(w_start), w_id_end(w_end), mix(txn_mix) {}
 
     inline txn_type next_transaction() {
         uint64_t x = ig.random(1, 100);
-        if (x <= 49)
-            return txn_type::new_order;
-        else if (x <= 96)
-            return txn_type::payment;
-        else
-            return txn_type::order_status;
+        int t = 0;
+        uint64_t sum = mix.pct[0];
+        while (x > sum)
+            sum += mix.pct[++t];
+        return static_cast<txn_type>(t + 1);
     }
 
-    inline void run_txn_neworder();
-    inline void run_txn_payment();
-    inline void run_txn_orderstatus();
+    // each returns the number of aborted attempts
+    inline size_t run_txn_neworder();
+    inline size_t run_txn_payment();
+    inline size_t run_txn_orderstatus();
+    inline size_t run_txn_delivery();
+    inline size_t run_txn_stocklevel();
+
+    void record(txn_type t, size_t aborts) {
+        ++txn_stats.commits[int(t) - 1];
+        txn_stats.aborts[int(t) - 1] += aborts;
+    }
+    const tpcc_txn_stats& stats() const {
+        return txn_stats;
+    }
 
 private:
     tpcc_input_generator ig;
@@ -230,6 +296,8 @@ private:
     int runner_id;
     uint64_t w_id_start;
     uint64_t w_id_end;
+    tpcc_txn_mix mix;
+    tpcc_txn_stats txn_stats;
 };
 
 template <typename DBParams>
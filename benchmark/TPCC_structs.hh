@@ -39,6 +39,15 @@ public:
     uint64_t next(uint64_t wid, uint64_t did) {
         return fetch_and_add(&(oid_gens[wid % max_whs][did % max_dts]), 1);
     }
+    // the id next() returns next
+    uint64_t peek(uint64_t wid, uint64_t did) const {
+        acquire_fence();
+        return oid_gens[wid % max_whs][did % max_dts];
+    }
+    // used after recovery to continue after the last recovered order
+    void set_next(uint64_t wid, uint64_t did, uint64_t oid) {
+        oid_gens[wid % max_whs][did % max_dts] = oid;
+    }
 
 private:
     uint64_t oid_gens[max_whs][max_dts];
@@ -165,13 +174,6 @@ struct customer_idx_key {
     char c_first[16];
 };
 
-struct customer_idx_value {
-    enum class NamedColumn : int { c_id = 0 };    
-
-    customer_idx_value(uint64_t cid) : c_id(cid) {};
-    uint64_t c_id;
-};
-
 struct customer_key {
     customer_key(uint64_t wid, uint64_t did, uint64_t cid) {
         c_w_id = bswap(wid);
@@ -242,6 +244,13 @@ struct customer_value {
     fix_string<500> c_data;
 };
 
+// customer index key of a customer row (see bench::secondary_index)
+struct customer_idx_extract {
+    customer_idx_key operator()(const customer_key& k, const customer_value& v) const {
+        return customer_idx_key(bswap(k.c_w_id), bswap(k.c_d_id), v.c_last, v.c_first);
+    }
+};
+
 // HISTORY
 
 struct history_key {
@@ -351,6 +360,13 @@ struct order_value{
     uint32_t o_all_local;
 };
 
+// order-customer index key of an order row
+struct order_cidx_extract {
+    order_cidx_key operator()(const order_key& k, const order_value& v) const {
+        return order_cidx_key(bswap(k.o_w_id), bswap(k.o_d_id), v.o_c_id, bswap(k.o_id));
+    }
+};
+
 // ORDER-LINE
 
 struct orderline_key {
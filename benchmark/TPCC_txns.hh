@@ -1,5 +1,7 @@
 #pragma once
 
+#include <unordered_set>
+
 #include "TPCC_bench.hh"
 
 namespace tpcc {
@@ -19,7 +21,7 @@ struct c_data_info {
 };
 
 template <typename DBParams>
-void tpcc_runner<DBParams>::run_txn_neworder() {
+size_t tpcc_runner<DBParams>::run_txn_neworder() {
     //fprintf(stdout, "NEWORDER\n");
 
     typedef district_value::NamedColumn dt_nc;
@@ -69,6 +71,19 @@ void tpcc_runner<DBParams>::run_txn_neworder() {
     volatile char out_brand_generic[15];
     (void) out_brand_generic;
 
+    // the item and stock rows are selected in batches
+    std::vector<item_key> it_keys;
+    std::vector<stock_key> st_keys;
+    it_keys.reserve(num_items);
+    st_keys.reserve(num_items);
+    for (uint64_t i = 0; i < num_items; ++i) {
+        it_keys.emplace_back(ol_i_ids[i]);
+        st_keys.emplace_back(ol_supply_w_ids[i], ol_i_ids[i]);
+    }
+    typename tpcc_db<DBParams>::it_table_type::sel_return_type item_rows[15];
+    typename tpcc_db<DBParams>::st_table_type::sel_return_type stock_rows[15];
+    size_t nexecs = 0;
+
     // begin txn
     TRANSACTION {
 
@@ -76,6 +91,8 @@ void tpcc_runner<DBParams>::run_txn_neworder() {
     uintptr_t row;
     const void *value;
 
+    ++nexecs;
+
     int64_t wh_tax_rate, dt_tax_rate;
     uint64_t dt_next_oid;
 
@@ -107,25 +124,30 @@ void tpcc_runner<DBParams>::run_txn_neworder() {
     ov->o_entry_d = o_entry_d;
     ov->o_ol_cnt = num_items;
 
-    order_cidx_key ock(q_w_id, q_d_id, q_c_id, dt_next_oid);
-
+    // also inserts into the order-customer index
     std::tie(abort, result) = db.tbl_orders(q_w_id).insert_row(ok, ov, false);
     TXN_DO(abort);
     assert(!result);
     std::tie(abort, result) = db.tbl_neworders(q_w_id).insert_row(ok, nullptr, false);
     TXN_DO(abort);
     assert(!result);
-    std::tie(abort, result) = db.tbl_order_customer_index(q_w_id).insert_row(ock, nullptr, false);
-    TXN_DO(abort);
-    assert(!result);
+
+    TXN_DO(db.tbl_items().select_rows(it_keys.data(), num_items, RowAccess::ObserveValue, item_rows));
+    if (all_local) {
+        TXN_DO(db.tbl_stocks(q_w_id).select_rows(st_keys.data(), num_items, {{st_nc::s_quantity, true}, {st_nc::s_dists, false}, {st_nc::s_data, false}, {st_nc::s_ytd, true}, {st_nc::s_order_cnt, true}, {st_nc::s_remote_cnt, true}}, stock_rows));
+    } else {
+        for (uint64_t i = 0; i < num_items; ++i) {
+            stock_rows[i] = db.tbl_stocks(ol_supply_w_ids[i]).select_row(st_keys[i], {{st_nc::s_quantity, true}, {st_nc::s_dists, false}, {st_nc::s_data, false}, {st_nc::s_ytd, true}, {st_nc::s_order_cnt, true}, {st_nc::s_remote_cnt, true}});
+            TXN_DO(std::get<0>(stock_rows[i]));
+        }
+    }
 
     for (uint64_t i = 0; i < num_items; ++i) {
         uint64_t iid = ol_i_ids[i];
         uint64_t wid = ol_supply_w_ids[i];
         uint64_t qty = ol_quantities[i];
 
-        std::tie(abort, result, std::ignore, value) = db.tbl_items().select_row(item_key(iid), RowAccess::ObserveValue);
-        TXN_DO(abort);
+        std::tie(std::ignore, result, std::ignore, value) = item_rows[i];
         assert(result);
         uint64_t oid = reinterpret_cast<const item_value *>(value)->i_im_id;
         TXN_DO(oid != 0);
@@ -133,8 +155,7 @@ void tpcc_runner<DBParams>::run_txn_neworder() {
         out_item_names[i] = reinterpret_cast<const item_value *>(value)->i_name;
         auto i_data = reinterpret_cast<const item_value *>(value)->i_data;
 
-        std::tie(abort, result, row, value) = db.tbl_stocks(wid).select_row(stock_key(wid, iid), {{st_nc::s_quantity, true}, {st_nc::s_dists, false}, {st_nc::s_data, false}, {st_nc::s_ytd, true}, {st_nc::s_order_cnt, true}, {st_nc::s_remote_cnt, true}});
-        TXN_DO(abort);
+        std::tie(std::ignore, result, row, value) = stock_rows[i];
         assert(result);
         stock_value *new_sv = Sto::tx_alloc(reinterpret_cast<const stock_value *>(value));
         int32_t s_quantity = new_sv->s_quantity;
@@ -177,13 +198,16 @@ void tpcc_runner<DBParams>::run_txn_neworder() {
     // commit txn
     // retry until commits
     } RETRY(true);
+
+    return nexecs - 1;
 }
 
 template <typename DBParams>
-void tpcc_runner<DBParams>::run_txn_payment() {
+size_t tpcc_runner<DBParams>::run_txn_payment() {
 
     typedef district_value::NamedColumn dt_nc;
     typedef customer_value::NamedColumn cu_nc;
+    typedef typename tpcc_db<DBParams>::cu_table_type cu_table_type;
 
     //fprintf(stdout, "PAYMENT\n");
     uint64_t q_w_id = ig.random(w_id_start, w_id_end);
@@ -238,6 +262,7 @@ void tpcc_runner<DBParams>::run_txn_payment() {
     (void)out_c_credit_lim;
     (void)out_c_discount;
     (void)out_c_balance;
+    size_t nexecs = 0;
 
     // begin txn
     TRANSACTION {
@@ -246,6 +271,8 @@ void tpcc_runner<DBParams>::run_txn_payment() {
     uintptr_t row;
     const void *value;
 
+    ++nexecs;
+
     // select warehouse row FOR UPDATE and retrieve warehouse info
     warehouse_key wk(q_w_id);
     auto& wv = db.get_warehouse(q_w_id);
@@ -281,11 +308,12 @@ void tpcc_runner<DBParams>::run_txn_payment() {
     db.tbl_districts(q_w_id).update_row(row, new_dv);
     
     // select and update customer
+    std::initializer_list<typename cu_table_type::column_access_t> cu_accesses = {{cu_nc::c_balance, true}, {cu_nc::c_ytd_payment, true}, {cu_nc::c_payment_cnt, true}, {cu_nc::c_since, false}, {cu_nc::c_credit_lim, false}, {cu_nc::c_discount, false}, {cu_nc::c_data, true}};
     if (by_name) {
-        std::vector<uint64_t> matches;
-        auto scan_callback = [&] (const customer_idx_key& key, const customer_idx_value& civ) -> bool {
+        std::vector<uintptr_t> matches;
+        auto scan_callback = [&] (const customer_idx_key& key, const index_entry_row& entry) -> bool {
             (void)key;
-            matches.emplace_back(civ.c_id);
+            matches.emplace_back(entry.rid);
             return true;
         };
 
@@ -293,7 +321,7 @@ void tpcc_runner<DBParams>::run_txn_payment() {
         customer_idx_key ck1(q_c_w_id, q_c_d_id, last_name, 0xff);
 
         success = db.tbl_customer_index(q_c_w_id)
-                .template range_scan<decltype(scan_callback), false/*reverse*/>(ck0, ck1, scan_callback, RowAccess::ObserveValue);
+                .template range_scan<decltype(scan_callback), false/*reverse*/>(ck0, ck1, scan_callback, RowAccess::ObserveExists);
         TXN_DO(success);
 
         size_t n = matches.size();
@@ -301,17 +329,18 @@ void tpcc_runner<DBParams>::run_txn_payment() {
         size_t idx = n / 2;
         if (n % 2 == 0)
             idx -= 1;
-        q_c_id = matches[idx];
-
+        std::tie(success, result, row, value) = db.tbl_customers(q_c_w_id).select_row(matches[idx], cu_accesses);
+        TXN_DO(success);
+        assert(result);
+        q_c_id = cu_table_type::row_key(row).get_c_id();
     } else {
         always_assert(q_c_id != 0, "q_c_id invalid when selecting customer by c_id");
+        customer_key ck(q_c_w_id, q_c_d_id, q_c_id);
+        std::tie(success, result, row, value) = db.tbl_customers(q_c_w_id).select_row(ck, cu_accesses);
+        TXN_DO(success);
+        assert(result);
     }
 
-    customer_key ck(q_c_w_id, q_c_d_id, q_c_id);
-    std::tie(success, result, row, value) = db.tbl_customers(q_c_w_id).select_row(ck, {{cu_nc::c_balance, true}, {cu_nc::c_ytd_payment, true}, {cu_nc::c_payment_cnt, true}, {cu_nc::c_since, false}, {cu_nc::c_credit_lim, false}, {cu_nc::c_discount, false}, {cu_nc::c_data, true}});
-    TXN_DO(success);
-    assert(result);
-
     auto cv = reinterpret_cast<const customer_value *>(value);
     customer_value *new_cv = Sto::tx_alloc(cv);
 
@@ -329,7 +358,8 @@ void tpcc_runner<DBParams>::run_txn_payment() {
         new_cv->c_data.insert_left(info.buf(), info.len);
     }
 
-    db.tbl_customers(q_c_w_id).update_row(row, new_cv);
+    // also maintains the customer index
+    TXN_DO(db.tbl_customers(q_c_w_id).update_row(row, new_cv));
 
     // insert to history table
     history_value *hv = Sto::tx_alloc<history_value>();
@@ -350,13 +380,16 @@ void tpcc_runner<DBParams>::run_txn_payment() {
     // commit txn
     // retry until commits
     } RETRY(true);
+
+    return nexecs - 1;
 }
 
 template <typename DBParams>
-void tpcc_runner<DBParams>::run_txn_orderstatus() {
+size_t tpcc_runner<DBParams>::run_txn_orderstatus() {
 
     typedef customer_value::NamedColumn cu_nc;
     typedef order_value::NamedColumn od_nc;
+    typedef typename tpcc_db<DBParams>::cu_table_type cu_table_type;
 
     uint64_t q_w_id = ig.random(w_id_start, w_id_end);
     uint64_t q_d_id = ig.random(1, 10);
@@ -387,18 +420,23 @@ void tpcc_runner<DBParams>::run_txn_orderstatus() {
     (void)out_c_balance;
     (void)out_o_carrier_id;
     (void)out_o_entry_date;
+    size_t nexecs = 0;
 
-    TRANSACTION {
+    // under MVCC, read at an untracked snapshot
+    TRANSACTION_SNAPSHOT_IF(DBParams::MVCC) {
 
     bool success, result;
     uintptr_t row;
     const void *value;
 
+    ++nexecs;
+
+    std::initializer_list<typename cu_table_type::column_access_t> cu_accesses = {{cu_nc::c_balance, false}, {cu_nc::c_first, false}, {cu_nc::c_last, false}, {cu_nc::c_middle, false}};
     if (by_name) {
-        std::vector<uint64_t> matches;
-        auto scan_callback = [&] (const customer_idx_key& key, const customer_idx_value& civ) -> bool {
+        std::vector<uintptr_t> matches;
+        auto scan_callback = [&] (const customer_idx_key& key, const index_entry_row& entry) -> bool {
             (void)key;
-            matches.emplace_back(civ.c_id);
+            matches.emplace_back(entry.rid);
             return true;
         };
 
@@ -406,7 +444,7 @@ void tpcc_runner<DBParams>::run_txn_orderstatus() {
         customer_idx_key ck1(q_w_id, q_d_id, last_name, 0xff);
 
         success = db.tbl_customer_index(q_w_id)
-                .template range_scan<decltype(scan_callback), false/*reverse*/>(ck0, ck1, scan_callback, RowAccess::ObserveValue);
+                .template range_scan<decltype(scan_callback), false/*reverse*/>(ck0, ck1, scan_callback, RowAccess::ObserveExists);
         TXN_DO(success);
 
         size_t n = matches.size();
@@ -414,16 +452,18 @@ void tpcc_runner<DBParams>::run_txn_orderstatus() {
         size_t idx = n / 2;
         if (n % 2 == 0)
             idx -= 1;
-        q_c_id = matches[idx];
+        std::tie(success, result, row, value) = db.tbl_customers(q_w_id).select_row(matches[idx], cu_accesses);
+        TXN_DO(success);
+        assert(result);
+        q_c_id = cu_table_type::row_key(row).get_c_id();
     } else {
         always_assert(q_c_id != 0, "q_c_id invalid when selecting customer by c_id");
+        customer_key ck(q_w_id, q_d_id, q_c_id);
+        std::tie(success, result, row, value) = db.tbl_customers(q_w_id).select_row(ck, cu_accesses);
+        TXN_DO(success);
+        assert(result);
     }
 
-    customer_key ck(q_w_id, q_d_id, q_c_id);
-    std::tie(success, result, row, value) = db.tbl_customers(q_w_id).select_row(ck, {{cu_nc::c_balance, false}, {cu_nc::c_first, false}, {cu_nc::c_last, false}, {cu_nc::c_middle, false}});
-    TXN_DO(success);
-    assert(result);
-
     auto cv = reinterpret_cast<const customer_value *>(value);
 
     // simulate retrieving customer info
@@ -434,9 +474,10 @@ void tpcc_runner<DBParams>::run_txn_orderstatus() {
 
     // find the highest order placed by customer q_c_id
     uint64_t cus_o_id = 0;
-    auto scan_callback = [&] (const order_cidx_key& key, const bench::dummy_row& dummy) -> bool {
-        (void)dummy;
-        cus_o_id = key.o_id;
+    uintptr_t od_rid = 0;
+    auto scan_callback = [&] (const order_cidx_key& key, const index_entry_row& entry) -> bool {
+        cus_o_id = bswap(key.o_id);
+        od_rid = entry.rid;
         return true;
     };
 
@@ -444,12 +485,11 @@ void tpcc_runner<DBParams>::run_txn_orderstatus() {
     order_cidx_key k1(q_w_id, q_d_id, q_c_id, std::numeric_limits<uint64_t>::max());
 
     success = db.tbl_order_customer_index(q_w_id)
-            .template range_scan<decltype(scan_callback), true/*reverse*/>(k0, k1, scan_callback, RowAccess::ObserveExists, false, 1/*reverse scan for only 1 item*/);
+            .template range_scan<decltype(scan_callback), true/*reverse*/>(k1, k0, scan_callback, RowAccess::ObserveExists, false, 1/*reverse scan for only 1 item*/);
     TXN_DO(success);
 
     if (cus_o_id > 0) {
-        order_key ok(q_w_id, q_d_id, cus_o_id);
-        std::tie(success, result, row, value) = db.tbl_orders(q_w_id).select_row(ok, {{od_nc::o_entry_d, false}, {od_nc::o_carrier_id, false}});
+        std::tie(success, result, row, value) = db.tbl_orders(q_w_id).select_row(od_rid, {{od_nc::o_entry_d, false}, {od_nc::o_carrier_id, false}});
         TXN_DO(success);
         assert(result);
 
@@ -471,7 +511,7 @@ void tpcc_runner<DBParams>::run_txn_orderstatus() {
         orderline_key olk1(q_w_id, q_d_id, cus_o_id, std::numeric_limits<uint64_t>::max());
 
         success = db.tbl_orderlines(q_w_id)
-                .template range_scan<decltype(ol_scan_callback), true/*reverse*/>(olk0, olk1, ol_scan_callback, RowAccess::ObserveValue);
+                .template range_scan<decltype(ol_scan_callback), true/*reverse*/>(olk1, olk0, ol_scan_callback, RowAccess::ObserveValue);
         TXN_DO(success);
     } else {
         // order doesn't exist, simply commit the transaction
@@ -480,6 +520,186 @@ void tpcc_runner<DBParams>::run_txn_orderstatus() {
     // commit txn
     // retry until commits
     } RETRY(true);
+
+    return nexecs - 1;
+}
+
+template <typename DBParams>
+size_t tpcc_runner<DBParams>::run_txn_delivery() {
+    typedef order_value::NamedColumn od_nc;
+    typedef orderline_value::NamedColumn ol_nc;
+    typedef customer_value::NamedColumn cu_nc;
+
+    uint64_t q_w_id = ig.random(w_id_start, w_id_end);
+    uint64_t q_carrier_id = ig.random(1, 10);
+    uint32_t delivery_d = ig.gen_date();
+
+    // holding outputs of the transaction: the delivered order of each
+    // district, or 0 if it had none
+    volatile uint64_t out_delivered_o_ids[NUM_DISTRICTS_PER_WAREHOUSE];
+    (void)out_delivered_o_ids;
+
+    std::vector<orderline_key> ol_keys;
+    typename tpcc_db<DBParams>::ol_table_type::sel_return_type ol_rows[15];
+    size_t nexecs = 0;
+
+    // begin txn
+    TRANSACTION {
+
+    bool success, result;
+    uintptr_t row;
+    const void *value;
+
+    ++nexecs;
+
+    for (uint64_t q_d_id = 1; q_d_id <= NUM_DISTRICTS_PER_WAREHOUSE; ++q_d_id) {
+        // find the oldest undelivered order of the district
+        uint64_t no_o_id = 0;
+        auto no_scan_callback = [&] (const order_key& key, const bench::dummy_row&) -> bool {
+            no_o_id = bswap(key.o_id);
+            return true;
+        };
+
+        order_key nok0(q_w_id, q_d_id, 0);
+        order_key nok1(q_w_id, q_d_id, std::numeric_limits<uint64_t>::max());
+
+        success = db.tbl_neworders(q_w_id)
+                .template range_scan<decltype(no_scan_callback), false/*reverse*/>(nok0, nok1, no_scan_callback, RowAccess::ObserveExists, true, 1/*oldest only*/);
+        TXN_DO(success);
+
+        out_delivered_o_ids[q_d_id - 1] = no_o_id;
+        if (no_o_id == 0)
+            continue;
+
+        order_key ok(q_w_id, q_d_id, no_o_id);
+        std::tie(success, result) = db.tbl_neworders(q_w_id).delete_row(ok);
+        TXN_DO(success);
+        // another delivery took the order first
+        TXN_DO(result);
+
+        std::tie(success, result, row, value) = db.tbl_orders(q_w_id).select_row(ok, {{od_nc::o_c_id, false}, {od_nc::o_carrier_id, true}});
+        TXN_DO(success);
+        assert(result);
+
+        order_value *new_ov = Sto::tx_alloc(reinterpret_cast<const order_value *>(value));
+        uint64_t q_c_id = new_ov->o_c_id;
+        new_ov->o_carrier_id = q_carrier_id;
+        // also maintains the order-customer index
+        TXN_DO(db.tbl_orders(q_w_id).update_row(row, new_ov));
+
+        // sum the order lines and stamp them delivered
+        int64_t ol_total = 0;
+        ol_keys.clear();
+        auto ol_scan_callback = [&] (const orderline_key& olk, const orderline_value& olv) -> bool {
+            ol_keys.push_back(olk);
+            ol_total += olv.ol_amount;
+            return true;
+        };
+
+        orderline_key olk0(q_w_id, q_d_id, no_o_id, 0);
+        orderline_key olk1(q_w_id, q_d_id, no_o_id, std::numeric_limits<uint64_t>::max());
+
+        success = db.tbl_orderlines(q_w_id)
+                .template range_scan<decltype(ol_scan_callback), false/*reverse*/>(olk0, olk1, ol_scan_callback, {{ol_nc::ol_amount, false}});
+        TXN_DO(success);
+        always_assert(ol_keys.size() <= 15, "order line count invalid");
+
+        int num_ols = int(ol_keys.size());
+        TXN_DO(db.tbl_orderlines(q_w_id).select_rows(ol_keys.data(), num_ols, {{ol_nc::ol_delivery_d, true}}, ol_rows));
+        for (int i = 0; i < num_ols; ++i) {
+            std::tie(std::ignore, result, row, value) = ol_rows[i];
+            assert(result);
+            orderline_value *new_olv = Sto::tx_alloc(reinterpret_cast<const orderline_value *>(value));
+            new_olv->ol_delivery_d = delivery_d;
+            db.tbl_orderlines(q_w_id).update_row(row, new_olv);
+        }
+
+        std::tie(success, result, row, value) = db.tbl_customers(q_w_id).select_row(customer_key(q_w_id, q_d_id, q_c_id), {{cu_nc::c_balance, true}, {cu_nc::c_delivery_cnt, true}});
+        TXN_DO(success);
+        assert(result);
+
+        customer_value *new_cv = Sto::tx_alloc(reinterpret_cast<const customer_value *>(value));
+        new_cv->c_balance += ol_total;
+        new_cv->c_delivery_cnt += 1;
+        // also maintains the customer index
+        TXN_DO(db.tbl_customers(q_w_id).update_row(row, new_cv));
+    }
+
+    // commit txn
+    // retry until commits
+    } RETRY(true);
+
+    return nexecs - 1;
+}
+
+template <typename DBParams>
+size_t tpcc_runner<DBParams>::run_txn_stocklevel() {
+    typedef orderline_value::NamedColumn ol_nc;
+    typedef stock_value::NamedColumn st_nc;
+
+    uint64_t q_w_id = ig.random(w_id_start, w_id_end);
+    uint64_t q_d_id = ig.random(1, 10);
+    int32_t q_threshold = (int32_t) ig.random(10, 20);
+
+    // holding outputs of the transaction
+    volatile uint64_t out_low_stock;
+    (void)out_low_stock;
+
+    std::unordered_set<uint64_t> i_ids;
+    std::vector<stock_key> st_keys;
+    std::vector<typename tpcc_db<DBParams>::st_table_type::sel_return_type> st_rows;
+    size_t nexecs = 0;
+
+    // under MVCC, read at an untracked snapshot
+    TRANSACTION_SNAPSHOT_IF(DBParams::MVCC) {
+
+    bool success, result;
+    const void *value;
+
+    ++nexecs;
+
+    // the last 20 orders of the district; the oid generator holds the
+    // district's next order id
+    uint64_t next_o_id = db.oid_generator().peek(q_w_id, q_d_id);
+    uint64_t first_o_id = (next_o_id > 20) ? next_o_id - 20 : 1;
+
+    // the distinct items of their order lines
+    i_ids.clear();
+    st_keys.clear();
+    auto ol_filter = [&] (const orderline_key&, const orderline_value& olv) -> bool {
+        return i_ids.count(olv.ol_i_id) == 0;
+    };
+    auto ol_scan_callback = [&] (const orderline_key&, const orderline_value& olv) -> bool {
+        i_ids.insert(olv.ol_i_id);
+        st_keys.emplace_back(q_w_id, olv.ol_i_id);
+        return true;
+    };
+
+    orderline_key olk0(q_w_id, q_d_id, first_o_id, 0);
+    orderline_key olk1(q_w_id, q_d_id, next_o_id - 1, std::numeric_limits<uint64_t>::max());
+
+    success = db.tbl_orderlines(q_w_id)
+            .template range_scan<decltype(ol_filter), decltype(ol_scan_callback), false/*reverse*/>(olk0, olk1, ol_filter, ol_scan_callback, {{ol_nc::ol_i_id, false}}, {{ol_nc::ol_i_id, false}});
+    TXN_DO(success);
+
+    int num_items = int(st_keys.size());
+    st_rows.resize(st_keys.size());
+    TXN_DO(db.tbl_stocks(q_w_id).select_rows(st_keys.data(), num_items, {{st_nc::s_quantity, false}}, st_rows.data()));
+
+    uint64_t low_stock = 0;
+    for (int i = 0; i < num_items; ++i) {
+        std::tie(std::ignore, result, std::ignore, value) = st_rows[i];
+        assert(result);
+        if (reinterpret_cast<const stock_value *>(value)->s_quantity < q_threshold)
+            ++low_stock;
+    }
+    out_low_stock = low_stock;
+
+    // commit txn
+    // retry until commits
+    } RETRY(true);
+
+    return nexecs - 1;
 }
 
 }; // namespace tpcc
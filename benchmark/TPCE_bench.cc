@@ -0,0 +1,821 @@
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <set>
+#include <thread>
+#include <cinttypes>
+
+#include "TPCE_bench.hh"
+#include "TPCE_txns.hh"
+#include "PlatformFeatures.hh"
+#include "DB_profiler.hh"
+
+static inline void print_usage(const char *);
+
+namespace tpce {
+
+using bench::db_profiler;
+
+const char *const constants::exchange_ids[] = {"AMEX", "NASDAQ", "NYSE", "PCX"};
+const char *const constants::sector_names[] = {
+        "Basic Materials", "Capital Goods", "Conglomerates", "Consumer Cyclical",
+        "Consumer Non-Cyclical", "Energy", "Financial", "Healthcare",
+        "Services", "Technology", "Transportation", "Utilities"};
+const char *const constants::trade_type_ids[] = {"TLB", "TLS", "TMB", "TMS", "TSL"};
+const int32_t constants::qty_band_starts[] = {0, 201, 5001, 50001};
+
+fix_string<15> constants::symbol(int64_t s_idx) {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "S%06" PRId64, s_idx);
+    return fix_string<15>(buf);
+}
+
+std::string constants::industry_id(int in_idx) {
+    return std::string{char('A' + in_idx / 26), char('A' + in_idx % 26)};
+}
+
+std::string constants::sector_id(int sc_idx) {
+    return std::string{char('A' + sc_idx / 26), char('A' + sc_idx % 26)};
+}
+
+std::string constants::zip_code(int zc_idx) {
+    return std::to_string(10000 + zc_idx);
+}
+
+void tpce_txn_stats::print(std::ostream& os, double seconds) const {
+    for (int t = 0; t < tpce_txn_mix::num_types; ++t) {
+        os << std::left << std::setw(18) << tpce_txn_mix::name(t) << std::right
+           << std::setw(10) << commits[t] << " commits, "
+           << std::fixed << std::setprecision(1) << commits[t] / seconds << " txns/sec, "
+           << aborts[t] << " aborts" << std::endl;
+        os.unsetf(std::ios::floatfield);
+    }
+}
+
+template <typename DBParams>
+void tpce_db<DBParams>::thread_init_all() {
+    tbl_cr_.thread_init();
+    tbl_zc_.thread_init();
+    tbl_ex_.thread_init();
+    tbl_sc_.thread_init();
+    tbl_in_.thread_init();
+    tbl_ca_.thread_init();
+    tbl_ap_.thread_init();
+    tbl_cx_.thread_init();
+    tbl_ad_.thread_init();
+    tbl_co_.thread_init();
+    tbl_cp_.thread_init();
+    tbl_dm_.thread_init();
+    tbl_fi_.thread_init();
+    tbl_ni_.thread_init();
+    tbl_nx_.thread_init();
+    tbl_t_.thread_init();
+    tbl_ti_.thread_init();
+    tbl_se_.thread_init();
+    tbl_th_.thread_init();
+    tbl_ct_.thread_init();
+    tbl_h_.thread_init();
+    tbl_hi_.thread_init();
+    tbl_hh_.thread_init();
+    tbl_hs_.thread_init();
+    tbl_wl_.thread_init();
+    tbl_wi_.thread_init();
+    tbl_tr_.thread_init();
+    tbl_tri_.thread_init();
+}
+
+// @section: loading
+// Every table is bulk loaded in key order by one thread.
+template <typename DBParams>
+void tpce_loader<DBParams>::load() {
+    db.thread_init_all();
+    load_fixed_tables();
+    load_market();
+    load_customers();
+}
+
+template <typename DBParams>
+void tpce_loader<DBParams>::load_fixed_tables() {
+    typedef tpce_db<DBParams> db_type;
+
+    typename db_type::st_table_type::bulk_loader status_types(db.tbl_status_types());
+    const char *const st_ids[] = {"ACTV", "CMPT", "CNCL", "PNDG", "SBMT"};
+    const char *const st_names[] = {"Active", "Completed", "Canceled", "Pending", "Submitted"};
+    for (int i = 0; i < 5; ++i) {
+        status_type_row stv;
+        stv.st_name = st_names[i];
+        status_types.add(status_type_key(st_ids[i]), stv);
+    }
+
+    typename db_type::tt_table_type::bulk_loader trade_types(db.tbl_trade_types());
+    const char *const tt_names[] = {"Limit-Buy", "Limit-Sell", "Market-Buy", "Market-Sell", "Stop-Loss"};
+    const int32_t tt_is_sells[] = {0, 1, 0, 1, 1};
+    const int32_t tt_is_mrkts[] = {0, 0, 1, 1, 0};
+    for (int i = 0; i < constants::num_trade_types; ++i) {
+        trade_type_row ttv;
+        ttv.tt_name = tt_names[i];
+        ttv.tt_is_sell = tt_is_sells[i];
+        ttv.tt_is_mrkt = tt_is_mrkts[i];
+        trade_types.add(trade_type_key(constants::trade_type_ids[i]), ttv);
+    }
+
+    // each customer pays one national and one state tax rate
+    typename db_type::tx_table_type::bulk_loader taxrates(db.tbl_taxrates());
+    for (int i = 1; i <= constants::num_tax_divisions; ++i) {
+        taxrate_row txv;
+        txv.tx_name = "National Tax " + std::to_string(i);
+        txv.tx_rate = 0.05f + 0.01f * i;
+        taxrates.add(taxrate_key("CN" + std::to_string(i)), txv);
+        txv.tx_name = "State Tax " + std::to_string(i);
+        txv.tx_rate = 0.01f * i;
+        taxrates.add(taxrate_key("US" + std::to_string(i)), txv);
+    }
+
+    typename db_type::ch_table_type::bulk_loader charges(db.tbl_charges());
+    typename db_type::cr_table_type::bulk_loader commission_rates(db.tbl_commission_rates());
+    for (int32_t c_tier = 1; c_tier <= constants::num_tiers; ++c_tier) {
+        for (auto tt_id : constants::trade_type_ids) {
+            charge_row chv;
+            chv.ch_chrg = constants::charge(c_tier);
+            charges.add(charge_key(tt_id, c_tier), chv);
+
+            for (auto ex_id : constants::exchange_ids) {
+                for (int b = 0; b < constants::num_qty_bands; ++b) {
+                    commission_rate_row crv;
+                    crv.cr_to_qty = (b + 1 < constants::num_qty_bands) ? constants::qty_band_starts[b + 1] - 1
+                                                                       : std::numeric_limits<int32_t>::max();
+                    crv.cr_rate = constants::commission_pct(c_tier, b);
+                    commission_rates.add(commission_rate_key(c_tier, tt_id, ex_id, constants::qty_band_starts[b]), crv);
+                }
+            }
+        }
+    }
+
+    typename db_type::zc_table_type::bulk_loader zip_codes(db.tbl_zip_codes());
+    for (int i = 0; i < constants::num_zip_codes; ++i) {
+        zip_code_row zcv;
+        zcv.zc_town = random_a_string(8, 20);
+        zcv.zc_div = random_a_string(2, 2);
+        zip_codes.add(zip_code_key(constants::zip_code(i)), zcv);
+    }
+
+    typename db_type::ex_table_type::bulk_loader exchanges(db.tbl_exchanges());
+    typename db_type::ad_table_type::bulk_loader addresses(db.tbl_addresses());
+    for (int i = 0; i < constants::num_exchanges; ++i) {
+        exchange_row exv;
+        exv.ex_name = std::string(constants::exchange_ids[i]) + " Exchange";
+        exv.ex_num_symb = int32_t(db.scale().num_securities / constants::num_exchanges);
+        exv.ex_open = 930;
+        exv.ex_close = 1600;
+        exv.ex_desc = random_a_string(50, 150);
+        exv.ex_ad_id = db.scale().exchange_address(i);
+        exchanges.add(exchange_key(constants::exchange_ids[i]), exv);
+        addresses.add(address_key(exv.ex_ad_id), random_address());
+    }
+
+    typename db_type::sc_table_type::bulk_loader sectors(db.tbl_sectors());
+    for (int i = 0; i < constants::num_sectors; ++i) {
+        sector_row scv;
+        scv.sc_name = constants::sector_names[i];
+        sectors.add(sector_key(constants::sector_id(i)), scv);
+    }
+
+    typename db_type::in_table_type::bulk_loader industries(db.tbl_industries());
+    for (int i = 0; i < constants::num_industries; ++i) {
+        industry_row inv;
+        inv.in_name = "Industry " + std::to_string(i);
+        inv.in_sc_id = constants::sector_id(i % constants::num_sectors);
+        industries.add(industry_key(constants::industry_id(i)), inv);
+    }
+}
+
+template <typename DBParams>
+void tpce_loader<DBParams>::load_market() {
+    typedef tpce_db<DBParams> db_type;
+    auto& scale = db.scale();
+
+    typename db_type::co_table_type::bulk_loader companies(db.tbl_companies());
+    typename db_type::ad_table_type::bulk_loader addresses(db.tbl_addresses());
+    typename db_type::cp_table_type::bulk_loader competitors(db.tbl_company_competitors());
+    typename db_type::fi_table_type::bulk_loader financials(db.tbl_financials());
+    typename db_type::ni_table_type::bulk_loader news_items(db.tbl_news_items());
+    typename db_type::nx_table_type::bulk_loader news_xrefs(db.tbl_news_xrefs());
+    for (int64_t co_id = 1; co_id <= scale.num_companies; ++co_id) {
+        company_row cov;
+        cov.co_st_id = "ACTV";
+        cov.co_name = "Company " + std::to_string(co_id);
+        cov.co_in_id = constants::industry_id(int((co_id - 1) % constants::num_industries));
+        cov.co_sp_rate = "AAA";
+        cov.co_ceo = random_a_string(10, 40);
+        cov.co_ad_id = scale.company_address(co_id);
+        cov.co_desc = random_a_string(50, 150);
+        cov.co_open_date = ig.gen_history_dts();
+        companies.add(company_key(co_id), cov);
+        addresses.add(address_key(cov.co_ad_id), random_address());
+
+        std::set<int64_t> comp_co_ids;
+        for (int i = 1; i <= constants::competitors_per_company; ++i)
+            comp_co_ids.insert((co_id - 1 + 7 * i) % scale.num_companies + 1);
+        for (auto comp_co_id : comp_co_ids)
+            competitors.add(company_competitor_key(co_id, comp_co_id, cov.co_in_id), bench::dummy_row());
+
+        for (int q = 0; q < constants::financial_quarters; ++q) {
+            financial_row fiv;
+            fiv.fi_qtr_start_date = constants::base_dts - (constants::financial_quarters - q) * 91 * constants::seconds_per_day;
+            fiv.fi_revenue = float(ig.random(100000, 10000000));
+            fiv.fi_net_earn = fiv.fi_revenue / 10;
+            fiv.fi_basic_eps = float(ig.random(1, 500)) / 100;
+            fiv.fi_dilut_eps = fiv.fi_basic_eps * 0.9f;
+            fiv.fi_margin = float(ig.random(1, 50)) / 100;
+            fiv.fi_inventory = float(ig.random(10000, 1000000));
+            fiv.fi_assets = float(ig.random(100000, 100000000));
+            fiv.fi_liability = fiv.fi_assets / 2;
+            fiv.fi_out_basic = int64_t(ig.random(1000000, 100000000));
+            fiv.fi_out_dilut = fiv.fi_out_basic * 11 / 10;
+            financials.add(financial_key(co_id, 2000 + q / 4, q % 4 + 1), fiv);
+        }
+
+        for (int n = 0; n < constants::news_per_company; ++n) {
+            int64_t ni_id = (co_id - 1) * constants::news_per_company + n + 1;
+            news_item_row niv;
+            niv.ni_headline = random_a_string(40, 80);
+            niv.ni_summary = random_a_string(100, 225);
+            niv.ni_item = random_a_string(500, 1024);
+            niv.ni_dts = ig.gen_history_dts();
+            niv.ni_source = random_a_string(10, 30);
+            niv.ni_author = random_a_string(10, 30);
+            news_items.add(news_item_key(ni_id), niv);
+            news_xrefs.add(news_xref_key(co_id, ni_id), bench::dummy_row());
+        }
+    }
+
+    // symbols sort in the order of their indexes
+    typename db_type::s_table_type::bulk_loader securities(db.tbl_securities());
+    typename db_type::dm_table_type::bulk_loader daily_markets(db.tbl_daily_markets());
+    typename db_type::lt_table_type::bulk_loader last_trades(db.tbl_last_trades());
+    for (int64_t s_idx = 1; s_idx <= scale.num_securities; ++s_idx) {
+        fix_string<15> symb = constants::symbol(s_idx);
+        float price = ig.random_price();
+
+        security_row sv;
+        sv.s_issue = "COMMON";
+        sv.s_st_id = "ACTV";
+        sv.s_name = "Security " + std::to_string(s_idx);
+        sv.s_ex_id = constants::exchange_ids[s_idx % constants::num_exchanges];
+        sv.s_co_id = (s_idx - 1) % scale.num_companies + 1;
+        sv.s_num_out = int64_t(ig.random(1000000, 100000000));
+        sv.s_start_date = ig.gen_history_dts();
+        sv.s_exch_date = sv.s_start_date;
+        sv.s_pe = float(ig.random(100, 12000)) / 100;
+        sv.s_52wk_high = constants::max_price;
+        sv.s_52wk_high_date = ig.gen_history_dts();
+        sv.s_52wk_low = constants::min_price;
+        sv.s_52wk_low_date = ig.gen_history_dts();
+        sv.s_dividend = float(ig.random(0, 100)) / 100;
+        sv.s_yield = float(ig.random(0, 1000)) / 100;
+        securities.add(security_key(symb), sv);
+
+        for (int d = 0; d < constants::daily_market_days; ++d) {
+            daily_market_row dmv;
+            dmv.dm_close = ig.random_price();
+            dmv.dm_high = std::max(dmv.dm_close, ig.random_price());
+            dmv.dm_low = std::min(dmv.dm_close, ig.random_price());
+            dmv.dm_vol = int64_t(ig.random(1000, 1000000));
+            daily_markets.add(daily_market_key(symb, constants::base_dts - (constants::daily_market_days - d) * constants::seconds_per_day), dmv);
+        }
+
+        last_trade_row ltv;
+        ltv.lt_dts = constants::base_dts;
+        ltv.lt_price = price;
+        ltv.lt_open_price = price;
+        ltv.lt_vol = 0;
+        last_trades.add(last_trade_key(symb), ltv);
+    }
+}
+
+// Customers, their accounts, and the trade history of each account. The
+// loaded trades are all completed buys, each still held.
+template <typename DBParams>
+void tpce_loader<DBParams>::load_customers() {
+    typedef tpce_db<DBParams> db_type;
+    auto& scale = db.scale();
+
+    typename db_type::c_table_type::bulk_loader customers(db.tbl_customers());
+    typename db_type::ad_table_type::bulk_loader addresses(db.tbl_addresses());
+    typename db_type::cx_table_type::bulk_loader customer_taxrates(db.tbl_customer_taxrates());
+    typename db_type::wl_table_type::bulk_loader watch_lists(db.tbl_watch_lists());
+    typename db_type::wi_table_type::bulk_loader watch_items(db.tbl_watch_items());
+    typename db_type::ca_table_type::bulk_loader accounts(db.tbl_accounts());
+    typename db_type::ap_table_type::bulk_loader account_permissions(db.tbl_account_permissions());
+    typename db_type::t_table_type::bulk_loader trades(db.tbl_trades());
+    typename db_type::se_table_type::bulk_loader settlements(db.tbl_settlements());
+    typename db_type::th_table_type::bulk_loader trade_histories(db.tbl_trade_histories());
+    typename db_type::ct_table_type::bulk_loader cash_transactions(db.tbl_cash_transactions());
+    typename db_type::h_table_type::bulk_loader holdings(db.tbl_holdings());
+    typename db_type::hh_table_type::bulk_loader holding_histories(db.tbl_holding_histories());
+    typename db_type::hs_table_type::bulk_loader holding_summaries(db.tbl_holding_summaries());
+
+    std::vector<int32_t> b_num_trades(scale.num_brokers + 1, 0);
+    std::vector<float> b_comm_totals(scale.num_brokers + 1, 0.0f);
+    int64_t t_id = 0;
+
+    for (int64_t c_id = 1; c_id <= scale.num_customers; ++c_id) {
+        customer_row cv;
+        cv.c_tax_id = random_n_string(9, 9);
+        cv.c_st_id = "ACTV";
+        cv.c_l_name = random_a_string(5, 15);
+        cv.c_f_name = random_a_string(5, 15);
+        cv.c_m_name = std::string(1, char('A' + ig.random(0, 25)));
+        cv.c_gndr = ig.percent(50) ? "M" : "F";
+        cv.c_tier = int32_t(ig.random(1, constants::num_tiers));
+        cv.c_dob = ig.gen_history_dts();
+        cv.c_ad_id = scale.customer_address(c_id);
+        cv.c_ctry_1 = "011";
+        cv.c_area_1 = random_n_string(3, 3);
+        cv.c_local_1 = random_n_string(7, 7);
+        cv.c_ext_1 = "";
+        cv.c_ctry_2 = "011";
+        cv.c_area_2 = random_n_string(3, 3);
+        cv.c_local_2 = random_n_string(7, 7);
+        cv.c_ext_2 = "";
+        cv.c_ctry_3 = "";
+        cv.c_area_3 = "";
+        cv.c_local_3 = "";
+        cv.c_ext_3 = "";
+        cv.c_email_1 = std::string(cv.c_f_name.c_str()) + "@example.com";
+        cv.c_email_2 = std::string(cv.c_l_name.c_str()) + "@example.com";
+        customers.add(customer_key(c_id), cv);
+        addresses.add(address_key(cv.c_ad_id), random_address());
+        std::string exec_name = std::string(cv.c_f_name.c_str()) + " " + cv.c_l_name.c_str();
+
+        int tx_div = int(ig.random(1, constants::num_tax_divisions));
+        customer_taxrates.add(customer_taxrate_key(c_id, "CN" + std::to_string(tx_div)), bench::dummy_row());
+        customer_taxrates.add(customer_taxrate_key(c_id, "US" + std::to_string(tx_div)), bench::dummy_row());
+
+        // a customer's watch list has the customer's id
+        watch_list_row wlv;
+        wlv.wl_c_id = c_id;
+        watch_lists.add(watch_list_key(c_id), wlv);
+        std::set<int64_t> watched;
+        size_t num_watched = std::min<size_t>(ig.random(constants::min_watch_items, constants::max_watch_items),
+                                              scale.num_securities);
+        while (watched.size() < num_watched)
+            watched.insert(ig.gen_security_index());
+        for (auto s_idx : watched)
+            watch_items.add(watch_item_key(c_id, constants::symbol(s_idx)), bench::dummy_row());
+
+        for (int n = 1; n <= constants::num_accounts(c_id); ++n) {
+            int64_t ca_id = constants::account_id(c_id, n);
+
+            customer_account_row cav;
+            cav.ca_b_id = ig.gen_broker_id();
+            cav.ca_c_id = c_id;
+            cav.ca_name = "Account " + std::to_string(n) + " of " + exec_name;
+            cav.ca_tax_st = int32_t(ig.random(0, 2));
+            cav.ca_bal = float(ig.random(1000000, 10000000)) / 100;
+            accounts.add(customer_account_key(ca_id), cav);
+
+            // the owner, and one other person who may trade on the account
+            account_permission_row apv;
+            apv.ap_tax_id = cv.c_tax_id;
+            apv.ap_l_name = cv.c_l_name;
+            apv.ap_f_name = cv.c_f_name;
+            account_permissions.add(account_permission_key(ca_id, "0000"), apv);
+            apv.ap_tax_id = random_n_string(9, 9);
+            apv.ap_l_name = random_a_string(5, 15);
+            apv.ap_f_name = random_a_string(5, 15);
+            account_permissions.add(account_permission_key(ca_id, "0001"), apv);
+
+            std::vector<int64_t> held;
+            for (auto i = ig.random(1, 5); i > 0; --i)
+                held.push_back(ig.gen_security_index());
+            std::map<int64_t, int32_t> held_qtys;
+
+            for (int i = 0; i < scale.trades_per_account; ++i) {
+                ++t_id;
+                int64_t s_idx = held[ig.random(0, held.size() - 1)];
+                fix_string<15> symb = constants::symbol(s_idx);
+                bool is_limit = ig.percent(20);
+                int32_t qty = int32_t(100 << ig.random(0, 3));
+                float price = ig.random_price();
+                uint32_t dts = ig.gen_history_dts();
+
+                trade_row tv;
+                tv.t_dts = dts;
+                tv.t_st_id = "CMPT";
+                tv.t_tt_id = is_limit ? "TLB" : "TMB";
+                tv.t_is_cash = !ig.percent(8);
+                tv.t_s_symb = symb;
+                tv.t_qty = qty;
+                tv.t_bid_price = price;
+                tv.t_ca_id = ca_id;
+                tv.t_exec_name = exec_name;
+                tv.t_trade_price = price;
+                tv.t_chrg = constants::charge(cv.c_tier);
+                tv.t_comm = constants::commission_pct(cv.c_tier, 0) / 100 * qty * price;
+                tv.t_tax = 0.0f;
+                tv.t_lifo = ig.percent(50);
+                trades.add(trade_key(t_id), tv);
+
+                trade_history_row thv;
+                thv.th_dts = dts;
+                trade_histories.add(trade_history_key(t_id, "CMPT"), thv);
+                if (is_limit)
+                    trade_histories.add(trade_history_key(t_id, "PNDG"), thv);
+                trade_histories.add(trade_history_key(t_id, "SBMT"), thv);
+
+                float se_amount = -(qty * price) - tv.t_chrg - tv.t_comm;
+                settlement_row sev;
+                sev.se_cash_type = tv.t_is_cash ? "Cash Account" : "Margin";
+                sev.se_cash_due_date = dts + 2 * constants::seconds_per_day;
+                sev.se_amt = se_amount;
+                settlements.add(settlement_key(t_id), sev);
+
+                if (tv.t_is_cash) {
+                    cash_transaction_row ctv;
+                    ctv.ct_dts = dts;
+                    ctv.ct_amt = se_amount;
+                    ctv.ct_name = std::string(tv.t_tt_id) + " " + std::to_string(qty) + " shares of Security " + std::to_string(s_idx);
+                    cash_transactions.add(cash_transaction_key(t_id), ctv);
+                }
+
+                holding_row hv;
+                hv.h_ca_id = ca_id;
+                hv.h_s_symb = symb;
+                hv.h_dts = dts;
+                hv.h_price = price;
+                hv.h_qty = qty;
+                holdings.add(holding_key(t_id), hv);
+
+                holding_history_row hhv;
+                hhv.hh_before_qty = 0;
+                hhv.hh_after_qty = qty;
+                holding_histories.add(holding_history_key(t_id, t_id), hhv);
+
+                held_qtys[s_idx] += qty;
+                b_num_trades[cav.ca_b_id] += 1;
+                b_comm_totals[cav.ca_b_id] += tv.t_comm;
+            }
+
+            for (auto& hq : held_qtys) {
+                holding_summary_row hsv;
+                hsv.hs_qty = hq.second;
+                holding_summaries.add(holding_summary_key(ca_id, constants::symbol(hq.first)), hsv);
+            }
+        }
+    }
+
+    typename db_type::b_table_type::bulk_loader brokers(db.tbl_brokers());
+    for (int64_t b_id = 1; b_id <= scale.num_brokers; ++b_id) {
+        broker_row bv;
+        bv.b_st_id = "ACTV";
+        bv.b_name = "Broker " + std::to_string(b_id);
+        bv.b_num_trades = b_num_trades[b_id];
+        bv.b_comm_total = b_comm_totals[b_id];
+        brokers.add(broker_key(b_id), bv);
+    }
+
+    // trades made during the run follow the loaded ones
+    scale.num_loaded_trades = t_id;
+    db.tbl_trades().set_key_gen(t_id + 1);
+}
+
+template <typename DBParams>
+address_row tpce_loader<DBParams>::random_address() {
+    address_row adv;
+    adv.ad_line1 = random_n_string(1, 5) + " " + random_a_string(5, 20);
+    adv.ad_line2 = "";
+    adv.ad_zc_code = constants::zip_code(int(ig.random(0, constants::num_zip_codes - 1)));
+    adv.ad_ctry = "USA";
+    return adv;
+}
+
+template <typename DBParams>
+std::string tpce_loader<DBParams>::random_a_string(int x, int y) {
+    size_t len = ig.random(x, y);
+    std::string str;
+    str.reserve(len);
+
+    for (auto i = 0u; i < len; ++i) {
+        auto n = ig.random(0, 51);
+        str.push_back((n < 26) ? char('a' + n) : char('A' + (n - 26)));
+    }
+    return str;
+}
+
+template <typename DBParams>
+std::string tpce_loader<DBParams>::random_n_string(int x, int y) {
+    size_t len = ig.random(x, y);
+    std::string str;
+    str.reserve(len);
+
+    for (auto i = 0u; i < len; ++i)
+        str.push_back(char('0' + ig.random(0, 9)));
+    return str;
+}
+// @endsection: loading
+
+// @section: clp parser definitions
+enum {
+    opt_dbid = 1, opt_nthrs, opt_time, opt_perf, opt_pfcnt, opt_cm, opt_units, opt_trades
+};
+
+static const Clp_Option options[] = {
+    { "dbid",               'i', opt_dbid,   Clp_ValString, Clp_Optional },
+    { "nthreads",           't', opt_nthrs,  Clp_ValInt,    Clp_Optional },
+    { "time",               'l', opt_time,   Clp_ValDouble, Clp_Optional },
+    { "perf",               'p', opt_perf,   Clp_NoVal,     Clp_Optional },
+    { "perf-counter",       'c', opt_pfcnt,  Clp_NoVal,     Clp_Negate| Clp_Optional },
+    { "cm",                 'C', opt_cm,     Clp_ValString, Clp_Optional },
+    { "load-units",         'u', opt_units,  Clp_ValInt,    Clp_Optional },
+    { "trades-per-account", 'a', opt_trades, Clp_ValInt,    Clp_Optional }
+};
+
+// @endsection: clp parser definitions
+
+template <typename DBParams>
+class tpce_access {
+public:
+    static void tpce_runner_thread(tpce_db<DBParams>& db, db_profiler& prof, int runner_id, double time_limit,
+                                   tpce_txn_stats& txn_stats) {
+        tpce_runner<DBParams> runner(runner_id, db);
+        typedef typename tpce_runner<DBParams>::txn_type txn_type;
+
+        ::TThread::set_id(runner_id);
+        set_affinity(runner_id);
+        db.thread_init_all();
+
+        uint64_t tsc_diff = (uint64_t)(time_limit * db_params::constants::processor_tsc_frequency * db_params::constants::billion);
+        auto start_t = prof.start_timestamp();
+
+        while (true) {
+            auto curr_t = read_tsc();
+            if ((curr_t - start_t) >= tsc_diff)
+                break;
+
+            txn_type t = runner.next_transaction();
+            size_t aborts = 0;
+            switch (t) {
+                case txn_type::broker_volume:
+                    aborts = runner.run_txn_broker_volume();
+                    break;
+                case txn_type::customer_position:
+                    aborts = runner.run_txn_customer_position();
+                    break;
+                case txn_type::market_feed:
+                    aborts = runner.run_txn_market_feed();
+                    break;
+                case txn_type::market_watch:
+                    aborts = runner.run_txn_market_watch();
+                    break;
+                case txn_type::security_detail:
+                    aborts = runner.run_txn_security_detail();
+                    break;
+                case txn_type::trade_lookup:
+                    aborts = runner.run_txn_trade_lookup();
+                    break;
+                case txn_type::trade_order:
+                    aborts = runner.run_txn_trade_order();
+                    break;
+                case txn_type::trade_result:
+                    aborts = runner.run_txn_trade_result();
+                    break;
+                case txn_type::trade_status:
+                    aborts = runner.run_txn_trade_status();
+                    break;
+                case txn_type::trade_update:
+                    aborts = runner.run_txn_trade_update();
+                    break;
+                default:
+                    fprintf(stderr, "r:%d unknown txn type\n", runner_id);
+                    assert(false);
+                    break;
+            };
+
+            runner.record(t, aborts);
+        }
+
+        Transaction::rcu_quiesce();
+        txn_stats = runner.stats();
+    }
+
+    static uint64_t run_benchmark(tpce_db<DBParams>& db, db_profiler& prof, int num_runners, double time_limit) {
+        std::vector<std::thread> runner_thrs;
+        std::vector<tpce_txn_stats> txn_stats(static_cast<size_t>(num_runners));
+
+        for (int i = 0; i < num_runners; ++i)
+            runner_thrs.emplace_back(tpce_runner_thread, std::ref(db), std::ref(prof),
+                                     i, time_limit, std::ref(txn_stats[i]));
+        for (auto &t : runner_thrs)
+            t.join();
+
+        tpce_txn_stats total;
+        for (auto& s : txn_stats)
+            total += s;
+        total.print(std::cout, time_limit);
+        return total.total_commits();
+    }
+
+    static int execute(int argc, const char *const *argv) {
+        int ret = 0;
+
+        bool spawn_perf = false;
+        bool counter_mode = false;
+        int num_load_units = 1;
+        int trades_per_account = 10;
+        int num_threads = 1;
+        double time_limit = 10.0;
+
+        Clp_Parser *clp = Clp_NewParser(argc, argv, arraysize(options), options);
+
+        int opt;
+        bool clp_stop = false;
+        while (!clp_stop && ((opt = Clp_Next(clp)) != Clp_Done)) {
+            switch (opt) {
+                case opt_dbid:
+                case opt_cm:
+                    break;
+                case opt_nthrs:
+                    num_threads = clp->val.i;
+                    break;
+                case opt_time:
+                    time_limit = clp->val.d;
+                    break;
+                case opt_perf:
+                    spawn_perf = !clp->negated;
+                    break;
+                case opt_pfcnt:
+                    counter_mode = !clp->negated;
+                    break;
+                case opt_units:
+                    num_load_units = clp->val.i;
+                    break;
+                case opt_trades:
+                    trades_per_account = clp->val.i;
+                    break;
+                default:
+                    print_usage(argv[0]);
+                    ret = 1;
+                    clp_stop = true;
+                    break;
+            }
+        }
+
+        Clp_DeleteParser(clp);
+        if (ret != 0)
+            return ret;
+
+        if (num_load_units < 1 || trades_per_account < 1) {
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        if (num_threads > TThread::max_threads())
+            TThread::set_max_threads(num_threads);
+
+        auto profiler_mode = counter_mode ?
+                             Profiler::perf_mode::counters : Profiler::perf_mode::record;
+
+        if (counter_mode && !spawn_perf) {
+            // turns on profiling automatically if perf counters are requested
+            spawn_perf = true;
+        }
+
+        if (spawn_perf) {
+            std::cout << "Info: Spawning perf profiler in "
+                      << (counter_mode ? "counter" : "record") << " mode" << std::endl;
+        }
+
+        db_profiler prof(spawn_perf);
+        tpce_db<DBParams> db(tpce_scale(num_load_units, trades_per_account));
+
+        std::cout << "Prepopulating database..." << std::endl;
+        bench::load_report load;
+        tpce_loader<DBParams>(db).load();
+        std::cout << "Prepopulation complete." << std::endl;
+        load.print(std::cout);
+
+        // Trade-Result deletes holdings and Market-Feed trade requests;
+        // their memory is reclaimed as the global epoch advances
+        pthread_t advancer;
+        pthread_create(&advancer, nullptr, Transaction::epoch_advancer, nullptr);
+
+        prof.start(profiler_mode);
+        auto num_trans = run_benchmark(db, prof, num_threads, time_limit);
+        prof.finish(num_trans);
+
+        Transaction::global_epochs.run = false;
+        pthread_join(advancer, nullptr);
+        return 0;
+    }
+}; // class tpce_access
+
+}; // namespace tpce
+
+using namespace tpce;
+
+static inline void print_usage(const char *argv_0) {
+    std::stringstream ss;
+    ss << "Usage of " << std::string(argv_0) << ":" << std::endl
+       << "  --dbid=<STRING> (or -i<STRING>)" << std::endl
+       << "    Specify the type of DB concurrency control used. Can be one of the followings:" << std::endl
+       << "      default, opaque, 2pl, adaptive, swiss, tictoc, mvcc" << std::endl
+       << "  --nthreads=<NUM> (or -t<NUM>)" << std::endl
+       << "    Specify the number of threads (or TPC-E customer emulators, default 1)." << std::endl
+       << "  --time=<NUM> (or -l<NUM>)" << std::endl
+       << "    Specify the time (duration) for which the benchmark is run (default 10 seconds)." << std::endl
+       << "  --perf (or -p)" << std::endl
+       << "    Spawns perf profiler in record mode for the duration of the benchmark run." << std::endl
+       << "  --perf-counter (or -c)" << std::endl
+       << "    Spawns perf profiler in counter mode for the duration of the benchmark run." << std::endl
+       << "  --cm=<STRING> (or -C<STRING>)" << std::endl
+       << "    Specify the contention management policy. Can be one of the followings:" << std::endl
+       << "      timestamp (default), greedy, karma, polka, wound_wait, backoff" << std::endl
+       << "  --load-units=<NUM> (or -u<NUM>)" << std::endl
+       << "    Specify the database size in load units of 1000 customers (default 1)." << std::endl
+       << "  --trades-per-account=<NUM> (or -a<NUM>)" << std::endl
+       << "    Specify the number of trades loaded into each account's history (default 10)." << std::endl;
+    std::cout << ss.str() << std::flush;
+}
+
+double db_params::constants::processor_tsc_frequency;
+
+int main(int argc, const char *const *argv) {
+    db_params::db_params_id dbid = db_params::db_params_id::Default;
+    ContentionManager::policy_type cm_policy = ContentionManager::policy_type::timestamp;
+    int ret_code = 0;
+
+    Clp_Parser *clp = Clp_NewParser(argc, argv, arraysize(options), options);
+
+    int opt;
+    bool clp_stop = false;
+    while (!clp_stop && ((opt = Clp_Next(clp)) != Clp_Done)) {
+        switch (opt) {
+        case opt_dbid:
+            dbid = db_params::parse_dbid(clp->val.s);
+            if (dbid == db_params::db_params_id::None) {
+                std::cout << "Unsupported DB CC id: "
+                    << ((clp->val.s == nullptr) ? "" : std::string(clp->val.s)) << std::endl;
+                print_usage(argv[0]);
+                ret_code = 1;
+                clp_stop = true;
+            }
+            break;
+        case opt_cm:
+            if (!ContentionManager::parse_policy(clp->val.s, cm_policy)) {
+                std::cout << "Unsupported contention manager: "
+                    << ((clp->val.s == nullptr) ? "" : std::string(clp->val.s)) << std::endl;
+                print_usage(argv[0]);
+                ret_code = 1;
+                clp_stop = true;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    Clp_DeleteParser(clp);
+    if (ret_code != 0)
+        return ret_code;
+    ContentionManager::set_policy(cm_policy);
+
+    auto cpu_freq = determine_cpu_freq();
+    if (cpu_freq == 0.0)
+        return 1;
+    else
+        db_params::constants::processor_tsc_frequency = cpu_freq;
+
+    switch (dbid) {
+    case db_params::db_params_id::Default:
+        ret_code = tpce_access<db_params::db_default_params>::execute(argc, argv);
+        break;
+    case db_params::db_params_id::Opaque:
+        ret_code = tpce_access<db_params::db_opaque_params>::execute(argc, argv);
+        break;
+    case db_params::db_params_id::TwoPL:
+        ret_code = tpce_access<db_params::db_2pl_params>::execute(argc, argv);
+        break;
+    case db_params::db_params_id::Adaptive:
+        ret_code = tpce_access<db_params::db_adaptive_params>::execute(argc, argv);
+        break;
+    case db_params::db_params_id::Swiss:
+        ret_code = tpce_access<db_params::db_swiss_params>::execute(argc, argv);
+        break;
+    case db_params::db_params_id::TicToc:
+        ret_code = tpce_access<db_params::db_tictoc_params>::execute(argc, argv);
+        break;
+    case db_params::db_params_id::MVCC:
+        ret_code = tpce_access<db_params::db_mvcc_params>::execute(argc, argv);
+        break;
+    default:
+        std::cerr << "unknown db config parameter id" << std::endl;
+        ret_code = 1;
+        break;
+    };
+
+    return ret_code;
+}
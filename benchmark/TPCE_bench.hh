@@ -0,0 +1,543 @@
+#pragma once
+
+#include <ctime>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "compiler.hh"
+#include "clp.h"
+#include "SystemProfiler.hh"
+#include "DB_structs.hh"
+#include "TPCE_structs.hh"
+#include "DB_index.hh"
+#include "DB_params.hh"
+
+// A TPC-E-like brokerage workload: the ten transactions of the standard
+// mix, run against the TPC-E schema. Data-Maintenance and Trade-Cleanup,
+// which run on a timer rather than in the mix, are left out, and so are the
+// frames that look up trades by security, for which the schema keeps no
+// index. Trades that Trade-Order and Market-Feed submit to the market are
+// queued on the runner that submitted them, standing in for the market
+// exchange emulator, and Trade-Result takes them from there.
+
+namespace tpce {
+
+using namespace db_params;
+
+struct constants {
+    // TPC-E scales the database in load units of 1000 customers
+    static constexpr int64_t customers_per_load_unit = 1000;
+    static constexpr int64_t companies_per_load_unit = 500;
+    static constexpr int64_t securities_per_load_unit = 685;
+    static constexpr int64_t brokers_per_load_unit = 10;
+
+    // account ids reserved per customer; a customer has 1 to 9 accounts
+    static constexpr int64_t max_accounts_per_customer = 10;
+    static constexpr int min_watch_items = 5;
+    static constexpr int max_watch_items = 15;
+    static constexpr int competitors_per_company = 3;
+    static constexpr int financial_quarters = 20;
+    static constexpr int news_per_company = 2;
+    static constexpr int daily_market_days = 30;
+
+    static constexpr int num_exchanges = 4;
+    static constexpr int num_sectors = 12;
+    static constexpr int num_industries = 102;
+    static constexpr int num_zip_codes = 100;
+    static constexpr int num_tax_divisions = 5;
+    static constexpr int num_tiers = 3;
+
+    // the loaded trades are dated in the days before base_dts; trades made
+    // during the run are dated by the clock
+    static constexpr uint32_t base_dts = 1500000000;
+    static constexpr uint32_t seconds_per_day = 86400;
+    static constexpr uint32_t trade_history_days = 300;
+
+    static constexpr float min_price = 20.0f;
+    static constexpr float max_price = 30.0f;
+
+    static constexpr int num_trade_types = 5;
+    static constexpr int num_qty_bands = 4;
+
+    static const char *const exchange_ids[num_exchanges];
+    static const char *const sector_names[num_sectors];
+    // in key order
+    static const char *const trade_type_ids[num_trade_types];
+    static const int32_t qty_band_starts[num_qty_bands];
+
+    // the charge of a trade, and its commission as a percentage of its
+    // value, for customers of tier c_tier
+    static float charge(int32_t c_tier) {
+        return 10.0f / c_tier;
+    }
+    static float commission_pct(int32_t c_tier, int qty_band) {
+        return 0.5f - 0.1f * c_tier - 0.05f * qty_band;
+    }
+
+    // the accounts of customer c_id are account_id(c_id, 1), ...,
+    // account_id(c_id, num_accounts(c_id))
+    static int num_accounts(int64_t c_id) {
+        return 1 + int((uint64_t(c_id) * 2654435761u >> 7) % (max_accounts_per_customer - 1));
+    }
+    static int64_t account_id(int64_t c_id, int n) {
+        return (c_id - 1) * max_accounts_per_customer + n;
+    }
+    static int64_t account_customer(int64_t ca_id) {
+        return (ca_id - 1) / max_accounts_per_customer + 1;
+    }
+
+    static fix_string<15> symbol(int64_t s_idx);
+    static std::string industry_id(int in_idx);
+    static std::string sector_id(int sc_idx);
+    static std::string zip_code(int zc_idx);
+};
+
+// table sizes of a database of num_load_units load units
+struct tpce_scale {
+    int64_t num_customers;
+    int64_t num_companies;
+    int64_t num_securities;
+    int64_t num_brokers;
+    int trades_per_account;
+    // the loaded trades have ids 1, ..., num_loaded_trades
+    int64_t num_loaded_trades;
+
+    tpce_scale(int num_load_units, int trades)
+        : num_customers(constants::customers_per_load_unit * num_load_units),
+          num_companies(constants::companies_per_load_unit * num_load_units),
+          num_securities(constants::securities_per_load_unit * num_load_units),
+          num_brokers(constants::brokers_per_load_unit * num_load_units),
+          trades_per_account(trades), num_loaded_trades(0) {}
+
+    // addresses of the exchanges, then the companies, then the customers
+    int64_t exchange_address(int ex_idx) const {
+        return ex_idx + 1;
+    }
+    int64_t company_address(int64_t co_id) const {
+        return constants::num_exchanges + co_id;
+    }
+    int64_t customer_address(int64_t c_id) const {
+        return constants::num_exchanges + num_companies + c_id;
+    }
+};
+
+class tpce_input_generator {
+public:
+    tpce_input_generator(int id, const tpce_scale& scale)
+            : gen(id), scale_(scale) {}
+
+    uint64_t random(uint64_t x, uint64_t y) {
+        std::uniform_int_distribution<uint64_t> dist(x, y);
+        return dist(gen);
+    }
+    float random_price() {
+        std::uniform_real_distribution<float> dist(constants::min_price, constants::max_price);
+        return dist(gen);
+    }
+    bool percent(uint64_t pct) {
+        return random(1, 100) <= pct;
+    }
+
+    int64_t gen_customer_id() {
+        return random(1, scale_.num_customers);
+    }
+    int64_t gen_account_id() {
+        return gen_account_id(gen_customer_id());
+    }
+    int64_t gen_account_id(int64_t c_id) {
+        return constants::account_id(c_id, int(random(1, constants::num_accounts(c_id))));
+    }
+    int64_t gen_security_index() {
+        return random(1, scale_.num_securities);
+    }
+    int64_t gen_broker_id() {
+        return random(1, scale_.num_brokers);
+    }
+    int64_t gen_loaded_trade_id() {
+        return random(1, scale_.num_loaded_trades);
+    }
+    // a time within the loaded trade history
+    uint32_t gen_history_dts() {
+        return uint32_t(random(constants::base_dts - constants::trade_history_days * constants::seconds_per_day,
+                               constants::base_dts - 1));
+    }
+    const tpce_scale& scale() const {
+        return scale_;
+    }
+    std::mt19937& random_generator() {
+        return gen;
+    }
+
+private:
+    std::mt19937 gen;
+    const tpce_scale& scale_;
+};
+
+template <typename DBParams>
+class tpce_db {
+public:
+    template <typename K, typename V>
+    using UIndex = unordered_index<K, V, DBParams>;
+
+    template <typename K, typename V>
+    using OIndex = ordered_index<K, V, DBParams>;
+
+    template <typename K, typename Base, typename Extract>
+    using SIndex = secondary_index<K, Base, Extract>;
+
+    // tables only looked up by key are hashed
+    typedef UIndex<status_type_key, status_type_row>                st_table_type;
+    typedef UIndex<trade_type_key, trade_type_row>                  tt_table_type;
+    typedef UIndex<taxrate_key, taxrate_row>                        tx_table_type;
+    typedef UIndex<charge_key, charge_row>                          ch_table_type;
+    typedef OIndex<commission_rate_key, commission_rate_row>        cr_table_type;
+    typedef OIndex<zip_code_key, zip_code_row>                      zc_table_type;
+    typedef OIndex<exchange_key, exchange_row>                      ex_table_type;
+    typedef OIndex<sector_key, sector_row>                          sc_table_type;
+    typedef OIndex<industry_key, industry_row>                      in_table_type;
+
+    typedef UIndex<customer_key, customer_row>                      c_table_type;
+    typedef OIndex<customer_account_key, customer_account_row>      ca_table_type;
+    typedef OIndex<account_permission_key, account_permission_row>  ap_table_type;
+    typedef OIndex<customer_taxrate_key, bench::dummy_row>          cx_table_type;
+    typedef OIndex<address_key, address_row>                        ad_table_type;
+
+    typedef OIndex<company_key, company_row>                        co_table_type;
+    typedef OIndex<company_competitor_key, bench::dummy_row>        cp_table_type;
+    typedef UIndex<security_key, security_row>                      s_table_type;
+    typedef OIndex<daily_market_key, daily_market_row>              dm_table_type;
+    typedef OIndex<financial_key, financial_row>                    fi_table_type;
+    typedef UIndex<last_trade_key, last_trade_row>                  lt_table_type;
+    typedef OIndex<news_item_key, news_item_row>                    ni_table_type;
+    typedef OIndex<news_xref_key, bench::dummy_row>                 nx_table_type;
+
+    typedef UIndex<broker_key, broker_row>                          b_table_type;
+    typedef OIndex<trade_key, trade_row>                            t_table_type;
+    typedef SIndex<trade_account_idx_key, t_table_type, trade_account_idx_extract> ti_table_type;
+    typedef OIndex<settlement_key, settlement_row>                  se_table_type;
+    typedef OIndex<trade_history_key, trade_history_row>            th_table_type;
+    typedef OIndex<cash_transaction_key, cash_transaction_row>      ct_table_type;
+    typedef OIndex<holding_key, holding_row>                        h_table_type;
+    typedef SIndex<holding_account_idx_key, h_table_type, holding_account_idx_extract> hi_table_type;
+    typedef OIndex<holding_history_key, holding_history_row>        hh_table_type;
+    typedef OIndex<holding_summary_key, holding_summary_row>        hs_table_type;
+    typedef OIndex<watch_list_key, watch_list_row>                  wl_table_type;
+    typedef OIndex<watch_item_key, bench::dummy_row>                wi_table_type;
+    typedef OIndex<trade_request_key, trade_request_row>            tr_table_type;
+    typedef SIndex<trade_request_symb_idx_key, tr_table_type, trade_request_symb_idx_extract> tri_table_type;
+
+    explicit tpce_db(const tpce_scale& scale)
+        : scale_(scale),
+          tbl_st_(16), tbl_tt_(16), tbl_tx_(64), tbl_ch_(64),
+          tbl_c_(scale.num_customers / 2 + 1),
+          tbl_s_(scale.num_securities / 2 + 1),
+          tbl_lt_(scale.num_securities / 2 + 1),
+          tbl_b_(scale.num_brokers / 2 + 1),
+          tbl_ti_(tbl_t_), tbl_hi_(tbl_h_), tbl_tri_(tbl_tr_) {}
+
+    void thread_init_all();
+
+    const tpce_scale& scale() const {
+        return scale_;
+    }
+    tpce_scale& scale() {
+        return scale_;
+    }
+
+    st_table_type& tbl_status_types() {
+        return tbl_st_;
+    }
+    tt_table_type& tbl_trade_types() {
+        return tbl_tt_;
+    }
+    tx_table_type& tbl_taxrates() {
+        return tbl_tx_;
+    }
+    ch_table_type& tbl_charges() {
+        return tbl_ch_;
+    }
+    cr_table_type& tbl_commission_rates() {
+        return tbl_cr_;
+    }
+    zc_table_type& tbl_zip_codes() {
+        return tbl_zc_;
+    }
+    ex_table_type& tbl_exchanges() {
+        return tbl_ex_;
+    }
+    sc_table_type& tbl_sectors() {
+        return tbl_sc_;
+    }
+    in_table_type& tbl_industries() {
+        return tbl_in_;
+    }
+    c_table_type& tbl_customers() {
+        return tbl_c_;
+    }
+    ca_table_type& tbl_accounts() {
+        return tbl_ca_;
+    }
+    ap_table_type& tbl_account_permissions() {
+        return tbl_ap_;
+    }
+    cx_table_type& tbl_customer_taxrates() {
+        return tbl_cx_;
+    }
+    ad_table_type& tbl_addresses() {
+        return tbl_ad_;
+    }
+    co_table_type& tbl_companies() {
+        return tbl_co_;
+    }
+    cp_table_type& tbl_company_competitors() {
+        return tbl_cp_;
+    }
+    s_table_type& tbl_securities() {
+        return tbl_s_;
+    }
+    dm_table_type& tbl_daily_markets() {
+        return tbl_dm_;
+    }
+    fi_table_type& tbl_financials() {
+        return tbl_fi_;
+    }
+    lt_table_type& tbl_last_trades() {
+        return tbl_lt_;
+    }
+    ni_table_type& tbl_news_items() {
+        return tbl_ni_;
+    }
+    nx_table_type& tbl_news_xrefs() {
+        return tbl_nx_;
+    }
+    b_table_type& tbl_brokers() {
+        return tbl_b_;
+    }
+    t_table_type& tbl_trades() {
+        return tbl_t_;
+    }
+    ti_table_type& tbl_trade_account_index() {
+        return tbl_ti_;
+    }
+    se_table_type& tbl_settlements() {
+        return tbl_se_;
+    }
+    th_table_type& tbl_trade_histories() {
+        return tbl_th_;
+    }
+    ct_table_type& tbl_cash_transactions() {
+        return tbl_ct_;
+    }
+    h_table_type& tbl_holdings() {
+        return tbl_h_;
+    }
+    hi_table_type& tbl_holding_account_index() {
+        return tbl_hi_;
+    }
+    hh_table_type& tbl_holding_histories() {
+        return tbl_hh_;
+    }
+    hs_table_type& tbl_holding_summaries() {
+        return tbl_hs_;
+    }
+    wl_table_type& tbl_watch_lists() {
+        return tbl_wl_;
+    }
+    wi_table_type& tbl_watch_items() {
+        return tbl_wi_;
+    }
+    tr_table_type& tbl_trade_requests() {
+        return tbl_tr_;
+    }
+    tri_table_type& tbl_trade_request_symbol_index() {
+        return tbl_tri_;
+    }
+
+private:
+    tpce_scale scale_;
+
+    st_table_type tbl_st_;
+    tt_table_type tbl_tt_;
+    tx_table_type tbl_tx_;
+    ch_table_type tbl_ch_;
+    cr_table_type tbl_cr_;
+    zc_table_type tbl_zc_;
+    ex_table_type tbl_ex_;
+    sc_table_type tbl_sc_;
+    in_table_type tbl_in_;
+
+    c_table_type  tbl_c_;
+    ca_table_type tbl_ca_;
+    ap_table_type tbl_ap_;
+    cx_table_type tbl_cx_;
+    ad_table_type tbl_ad_;
+
+    co_table_type tbl_co_;
+    cp_table_type tbl_cp_;
+    s_table_type  tbl_s_;
+    dm_table_type tbl_dm_;
+    fi_table_type tbl_fi_;
+    lt_table_type tbl_lt_;
+    ni_table_type tbl_ni_;
+    nx_table_type tbl_nx_;
+
+    // the secondary indexes refer to their base tables, declared before them
+    b_table_type   tbl_b_;
+    t_table_type   tbl_t_;
+    ti_table_type  tbl_ti_;
+    se_table_type  tbl_se_;
+    th_table_type  tbl_th_;
+    ct_table_type  tbl_ct_;
+    h_table_type   tbl_h_;
+    hi_table_type  tbl_hi_;
+    hh_table_type  tbl_hh_;
+    hs_table_type  tbl_hs_;
+    wl_table_type  tbl_wl_;
+    wi_table_type  tbl_wi_;
+    tr_table_type  tbl_tr_;
+    tri_table_type tbl_tri_;
+};
+
+// percentages of the transaction types, in tenths of a percent
+struct tpce_txn_mix {
+    static constexpr int num_types = 10;
+    uint64_t pct[num_types];
+
+    tpce_txn_mix()
+        : pct{49, 130, 10, 180, 140, 80, 101, 100, 190, 20} {}
+
+    static const char *name(int type) {
+        static const char *const names[num_types] = {
+            "broker-volume", "customer-position", "market-feed", "market-watch",
+            "security-detail", "trade-lookup", "trade-order", "trade-result",
+            "trade-status", "trade-update"
+        };
+        return names[type];
+    }
+};
+
+// committed transactions and their aborted attempts, by type
+struct tpce_txn_stats {
+    uint64_t commits[tpce_txn_mix::num_types];
+    uint64_t aborts[tpce_txn_mix::num_types];
+
+    tpce_txn_stats()
+        : commits(), aborts() {}
+
+    tpce_txn_stats& operator+=(const tpce_txn_stats& x) {
+        for (int t = 0; t < tpce_txn_mix::num_types; ++t) {
+            commits[t] += x.commits[t];
+            aborts[t] += x.aborts[t];
+        }
+        return *this;
+    }
+    uint64_t total_commits() const {
+        uint64_t n = 0;
+        for (int t = 0; t < tpce_txn_mix::num_types; ++t)
+            n += commits[t];
+        return n;
+    }
+    void print(std::ostream& os, double seconds) const;
+};
+
+template <typename DBParams>
+class tpce_runner {
+public:
+    enum class txn_type : int {
+        broker_volume = 1,
+        customer_position,
+        market_feed,
+        market_watch,
+        security_detail,
+        trade_lookup,
+        trade_order,
+        trade_result,
+        trade_status,
+        trade_update
+    };
+
+    tpce_runner(int id, tpce_db<DBParams>& database)
+        : ig(id, database.scale()), db(database), runner_id(id) {}
+
+    // a runner with no submitted trade runs Trade-Order for Trade-Result
+    inline txn_type next_transaction() {
+        uint64_t x = ig.random(1, 1000);
+        int t = 0;
+        uint64_t sum = mix.pct[0];
+        while (x > sum)
+            sum += mix.pct[++t];
+        auto type = static_cast<txn_type>(t + 1);
+        if (type == txn_type::trade_result && submitted.empty())
+            type = txn_type::trade_order;
+        return type;
+    }
+
+    // each returns the number of aborted attempts
+    inline size_t run_txn_broker_volume();
+    inline size_t run_txn_customer_position();
+    inline size_t run_txn_market_feed();
+    inline size_t run_txn_market_watch();
+    inline size_t run_txn_security_detail();
+    inline size_t run_txn_trade_lookup();
+    inline size_t run_txn_trade_order();
+    inline size_t run_txn_trade_result();
+    inline size_t run_txn_trade_status();
+    inline size_t run_txn_trade_update();
+
+    void record(txn_type t, size_t aborts) {
+        ++txn_stats.commits[int(t) - 1];
+        txn_stats.aborts[int(t) - 1] += aborts;
+    }
+    const tpce_txn_stats& stats() const {
+        return txn_stats;
+    }
+
+private:
+    // a trade submitted to the market, and the price it executes at
+    struct submitted_trade {
+        int64_t t_id;
+        float price;
+    };
+
+    static uint32_t now() {
+        return uint32_t(::time(nullptr));
+    }
+
+    // each returns false if the transaction must abort
+    inline bool lookup_commission_rate(int32_t c_tier, const fix_string<3>& tt_id,
+                                       const fix_string<6>& ex_id, int32_t qty, float& rate);
+    inline bool lookup_tax_rate(int64_t c_id, float& rate);
+    inline bool read_trade_details(int64_t t_id, bool is_cash);
+
+    tpce_input_generator ig;
+    tpce_db<DBParams>& db;
+    int runner_id;
+    tpce_txn_mix mix;
+    tpce_txn_stats txn_stats;
+    std::deque<submitted_trade> submitted;
+};
+
+template <typename DBParams>
+class tpce_loader {
+public:
+    tpce_loader(tpce_db<DBParams>& database)
+        : ig(0, database.scale()), db(database) {}
+
+    void load();
+
+private:
+    inline void load_fixed_tables();
+    inline void load_market();
+    inline void load_customers();
+
+    inline address_row random_address();
+    inline std::string random_a_string(int x, int y);
+    inline std::string random_n_string(int x, int y);
+
+    tpce_input_generator ig;
+    tpce_db<DBParams>& db;
+};
+
+}; // namespace tpce
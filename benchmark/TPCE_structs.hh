@@ -3,54 +3,138 @@
 #include <string>
 #include <cassert>
 #include "DB_structs.hh"
+#include "xxhash.h"
 #include "str.hh"
 
 namespace tpce {
 
 using namespace bench;
 
-struct zip_code_key {
+// Keys are stored in masstree byte order: integer fields are byte-swapped
+// by the constructors, and keys mixing field sizes are packed so that no
+// padding bytes end up in a key. Tables that are only looked up by key
+// (see tpce_db) hash their keys instead; their bare keys compare bytes.
+
+// Customer tables 1/2
+
+struct zip_code_key_bare {
     fix_string<12> zc_code;
+
+    zip_code_key_bare() = default;
+    explicit zip_code_key_bare(const fix_string<12>& code)
+            : zc_code(code) {}
 };
 
+typedef masstree_key_adapter<zip_code_key_bare> zip_code_key;
+
 struct zip_code_row {
+    enum class NamedColumn : int { zc_town = 0,
+                                   zc_div };
+
     var_string<80> zc_town;
     var_string<80> zc_div;
 };
 
-struct address_key {
+struct address_key_bare {
     int64_t ad_id;
+
+    address_key_bare() = default;
+    explicit address_key_bare(int64_t id)
+            : ad_id(bswap(id)) {}
 };
 
+typedef masstree_key_adapter<address_key_bare> address_key;
+
 struct address_row {
+    enum class NamedColumn : int { ad_line1 = 0,
+                                   ad_line2,
+                                   ad_zc_code,
+                                   ad_ctry };
+
     var_string<80> ad_line1;
     var_string<80> ad_line2;
     fix_string<12> ad_zc_code;
     var_string<80> ad_ctry;
 };
 
-struct status_type_key {
+struct status_type_key_bare {
     fix_string<4> st_id;
+
+    status_type_key_bare() = default;
+    explicit status_type_key_bare(const fix_string<4>& id)
+            : st_id(id) {}
+    bool operator==(const status_type_key_bare& other) const {
+        return st_id == other.st_id;
+    }
 };
 
+typedef masstree_key_adapter<status_type_key_bare> status_type_key;
+
 struct status_type_row {
+    enum class NamedColumn : int { st_name = 0 };
+
     fix_string<10> st_name;
 };
 
-struct taxrate_key {
+struct taxrate_key_bare {
     fix_string<4> tx_id;
+
+    taxrate_key_bare() = default;
+    explicit taxrate_key_bare(const fix_string<4>& id)
+            : tx_id(id) {}
+    bool operator==(const taxrate_key_bare& other) const {
+        return tx_id == other.tx_id;
+    }
 };
 
+typedef masstree_key_adapter<taxrate_key_bare> taxrate_key;
+
 struct taxrate_row {
+    enum class NamedColumn : int { tx_name = 0,
+                                   tx_rate };
+
     var_string<50> tx_name;
     float          tx_rate;
 };
 
-struct customer_key {
+struct customer_key_bare {
     int64_t c_id;
+
+    customer_key_bare() = default;
+    explicit customer_key_bare(int64_t id)
+            : c_id(bswap(id)) {}
+    bool operator==(const customer_key_bare& other) const {
+        return c_id == other.c_id;
+    }
 };
 
+typedef masstree_key_adapter<customer_key_bare> customer_key;
+
 struct customer_row {
+    enum class NamedColumn : int { c_tax_id = 0,
+                                   c_st_id,
+                                   c_l_name,
+                                   c_f_name,
+                                   c_m_name,
+                                   c_gndr,
+                                   c_tier,
+                                   c_dob,
+                                   c_ad_id,
+                                   c_ctry_1,
+                                   c_area_1,
+                                   c_local_1,
+                                   c_ext_1,
+                                   c_ctry_2,
+                                   c_area_2,
+                                   c_local_2,
+                                   c_ext_2,
+                                   c_ctry_3,
+                                   c_area_3,
+                                   c_local_3,
+                                   c_ext_3,
+                                   c_email_1,
+                                   c_email_2 };
+
     var_string<20> c_tax_id;
     fix_string<4>  c_st_id;
     var_string<30> c_l_name;
@@ -78,11 +162,24 @@ struct customer_row {
 
 // Market Tables
 
-struct exchange_key {
+struct exchange_key_bare {
     fix_string<6> ex_id;
+
+    exchange_key_bare() = default;
+    explicit exchange_key_bare(const fix_string<6>& id)
+            : ex_id(id) {}
 };
 
+typedef masstree_key_adapter<exchange_key_bare> exchange_key;
+
 struct exchange_row {
+    enum class NamedColumn : int { ex_name = 0,
+                                   ex_num_symb,
+                                   ex_open,
+                                   ex_close,
+                                   ex_desc,
+                                   ex_ad_id };
+
     var_string<100> ex_name;
     int32_t         ex_num_symb;
     int32_t         ex_open;
@@ -91,28 +188,60 @@ struct exchange_row {
     int64_t         ex_ad_id;
 };
 
-struct sector_key {
+struct sector_key_bare {
     fix_string<2> sc_id;
+
+    sector_key_bare() = default;
+    explicit sector_key_bare(const fix_string<2>& id)
+            : sc_id(id) {}
 };
 
+typedef masstree_key_adapter<sector_key_bare> sector_key;
+
 struct sector_row {
+    enum class NamedColumn : int { sc_name = 0 };
+
     var_string<30> sc_name;
 };
 
-struct industry_key {
+struct industry_key_bare {
     fix_string<2> in_id;
+
+    industry_key_bare() = default;
+    explicit industry_key_bare(const fix_string<2>& id)
+            : in_id(id) {}
 };
 
+typedef masstree_key_adapter<industry_key_bare> industry_key;
+
 struct industry_row {
+    enum class NamedColumn : int { in_name = 0,
+                                   in_sc_id };
+
     var_string<50> in_name;
     fix_string<2>  in_sc_id;
 };
 
-struct company_key {
+struct company_key_bare {
     int64_t co_id;
+
+    company_key_bare() = default;
+    explicit company_key_bare(int64_t id)
+            : co_id(bswap(id)) {}
 };
 
+typedef masstree_key_adapter<company_key_bare> company_key;
+
 struct company_row {
+    enum class NamedColumn : int { co_st_id = 0,
+                                   co_name,
+                                   co_in_id,
+                                   co_sp_rate,
+                                   co_ceo,
+                                   co_ad_id,
+                                   co_desc,
+                                   co_open_date };
+
     fix_string<4>   co_st_id;
     var_string<60>  co_name;
     fix_string<2>   co_in_id;
@@ -123,17 +252,48 @@ struct company_row {
     uint32_t        co_open_date;
 };
 
-struct company_competitor_key {
+struct __attribute__((packed)) company_competitor_key_bare {
     int64_t       cp_co_id;
     int64_t       cp_comp_co_id;
     fix_string<2> cp_in_id;
+
+    company_competitor_key_bare() = default;
+    company_competitor_key_bare(int64_t co_id, int64_t comp_co_id, const fix_string<2>& in_id)
+            : cp_co_id(bswap(co_id)), cp_comp_co_id(bswap(comp_co_id)), cp_in_id(in_id) {}
 };
 
-struct security_key {
+typedef masstree_key_adapter<company_competitor_key_bare> company_competitor_key;
+
+struct security_key_bare {
     fix_string<15> s_symb;
+
+    security_key_bare() = default;
+    explicit security_key_bare(const fix_string<15>& symb)
+            : s_symb(symb) {}
+    bool operator==(const security_key_bare& other) const {
+        return s_symb == other.s_symb;
+    }
 };
 
+typedef masstree_key_adapter<security_key_bare> security_key;
+
 struct security_row {
+    enum class NamedColumn : int { s_issue = 0,
+                                   s_st_id,
+                                   s_name,
+                                   s_ex_id,
+                                   s_co_id,
+                                   s_num_out,
+                                   s_start_date,
+                                   s_exch_date,
+                                   s_pe,
+                                   s_52wk_high,
+                                   s_52wk_high_date,
+                                   s_52wk_low,
+                                   s_52wk_low_date,
+                                   s_dividend,
+                                   s_yield };
+
     fix_string<6>  s_issue;
     fix_string<4>  s_st_id;
     var_string<70> s_name;
@@ -151,25 +311,55 @@ struct security_row {
     float          s_yield;
 };
 
-struct daily_market_key {
-    uint32_t       dm_date;
+// ordered by symbol first, so the days of a security are a key range
+struct __attribute__((packed)) daily_market_key_bare {
     fix_string<15> dm_s_symb;
+    uint32_t       dm_date;
+
+    daily_market_key_bare() = default;
+    daily_market_key_bare(const fix_string<15>& symb, uint32_t date)
+            : dm_s_symb(symb), dm_date(bswap(date)) {}
 };
 
+typedef masstree_key_adapter<daily_market_key_bare> daily_market_key;
+
 struct daily_market_row {
+    enum class NamedColumn : int { dm_close = 0,
+                                   dm_high,
+                                   dm_low,
+                                   dm_vol };
+
     float   dm_close;
     float   dm_high;
     float   dm_low;
     int64_t dm_vol;
 };
 
-struct financial_key {
+struct financial_key_bare {
     int64_t fi_co_id;
     int32_t fi_year;
     int32_t fi_qtr;
+
+    financial_key_bare() = default;
+    financial_key_bare(int64_t co_id, int32_t year, int32_t qtr)
+            : fi_co_id(bswap(co_id)), fi_year(bswap(year)), fi_qtr(bswap(qtr)) {}
 };
 
+typedef masstree_key_adapter<financial_key_bare> financial_key;
+
 struct financial_row {
+    enum class NamedColumn : int { fi_qtr_start_date = 0,
+                                   fi_revenue,
+                                   fi_net_earn,
+                                   fi_basic_eps,
+                                   fi_dilut_eps,
+                                   fi_margin,
+                                   fi_inventory,
+                                   fi_assets,
+                                   fi_liability,
+                                   fi_out_basic,
+                                   fi_out_dilut };
+
     uint32_t fi_qtr_start_date;
     float    fi_revenue;
     float    fi_net_earn;
@@ -183,22 +373,49 @@ struct financial_row {
     int64_t  fi_out_dilut;
 };
 
-struct last_trade_key {
+struct last_trade_key_bare {
     fix_string<15> lt_s_symb;
+
+    last_trade_key_bare() = default;
+    explicit last_trade_key_bare(const fix_string<15>& symb)
+            : lt_s_symb(symb) {}
+    bool operator==(const last_trade_key_bare& other) const {
+        return lt_s_symb == other.lt_s_symb;
+    }
 };
 
+typedef masstree_key_adapter<last_trade_key_bare> last_trade_key;
+
 struct last_trade_row {
+    enum class NamedColumn : int { lt_dts = 0,
+                                   lt_price,
+                                   lt_open_price,
+                                   lt_vol };
+
     uint32_t lt_dts;
     float    lt_price;
     float    lt_open_price;
     int64_t  lt_vol;
 };
 
-struct news_item_key {
+struct news_item_key_bare {
     int64_t ni_id;
+
+    news_item_key_bare() = default;
+    explicit news_item_key_bare(int64_t id)
+            : ni_id(bswap(id)) {}
 };
 
+typedef masstree_key_adapter<news_item_key_bare> news_item_key;
+
 struct news_item_row {
+    enum class NamedColumn : int { ni_headline = 0,
+                                   ni_summary,
+                                   ni_item,
+                                   ni_dts,
+                                   ni_source,
+                                   ni_author };
+
     var_string<80>   ni_headline;
     var_string<225>  ni_summary;
     var_string<1024> ni_item;
@@ -207,18 +424,39 @@ struct news_item_row {
     var_string<30>   ni_author;
 };
 
-struct news_xref_key {
-    int64_t nx_ni_id;
+// ordered by company first, so the news of a company are a key range
+struct news_xref_key_bare {
     int64_t nx_co_id;
+    int64_t nx_ni_id;
+
+    news_xref_key_bare() = default;
+    news_xref_key_bare(int64_t co_id, int64_t ni_id)
+            : nx_co_id(bswap(co_id)), nx_ni_id(bswap(ni_id)) {}
 };
 
+typedef masstree_key_adapter<news_xref_key_bare> news_xref_key;
+
 // Broker tables 1/3
 
-struct broker_key {
+struct broker_key_bare {
     int64_t b_id;
+
+    broker_key_bare() = default;
+    explicit broker_key_bare(int64_t id)
+            : b_id(bswap(id)) {}
+    bool operator==(const broker_key_bare& other) const {
+        return b_id == other.b_id;
+    }
 };
 
+typedef masstree_key_adapter<broker_key_bare> broker_key;
+
 struct broker_row {
+    enum class NamedColumn : int { b_st_id = 0,
+                                   b_name,
+                                   b_num_trades,
+                                   b_comm_total };
+
     fix_string<4>   b_st_id;
     var_string<100> b_name;
     int32_t         b_num_trades;
@@ -227,11 +465,23 @@ struct broker_row {
 
 // Customer tables 2/2
 
-struct customer_account_key {
+struct customer_account_key_bare {
     int64_t ca_id;
+
+    customer_account_key_bare() = default;
+    explicit customer_account_key_bare(int64_t id)
+            : ca_id(bswap(id)) {}
 };
 
+typedef masstree_key_adapter<customer_account_key_bare> customer_account_key;
+
 struct customer_account_row {
+    enum class NamedColumn : int { ca_b_id = 0,
+                                   ca_c_id,
+                                   ca_name,
+                                   ca_tax_st,
+                                   ca_bal };
+
     int64_t        ca_b_id;
     int64_t        ca_c_id;
     var_string<50> ca_name;
@@ -239,39 +489,90 @@ struct customer_account_row {
     float          ca_bal;
 };
 
-struct account_permission_key {
+struct __attribute__((packed)) account_permission_key_bare {
     int64_t       ap_ca_id;
     fix_string<4> ap_acl;
+
+    account_permission_key_bare() = default;
+    account_permission_key_bare(int64_t ca_id, const fix_string<4>& acl)
+            : ap_ca_id(bswap(ca_id)), ap_acl(acl) {}
 };
 
+typedef masstree_key_adapter<account_permission_key_bare> account_permission_key;
+
 struct account_permission_row {
+    enum class NamedColumn : int { ap_tax_id = 0,
+                                   ap_l_name,
+                                   ap_f_name };
+
     var_string<20> ap_tax_id;
     var_string<30> ap_l_name;
     var_string<30> ap_f_name;
 };
 
-struct customer_taxrate_key {
-    fix_string<4> cx_tx_id;
+// ordered by customer first, so the tax rates of a customer are a key range
+struct __attribute__((packed)) customer_taxrate_key_bare {
     int64_t       cx_c_id;
-} __attribute__((packed));
+    fix_string<4> cx_tx_id;
+
+    customer_taxrate_key_bare() = default;
+    customer_taxrate_key_bare(int64_t c_id, const fix_string<4>& tx_id)
+            : cx_c_id(bswap(c_id)), cx_tx_id(tx_id) {}
+};
+
+typedef masstree_key_adapter<customer_taxrate_key_bare> customer_taxrate_key;
 
 // Broker tables 2/3
 
-struct trade_type_key {
+struct trade_type_key_bare {
     fix_string<3> tt_id;
+
+    trade_type_key_bare() = default;
+    explicit trade_type_key_bare(const fix_string<3>& id)
+            : tt_id(id) {}
+    bool operator==(const trade_type_key_bare& other) const {
+        return tt_id == other.tt_id;
+    }
 };
 
+typedef masstree_key_adapter<trade_type_key_bare> trade_type_key;
+
 struct trade_type_row {
+    enum class NamedColumn : int { tt_name = 0,
+                                   tt_is_sell,
+                                   tt_is_mrkt };
+
     fix_string<12> tt_name;
     int32_t        tt_is_sell;
     int32_t        tt_is_mrkt;
 };
 
-struct trade_key {
+struct trade_key_bare {
     int64_t t_id;
+
+    trade_key_bare() = default;
+    explicit trade_key_bare(int64_t id)
+            : t_id(bswap(id)) {}
 };
 
+typedef masstree_key_adapter<trade_key_bare> trade_key;
+
 struct trade_row {
+    enum class NamedColumn : int { t_dts = 0,
+                                   t_st_id,
+                                   t_tt_id,
+                                   t_is_cash,
+                                   t_s_symb,
+                                   t_qty,
+                                   t_bid_price,
+                                   t_ca_id,
+                                   t_exec_name,
+                                   t_trade_price,
+                                   t_chrg,
+                                   t_comm,
+                                   t_tax,
+                                   t_lifo };
+
     uint32_t       t_dts;
     fix_string<4>  t_st_id;
     fix_string<3>  t_tt_id;
@@ -288,39 +589,96 @@ struct trade_row {
     int32_t        t_lifo;
 };
 
-struct settlement_key {
+// trade index key of a trade row: the trades of an account by time
+struct __attribute__((packed)) trade_account_idx_key_bare {
+    int64_t  t_ca_id;
+    uint32_t t_dts;
+    int64_t  t_id;
+
+    trade_account_idx_key_bare() = default;
+    trade_account_idx_key_bare(int64_t ca_id, uint32_t dts, int64_t id)
+            : t_ca_id(bswap(ca_id)), t_dts(bswap(dts)), t_id(bswap(id)) {}
+};
+
+typedef masstree_key_adapter<trade_account_idx_key_bare> trade_account_idx_key;
+
+struct trade_account_idx_extract {
+    trade_account_idx_key operator()(const trade_key& k, const trade_row& v) const {
+        return trade_account_idx_key(v.t_ca_id, v.t_dts, bswap(k.t_id));
+    }
+};
+
+struct settlement_key_bare {
     int64_t se_t_id;
+
+    settlement_key_bare() = default;
+    explicit settlement_key_bare(int64_t t_id)
+            : se_t_id(bswap(t_id)) {}
 };
 
+typedef masstree_key_adapter<settlement_key_bare> settlement_key;
+
 struct settlement_row {
+    enum class NamedColumn : int { se_cash_type = 0,
+                                   se_cash_due_date,
+                                   se_amt };
+
     var_string<40> se_cash_type;
     uint32_t       se_cash_due_date;
     float          se_amt;
 };
 
-struct trade_history_key {
+struct __attribute__((packed)) trade_history_key_bare {
     int64_t       th_t_id;
     fix_string<4> th_st_id;
+
+    trade_history_key_bare() = default;
+    trade_history_key_bare(int64_t t_id, const fix_string<4>& st_id)
+            : th_t_id(bswap(t_id)), th_st_id(st_id) {}
 };
 
+typedef masstree_key_adapter<trade_history_key_bare> trade_history_key;
+
 struct trade_history_row {
+    enum class NamedColumn : int { th_dts = 0 };
+
     uint32_t th_dts;
 };
 
-struct holding_summary_key {
+struct __attribute__((packed)) holding_summary_key_bare {
     int64_t hs_ca_id;
     fix_string<15> hs_s_symb;
+
+    holding_summary_key_bare() = default;
+    holding_summary_key_bare(int64_t ca_id, const fix_string<15>& symb)
+            : hs_ca_id(bswap(ca_id)), hs_s_symb(symb) {}
 };
 
+typedef masstree_key_adapter<holding_summary_key_bare> holding_summary_key;
+
 struct holding_summary_row {
+    enum class NamedColumn : int { hs_qty = 0 };
+
     int32_t hs_qty;
 };
 
-struct holding_key {
+struct holding_key_bare {
     int64_t h_t_id;
+
+    holding_key_bare() = default;
+    explicit holding_key_bare(int64_t t_id)
+            : h_t_id(bswap(t_id)) {}
 };
 
+typedef masstree_key_adapter<holding_key_bare> holding_key;
+
 struct holding_row {
+    enum class NamedColumn : int { h_ca_id = 0,
+                                   h_s_symb,
+                                   h_dts,
+                                   h_price,
+                                   h_qty };
+
     int64_t        h_ca_id;
     fix_string<15> h_s_symb;
     uint32_t       h_dts;
@@ -328,67 +686,156 @@ struct holding_row {
     int32_t        h_qty;
 };
 
-struct holding_history_key {
+// holding index key of a holding row: the holdings of an account in a
+// security, oldest first
+struct __attribute__((packed)) holding_account_idx_key_bare {
+    int64_t        h_ca_id;
+    fix_string<15> h_s_symb;
+    uint32_t       h_dts;
+    int64_t        h_t_id;
+
+    holding_account_idx_key_bare() = default;
+    holding_account_idx_key_bare(int64_t ca_id, const fix_string<15>& symb, uint32_t dts, int64_t t_id)
+            : h_ca_id(bswap(ca_id)), h_s_symb(symb), h_dts(bswap(dts)), h_t_id(bswap(t_id)) {}
+};
+
+typedef masstree_key_adapter<holding_account_idx_key_bare> holding_account_idx_key;
+
+struct holding_account_idx_extract {
+    holding_account_idx_key operator()(const holding_key& k, const holding_row& v) const {
+        return holding_account_idx_key(v.h_ca_id, v.h_s_symb, v.h_dts, bswap(k.h_t_id));
+    }
+};
+
+struct holding_history_key_bare {
     int64_t hh_h_t_id;
     int64_t hh_t_id;
+
+    holding_history_key_bare() = default;
+    holding_history_key_bare(int64_t h_t_id, int64_t t_id)
+            : hh_h_t_id(bswap(h_t_id)), hh_t_id(bswap(t_id)) {}
 };
 
+typedef masstree_key_adapter<holding_history_key_bare> holding_history_key;
+
 struct holding_history_row {
+    enum class NamedColumn : int { hh_before_qty = 0,
+                                   hh_after_qty };
+
     int32_t hh_before_qty;
     int32_t hh_after_qty;
 };
 
-struct watch_list_key {
+struct watch_list_key_bare {
     int64_t wl_id;
+
+    watch_list_key_bare() = default;
+    explicit watch_list_key_bare(int64_t id)
+            : wl_id(bswap(id)) {}
 };
 
+typedef masstree_key_adapter<watch_list_key_bare> watch_list_key;
+
 struct watch_list_row {
+    enum class NamedColumn : int { wl_c_id = 0 };
+
     int64_t wl_c_id;
 };
 
-struct watch_item_key {
+struct __attribute__((packed)) watch_item_key_bare {
     int64_t        wi_wl_id;
     fix_string<15> wi_s_symb;
+
+    watch_item_key_bare() = default;
+    watch_item_key_bare(int64_t wl_id, const fix_string<15>& symb)
+            : wi_wl_id(bswap(wl_id)), wi_s_symb(symb) {}
 };
 
+typedef masstree_key_adapter<watch_item_key_bare> watch_item_key;
+
 // Broker tables 3/3
 
-struct cash_transaction_key {
+struct cash_transaction_key_bare {
     int64_t ct_t_id;
+
+    cash_transaction_key_bare() = default;
+    explicit cash_transaction_key_bare(int64_t t_id)
+            : ct_t_id(bswap(t_id)) {}
 };
 
+typedef masstree_key_adapter<cash_transaction_key_bare> cash_transaction_key;
+
 struct cash_transaction_row {
+    enum class NamedColumn : int { ct_dts = 0,
+                                   ct_amt,
+                                   ct_name };
+
     uint32_t        ct_dts;
     float           ct_amt;
     var_string<100> ct_name;
 };
 
-struct charge_key {
+struct __attribute__((packed)) charge_key_bare {
     fix_string<3> ch_tt_id;
     int32_t       ch_c_tier;
-} __attribute__((packed));
+
+    charge_key_bare() = default;
+    charge_key_bare(const fix_string<3>& tt_id, int32_t c_tier)
+            : ch_tt_id(tt_id), ch_c_tier(bswap(c_tier)) {}
+    bool operator==(const charge_key_bare& other) const {
+        return ch_tt_id == other.ch_tt_id && ch_c_tier == other.ch_c_tier;
+    }
+};
+
+typedef masstree_key_adapter<charge_key_bare> charge_key;
 
 struct charge_row {
+    enum class NamedColumn : int { ch_chrg = 0 };
+
     float ch_chrg;
 };
 
-struct commission_rate_key {
+// ordered by quantity last, so the rate of a quantity is the last row at
+// or before it
+struct __attribute__((packed)) commission_rate_key_bare {
     int32_t       cr_c_tier;
-    int32_t       cr_from_qty;
     fix_string<3> cr_tt_id;
     fix_string<6> cr_ex_id;
+    int32_t       cr_from_qty;
+
+    commission_rate_key_bare() = default;
+    commission_rate_key_bare(int32_t c_tier, const fix_string<3>& tt_id,
+                             const fix_string<6>& ex_id, int32_t from_qty)
+            : cr_c_tier(bswap(c_tier)), cr_tt_id(tt_id), cr_ex_id(ex_id), cr_from_qty(bswap(from_qty)) {}
 };
 
+typedef masstree_key_adapter<commission_rate_key_bare> commission_rate_key;
+
 struct commission_rate_row {
+    enum class NamedColumn : int { cr_to_qty = 0,
+                                   cr_rate };
+
     int32_t cr_to_qty;
     float   cr_rate;
 };
 
-struct trade_request_key {
+struct trade_request_key_bare {
     int64_t tr_t_id;
+
+    trade_request_key_bare() = default;
+    explicit trade_request_key_bare(int64_t t_id)
+            : tr_t_id(bswap(t_id)) {}
 };
 
+typedef masstree_key_adapter<trade_request_key_bare> trade_request_key;
+
 struct trade_request_row {
+    enum class NamedColumn : int { tr_tt_id = 0,
+                                   tr_s_symb,
+                                   tr_qty,
+                                   tr_bid_price,
+                                   tr_ca_id };
+
     fix_string<3>  tr_tt_id;
     fix_string<15> tr_s_symb;
     int32_t        tr_qty;
@@ -396,4 +843,52 @@ struct trade_request_row {
     int64_t        tr_ca_id;
 };
 
+// trade request index key of a trade request row: the pending requests of
+// a security
+struct __attribute__((packed)) trade_request_symb_idx_key_bare {
+    fix_string<15> tr_s_symb;
+    int64_t        tr_t_id;
+
+    trade_request_symb_idx_key_bare() = default;
+    trade_request_symb_idx_key_bare(const fix_string<15>& symb, int64_t t_id)
+            : tr_s_symb(symb), tr_t_id(bswap(t_id)) {}
+};
+
+typedef masstree_key_adapter<trade_request_symb_idx_key_bare> trade_request_symb_idx_key;
+
+struct trade_request_symb_idx_extract {
+    trade_request_symb_idx_key operator()(const trade_request_key& k, const trade_request_row& v) const {
+        return trade_request_symb_idx_key(v.tr_s_symb, bswap(k.tr_t_id));
+    }
+};
+
+// hashes the bytes of a key of an unordered table
+template <typename K>
+struct key_hash {
+    size_t operator()(const K& k) const {
+        return XXH64(&k, sizeof(k), 0xdeadbeefdeadbeef);
+    }
+};
+
 }; // namespace tpce
+
+namespace std {
+
+template <>
+struct hash<tpce::status_type_key> : tpce::key_hash<tpce::status_type_key> {};
+template <>
+struct hash<tpce::taxrate_key> : tpce::key_hash<tpce::taxrate_key> {};
+template <>
+struct hash<tpce::customer_key> : tpce::key_hash<tpce::customer_key> {};
+template <>
+struct hash<tpce::security_key> : tpce::key_hash<tpce::security_key> {};
+template <>
+struct hash<tpce::last_trade_key> : tpce::key_hash<tpce::last_trade_key> {};
+template <>
+struct hash<tpce::broker_key> : tpce::key_hash<tpce::broker_key> {};
+template <>
+struct hash<tpce::trade_type_key> : tpce::key_hash<tpce::trade_type_key> {};
+template <>
+struct hash<tpce::charge_key> : tpce::key_hash<tpce::charge_key> {};
+
+}; // namespace std
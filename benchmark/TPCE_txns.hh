@@ -0,0 +1,1347 @@
+#pragma once
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "TPCE_bench.hh"
+
+namespace tpce {
+
+// the commission rate of a trade of qty shares; the rate of a quantity is
+// that of the last band starting at or before it
+template <typename DBParams>
+bool tpce_runner<DBParams>::lookup_commission_rate(int32_t c_tier, const fix_string<3>& tt_id,
+                                                   const fix_string<6>& ex_id, int32_t qty, float& rate) {
+    typedef commission_rate_row::NamedColumn cr_nc;
+
+    bool found = false;
+    auto scan_callback = [&] (const commission_rate_key&, const commission_rate_row& crv) -> bool {
+        found = qty <= crv.cr_to_qty;
+        rate = crv.cr_rate;
+        return true;
+    };
+
+    commission_rate_key crk0(c_tier, tt_id, ex_id, 0);
+    commission_rate_key crk1(c_tier, tt_id, ex_id, qty + 1);
+
+    bool success = db.tbl_commission_rates()
+            .template range_scan<decltype(scan_callback), false/*reverse*/>(crk0, crk1, scan_callback, {{cr_nc::cr_to_qty, false}, {cr_nc::cr_rate, false}});
+    always_assert(!success || found, "commission rate missing");
+    return success;
+}
+
+// the sum of the tax rates of customer c_id
+template <typename DBParams>
+bool tpce_runner<DBParams>::lookup_tax_rate(int64_t c_id, float& rate) {
+    std::vector<taxrate_key> tx_keys;
+    auto scan_callback = [&] (const customer_taxrate_key& key, const bench::dummy_row&) -> bool {
+        tx_keys.emplace_back(key.cx_tx_id);
+        return true;
+    };
+
+    customer_taxrate_key cxk0(c_id, "");
+    customer_taxrate_key cxk1(c_id + 1, "");
+
+    bool success = db.tbl_customer_taxrates()
+            .template range_scan<decltype(scan_callback), false/*reverse*/>(cxk0, cxk1, scan_callback, RowAccess::ObserveExists);
+    if (!success)
+        return false;
+
+    std::vector<typename tpce_db<DBParams>::tx_table_type::sel_return_type> tx_rows(tx_keys.size());
+    if (!db.tbl_taxrates().select_rows(tx_keys.data(), int(tx_keys.size()), false, tx_rows.data()))
+        return false;
+
+    rate = 0.0f;
+    for (auto& tx_row : tx_rows) {
+        assert(std::get<1>(tx_row));
+        rate += std::get<3>(tx_row)->tx_rate;
+    }
+    return true;
+}
+
+// the settlement, cash transaction and history of trade t_id, which
+// Trade-Lookup and Trade-Update return with the trade
+template <typename DBParams>
+bool tpce_runner<DBParams>::read_trade_details(int64_t t_id, bool is_cash) {
+    // holding outputs of the transaction
+    volatile float out_settlement_amount;
+    volatile float out_cash_amount;
+    volatile uint32_t out_history_dts;
+    (void)out_settlement_amount;
+    (void)out_cash_amount;
+    (void)out_history_dts;
+
+    bool success, result;
+    const void *value;
+
+    std::tie(success, result, std::ignore, value) = db.tbl_settlements().select_row(settlement_key(t_id), RowAccess::ObserveValue);
+    if (!success)
+        return false;
+    assert(result);
+    out_settlement_amount = reinterpret_cast<const settlement_row *>(value)->se_amt;
+
+    if (is_cash) {
+        std::tie(success, result, std::ignore, value) = db.tbl_cash_transactions().select_row(cash_transaction_key(t_id), RowAccess::ObserveValue);
+        if (!success)
+            return false;
+        assert(result);
+        out_cash_amount = reinterpret_cast<const cash_transaction_row *>(value)->ct_amt;
+    }
+
+    auto th_scan_callback = [&] (const trade_history_key&, const trade_history_row& thv) -> bool {
+        out_history_dts = thv.th_dts;
+        return true;
+    };
+
+    trade_history_key thk0(t_id, "");
+    trade_history_key thk1(t_id + 1, "");
+
+    return db.tbl_trade_histories()
+            .template range_scan<decltype(th_scan_callback), false/*reverse*/>(thk0, thk1, th_scan_callback, RowAccess::ObserveValue);
+}
+
+template <typename DBParams>
+size_t tpce_runner<DBParams>::run_txn_broker_volume() {
+    typedef trade_request_row::NamedColumn tr_nc;
+    typedef customer_account_row::NamedColumn ca_nc;
+    typedef company_row::NamedColumn co_nc;
+    typedef industry_row::NamedColumn in_nc;
+
+    auto& scale = ig.scale();
+    fix_string<2> q_sc_id = constants::sector_id(int(ig.random(0, constants::num_sectors - 1)));
+    // the brokers to report on
+    std::vector<bool> q_brokers(scale.num_brokers + 1, false);
+    for (auto n = ig.random(1, scale.num_brokers); n > 0; --n)
+        q_brokers[ig.gen_broker_id()] = true;
+
+    // holding outputs of the transaction
+    std::vector<float> out_volumes(scale.num_brokers + 1);
+
+    struct pending_request {
+        int64_t ca_id;
+        fix_string<15> symb;
+        float volume;
+    };
+    std::vector<pending_request> requests;
+    size_t nexecs = 0;
+
+    // under MVCC, read at an untracked snapshot
+    TRANSACTION_SNAPSHOT_IF(DBParams::MVCC) {
+
+    bool success, result;
+    const void *value;
+
+    ++nexecs;
+
+    // the pending limit orders
+    requests.clear();
+    auto tr_scan_callback = [&] (const trade_request_key&, const trade_request_row& trv) -> bool {
+        requests.push_back({trv.tr_ca_id, trv.tr_s_symb, trv.tr_qty * trv.tr_bid_price});
+        return true;
+    };
+
+    trade_request_key trk0(0);
+    trade_request_key trk1(std::numeric_limits<int64_t>::max());
+
+    success = db.tbl_trade_requests()
+            .template range_scan<decltype(tr_scan_callback), false/*reverse*/>(trk0, trk1, tr_scan_callback, {{tr_nc::tr_s_symb, false}, {tr_nc::tr_qty, false}, {tr_nc::tr_bid_price, false}, {tr_nc::tr_ca_id, false}});
+    TXN_DO(success);
+
+    std::fill(out_volumes.begin(), out_volumes.end(), 0.0f);
+    for (auto& req : requests) {
+        std::tie(success, result, std::ignore, value) = db.tbl_accounts().select_row(customer_account_key(req.ca_id), {{ca_nc::ca_b_id, false}});
+        TXN_DO(success);
+        assert(result);
+        int64_t b_id = reinterpret_cast<const customer_account_row *>(value)->ca_b_id;
+        if (!q_brokers[b_id])
+            continue;
+
+        // the sector of the security's company
+        std::tie(success, result, std::ignore, value) = db.tbl_securities().select_row(security_key(req.symb));
+        TXN_DO(success);
+        assert(result);
+        int64_t co_id = reinterpret_cast<const security_row *>(value)->s_co_id;
+
+        std::tie(success, result, std::ignore, value) = db.tbl_companies().select_row(company_key(co_id), {{co_nc::co_in_id, false}});
+        TXN_DO(success);
+        assert(result);
+        auto in_id = reinterpret_cast<const company_row *>(value)->co_in_id;
+
+        std::tie(success, result, std::ignore, value) = db.tbl_industries().select_row(industry_key(in_id), {{in_nc::in_sc_id, false}});
+        TXN_DO(success);
+        assert(result);
+        if (!(reinterpret_cast<const industry_row *>(value)->in_sc_id == q_sc_id))
+            continue;
+
+        out_volumes[b_id] += req.volume;
+    }
+
+    // commit txn
+    // retry until commits
+    } RETRY(true);
+
+    return nexecs - 1;
+}
+
+template <typename DBParams>
+size_t tpce_runner<DBParams>::run_txn_customer_position() {
+    typedef customer_account_row::NamedColumn ca_nc;
+    typedef trade_row::NamedColumn t_nc;
+
+    int64_t q_c_id = ig.gen_customer_id();
+    bool q_get_history = ig.percent(50);
+    int q_acct_idx = int(ig.random(0, constants::num_accounts(q_c_id) - 1));
+
+    // holding outputs of the transaction
+    volatile var_string<30> out_c_l_name, out_c_f_name;
+    volatile float out_asset_totals[constants::max_accounts_per_customer];
+    volatile int32_t out_qty;
+    volatile uint32_t out_dts;
+    (void)out_asset_totals;
+    (void)out_qty;
+    (void)out_dts;
+
+    std::vector<int64_t> ca_ids;
+    std::vector<std::pair<fix_string<15>, int32_t>> holdings;
+    std::vector<uintptr_t> t_rids;
+    size_t nexecs = 0;
+
+    // under MVCC, read at an untracked snapshot
+    TRANSACTION_SNAPSHOT_IF(DBParams::MVCC) {
+
+    bool success, result;
+    const void *value;
+
+    ++nexecs;
+
+    std::tie(success, result, std::ignore, value) = db.tbl_customers().select_row(customer_key(q_c_id));
+    TXN_DO(success);
+    assert(result);
+    auto cv = reinterpret_cast<const customer_row *>(value);
+    out_c_l_name = cv->c_l_name;
+    out_c_f_name = cv->c_f_name;
+
+    // the customer's accounts, and the market value of their holdings
+    ca_ids.clear();
+    auto ca_scan_callback = [&] (const customer_account_key& key, const customer_account_row&) -> bool {
+        ca_ids.push_back(bswap(key.ca_id));
+        return true;
+    };
+
+    customer_account_key cak0(constants::account_id(q_c_id, 1));
+    customer_account_key cak1(constants::account_id(q_c_id, constants::max_accounts_per_customer));
+
+    success = db.tbl_accounts()
+            .template range_scan<decltype(ca_scan_callback), false/*reverse*/>(cak0, cak1, ca_scan_callback, {{ca_nc::ca_bal, false}});
+    TXN_DO(success);
+
+    for (size_t i = 0; i < ca_ids.size(); ++i) {
+        holdings.clear();
+        auto hs_scan_callback = [&] (const holding_summary_key& key, const holding_summary_row& hsv) -> bool {
+            holdings.emplace_back(key.hs_s_symb, hsv.hs_qty);
+            return true;
+        };
+
+        holding_summary_key hsk0(ca_ids[i], "");
+        holding_summary_key hsk1(ca_ids[i] + 1, "");
+
+        success = db.tbl_holding_summaries()
+                .template range_scan<decltype(hs_scan_callback), false/*reverse*/>(hsk0, hsk1, hs_scan_callback, RowAccess::ObserveValue);
+        TXN_DO(success);
+
+        float assets = 0.0f;
+        for (auto& h : holdings) {
+            std::tie(success, result, std::ignore, value) = db.tbl_last_trades().select_row(last_trade_key(h.first));
+            TXN_DO(success);
+            assert(result);
+            assets += h.second * reinterpret_cast<const last_trade_row *>(value)->lt_price;
+        }
+        out_asset_totals[i] = assets;
+    }
+
+    if (q_get_history) {
+        // the last 10 trades of one account, and their histories
+        always_assert(q_acct_idx < int(ca_ids.size()), "account index invalid");
+        int64_t ca_id = ca_ids[q_acct_idx];
+
+        t_rids.clear();
+        auto t_scan_callback = [&] (const trade_account_idx_key&, const index_entry_row& entry) -> bool {
+            t_rids.push_back(entry.rid);
+            return true;
+        };
+
+        trade_account_idx_key tik0(ca_id, 0, 0);
+        trade_account_idx_key tik1(ca_id, std::numeric_limits<uint32_t>::max(), std::numeric_limits<int64_t>::max());
+
+        success = db.tbl_trade_account_index()
+                .template range_scan<decltype(t_scan_callback), true/*reverse*/>(tik1, tik0, t_scan_callback, RowAccess::ObserveExists, true, 10);
+        TXN_DO(success);
+
+        for (auto rid : t_rids) {
+            std::tie(success, result, std::ignore, value) = db.tbl_trades().select_row(rid, {{t_nc::t_s_symb, false}, {t_nc::t_qty, false}});
+            TXN_DO(success);
+            assert(result);
+            out_qty = reinterpret_cast<const trade_row *>(value)->t_qty;
+
+            int64_t t_id = bswap(tpce_db<DBParams>::t_table_type::row_key(rid).t_id);
+            auto th_scan_callback = [&] (const trade_history_key&, const trade_history_row& thv) -> bool {
+                out_dts = thv.th_dts;
+                return true;
+            };
+
+            trade_history_key thk0(t_id, "");
+            trade_history_key thk1(t_id + 1, "");
+
+            success = db.tbl_trade_histories()
+                    .template range_scan<decltype(th_scan_callback), false/*reverse*/>(thk0, thk1, th_scan_callback, RowAccess::ObserveValue);
+            TXN_DO(success);
+        }
+    }
+
+    // commit txn
+    // retry until commits
+    } RETRY(true);
+
+    return nexecs - 1;
+}
+
+template <typename DBParams>
+size_t tpce_runner<DBParams>::run_txn_market_feed() {
+    typedef last_trade_row::NamedColumn lt_nc;
+    typedef trade_request_row::NamedColumn tr_nc;
+    typedef trade_row::NamedColumn t_nc;
+
+    constexpr size_t max_feed_len = 20;
+
+    // the ticker: distinct securities, in key order
+    std::set<int64_t> s_idxs;
+    while (s_idxs.size() < std::min<size_t>(max_feed_len, ig.scale().num_securities))
+        s_idxs.insert(ig.gen_security_index());
+    std::vector<fix_string<15>> q_symbs;
+    std::vector<float> q_prices;
+    std::vector<int32_t> q_qtys;
+    for (auto s_idx : s_idxs) {
+        q_symbs.push_back(constants::symbol(s_idx));
+        q_prices.push_back(ig.random_price());
+        q_qtys.push_back(int32_t(100 * ig.random(1, 8)));
+    }
+
+    std::vector<uintptr_t> tr_rids;
+    std::vector<submitted_trade> triggered;
+    size_t nexecs = 0;
+
+    // begin txn
+    TRANSACTION {
+
+    bool success, result;
+    uintptr_t row;
+    const void *value;
+
+    ++nexecs;
+
+    triggered.clear();
+    uint32_t dts = now();
+    for (size_t i = 0; i < q_symbs.size(); ++i) {
+        std::tie(success, result, row, value) = db.tbl_last_trades().select_row(last_trade_key(q_symbs[i]), true);
+        TXN_DO(success);
+        assert(result);
+
+        last_trade_row *new_ltv = Sto::tx_alloc(reinterpret_cast<const last_trade_row *>(value));
+        new_ltv->lt_dts = dts;
+        new_ltv->lt_price = q_prices[i];
+        new_ltv->lt_vol += q_qtys[i];
+        db.tbl_last_trades().update_row(row, new_ltv);
+
+        // the limit orders of the security the new price triggers
+        tr_rids.clear();
+        auto tr_scan_callback = [&] (const trade_request_symb_idx_key&, const index_entry_row& entry) -> bool {
+            tr_rids.push_back(entry.rid);
+            return true;
+        };
+
+        trade_request_symb_idx_key trik0(q_symbs[i], 0);
+        trade_request_symb_idx_key trik1(q_symbs[i], std::numeric_limits<int64_t>::max());
+
+        success = db.tbl_trade_request_symbol_index()
+                .template range_scan<decltype(tr_scan_callback), false/*reverse*/>(trik0, trik1, tr_scan_callback, RowAccess::ObserveExists);
+        TXN_DO(success);
+
+        for (auto rid : tr_rids) {
+            std::tie(success, result, std::ignore, value) = db.tbl_trade_requests().select_row(rid, {{tr_nc::tr_tt_id, false}, {tr_nc::tr_bid_price, false}});
+            TXN_DO(success);
+            assert(result);
+            auto trv = reinterpret_cast<const trade_request_row *>(value);
+            if ((trv->tr_tt_id == "TSL" && trv->tr_bid_price >= q_prices[i])
+                || (trv->tr_tt_id == "TLS" && trv->tr_bid_price <= q_prices[i])
+                || (trv->tr_tt_id == "TLB" && trv->tr_bid_price >= q_prices[i]))
+                triggered.push_back({bswap(tpce_db<DBParams>::tr_table_type::row_key(rid).tr_t_id), q_prices[i]});
+        }
+    }
+
+    // submit the triggered orders
+    for (auto& trade : triggered) {
+        std::tie(success, result, row, value) = db.tbl_trades().select_row(trade_key(trade.t_id), {{t_nc::t_dts, true}, {t_nc::t_st_id, true}});
+        TXN_DO(success);
+        assert(result);
+
+        trade_row *new_tv = Sto::tx_alloc(reinterpret_cast<const trade_row *>(value));
+        new_tv->t_dts = dts;
+        new_tv->t_st_id = "SBMT";
+        // also maintains the trade-account index
+        TXN_DO(db.tbl_trades().update_row(row, new_tv));
+
+        // also maintains the trade request index
+        std::tie(success, result) = db.tbl_trade_requests().delete_row(trade_request_key(trade.t_id));
+        TXN_DO(success);
+        TXN_DO(result);
+
+        trade_history_row *thv = Sto::tx_alloc<trade_history_row>();
+        thv->th_dts = dts;
+        std::tie(success, result) = db.tbl_trade_histories().insert_row(trade_history_key(trade.t_id, "SBMT"), thv);
+        TXN_DO(success);
+        assert(!result);
+    }
+
+    // commit txn
+    // retry until commits
+    } RETRY(true);
+
+    submitted.insert(submitted.end(), triggered.begin(), triggered.end());
+    return nexecs - 1;
+}
+
+template <typename DBParams>
+size_t tpce_runner<DBParams>::run_txn_market_watch() {
+    // the securities of a customer's watch list, or those an account holds
+    bool q_by_watch_list = ig.percent(35);
+    int64_t q_c_id = ig.gen_customer_id();
+    int64_t q_ca_id = ig.gen_account_id(q_c_id);
+    int q_day = int(ig.random(0, constants::daily_market_days - 1));
+    uint32_t q_start_date = constants::base_dts - (constants::daily_market_days - q_day) * constants::seconds_per_day;
+
+    // holding outputs of the transaction
+    volatile double out_pct_change;
+    (void)out_pct_change;
+
+    std::vector<fix_string<15>> symbs;
+    size_t nexecs = 0;
+
+    // under MVCC, read at an untracked snapshot
+    TRANSACTION_SNAPSHOT_IF(DBParams::MVCC) {
+
+    bool success, result;
+    const void *value;
+
+    ++nexecs;
+
+    symbs.clear();
+    if (q_by_watch_list) {
+        auto wi_scan_callback = [&] (const watch_item_key& key, const bench::dummy_row&) -> bool {
+            symbs.push_back(key.wi_s_symb);
+            return true;
+        };
+
+        // a customer's watch list has the customer's id
+        watch_item_key wik0(q_c_id, "");
+        watch_item_key wik1(q_c_id + 1, "");
+
+        success = db.tbl_watch_items()
+                .template range_scan<decltype(wi_scan_callback), false/*reverse*/>(wik0, wik1, wi_scan_callback, RowAccess::ObserveExists);
+        TXN_DO(success);
+    } else {
+        auto hs_scan_callback = [&] (const holding_summary_key& key, const holding_summary_row&) -> bool {
+            symbs.push_back(key.hs_s_symb);
+            return true;
+        };
+
+        holding_summary_key hsk0(q_ca_id, "");
+        holding_summary_key hsk1(q_ca_id + 1, "");
+
+        success = db.tbl_holding_summaries()
+                .template range_scan<decltype(hs_scan_callback), false/*reverse*/>(hsk0, hsk1, hs_scan_callback, RowAccess::ObserveExists);
+        TXN_DO(success);
+    }
+
+    double old_mkt_cap = 0.0, new_mkt_cap = 0.0;
+    for (auto& symb : symbs) {
+        std::tie(success, result, std::ignore, value) = db.tbl_last_trades().select_row(last_trade_key(symb));
+        TXN_DO(success);
+        assert(result);
+        float new_price = reinterpret_cast<const last_trade_row *>(value)->lt_price;
+
+        std::tie(success, result, std::ignore, value) = db.tbl_securities().select_row(security_key(symb));
+        TXN_DO(success);
+        assert(result);
+        int64_t s_num_out = reinterpret_cast<const security_row *>(value)->s_num_out;
+
+        std::tie(success, result, std::ignore, value) = db.tbl_daily_markets().select_row(daily_market_key(symb, q_start_date), {{daily_market_row::NamedColumn::dm_close, false}});
+        TXN_DO(success);
+        assert(result);
+        float old_price = reinterpret_cast<const daily_market_row *>(value)->dm_close;
+
+        old_mkt_cap += double(s_num_out) * old_price;
+        new_mkt_cap += double(s_num_out) * new_price;
+    }
+    out_pct_change = (old_mkt_cap != 0.0) ? 100.0 * (new_mkt_cap / old_mkt_cap - 1.0) : 0.0;
+
+    // commit txn
+    // retry until commits
+    } RETRY(true);
+
+    return nexecs - 1;
+}
+
+template <typename DBParams>
+size_t tpce_runner<DBParams>::run_txn_security_detail() {
+    typedef company_row::NamedColumn co_nc;
+    typedef industry_row::NamedColumn in_nc;
+    typedef news_item_row::NamedColumn ni_nc;
+
+    fix_string<15> q_symb = constants::symbol(ig.gen_security_index());
+    int q_max_rows = int(ig.random(5, 20));
+    int q_start_day = int(ig.random(0, constants::daily_market_days - q_max_rows));
+    uint32_t q_start_date = constants::base_dts - (constants::daily_market_days - q_start_day) * constants::seconds_per_day;
+    bool q_access_lob = ig.percent(1);
+
+    // holding outputs of the transaction
+    volatile var_string<70> out_s_name;
+    volatile var_string<60> out_co_name;
+    volatile var_string<80> out_zc_town;
+    volatile var_string<100> out_ex_name;
+    volatile var_string<50> out_in_name;
+    volatile float out_fi_revenue;
+    volatile float out_dm_close;
+    volatile float out_lt_price;
+    volatile var_string<80> out_ni_headline;
+    volatile size_t out_ni_length;
+    (void)out_fi_revenue;
+    (void)out_dm_close;
+    (void)out_lt_price;
+    (void)out_ni_length;
+
+    std::vector<std::pair<int64_t, fix_string<2>>> competitors;
+    std::vector<int64_t> ni_ids;
+    size_t nexecs = 0;
+
+    // under MVCC, read at an untracked snapshot
+    TRANSACTION_SNAPSHOT_IF(DBParams::MVCC) {
+
+    bool success, result;
+    const void *value;
+
+    ++nexecs;
+
+    std::tie(success, result, std::ignore, value) = db.tbl_securities().select_row(security_key(q_symb));
+    TXN_DO(success);
+    assert(result);
+    auto sv = reinterpret_cast<const security_row *>(value);
+    out_s_name = sv->s_name;
+    int64_t co_id = sv->s_co_id;
+    fix_string<6> ex_id = sv->s_ex_id;
+
+    std::tie(success, result, std::ignore, value) = db.tbl_companies().select_row(company_key(co_id), RowAccess::ObserveValue);
+    TXN_DO(success);
+    assert(result);
+    auto cov = reinterpret_cast<const company_row *>(value);
+    out_co_name = cov->co_name;
+    int64_t ad_id = cov->co_ad_id;
+
+    std::tie(success, result, std::ignore, value) = db.tbl_addresses().select_row(address_key(ad_id), RowAccess::ObserveValue);
+    TXN_DO(success);
+    assert(result);
+    auto zc_code = reinterpret_cast<const address_row *>(value)->ad_zc_code;
+
+    std::tie(success, result, std::ignore, value) = db.tbl_zip_codes().select_row(zip_code_key(zc_code), RowAccess::ObserveValue);
+    TXN_DO(success);
+    assert(result);
+    out_zc_town = reinterpret_cast<const zip_code_row *>(value)->zc_town;
+
+    std::tie(success, result, std::ignore, value) = db.tbl_exchanges().select_row(exchange_key(ex_id), RowAccess::ObserveValue);
+    TXN_DO(success);
+    assert(result);
+    out_ex_name = reinterpret_cast<const exchange_row *>(value)->ex_name;
+
+    // the company's competitors and their industries
+    competitors.clear();
+    auto cp_scan_callback = [&] (const company_competitor_key& key, const bench::dummy_row&) -> bool {
+        competitors.emplace_back(bswap(key.cp_comp_co_id), key.cp_in_id);
+        return true;
+    };
+
+    company_competitor_key cpk0(co_id, 0, "");
+    company_competitor_key cpk1(co_id + 1, 0, "");
+
+    success = db.tbl_company_competitors()
+            .template range_scan<decltype(cp_scan_callback), false/*reverse*/>(cpk0, cpk1, cp_scan_callback, RowAccess::ObserveExists, true, constants::competitors_per_company);
+    TXN_DO(success);
+
+    for (auto& cp : competitors) {
+        std::tie(success, result, std::ignore, value) = db.tbl_companies().select_row(company_key(cp.first), {{co_nc::co_name, false}});
+        TXN_DO(success);
+        assert(result);
+        out_co_name = reinterpret_cast<const company_row *>(value)->co_name;
+
+        std::tie(success, result, std::ignore, value) = db.tbl_industries().select_row(industry_key(cp.second), {{in_nc::in_name, false}});
+        TXN_DO(success);
+        assert(result);
+        out_in_name = reinterpret_cast<const industry_row *>(value)->in_name;
+    }
+
+    // the company's financials, by quarter
+    auto fi_scan_callback = [&] (const financial_key&, const financial_row& fiv) -> bool {
+        out_fi_revenue = fiv.fi_revenue;
+        return true;
+    };
+
+    financial_key fik0(co_id, 0, 0);
+    financial_key fik1(co_id + 1, 0, 0);
+
+    success = db.tbl_financials()
+            .template range_scan<decltype(fi_scan_callback), false/*reverse*/>(fik0, fik1, fi_scan_callback, RowAccess::ObserveValue);
+    TXN_DO(success);
+
+    // the security's market history from the start date
+    auto dm_scan_callback = [&] (const daily_market_key&, const daily_market_row& dmv) -> bool {
+        out_dm_close = dmv.dm_close;
+        return true;
+    };
+
+    daily_market_key dmk0(q_symb, q_start_date);
+    daily_market_key dmk1(q_symb, std::numeric_limits<uint32_t>::max());
+
+    success = db.tbl_daily_markets()
+            .template range_scan<decltype(dm_scan_callback), false/*reverse*/>(dmk0, dmk1, dm_scan_callback, RowAccess::ObserveValue, true, q_max_rows);
+    TXN_DO(success);
+
+    std::tie(success, result, std::ignore, value) = db.tbl_last_trades().select_row(last_trade_key(q_symb));
+    TXN_DO(success);
+    assert(result);
+    out_lt_price = reinterpret_cast<const last_trade_row *>(value)->lt_price;
+
+    // the company's news
+    ni_ids.clear();
+    auto nx_scan_callback = [&] (const news_xref_key& key, const bench::dummy_row&) -> bool {
+        ni_ids.push_back(bswap(key.nx_ni_id));
+        return true;
+    };
+
+    news_xref_key nxk0(co_id, 0);
+    news_xref_key nxk1(co_id + 1, 0);
+
+    success = db.tbl_news_xrefs()
+            .template range_scan<decltype(nx_scan_callback), false/*reverse*/>(nxk0, nxk1, nx_scan_callback, RowAccess::ObserveExists, true, constants::news_per_company);
+    TXN_DO(success);
+
+    for (auto ni_id : ni_ids) {
+        if (q_access_lob) {
+            std::tie(success, result, std::ignore, value) = db.tbl_news_items().select_row(news_item_key(ni_id), {{ni_nc::ni_headline, false}, {ni_nc::ni_item, false}});
+            TXN_DO(success);
+            assert(result);
+            out_ni_length = reinterpret_cast<const news_item_row *>(value)->ni_item.length();
+        } else {
+            std::tie(success, result, std::ignore, value) = db.tbl_news_items().select_row(news_item_key(ni_id), {{ni_nc::ni_headline, false}, {ni_nc::ni_summary, false}});
+            TXN_DO(success);
+            assert(result);
+            out_ni_length = reinterpret_cast<const news_item_row *>(value)->ni_summary.length();
+        }
+        out_ni_headline = reinterpret_cast<const news_item_row *>(value)->ni_headline;
+    }
+
+    // commit txn
+    // retry until commits
+    } RETRY(true);
+
+    return nexecs - 1;
+}
+
+template <typename DBParams>
+size_t tpce_runner<DBParams>::run_txn_trade_lookup() {
+    typedef trade_row::NamedColumn t_nc;
+
+    constexpr size_t max_trades = 20;
+
+    // frame 1 looks up trades by id, frame 2 the trades of an account in a
+    // time range, and frame 4 the holding history of an account's first
+    // trade after a time. Frame 3 looks trades up by security; it is left
+    // out and frame 2 runs in its place.
+    uint64_t x = ig.random(1, 100);
+    int q_frame = (x <= 30) ? 1 : ((x <= 90) ? 2 : 4);
+    std::set<int64_t> q_t_ids;
+    if (q_frame == 1) {
+        while (q_t_ids.size() < std::min<size_t>(max_trades, ig.scale().num_loaded_trades))
+            q_t_ids.insert(ig.gen_loaded_trade_id());
+    }
+    int64_t q_ca_id = ig.gen_account_id();
+    uint32_t q_start_dts = ig.gen_history_dts();
+    uint32_t q_end_dts = q_start_dts + 30 * constants::seconds_per_day;
+
+    // holding outputs of the transaction
+    volatile float out_trade_price;
+    volatile int32_t out_hh_after_qty;
+    (void)out_trade_price;
+    (void)out_hh_after_qty;
+
+    std::vector<uintptr_t> t_rids;
+    size_t nexecs = 0;
+
+    // under MVCC, read at an untracked snapshot
+    TRANSACTION_SNAPSHOT_IF(DBParams::MVCC) {
+
+    bool success, result;
+    const void *value;
+
+    ++nexecs;
+
+    std::initializer_list<typename tpce_db<DBParams>::t_table_type::column_access_t> t_accesses = {{t_nc::t_is_cash, false}, {t_nc::t_exec_name, false}, {t_nc::t_trade_price, false}};
+    if (q_frame == 1) {
+        for (auto t_id : q_t_ids) {
+            std::tie(success, result, std::ignore, value) = db.tbl_trades().select_row(trade_key(t_id), t_accesses);
+            TXN_DO(success);
+            assert(result);
+            auto tv = reinterpret_cast<const trade_row *>(value);
+            out_trade_price = tv->t_trade_price;
+            TXN_DO(read_trade_details(t_id, tv->t_is_cash));
+        }
+    } else if (q_frame == 2) {
+        t_rids.clear();
+        auto t_scan_callback = [&] (const trade_account_idx_key&, const index_entry_row& entry) -> bool {
+            t_rids.push_back(entry.rid);
+            return true;
+        };
+
+        trade_account_idx_key tik0(q_ca_id, q_start_dts, 0);
+        trade_account_idx_key tik1(q_ca_id, q_end_dts, 0);
+
+        success = db.tbl_trade_account_index()
+                .template range_scan<decltype(t_scan_callback), false/*reverse*/>(tik0, tik1, t_scan_callback, RowAccess::ObserveExists, true, max_trades);
+        TXN_DO(success);
+
+        for (auto rid : t_rids) {
+            std::tie(success, result, std::ignore, value) = db.tbl_trades().select_row(rid, t_accesses);
+            TXN_DO(success);
+            assert(result);
+            auto tv = reinterpret_cast<const trade_row *>(value);
+            out_trade_price = tv->t_trade_price;
+            TXN_DO(read_trade_details(bswap(tpce_db<DBParams>::t_table_type::row_key(rid).t_id), tv->t_is_cash));
+        }
+    } else {
+        int64_t t_id = 0;
+        auto t_scan_callback = [&] (const trade_account_idx_key& key, const index_entry_row&) -> bool {
+            t_id = bswap(key.t_id);
+            return true;
+        };
+
+        trade_account_idx_key tik0(q_ca_id, q_start_dts, 0);
+        trade_account_idx_key tik1(q_ca_id, std::numeric_limits<uint32_t>::max(), std::numeric_limits<int64_t>::max());
+
+        success = db.tbl_trade_account_index()
+                .template range_scan<decltype(t_scan_callback), false/*reverse*/>(tik0, tik1, t_scan_callback, RowAccess::ObserveExists, true, 1/*first only*/);
+        TXN_DO(success);
+
+        if (t_id != 0) {
+            // the history of the holding the trade opened
+            auto hh_scan_callback = [&] (const holding_history_key&, const holding_history_row& hhv) -> bool {
+                out_hh_after_qty = hhv.hh_after_qty;
+                return true;
+            };
+
+            holding_history_key hhk0(t_id, 0);
+            holding_history_key hhk1(t_id + 1, 0);
+
+            success = db.tbl_holding_histories()
+                    .template range_scan<decltype(hh_scan_callback), false/*reverse*/>(hhk0, hhk1, hh_scan_callback, RowAccess::ObserveValue, true, max_trades);
+            TXN_DO(success);
+        }
+    }
+
+    // commit txn
+    // retry until commits
+    } RETRY(true);
+
+    return nexecs - 1;
+}
+
+template <typename DBParams>
+size_t tpce_runner<DBParams>::run_txn_trade_order() {
+    typedef customer_account_row::NamedColumn ca_nc;
+    typedef company_row::NamedColumn co_nc;
+
+    int64_t q_c_id = ig.gen_customer_id();
+    int64_t q_ca_id = ig.gen_account_id(q_c_id);
+    // the trade is placed by someone other than the account owner
+    bool q_by_other = ig.percent(10);
+    fix_string<15> q_symb = constants::symbol(ig.gen_security_index());
+    uint64_t x = ig.random(1, 100);
+    fix_string<3> q_tt_id = (x <= 30) ? "TMB" : ((x <= 60) ? "TMS" : ((x <= 80) ? "TLB" : ((x <= 90) ? "TLS" : "TSL")));
+    int32_t q_qty = int32_t(100 << ig.random(0, 3));
+    int32_t q_is_lifo = ig.percent(50);
+    int32_t q_is_cash = !ig.percent(8);
+    // a limit order's price, relative to the market price
+    float q_limit_ratio = 1.0f + ((q_tt_id == "TLS") ? 1.0f : -1.0f) * ig.random(5, 20) / 100.0f;
+    bool q_roll_back = ig.percent(1);
+
+    // holding outputs of the transaction
+    volatile var_string<50> out_ca_name;
+    volatile var_string<100> out_b_name;
+    volatile var_string<60> out_co_name;
+    (void)out_co_name;
+
+    int64_t t_id = 0;
+    bool is_mrkt = false;
+    float requested_price = 0.0f;
+    bool rolled_back = false;
+    size_t nexecs = 0;
+
+    // begin txn
+    TRANSACTION {
+
+    bool success, result;
+    const void *value;
+
+    ++nexecs;
+    rolled_back = false;
+
+    std::tie(success, result, std::ignore, value) = db.tbl_accounts().select_row(customer_account_key(q_ca_id), {{ca_nc::ca_b_id, false}, {ca_nc::ca_name, false}});
+    TXN_DO(success);
+    assert(result);
+    auto cav = reinterpret_cast<const customer_account_row *>(value);
+    out_ca_name = cav->ca_name;
+    int64_t b_id = cav->ca_b_id;
+
+    std::tie(success, result, std::ignore, value) = db.tbl_customers().select_row(customer_key(q_c_id));
+    TXN_DO(success);
+    assert(result);
+    auto cv = reinterpret_cast<const customer_row *>(value);
+    int32_t c_tier = cv->c_tier;
+    std::string exec_name = std::string(cv->c_f_name.c_str()) + " " + cv->c_l_name.c_str();
+
+    std::tie(success, result, std::ignore, value) = db.tbl_brokers().select_row(broker_key(b_id));
+    TXN_DO(success);
+    assert(result);
+    out_b_name = reinterpret_cast<const broker_row *>(value)->b_name;
+
+    if (q_by_other) {
+        // the executor must be permitted to trade on the account
+        std::tie(success, result, std::ignore, value) = db.tbl_account_permissions().select_row(account_permission_key(q_ca_id, "0001"), RowAccess::ObserveValue);
+        TXN_DO(success);
+        assert(result);
+        auto apv = reinterpret_cast<const account_permission_row *>(value);
+        exec_name = std::string(apv->ap_f_name.c_str()) + " " + apv->ap_l_name.c_str();
+    }
+
+    std::tie(success, result, std::ignore, value) = db.tbl_securities().select_row(security_key(q_symb));
+    TXN_DO(success);
+    assert(result);
+    auto sv = reinterpret_cast<const security_row *>(value);
+    int64_t co_id = sv->s_co_id;
+    fix_string<6> ex_id = sv->s_ex_id;
+
+    std::tie(success, result, std::ignore, value) = db.tbl_companies().select_row(company_key(co_id), {{co_nc::co_name, false}});
+    TXN_DO(success);
+    assert(result);
+    out_co_name = reinterpret_cast<const company_row *>(value)->co_name;
+
+    std::tie(success, result, std::ignore, value) = db.tbl_last_trades().select_row(last_trade_key(q_symb));
+    TXN_DO(success);
+    assert(result);
+    float market_price = reinterpret_cast<const last_trade_row *>(value)->lt_price;
+
+    std::tie(success, result, std::ignore, value) = db.tbl_trade_types().select_row(trade_type_key(q_tt_id));
+    TXN_DO(success);
+    assert(result);
+    is_mrkt = reinterpret_cast<const trade_type_row *>(value)->tt_is_mrkt;
+    requested_price = is_mrkt ? market_price : market_price * q_limit_ratio;
+
+    std::tie(success, result, std::ignore, value) = db.tbl_charges().select_row(charge_key(q_tt_id, c_tier));
+    TXN_DO(success);
+    assert(result);
+    float charge = reinterpret_cast<const charge_row *>(value)->ch_chrg;
+
+    float comm_rate;
+    TXN_DO(lookup_commission_rate(c_tier, q_tt_id, ex_id, q_qty, comm_rate));
+
+    // record the order; a limit order waits for the market to reach its
+    // price, a market order goes to the market now
+    uint32_t dts = now();
+    const char *st_id = is_mrkt ? "SBMT" : "PNDG";
+    t_id = int64_t(db.tbl_trades().gen_key());
+
+    trade_row *tv = Sto::tx_alloc<trade_row>();
+    tv->t_dts = dts;
+    tv->t_st_id = st_id;
+    tv->t_tt_id = q_tt_id;
+    tv->t_is_cash = q_is_cash;
+    tv->t_s_symb = q_symb;
+    tv->t_qty = q_qty;
+    tv->t_bid_price = requested_price;
+    tv->t_ca_id = q_ca_id;
+    tv->t_exec_name = exec_name;
+    tv->t_trade_price = 0.0f;
+    tv->t_chrg = charge;
+    tv->t_comm = comm_rate / 100.0f * q_qty * requested_price;
+    tv->t_tax = 0.0f;
+    tv->t_lifo = q_is_lifo;
+    // also inserts into the trade-account index
+    std::tie(success, result) = db.tbl_trades().insert_row(trade_key(t_id), tv);
+    TXN_DO(success);
+    assert(!result);
+
+    if (!is_mrkt) {
+        trade_request_row *trv = Sto::tx_alloc<trade_request_row>();
+        trv->tr_tt_id = q_tt_id;
+        trv->tr_s_symb = q_symb;
+        trv->tr_qty = q_qty;
+        trv->tr_bid_price = requested_price;
+        trv->tr_ca_id = q_ca_id;
+        // also inserts into the trade request index
+        std::tie(success, result) = db.tbl_trade_requests().insert_row(trade_request_key(t_id), trv);
+        TXN_DO(success);
+        assert(!result);
+    }
+
+    trade_history_row *thv = Sto::tx_alloc<trade_history_row>();
+    thv->th_dts = dts;
+    std::tie(success, result) = db.tbl_trade_histories().insert_row(trade_history_key(t_id, st_id), thv);
+    TXN_DO(success);
+    assert(!result);
+
+    if (q_roll_back) {
+        rolled_back = true;
+        TXN_DO(false);
+    }
+
+    // commit txn
+    // retry until commits, unless rolled back
+    } RETRY(!rolled_back);
+
+    if (!rolled_back && is_mrkt)
+        submitted.push_back({t_id, requested_price});
+    return nexecs - 1;
+}
+
+template <typename DBParams>
+size_t tpce_runner<DBParams>::run_txn_trade_result() {
+    typedef trade_row::NamedColumn t_nc;
+    typedef customer_account_row::NamedColumn ca_nc;
+    typedef holding_summary_row::NamedColumn hs_nc;
+    typedef holding_row::NamedColumn h_nc;
+
+    // the oldest trade this runner submitted
+    always_assert(!submitted.empty(), "no submitted trade");
+    submitted_trade q_trade = submitted.front();
+    submitted.pop_front();
+
+    std::vector<uintptr_t> h_rids;
+    size_t nexecs = 0;
+
+    // begin txn
+    TRANSACTION {
+
+    bool success, result;
+    uintptr_t row;
+    const void *value;
+
+    ++nexecs;
+
+    uint32_t dts = now();
+    float price = q_trade.price;
+
+    std::tie(success, result, row, value) = db.tbl_trades().select_row(trade_key(q_trade.t_id), {{t_nc::t_ca_id, false}, {t_nc::t_tt_id, false}, {t_nc::t_s_symb, false}, {t_nc::t_qty, false}, {t_nc::t_chrg, false}, {t_nc::t_lifo, false}, {t_nc::t_is_cash, false}, {t_nc::t_dts, true}, {t_nc::t_st_id, true}, {t_nc::t_trade_price, true}, {t_nc::t_comm, true}, {t_nc::t_tax, true}});
+    TXN_DO(success);
+    assert(result);
+    uintptr_t t_row = row;
+    trade_row *new_tv = Sto::tx_alloc(reinterpret_cast<const trade_row *>(value));
+    int64_t ca_id = new_tv->t_ca_id;
+    fix_string<15> symb = new_tv->t_s_symb;
+    int32_t qty = new_tv->t_qty;
+
+    std::tie(success, result, std::ignore, value) = db.tbl_trade_types().select_row(trade_type_key(new_tv->t_tt_id));
+    TXN_DO(success);
+    assert(result);
+    bool is_sell = reinterpret_cast<const trade_type_row *>(value)->tt_is_sell;
+
+    std::tie(success, result, row, value) = db.tbl_accounts().select_row(customer_account_key(ca_id), {{ca_nc::ca_b_id, false}, {ca_nc::ca_c_id, false}, {ca_nc::ca_tax_st, false}, {ca_nc::ca_bal, true}});
+    TXN_DO(success);
+    assert(result);
+    uintptr_t ca_row = row;
+    customer_account_row *new_cav = Sto::tx_alloc(reinterpret_cast<const customer_account_row *>(value));
+
+    // A sell closes long holdings and a buy short ones, oldest or newest
+    // first; what the trade does not close opens a new holding. All the
+    // holdings of an account in a security are on the same side.
+    holding_summary_key hsk(ca_id, symb);
+    std::tie(success, result, row, value) = db.tbl_holding_summaries().select_row(hsk, {{hs_nc::hs_qty, true}});
+    TXN_DO(success);
+    bool hs_found = result;
+    uintptr_t hs_row = row;
+    int32_t hs_qty = hs_found ? reinterpret_cast<const holding_summary_row *>(value)->hs_qty : 0;
+
+    int32_t sign = is_sell ? -1 : 1;
+    int32_t needed_qty = qty;
+    float buy_value = 0.0f, sell_value = 0.0f;
+    if (hs_qty * sign < 0) {
+        h_rids.clear();
+        auto h_scan_callback = [&] (const holding_account_idx_key&, const index_entry_row& entry) -> bool {
+            h_rids.push_back(entry.rid);
+            return true;
+        };
+
+        holding_account_idx_key hik0(ca_id, symb, 0, 0);
+        holding_account_idx_key hik1(ca_id, symb, std::numeric_limits<uint32_t>::max(), std::numeric_limits<int64_t>::max());
+
+        if (new_tv->t_lifo)
+            success = db.tbl_holding_account_index()
+                    .template range_scan<decltype(h_scan_callback), true/*reverse*/>(hik1, hik0, h_scan_callback, RowAccess::ObserveExists);
+        else
+            success = db.tbl_holding_account_index()
+                    .template range_scan<decltype(h_scan_callback), false/*reverse*/>(hik0, hik1, h_scan_callback, RowAccess::ObserveExists);
+        TXN_DO(success);
+
+        for (auto rid : h_rids) {
+            if (needed_qty == 0)
+                break;
+            std::tie(success, result, std::ignore, value) = db.tbl_holdings().select_row(rid, {{h_nc::h_price, false}, {h_nc::h_qty, true}});
+            TXN_DO(success);
+            assert(result);
+            auto hv = reinterpret_cast<const holding_row *>(value);
+            int32_t closed_qty = std::min(std::abs(hv->h_qty), needed_qty);
+            int32_t after_qty = hv->h_qty + sign * closed_qty;
+            if (is_sell) {
+                buy_value += closed_qty * hv->h_price;
+                sell_value += closed_qty * price;
+            } else {
+                buy_value += closed_qty * price;
+                sell_value += closed_qty * hv->h_price;
+            }
+            needed_qty -= closed_qty;
+
+            int64_t h_t_id = bswap(tpce_db<DBParams>::h_table_type::row_key(rid).h_t_id);
+            holding_history_row *hhv = Sto::tx_alloc<holding_history_row>();
+            hhv->hh_before_qty = hv->h_qty;
+            hhv->hh_after_qty = after_qty;
+            std::tie(success, result) = db.tbl_holding_histories().insert_row(holding_history_key(h_t_id, q_trade.t_id), hhv);
+            TXN_DO(success);
+            assert(!result);
+
+            // also maintains the holding-account index
+            if (after_qty == 0) {
+                std::tie(success, result) = db.tbl_holdings().delete_row(holding_key(h_t_id));
+                TXN_DO(success);
+                TXN_DO(result);
+            } else {
+                holding_row *new_hv = Sto::tx_alloc(hv);
+                new_hv->h_qty = after_qty;
+                TXN_DO(db.tbl_holdings().update_row(rid, new_hv));
+            }
+        }
+    }
+
+    if (needed_qty > 0) {
+        holding_row *hv = Sto::tx_alloc<holding_row>();
+        hv->h_ca_id = ca_id;
+        hv->h_s_symb = symb;
+        hv->h_dts = dts;
+        hv->h_price = price;
+        hv->h_qty = sign * needed_qty;
+        std::tie(success, result) = db.tbl_holdings().insert_row(holding_key(q_trade.t_id), hv);
+        TXN_DO(success);
+        assert(!result);
+
+        holding_history_row *hhv = Sto::tx_alloc<holding_history_row>();
+        hhv->hh_before_qty = 0;
+        hhv->hh_after_qty = hv->h_qty;
+        std::tie(success, result) = db.tbl_holding_histories().insert_row(holding_history_key(q_trade.t_id, q_trade.t_id), hhv);
+        TXN_DO(success);
+        assert(!result);
+    }
+
+    int32_t new_hs_qty = hs_qty + sign * qty;
+    if (!hs_found) {
+        holding_summary_row *hsv = Sto::tx_alloc<holding_summary_row>();
+        hsv->hs_qty = new_hs_qty;
+        std::tie(success, result) = db.tbl_holding_summaries().insert_row(hsk, hsv);
+        TXN_DO(success);
+        assert(!result);
+    } else if (new_hs_qty == 0) {
+        std::tie(success, result) = db.tbl_holding_summaries().delete_row(hsk);
+        TXN_DO(success);
+        TXN_DO(result);
+    } else {
+        holding_summary_row *new_hsv = Sto::tx_alloc<holding_summary_row>();
+        new_hsv->hs_qty = new_hs_qty;
+        TXN_DO(db.tbl_holding_summaries().update_row(hs_row, new_hsv));
+    }
+
+    // taxable accounts pay tax on gains
+    float tax = 0.0f;
+    if (new_cav->ca_tax_st != 0 && sell_value > buy_value) {
+        float tax_rate;
+        TXN_DO(lookup_tax_rate(new_cav->ca_c_id, tax_rate));
+        tax = (sell_value - buy_value) * tax_rate;
+    }
+
+    std::tie(success, result, std::ignore, value) = db.tbl_securities().select_row(security_key(symb));
+    TXN_DO(success);
+    assert(result);
+    auto sv = reinterpret_cast<const security_row *>(value);
+    fix_string<6> ex_id = sv->s_ex_id;
+    std::string s_name(sv->s_name.c_str());
+
+    std::tie(success, result, std::ignore, value) = db.tbl_customers().select_row(customer_key(new_cav->ca_c_id));
+    TXN_DO(success);
+    assert(result);
+    int32_t c_tier = reinterpret_cast<const customer_row *>(value)->c_tier;
+
+    float comm_rate;
+    TXN_DO(lookup_commission_rate(c_tier, new_tv->t_tt_id, ex_id, qty, comm_rate));
+    float comm = comm_rate / 100.0f * qty * price;
+
+    // complete the trade
+    new_tv->t_dts = dts;
+    new_tv->t_st_id = "CMPT";
+    new_tv->t_trade_price = price;
+    new_tv->t_comm = comm;
+    new_tv->t_tax = tax;
+    // also maintains the trade-account index
+    TXN_DO(db.tbl_trades().update_row(t_row, new_tv));
+
+    trade_history_row *thv = Sto::tx_alloc<trade_history_row>();
+    thv->th_dts = dts;
+    std::tie(success, result) = db.tbl_trade_histories().insert_row(trade_history_key(q_trade.t_id, "CMPT"), thv);
+    TXN_DO(success);
+    assert(!result);
+
+    std::tie(success, result, row, value) = db.tbl_brokers().select_row(broker_key(new_cav->ca_b_id), true);
+    TXN_DO(success);
+    assert(result);
+    broker_row *new_bv = Sto::tx_alloc(reinterpret_cast<const broker_row *>(value));
+    new_bv->b_num_trades += 1;
+    new_bv->b_comm_total += comm;
+    db.tbl_brokers().update_row(row, new_bv);
+
+    // settle the trade
+    float se_amount = (is_sell ? 1.0f : -1.0f) * qty * price - new_tv->t_chrg - comm;
+    if (new_cav->ca_tax_st == 1)
+        se_amount -= tax;
+
+    settlement_row *sev = Sto::tx_alloc<settlement_row>();
+    sev->se_cash_type = new_tv->t_is_cash ? "Cash Account" : "Margin";
+    sev->se_cash_due_date = dts + 2 * constants::seconds_per_day;
+    sev->se_amt = se_amount;
+    std::tie(success, result) = db.tbl_settlements().insert_row(settlement_key(q_trade.t_id), sev);
+    TXN_DO(success);
+    assert(!result);
+
+    if (new_tv->t_is_cash) {
+        new_cav->ca_bal += se_amount;
+        TXN_DO(db.tbl_accounts().update_row(ca_row, new_cav));
+
+        cash_transaction_row *ctv = Sto::tx_alloc<cash_transaction_row>();
+        ctv->ct_dts = dts;
+        ctv->ct_amt = se_amount;
+        ctv->ct_name = std::string(new_tv->t_tt_id) + " " + std::to_string(qty) + " shares of " + s_name;
+        std::tie(success, result) = db.tbl_cash_transactions().insert_row(cash_transaction_key(q_trade.t_id), ctv);
+        TXN_DO(success);
+        assert(!result);
+    }
+
+    // commit txn
+    // retry until commits
+    } RETRY(true);
+
+    return nexecs - 1;
+}
+
+template <typename DBParams>
+size_t tpce_runner<DBParams>::run_txn_trade_status() {
+    typedef customer_account_row::NamedColumn ca_nc;
+    typedef trade_row::NamedColumn t_nc;
+
+    constexpr int max_trades = 50;
+
+    int64_t q_ca_id = ig.gen_account_id();
+
+    // holding outputs of the transaction
+    volatile var_string<30> out_c_l_name, out_c_f_name;
+    volatile var_string<100> out_b_name;
+    volatile fix_string<10> out_st_name;
+    volatile fix_string<12> out_tt_name;
+    volatile var_string<70> out_s_name;
+    volatile var_string<100> out_ex_name;
+
+    std::vector<uintptr_t> t_rids;
+    size_t nexecs = 0;
+
+    // under MVCC, read at an untracked snapshot
+    TRANSACTION_SNAPSHOT_IF(DBParams::MVCC) {
+
+    bool success, result;
+    const void *value;
+
+    ++nexecs;
+
+    // the account's latest trades
+    t_rids.clear();
+    auto t_scan_callback = [&] (const trade_account_idx_key&, const index_entry_row& entry) -> bool {
+        t_rids.push_back(entry.rid);
+        return true;
+    };
+
+    trade_account_idx_key tik0(q_ca_id, 0, 0);
+    trade_account_idx_key tik1(q_ca_id, std::numeric_limits<uint32_t>::max(), std::numeric_limits<int64_t>::max());
+
+    success = db.tbl_trade_account_index()
+            .template range_scan<decltype(t_scan_callback), true/*reverse*/>(tik1, tik0, t_scan_callback, RowAccess::ObserveExists, true, max_trades);
+    TXN_DO(success);
+
+    for (auto rid : t_rids) {
+        std::tie(success, result, std::ignore, value) = db.tbl_trades().select_row(rid, {{t_nc::t_st_id, false}, {t_nc::t_tt_id, false}, {t_nc::t_s_symb, false}, {t_nc::t_qty, false}, {t_nc::t_exec_name, false}, {t_nc::t_chrg, false}});
+        TXN_DO(success);
+        assert(result);
+        auto tv = reinterpret_cast<const trade_row *>(value);
+
+        std::tie(success, result, std::ignore, value) = db.tbl_status_types().select_row(status_type_key(tv->t_st_id));
+        TXN_DO(success);
+        assert(result);
+        out_st_name = reinterpret_cast<const status_type_row *>(value)->st_name;
+
+        std::tie(success, result, std::ignore, value) = db.tbl_trade_types().select_row(trade_type_key(tv->t_tt_id));
+        TXN_DO(success);
+        assert(result);
+        out_tt_name = reinterpret_cast<const trade_type_row *>(value)->tt_name;
+
+        std::tie(success, result, std::ignore, value) = db.tbl_securities().select_row(security_key(tv->t_s_symb));
+        TXN_DO(success);
+        assert(result);
+        auto sv = reinterpret_cast<const security_row *>(value);
+        out_s_name = sv->s_name;
+
+        std::tie(success, result, std::ignore, value) = db.tbl_exchanges().select_row(exchange_key(sv->s_ex_id), {{exchange_row::NamedColumn::ex_name, false}});
+        TXN_DO(success);
+        assert(result);
+        out_ex_name = reinterpret_cast<const exchange_row *>(value)->ex_name;
+    }
+
+    std::tie(success, result, std::ignore, value) = db.tbl_accounts().select_row(customer_account_key(q_ca_id), {{ca_nc::ca_b_id, false}, {ca_nc::ca_c_id, false}});
+    TXN_DO(success);
+    assert(result);
+    auto cav = reinterpret_cast<const customer_account_row *>(value);
+    int64_t b_id = cav->ca_b_id;
+
+    std::tie(success, result, std::ignore, value) = db.tbl_customers().select_row(customer_key(cav->ca_c_id));
+    TXN_DO(success);
+    assert(result);
+    auto cv = reinterpret_cast<const customer_row *>(value);
+    out_c_l_name = cv->c_l_name;
+    out_c_f_name = cv->c_f_name;
+
+    std::tie(success, result, std::ignore, value) = db.tbl_brokers().select_row(broker_key(b_id));
+    TXN_DO(success);
+    assert(result);
+    out_b_name = reinterpret_cast<const broker_row *>(value)->b_name;
+
+    // commit txn
+    // retry until commits
+    } RETRY(true);
+
+    return nexecs - 1;
+}
+
+template <typename DBParams>
+size_t tpce_runner<DBParams>::run_txn_trade_update() {
+    typedef trade_row::NamedColumn t_nc;
+    typedef settlement_row::NamedColumn se_nc;
+
+    constexpr size_t max_trades = 20;
+
+    // frame 1 renames the executors of trades looked up by id, frame 2
+    // retypes the settlements of the trades of an account in a time range.
+    // Frame 3 looks trades up by security; it is left out and frame 2 runs
+    // in its place.
+    bool q_by_id = ig.percent(33);
+    std::set<int64_t> q_t_ids;
+    if (q_by_id) {
+        while (q_t_ids.size() < std::min<size_t>(max_trades, ig.scale().num_loaded_trades))
+            q_t_ids.insert(ig.gen_loaded_trade_id());
+    }
+    int64_t q_ca_id = ig.gen_account_id();
+    uint32_t q_start_dts = ig.gen_history_dts();
+    uint32_t q_end_dts = q_start_dts + 30 * constants::seconds_per_day;
+
+    std::vector<uintptr_t> t_rids;
+    size_t nexecs = 0;
+
+    // begin txn
+    TRANSACTION {
+
+    bool success, result;
+    uintptr_t row;
+    const void *value;
+
+    ++nexecs;
+
+    if (q_by_id) {
+        for (auto t_id : q_t_ids) {
+            std::tie(success, result, row, value) = db.tbl_trades().select_row(trade_key(t_id), {{t_nc::t_is_cash, false}, {t_nc::t_exec_name, true}});
+            TXN_DO(success);
+            assert(result);
+            trade_row *new_tv = Sto::tx_alloc(reinterpret_cast<const trade_row *>(value));
+
+            // toggle the " X " in the executor's name
+            std::string exec_name(new_tv->t_exec_name.c_str());
+            size_t pos = exec_name.find(" X ");
+            if (pos != std::string::npos)
+                exec_name.replace(pos, 3, " ");
+            else if ((pos = exec_name.find(' ')) != std::string::npos)
+                exec_name.replace(pos, 1, " X ");
+            new_tv->t_exec_name = exec_name;
+            TXN_DO(db.tbl_trades().update_row(row, new_tv));
+
+            TXN_DO(read_trade_details(t_id, new_tv->t_is_cash));
+        }
+    } else {
+        t_rids.clear();
+        auto t_scan_callback = [&] (const trade_account_idx_key&, const index_entry_row& entry) -> bool {
+            t_rids.push_back(entry.rid);
+            return true;
+        };
+
+        trade_account_idx_key tik0(q_ca_id, q_start_dts, 0);
+        trade_account_idx_key tik1(q_ca_id, q_end_dts, 0);
+
+        success = db.tbl_trade_account_index()
+                .template range_scan<decltype(t_scan_callback), false/*reverse*/>(tik0, tik1, t_scan_callback, RowAccess::ObserveExists, true, max_trades);
+        TXN_DO(success);
+
+        for (auto rid : t_rids) {
+            int64_t t_id = bswap(tpce_db<DBParams>::t_table_type::row_key(rid).t_id);
+            std::tie(success, result, std::ignore, value) = db.tbl_trades().select_row(rid, {{t_nc::t_is_cash, false}});
+            TXN_DO(success);
+            assert(result);
+            bool is_cash = reinterpret_cast<const trade_row *>(value)->t_is_cash;
+
+            std::tie(success, result, row, value) = db.tbl_settlements().select_row(settlement_key(t_id), {{se_nc::se_cash_type, true}});
+            TXN_DO(success);
+            assert(result);
+            settlement_row *new_sev = Sto::tx_alloc(reinterpret_cast<const settlement_row *>(value));
+
+            // toggle between the long and short names of the cash type
+            if (is_cash)
+                new_sev->se_cash_type = (new_sev->se_cash_type == "Cash Account") ? "Cash" : "Cash Account";
+            else
+                new_sev->se_cash_type = (new_sev->se_cash_type == "Margin Account") ? "Margin" : "Margin Account";
+            TXN_DO(db.tbl_settlements().update_row(row, new_sev));
+
+            TXN_DO(read_trade_details(t_id, is_cash));
+        }
+    }
+
+    // commit txn
+    // retry until commits
+    } RETRY(true);
+
+    return nexecs - 1;
+}
+
+}; // namespace tpce
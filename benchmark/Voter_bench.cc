@@ -160,6 +160,9 @@ int main(int argc, const char * const *argv) {
     if (ret_code != 0)
         return ret_code;
 
+    if (params.num_threads > TThread::max_threads())
+        TThread::set_max_threads(params.num_threads);
+
     auto cpu_freq = determine_cpu_freq();
     if (cpu_freq == 0.0)
         return 1;
@@ -170,21 +170,35 @@ public:
         std::cout << "Loading..." << std::endl;
         always_assert(!area_codes.empty());
         always_assert(area_codes.size() == area_code_state_map.size());
+        bench::load_report report;
 
+        typename db_type::contestant_tbl_type::bulk_loader contestants(db.tbl_contestant());
         for (int i = 0; i < constants::num_contestants; ++i) {
             contestant_key ck(i);
             contestant_row cr;
             cr.name = contestant_names[i];
-            db.tbl_contestant().nontrans_put(ck, cr);
+            contestants.add(ck, cr);
         }
-
-        for (size_t i = 0; i < area_codes.size(); ++i) {
+        contestants.finish();
+
+        // the area codes are listed by state
+        std::vector<size_t> order(area_codes.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
+        std::sort(order.begin(), order.end(), [] (size_t a, size_t b) {
+            return area_codes[a] < area_codes[b];
+        });
+        typename db_type::areacodestate_tbl_type::bulk_loader states(db.tbl_areacode_state());
+        for (size_t i : order) {
             area_code_state_key acs_k(area_codes[i]);
             area_code_state_row acs_r;
             acs_r.state = area_code_state_map[i];
-            db.tbl_areacode_state().nontrans_put(acs_k, acs_r);
+            states.add(acs_k, acs_r);
         }
+        states.finish();
+
         std::cout << "Loaded." << std::endl;
+        report.print(std::cout);
     }
 
 private:
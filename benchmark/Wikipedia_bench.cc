@@ -12,6 +12,7 @@ using db_params::db_params_id;
 using db_params::db_default_params;
 using db_params::db_adaptive_params;
 using db_params::db_tictoc_params;
+using db_params::db_mvcc_params;
 using db_params::db_2pl_params;
 using db_params::db_swiss_params;
 using db_params::db_opaque_params;
@@ -44,7 +45,7 @@ static inline void print_usage(const char *argv_0) {
     ss << "Usage of " << std::string(argv_0) << ":" << std::endl
        << "  --dbid=<STRING> (or -i<STRING>)" << std::endl
        << "    Specify the type of DB concurrency control used. Can be one of the followings:" << std::endl
-       << "      default, opaque, 2pl, adaptive, swiss, tictoc" << std::endl
+       << "      default, opaque, 2pl, adaptive, swiss, tictoc, mvcc" << std::endl
        << "  --nthreads=<NUM> (or -t<NUM>)" << std::endl
        << "    Specify the number of parallel worker threads (default 1)." << std::endl
        << "  --scaleusers=<NUM> (or -u<NUM>)" << std::endl
@@ -212,6 +213,9 @@ int main(int argc, const char * const *argv) {
     if (ret_code != 0)
         return ret_code;
 
+    if (params.num_threads > TThread::max_threads())
+        TThread::set_max_threads(params.num_threads);
+
     auto cpu_freq = determine_cpu_freq();
     if (cpu_freq == 0.0)
         return 1;
@@ -237,6 +241,9 @@ int main(int argc, const char * const *argv) {
         case db_params_id::TicToc:
             ret_code = bench_access<db_tictoc_params>::execute(params);
             break;
+        case db_params_id::MVCC:
+            ret_code = bench_access<db_mvcc_params>::execute(params);
+            break;
         default:
             std::cerr << "unknown db config parameter id" << std::endl;
             ret_code = 1;
@@ -552,6 +552,14 @@ private:
     void load_watchlist();
     void load_revision();
 
+    // the bulk loaders take rows in ascending key order
+    template <typename K, typename R>
+    static void sort_rows(std::vector<std::pair<K, R>>& rows) {
+        std::sort(rows.begin(), rows.end(), [] (const std::pair<K, R>& x, const std::pair<K, R>& y) {
+            return lcdf::Str(x.first).compare(lcdf::Str(y.first)) < 0;
+        });
+    }
+
     int num_users;
     int num_pages;
     wikipedia_db<DBParams>& db;
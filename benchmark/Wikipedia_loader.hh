@@ -8,6 +8,7 @@ namespace wikipedia {
 template <typename DBParams>
 void wikipedia_loader<DBParams>::load() {
     std::cout << "Loading database..." << std::endl;
+    bench::load_report report;
 
     wikipedia_loader::initialize_scratch_space((size_t)num_users, (size_t)num_pages);
     load_revision();
@@ -17,10 +18,12 @@ void wikipedia_loader<DBParams>::load() {
     wikipedia_loader::free_scratch_space();
 
     std::cout << "Loaded." << std::endl;
+    report.print(std::cout);
 }
 
 template <typename DBParams>
 void wikipedia_loader<DBParams>::load_useracct() {
+    typename wikipedia_db<DBParams>::user_tbl_type::bulk_loader users(db.tbl_useracct());
     for (int uid = 1; uid <= num_users; ++uid) {
         useracct_row u_r;
         u_r.user_name = ig.generate_user_name();
@@ -38,12 +41,14 @@ void wikipedia_loader<DBParams>::load_useracct() {
         u_r.user_registration = "null";
         u_r.user_editcount = user_revision_cnts[uid - 1];
 
-        db.tbl_useracct().nontrans_put(useracct_key(uid), u_r);
+        users.add(useracct_key(uid), u_r);
     }
 }
 
 template <typename DBParams>
 void wikipedia_loader<DBParams>::load_page() {
+    typename wikipedia_db<DBParams>::page_tbl_type::bulk_loader pages(db.tbl_page());
+    std::vector<std::pair<page_idx_key, page_idx_row>> page_idx_rows;
     for (int pid = 1; pid <= num_pages; ++pid) {
         int page_ns = ig.generate_page_namespace(pid);
         auto page_title = ig.generate_page_title(pid);
@@ -60,19 +65,28 @@ void wikipedia_loader<DBParams>::load_page() {
         pg_r.page_latest = page_last_rev_ids[pid - 1];
         pg_r.page_len = page_last_rev_lens[pid - 1];
 
-        db.tbl_page().nontrans_put(page_key(pid), pg_r);
+        pages.add(page_key(pid), pg_r);
 
         page_idx_row pi_r{};
         pi_r.page_id = pid;
-        db.idx_page().nontrans_put(page_idx_key(page_ns, page_title), pi_r);
+        page_idx_rows.emplace_back(page_idx_key(page_ns, page_title), pi_r);
     }
+
+    sort_rows(page_idx_rows);
+    typename wikipedia_db<DBParams>::page_idx_type::bulk_loader page_index(db.idx_page());
+    for (auto& r : page_idx_rows)
+        page_index.add(r.first, r.second);
 }
 
 template <typename DBParams>
 void wikipedia_loader<DBParams>::load_watchlist() {
+    typename wikipedia_db<DBParams>::wl_tbl_type::bulk_loader watches(db.tbl_watchlist());
     std::set<int> user_pages;
+    std::vector<std::pair<watchlist_key, watchlist_row>> wl_rows;
+    std::vector<std::pair<watchlist_idx_key, watchlist_idx_row>> wl_idx_rows;
     for (int uid = 1; uid <= num_users; ++uid) {
         user_pages.clear();
+        wl_rows.clear();
         auto num_watches = ig.generate_num_watches();
         for (int wid = 1; wid <= num_watches; ++wid) {
             int page_id;
@@ -96,15 +110,26 @@ void wikipedia_loader<DBParams>::load_watchlist() {
             watchlist_row wl_r;
             wl_r.wl_notificationtimestamp = "null";
 
-            db.tbl_watchlist().nontrans_put(wl_k, wl_r);
-            db.idx_watchlist().nontrans_put(wl_i_k, watchlist_idx_row());
+            wl_rows.emplace_back(wl_k, wl_r);
+            wl_idx_rows.emplace_back(wl_i_k, watchlist_idx_row());
         }
+
+        // a user's watches are keyed by page title
+        sort_rows(wl_rows);
+        for (auto& r : wl_rows)
+            watches.add(r.first, r.second);
     }
+
+    sort_rows(wl_idx_rows);
+    typename wikipedia_db<DBParams>::wl_idx_type::bulk_loader watch_index(db.idx_watchlist());
+    for (auto& r : wl_idx_rows)
+        watch_index.add(r.first, r.second);
 }
 
 template <typename DBParams>
 void wikipedia_loader<DBParams>::load_revision() {
-
+    typename wikipedia_db<DBParams>::text_tbl_type::bulk_loader texts(db.tbl_text());
+    typename wikipedia_db<DBParams>::rev_tbl_type::bulk_loader revisions(db.tbl_revision());
     for (int pid = 1; pid <= num_pages; ++pid) {
         auto num_revs = ig.generate_num_revisions();
         auto old_text = ig.generate_random_old_text();
@@ -128,7 +153,7 @@ void wikipedia_loader<DBParams>::load_revision() {
             memcpy(t_r.old_text, old_text.c_str(), old_text_len + 1);
             t_r.old_flags = "utf-8";
             t_r.old_page = pid;
-            db.tbl_text().nontrans_put(t_k, t_r);
+            texts.add(t_k, t_r);
 
             revision_key r_k(tr_id);
             revision_row r_r;
@@ -143,7 +168,7 @@ void wikipedia_loader<DBParams>::load_revision() {
             r_r.rev_len = (int)old_text_len;
             r_r.rev_parent_id = 0;
 
-            db.tbl_revision().nontrans_put(r_k, r_r);
+            revisions.add(r_k, r_r);
 
             page_last_rev_ids[pid - 1] = tr_id;
             page_last_rev_lens[pid - 1] = tr_id;
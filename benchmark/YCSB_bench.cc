@@ -13,7 +13,7 @@ using namespace db_params;
 using bench::db_profiler;
 
 enum {
-    opt_dbid = 1, opt_nthrs, opt_mode, opt_time, opt_perf, opt_pfcnt
+    opt_dbid = 1, opt_nthrs, opt_mode, opt_time, opt_perf, opt_pfcnt, opt_log, opt_nlog, opt_cm
 };
 
 static const Clp_Option options[] = {
@@ -22,7 +22,10 @@ static const Clp_Option options[] = {
     { "mode",         'm', opt_mode,  Clp_ValInt,    Clp_Optional },
     { "time",         'l', opt_time,  Clp_ValDouble, Clp_Optional },
     { "perf",         'p', opt_perf,  Clp_NoVal,     Clp_Optional },
-    { "perf-counter", 'c', opt_pfcnt, Clp_NoVal,     Clp_Negate| Clp_Optional }
+    { "perf-counter", 'c', opt_pfcnt, Clp_NoVal,     Clp_Negate| Clp_Optional },
+    { "log",          'g', opt_log,   Clp_ValString, Clp_Negate| Clp_Optional },
+    { "log-threads",  'G', opt_nlog,  Clp_ValInt,    Clp_Optional },
+    { "cm",           'C', opt_cm,    Clp_ValString, Clp_Optional }
 };
 
 void print_usage(const char *prog_name) {
@@ -35,8 +38,11 @@ void ycsb_prepopulation_thread(int thread_id, ycsb_db<DBParams>& db, uint64_t ke
     set_affinity(thread_id);
     ycsb_input_generator<DBParams> ig(thread_id);
     db.table_thread_init();
+    typename ycsb_db<DBParams>::ycsb_table_type::bulk_loader loader(db.ycsb_table());
     for (uint64_t i = key_begin; i < key_end; ++i) {
-        db.ycsb_table().nontrans_put(ycsb_key(i), ig.random_ycsb_value());
+        auto v = ig.random_ycsb_value();
+        v.set_row_key(i);
+        loader.add(ycsb_key(i), v);
     }
 }
 
@@ -127,6 +133,9 @@ public:
 
         bool spawn_perf = false;
         bool counter_mode = false;
+        bool enable_log = false;
+        std::string log_dir = ".";
+        int num_loggers = 1;
         int num_threads = 1;
         int mode = static_cast<int>(mode_id::ReadOnly);
         double time_limit = 10.0;
@@ -138,6 +147,7 @@ public:
         while (!clp_stop && ((opt = Clp_Next(clp)) != Clp_Done)) {
             switch (opt) {
                 case opt_dbid:
+                case opt_cm:
                     break;
                 case opt_nthrs:
                     num_threads = clp->val.i;
@@ -154,6 +164,14 @@ public:
                 case opt_pfcnt:
                     counter_mode = !clp->negated;
                     break;
+                case opt_log:
+                    enable_log = !clp->negated;
+                    if (clp->have_val)
+                        log_dir = clp->val.s;
+                    break;
+                case opt_nlog:
+                    num_loggers = clp->val.i;
+                    break;
                 default:
                     print_usage(argv[0]);
                     ret = 1;
@@ -166,6 +184,9 @@ public:
         if (ret != 0)
             return ret;
 
+        if (num_threads > TThread::max_threads())
+            TThread::set_max_threads(num_threads);
+
         auto profiler_mode = counter_mode ?
                              Profiler::perf_mode::counters : Profiler::perf_mode::record;
 
@@ -183,8 +204,10 @@ public:
         ycsb_db<DBParams> db;
 
         std::cout << "Prepopulating database..." << std::endl;
+        bench::load_report load;
         db.prepopulate();
         std::cout << "Prepopulation complete." << std::endl;
+        load.print(std::cout);
 
         std::vector<ycsb_runner<DBParams>> runners;
         for (int i = 0; i < num_threads; ++i) {
@@ -195,10 +218,30 @@ public:
         workload_generation(runners, mode);
         std::cout << "Done." << std::endl;
 
+        pthread_t advancer;
+        if (enable_log) {
+            std::cout << "Info: Redo logging to " << log_dir << " with "
+                      << num_loggers << " logger thread(s)" << std::endl;
+            Logger::start(log_dir, num_loggers);
+        }
+        // MVCC snapshots and history trimming follow the global epoch
+        bool run_advancer = enable_log || DBParams::MVCC;
+        if (run_advancer)
+            pthread_create(&advancer, nullptr, Transaction::epoch_advancer, nullptr);
+
         prof.start(profiler_mode);
         auto num_trans = run_benchmark(db, prof, runners, time_limit);
         prof.finish(num_trans);
 
+        if (run_advancer) {
+            Transaction::global_epochs.run = false;
+            pthread_join(advancer, nullptr);
+        }
+        if (enable_log) {
+            Logger::stop();
+            Logger::print_stats();
+        }
+
         return 0;
     }
 
@@ -213,6 +256,7 @@ double constants::processor_tsc_frequency;
 
 int main(int argc, const char *const *argv) {
     db_params_id dbid = db_params_id::Default;
+    ContentionManager::policy_type cm_policy = ContentionManager::policy_type::timestamp;
     int ret_code = 0;
 
     Clp_Parser *clp = Clp_NewParser(argc, argv, arraysize(options), options);
@@ -231,6 +275,15 @@ int main(int argc, const char *const *argv) {
                 clp_stop = true;
             }
             break;
+        case opt_cm:
+            if (!ContentionManager::parse_policy(clp->val.s, cm_policy)) {
+                std::cout << "Unsupported contention manager: "
+                    << ((clp->val.s == nullptr) ? "" : std::string(clp->val.s)) << std::endl;
+                print_usage(argv[0]);
+                ret_code = 1;
+                clp_stop = true;
+            }
+            break;
         default:
             break;
         }
@@ -239,6 +292,7 @@ int main(int argc, const char *const *argv) {
     Clp_DeleteParser(clp);
     if (ret_code != 0)
         return ret_code;
+    ContentionManager::set_policy(cm_policy);
 
     auto cpu_freq = determine_cpu_freq();
     if (cpu_freq == 0.0)
@@ -265,6 +319,9 @@ int main(int argc, const char *const *argv) {
     case db_params_id::TicToc:
         ret_code = ycsb_access<db_tictoc_params>::execute(argc, argv);
         break;
+    case db_params_id::MVCC:
+        ret_code = ycsb_access<db_mvcc_params>::execute(argc, argv);
+        break;
     default:
         std::cerr << "unknown db config parameter id" << std::endl;
         ret_code = 1;
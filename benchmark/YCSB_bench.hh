@@ -28,7 +28,9 @@ public:
 
     typedef UIndex<ycsb_key, ycsb_value<DBParams>> ycsb_table_type;
 
-    explicit ycsb_db() : ycsb_table_(ycsb_table_size) {}
+    explicit ycsb_db() : ycsb_table_(ycsb_table_size / (ycsb_table_type::bucket_slots - 1)) {
+        ycsb_value<DBParams>::log_id = ycsb_table_.log_id();
+    }
 
     ycsb_table_type& ycsb_table() {
         return ycsb_table_;
@@ -102,6 +104,10 @@ private:
     sampling::StoRandomDistribution<> *dd;
 
     uint32_t write_threshold;
+
+    // run_txn's keys and the rows they find
+    std::vector<ycsb_key> keys_;
+    std::vector<ycsb_value<DBParams> *> values_;
 };
 
 }; // namespace ycsb
@@ -11,6 +11,8 @@
 namespace ycsb {
 
 using bench::fix_string;
+using bench::get_mvcc_history;
+using bench::mvcc_read_latest;
 using bench::get_version;
 using bench::version_adapter;
 
@@ -49,13 +51,21 @@ public:
     static constexpr size_t num_cols = 10;
     typedef fix_string<col_width> col_type;
     typedef typename get_version<DBParams>::type version_type;
+    typedef typename get_mvcc_history<col_type, DBParams>::type history_type;
 
-    ycsb_value() : cols(), v0(Sto::initialized_tid(), false)
+    ycsb_value() : cols(), row_key(), v0(Sto::initialized_tid(), false)
 #if TABLE_FINE_GRAINED
                    , v1(Sto::initialized_tid(), false)
 #endif
     {}
 
+    // log id of the table holding the rows, used for redo logging
+    static uint32_t log_id;
+
+    void set_row_key(uint64_t key) {
+        row_key = key;
+    }
+
     col_type& col_access(int col_n) {
         return cols[col_n];
     }
@@ -82,12 +92,23 @@ public:
     // return: success, column
     std::pair<bool, const col_type *> trans_col_read(int col_n) {
         always_assert((size_t)col_n < num_cols, "column index out of bound");
+        if (DBParams::MVCC && Sto::transaction()->readonly_snapshot()) {
+#if TABLE_FINE_GRAINED
+            return {true, snapshot_col(col_n, (col_n % 2 == 0) ? v0 : v1, (col_n % 2 == 0) ? h0 : h1)};
+#else
+            return {true, snapshot_col(col_n, v0, h0)};
+#endif
+        }
 #if TABLE_FINE_GRAINED
         auto item = Sto::item(this, col_n);
+        if (DBParams::MVCC && !item.has_write())
+            return latest_col_read(item, col_n, (col_n % 2 == 0) ? v0 : v1);
         if (!item.observe((col_n % 2 == 0) ? v0 : v1))
             return {false, nullptr};
 #else
         auto item = Sto::item(this, col_n);
+        if (DBParams::MVCC && !item.has_write())
+            return latest_col_read(item, col_n, v0);
         if (!item.observe(v0))
             return {false, nullptr};
 #endif
@@ -105,6 +126,8 @@ public:
     }
 
     bool check(TransItem& item, Transaction& txn) override {
+        if (DBParams::MVCC && txn.read_only_at_snapshot())
+            return true;
 #if TABLE_FINE_GRAINED
         version_type& v = (item.key<int>()%2 == 0) ? v0 : v1;
 #else
@@ -116,10 +139,14 @@ public:
     void install(TransItem& item, Transaction& txn) override {
 #if TABLE_FINE_GRAINED
         version_type& v = (item.key<int>()%2 == 0) ? v0 : v1;
+        history_type& h = (item.key<int>()%2 == 0) ? h0 : h1;
 #else
         version_type& v = v0;
+        history_type& h = h0;
 #endif
         auto new_col = item.write_value<col_type *>();
+        if (DBParams::MVCC)
+            h.push(item.key<int>(), cols[item.key<int>()], v.value(), txn.commit_tid());
         cols[item.key<int>()] = *new_col;
         txn.set_version_unlock(v, item);
     }
@@ -133,14 +160,58 @@ public:
         v.cp_unlock(item);
     }
 
+    void log_redo(TransItem& item, TLogRecord& rec) override {
+        rec.put_cell(log_id, item.key<int>(), row_key, *item.write_value<col_type *>());
+    }
+
 private:
     col_type cols[num_cols];
+    uint64_t row_key;
+    friend struct bench::row_codec<ycsb_value<DBParams>>;
     version_type v0;
+    history_type h0;
 #if TABLE_FINE_GRAINED
     version_type v1;
+    history_type h1;
 #endif
+
+    // MVCC read of a column at the snapshot of a read-only snapshot
+    // transaction; a column overwritten since the snapshot is read from the
+    // history
+    const col_type *snapshot_col(int col_n, version_type& v, const history_type& h) {
+        auto snapshot = Sto::transaction()->snapshot_tid();
+        while (true) {
+            auto vv = v.value();
+            if (TransactionTid::is_locked(vv)) {
+                relax_fence();
+                continue;
+            }
+            acquire_fence();
+            auto n = h.find(col_n, snapshot);
+            if (n)
+                return &n->value;
+            col_type *col = Sto::tx_alloc(&cols[col_n]);
+            acquire_fence();
+            if (v.value() != vv)
+                continue;
+            return col;
+        }
+    }
+
+    std::pair<bool, const col_type *>
+    latest_col_read(TransProxy& item, int col_n, version_type& v) {
+        TransactionTid::type seen;
+        const col_type *col = mvcc_read_latest(v, cols[col_n], false, 0, seen);
+        TMvccVersion seen_version(seen);
+        if (!item.observe(seen_version))
+            return {false, nullptr};
+        return {true, col};
+    }
 };
 
+template <typename DBParams>
+uint32_t ycsb_value<DBParams>::log_id;
+
 template <typename DBParams>
 class ycsb_input_generator {
 public:
@@ -188,6 +259,33 @@ private:
 
 }; // namespace ycsb
 
+namespace bench {
+
+// only the columns and the row key of a ycsb_value are persisted; the
+// versions and the vtable pointer are not
+template <typename DBParams>
+struct row_codec<ycsb::ycsb_value<DBParams>> {
+    typedef ycsb::ycsb_value<DBParams> value_type;
+    typedef typename value_type::col_type col_type;
+    static constexpr uint32_t size = sizeof(uint64_t) + sizeof(col_type) * value_type::num_cols;
+
+    static void encode(const value_type& value, char *buf) {
+        memcpy(buf, &value.row_key, sizeof(uint64_t));
+        memcpy(buf + sizeof(uint64_t), value.cols, sizeof(value.cols));
+    }
+    static void decode(const char *buf, value_type& value) {
+        memcpy(&value.row_key, buf, sizeof(uint64_t));
+        memcpy(value.cols, buf + sizeof(uint64_t), sizeof(value.cols));
+    }
+    static void decode_cell(const char *buf, uint32_t len, int cell, value_type& value) {
+        always_assert(len == sizeof(col_type) && size_t(cell) < value_type::num_cols,
+                      "replay: bad ycsb column");
+        memcpy(&value.cols[cell], buf, len);
+    }
+};
+
+}; // namespace bench
+
 namespace std {
 
 template <>
@@ -1,6 +1,7 @@
 #pragma once
 
 
+#include <algorithm>
 #include <set>
 #include "YCSB_bench.hh"
 
@@ -32,22 +33,29 @@ void ycsb_runner<DBParams>::gen_workload(int txn_size) {
 
 template <typename DBParams>
 void ycsb_runner<DBParams>::run_txn(const ycsb_txn_t& txn) {
-    TRANSACTION {
+    // read-only transactions read an untracked snapshot
+    bool snapshot = DBParams::MVCC
+        && std::none_of(txn.begin(), txn.end(), [] (const ycsb_op_t& op) { return op.is_write; });
+
+    // rows are never removed, so they are looked up once, together
+    keys_.clear();
+    for (auto& op : txn)
+        keys_.emplace_back(op.key);
+    values_.resize(txn.size());
+    db.ycsb_table().nontrans_get(keys_.data(), int(keys_.size()), values_.data());
+
+    TRANSACTION_SNAPSHOT_IF(snapshot) {
         bool success;
-        for (auto& op : txn) {
+        for (size_t i = 0; i != txn.size(); ++i) {
+            auto& op = txn[i];
+            auto value = values_[i];
+            assert(value);
             if (op.is_write) {
-                ycsb_key key(op.key);
-                auto value = db.ycsb_table().nontrans_get(key);
-                assert(value);
-
                 auto new_col = Sto::tx_alloc<typename ycsb_value<DBParams>::col_type>();
                 ig.random_ycsb_col_value_inplace(new_col);
                 success = value->trans_col_update(op.col_n, *new_col);
                 TXN_DO(success);
             } else {
-                auto value = db.ycsb_table().nontrans_get(ycsb_key(op.key));
-                assert(value);
-
                 std::tie(success, std::ignore) = value->trans_col_read(op.col_n);
                 TXN_DO(success);
             }
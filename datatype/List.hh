@@ -491,14 +491,18 @@ private:
   }
 
 #ifndef STO_NO_STM
-    bool lock(TransItem& item, Transaction&) override {
+    bool lock(TransItem& item, Transaction& t) override {
       list_node *n = item.key<list_node*>();
       if (n == list_key) {
-        return listversion_.try_lock();
+        if (!listversion_.try_lock())
+          return false;
+        t.commit_after(listversion_.value());
       } else if (!has_insert(item)) {
         // we only lock non-inserts (removes, updates) so as to make our 
 	// life harder (also it's not necessary for inserts).
-        return n->try_lock();
+        if (!n->try_lock())
+          return false;
+        t.commit_after(n->version().value());
       }
       return true;
     }
@@ -4,7 +4,7 @@
 #include "TArrayProxy.hh"
 
 template <typename T, unsigned N, template <typename> class W = TOpaqueWrapped>
-class TArray : public TObject {
+class TArray : public TObjectBatched<TArray<T, N, W>> {
 public:
     class iterator;
     class const_iterator;
@@ -92,6 +92,9 @@ public:
     bool check(TransItem& item, Transaction& txn) override {
         return data_[item.key<size_type>()].vers.cp_check_version(txn, item);
     }
+    void prefetch(const TransItem& item) const override {
+        ::prefetch(&data_[item.key<size_type>()].vers);
+    }
     void install(TransItem& item, Transaction& txn) override {
         size_type i = item.key<size_type>();
         data_[i].v.write(item.write_value<T>());
@@ -3,7 +3,7 @@
 #include "Sto.hh"
 
 template <typename T, typename W = TOpaqueWrapped<T> >
-class TBox : public TObject {
+class TBox : public TObjectBatched<TBox<T, W>> {
 public:
     typedef typename W::read_type read_type;
     typedef typename W::version_type version_type;
@@ -388,9 +388,10 @@ public:
     return vector_item().add_read(ver);
   }
   
-  bool lock(TransItem& item, Transaction&) override {
+  bool lock(TransItem& item, Transaction& t) override {
     if (item.key<int>() == vector_key) {
       lock_version(vecversion_); // TODO: no need to lock vecversion_ if trans_size_offs() is 0
+      t.commit_after(vecversion_);
     } else if (item.key<int>() != push_back_key) {
       lock(item.key<key_type>());
     }
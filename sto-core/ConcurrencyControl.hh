@@ -10,6 +10,7 @@
 class VersionDelegate {
     friend class TVersion;
     friend class TNonopaqueVersion;
+    friend class TMvccVersion;
     friend class TCommutativeVersion;
     template <bool Adaptive>
     friend class TLockVersion;
@@ -36,6 +37,9 @@ class VersionDelegate {
     static void txn_set_any_nonopaque(Transaction& txn, bool val) {
         txn.any_nonopaque_ = val;
     }
+    static void txn_set_any_opaque_writes(Transaction& txn, bool val) {
+        txn.any_opaque_writes_ = val;
+    }
 
     static TransactionTid::type& standard_tid(Transaction& txn) {
         return txn.commit_tid_;
@@ -111,6 +115,14 @@ inline bool BasicVersion<VersImpl>::acquire_write_impl(TransItem& item, Args&&..
 
 // STO opaque optimistic concurrency control
 
+inline bool TVersion::cp_try_lock_impl(TransItem& item, int threadid) {
+    if (!BasicVersion<TVersion>::cp_try_lock_impl(item, threadid))
+        return false;
+    // opaque readers order this commit by the opacity clock
+    VersionDelegate::txn_set_any_opaque_writes(t(), true);
+    return true;
+}
+
 inline bool TVersion::observe_read_impl(TransItem &item, bool add_read){
     assert(!item.has_stash());
     TVersion version = *this;
@@ -156,6 +168,25 @@ inline bool TNonopaqueVersion::observe_read_impl(TransItem& item, bool add_read)
 }
 
 
+// STO multi-version optimistic concurrency control (latest-version reads)
+
+inline bool TMvccVersion::observe_read_impl(TransItem& item, bool add_read) {
+    assert(!item.has_stash());
+    TMvccVersion version = *this;
+    fence();
+    if (version.is_locked_elsewhere()) {
+        t().mark_abort_because(&item, "locked", version.value());
+        TXP_INCREMENT(txp_observe_lock_aborts);
+        return false;
+    }
+    if (add_read && !item.has_read()) {
+        VersionDelegate::item_or_flags(item, TransItem::read_bit);
+        VersionDelegate::item_access_rdata(item).v = Packer<TMvccVersion>::pack(t().buf_, std::move(version));
+        VersionDelegate::txn_set_any_nonopaque(t(), true);
+    }
+    return true;
+}
+
 // Adaptive Reader/Writer lock concurrency control
 
 template <bool Adaptive>
@@ -218,6 +249,7 @@ inline bool TLockVersion<Adaptive>::lock_for_write(TransItem& item) {
         }
         VersionDelegate::item_or_flags(item, TransItem::lock_bit);
     }
+    t().commit_after(BV::value());
     return true;
     // Invariant: after this function returns, item::lock_bit is set and the
     // write lock is held on the corresponding TVersion
@@ -351,6 +383,9 @@ inline bool TSwissVersion<Opaque>::acquire_write_impl(TransItem& item) {
 
         relax_fence();
     }
+    t().commit_after(BV::value());
+    if (Opaque)
+        VersionDelegate::txn_set_any_opaque_writes(t(), true);
 
     VersionDelegate::item_or_flags(item, TransItem::write_bit | TransItem::lock_bit);
     VersionDelegate::txn_set_any_writes(t(), true);
@@ -395,6 +430,9 @@ inline bool TSwissVersion<Opaque>::acquire_write_impl(TransItem& item, Args&&...
 
         relax_fence();
     }
+    t().commit_after(BV::value());
+    if (Opaque)
+        VersionDelegate::txn_set_any_opaque_writes(t(), true);
 
     VersionDelegate::item_or_flags(item, TransItem::write_bit | TransItem::lock_bit);
     VersionDelegate::item_access_wdata(item) = Packer<T>::pack(t().buf_, std::forward<Args>(args)...);
@@ -623,6 +661,13 @@ TNonopaqueVersion::type TNonopaqueVersion::cp_commit_tid_impl(Transaction &txn)
         return TransactionTid::next_unflagged_nonopaque_version(value());
 }
 
+TMvccVersion::type& TMvccVersion::cp_access_tid_impl(Transaction &txn) {
+    return VersionDelegate::standard_tid(txn);
+}
+TMvccVersion::type TMvccVersion::cp_commit_tid_impl(Transaction &txn) {
+    return txn.commit_tid();
+}
+
 TCommutativeVersion::type& TCommutativeVersion::cp_access_tid_impl(Transaction &txn) {
     return VersionDelegate::standard_tid(txn);
 }
@@ -743,7 +788,7 @@ inline bool Transaction::try_lock(TransItem& item, VersionBase<VersImpl>& vers)
         if (std::is_base_of<TicTocBase<VersImpl>, VersImpl>::value) {
             vers.compute_commit_ts_step(this->tictoc_tid_, true/* write */);
         } else {
-            vers.compute_commit_ts_step(this->commit_tid_, true/* write */);
+            commit_after(vers.value());
         }
     }
     return locked;
@@ -1,81 +1,249 @@
 #include "ContentionManager.hh"
 #include "Transaction.hh"
 
+#include <cstring>
+
 // Contention Manager implementation
 
-bool ContentionManager::should_abort(int this_id, int owner_id) {
-    TXP_INCREMENT(txp_cm_shouldabort);
-    this_id *= 4;
-    acquire_fence();
-    if (aborted[this_id] == 1){
+typedef ContentionManager::thread_state cm_state;
+
+namespace {
+
+// Global timestamp (timestamp policy)
+uint64_t __attribute__((aligned(CACHE_LINE_SIZE))) global_ts = 0;
+
+// Policies implement should_abort(self, self_id, owner, owner_id),
+// on_write(self), start(self, restarted) and backoff(self). The state
+// shared by all policies (abort flags, counters) is maintained by
+// ContentionManager itself.
+
+inline void wound(cm_state& owner) {
+    //FIXME: this might abort a new transaction on that thread
+    owner.aborted = true;
+    release_fence();
+}
+
+// waits before the next attempt on the lock; true if we should give up
+inline bool wait_attempt(cm_state& self, uint64_t cycles, uint32_t max_attempts) {
+    if (++self.wait_attempts > max_attempts)
         return true;
+    wait_cycles(cycles);
+    return false;
+}
+
+inline bool older(const cm_state& a, int a_id, const cm_state& b, int b_id) {
+    return a.timestamp < b.timestamp || (a.timestamp == b.timestamp && a_id < b_id);
+}
+
+// randomized linear back off over the number of consecutive aborts
+inline void linear_backoff(cm_state& self) {
+    uint64_t cycles_to_wait = rand_r(&self.seed) % (self.abort_count * WAIT_CYCLES_MULTIPLICATOR);
+    wait_cycles(cycles_to_wait);
+}
+
+struct timestamp_policy {
+    static bool should_abort(cm_state& self, int, cm_state& owner, int) {
+        // This transaction is still in the timid phase
+        if (self.timestamp == MAX_TS)
+            return true;
+        if (owner.timestamp < self.timestamp) {
+            acquire_fence();
+            return !owner.aborted;
+        }
+        wound(owner);
+        return false;
+    }
+    static void on_write(cm_state& self) {
+        if (self.timestamp == MAX_TS && self.write_set_size == TS_THRESHOLD)
+            self.timestamp = fetch_and_add(&global_ts, uint64_t(1));
+    }
+    static void start(cm_state& self, bool) {
+        self.timestamp = MAX_TS;
+    }
+    static void backoff(cm_state& self) {
+        linear_backoff(self);
     }
+};
 
-    // This transaction is still in the timid phase
-    acquire_fence();
-    if (timestamp[this_id] == MAX_TS) {
+struct greedy_policy {
+    static bool should_abort(cm_state& self, int self_id, cm_state& owner, int owner_id) {
+        if (older(self, self_id, owner, owner_id) || owner.waiting)
+            wound(owner);
+        self.waiting = true;
+        return wait_attempt(self, CM_WAIT_CYCLES, CM_MAX_WAIT_ATTEMPTS);
+    }
+    static void on_write(cm_state& self) {
+        self.waiting = false;
+    }
+    static void start(cm_state& self, bool restarted) {
+        if (!restarted)
+            self.timestamp = read_tsc();
+    }
+    static void backoff(cm_state& self) {
+        linear_backoff(self);
+    }
+};
+
+struct karma_policy {
+    static bool should_abort(cm_state& self, int, cm_state& owner, int) {
+        if (self.karma + self.wait_attempts > owner.karma)
+            wound(owner);
+        return wait_attempt(self, CM_WAIT_CYCLES, CM_MAX_WAIT_ATTEMPTS);
+    }
+    static void on_write(cm_state&) {
+    }
+    static void start(cm_state&, bool) {
+    }
+    static void backoff(cm_state& self) {
+        linear_backoff(self);
+    }
+};
+
+struct polka_policy {
+    static constexpr uint32_t max_attempts = 16;
+
+    static bool should_abort(cm_state& self, int, cm_state& owner, int) {
+        if (self.karma + self.wait_attempts > owner.karma)
+            wound(owner);
+        uint64_t limit = uint64_t(CM_WAIT_CYCLES) << std::min(self.wait_attempts, uint32_t(10));
+        return wait_attempt(self, rand_r(&self.seed) % limit, max_attempts);
+    }
+    static void on_write(cm_state&) {
+    }
+    static void start(cm_state&, bool) {
+    }
+    static void backoff(cm_state& self) {
+        linear_backoff(self);
+    }
+};
+
+struct wound_wait_policy {
+    static bool should_abort(cm_state& self, int self_id, cm_state& owner, int owner_id) {
+        if (older(self, self_id, owner, owner_id))
+            wound(owner);
+        return wait_attempt(self, CM_WAIT_CYCLES, CM_MAX_WAIT_ATTEMPTS);
+    }
+    static void on_write(cm_state&) {
+    }
+    static void start(cm_state& self, bool restarted) {
+        if (!restarted)
+            self.timestamp = read_tsc();
+    }
+    static void backoff(cm_state& self) {
+        linear_backoff(self);
+    }
+};
+
+struct backoff_policy {
+    static bool should_abort(cm_state&, int, cm_state&, int) {
         return true;
     }
+    static void on_write(cm_state&) {
+    }
+    static void start(cm_state&, bool) {
+    }
+    // the window doubles with every consecutive abort, up to a limit that
+    // grows with the thread's abort rate
+    static void backoff(cm_state& self) {
+        uint32_t max_shift = 1 + (self.abort_rate * SUCC_ABORTS_MAX >> 10);
+        uint64_t limit = uint64_t(CM_WAIT_CYCLES) << std::min(self.abort_count, max_shift);
+        wait_cycles(rand_r(&self.seed) % limit);
+    }
+};
 
-    owner_id *= 4;
-    //if (write_set_size[threadid] < write_set_size[owner_threadid]) {
-    if (timestamp[owner_id] < timestamp[this_id]) {
-        acquire_fence();
-        return (aborted[owner_id] == 0);
-    } else {
-        //FIXME: this might abort a new transaction on that thread
-        aborted[owner_id] = 1;
-        release_fence();
-        return false;
+}
+
+// runs [result =] Policy::call for the selected policy
+#define CM_DISPATCH(result, call)                                            \
+    switch (policy_) {                                                       \
+    case policy_type::timestamp:  result timestamp_policy::call; break;      \
+    case policy_type::greedy:     result greedy_policy::call; break;         \
+    case policy_type::karma:      result karma_policy::call; break;          \
+    case policy_type::polka:      result polka_policy::call; break;          \
+    case policy_type::wound_wait: result wound_wait_policy::call; break;     \
+    case policy_type::backoff:    result backoff_policy::call; break;        \
     }
 
+bool ContentionManager::should_abort(int this_id, int owner_id) {
+    TXP_INCREMENT(txp_cm_shouldabort);
+    cm_state& self = state_[this_id];
+    cm_state& owner = state_[owner_id];
+    acquire_fence();
+    if (self.aborted)
+        return true;
+    bool abort = true;
+    CM_DISPATCH(abort =, should_abort(self, this_id, owner, owner_id));
+    return abort;
 }
 
 bool ContentionManager::on_write(int threadid) {
     TXP_INCREMENT(txp_cm_onwrite);
-    threadid *= 4;
-    if (aborted[threadid] == 1) {
-      return false;
-    }
-    write_set_size[threadid] += 1;
-    if (timestamp[threadid] == MAX_TS && write_set_size[threadid] == TS_THRESHOLD) {
-        timestamp[threadid] = fetch_and_add(&ts, uint64_t(1));
-        //timestamp[threadid] = 1;
-    }
+    cm_state& self = state_[threadid];
+    if (self.aborted)
+        return false;
+    ++self.write_set_size;
+    ++self.karma;
+    self.wait_attempts = 0;
+    CM_DISPATCH(, on_write(self));
     return true;
 }
 
 void ContentionManager::start(Transaction *tx) {
     TXP_INCREMENT(txp_cm_start);
-    int threadid = tx->threadid();
-    threadid *= 4;
-    if (tx->is_restarted()) {
-        // Do not reset abort count
-        timestamp[threadid] = MAX_TS;
-        aborted[threadid] = 0;
-        write_set_size[threadid] = 0;
-    } else {
-        timestamp[threadid] = MAX_TS;
-        aborted[threadid] = 0;
-        write_set_size[threadid] = 0;
-        abort_count[threadid] = 0;
+    cm_state& self = state_[tx->threadid()];
+    bool restarted = tx->is_restarted();
+    self.aborted = false;
+    self.waiting = false;
+    self.write_set_size = 0;
+    self.wait_attempts = 0;
+    if (!restarted) {
+        // the previous transaction committed (or gave up)
+        self.abort_count = 0;
+        self.karma = 0;
+        self.abort_rate -= self.abort_rate >> 4;
     }
+    CM_DISPATCH(, start(self, restarted));
 }
 
 void ContentionManager::on_rollback(int threadid) {
     TXP_INCREMENT(txp_cm_onrollback);
-    threadid *= 4;
-    if (abort_count[threadid] < SUCC_ABORTS_MAX)
-        ++abort_count[threadid];
-    uint64_t cycles_to_wait = rand_r((unsigned int*)&seed[threadid]) % (abort_count[threadid] * WAIT_CYCLES_MULTIPLICATOR);
-    wait_cycles(cycles_to_wait);
+    cm_state& self = state_[threadid];
+    if (self.abort_count < SUCC_ABORTS_MAX)
+        ++self.abort_count;
+    self.abort_rate += (1024 - self.abort_rate) >> 4;
+    CM_DISPATCH(, backoff(self));
+}
+
+#undef CM_DISPATCH
+
+const char* const ContentionManager::policy_names[] = {
+    "timestamp", "greedy", "karma", "polka", "wound_wait", "backoff"
+};
+
+bool ContentionManager::parse_policy(const char* name, policy_type& policy) {
+    for (int i = 0; i != npolicies; ++i)
+        if (name && strcmp(name, policy_names[i]) == 0) {
+            policy = static_cast<policy_type>(i);
+            return true;
+        }
+    return false;
+}
+
+namespace {
+// per-thread state until set_max_threads replaces it
+cm_state default_state[TThread::default_max_threads] = {};
+}
+
+void ContentionManager::set_max_threads(int n) {
+    void* mem = nullptr;
+    always_assert(posix_memalign(&mem, alignof(cm_state), n * sizeof(cm_state)) == 0,
+                  "cannot allocate contention manager state");
+    memset(mem, 0, n * sizeof(cm_state));
+    if (state_ != default_state)
+        free(state_);
+    state_ = static_cast<cm_state*>(mem);
 }
 
 // Defines and initializes the static fields
-uint64_t ContentionManager::ts = 0;
-uint128_t ContentionManager::aborted[4*MAX_THREADS] = { 0 };
-uint128_t ContentionManager::timestamp[4*MAX_THREADS] = { 0 };
-uint128_t ContentionManager::write_set_size[4*MAX_THREADS] = { 0 };
-uint128_t ContentionManager::abort_count[4*MAX_THREADS] = { 0 };
-uint128_t ContentionManager::version[4*MAX_THREADS] = { 0 };
-uint128_t ContentionManager::seed[4*MAX_THREADS];
+ContentionManager::policy_type ContentionManager::policy_ = ContentionManager::policy_type::timestamp;
+cm_state* ContentionManager::state_ = default_state;
@@ -8,32 +8,80 @@
 #define TS_THRESHOLD 10
 #define SUCC_ABORTS_MAX 10
 #define WAIT_CYCLES_MULTIPLICATOR 8000
-
-#define MAX_THREADS 128
-
-typedef __uint128_t uint128_t;
+// attempts a waiting transaction makes on one lock before aborting itself
+// (the owner may never get to see that it was wounded)
+#define CM_MAX_WAIT_ATTEMPTS 1024
+#define CM_WAIT_CYCLES 1000
 
 class Transaction;
 
+// Contention management for write-write conflicts on TSwissVersion locks,
+// and back off after aborts (for all concurrency control policies).
+//
+// should_abort(this_id, owner_id) is called while this_id spins on a lock
+// held by owner_id, and returns true if this_id should abort. A policy may
+// instead wound the owner, which then aborts at its next should_abort or
+// on_write. The policy is chosen at runtime with set_policy:
+//
+//   timestamp   timid until TS_THRESHOLD writes, then the older timestamp
+//               (from a global counter) wins
+//   greedy      the older transaction wins; a waiting owner is wounded
+//   karma       the transaction that has done more writes wins, counting
+//               its retries and the attempts made on the lock
+//   polka       karma with randomized exponential waits between attempts
+//   wound_wait  older transactions wound, younger ones wait
+//   backoff     abort on conflict; back off exponentially, scaled by the
+//               thread's recent abort rate
+//
+// Greedy and wound-wait timestamps are taken from the TSC when a
+// transaction first starts and kept across its retries.
 class ContentionManager {
 public:
+    enum class policy_type : int {
+        timestamp = 0, greedy, karma, polka, wound_wait, backoff
+    };
+    static const char* const policy_names[];
+    static constexpr int npolicies = 6;
+
+    // returns false if name is not a policy
+    static bool parse_policy(const char* name, policy_type& policy);
+    static void set_policy(policy_type policy) {
+        policy_ = policy;
+    }
+    static policy_type policy() {
+        return policy_;
+    }
+
     static bool should_abort(int this_id, int owner_id);
 
     static bool on_write(int threadid);
 
-    static void start(Transaction *tx); 
+    static void start(Transaction *tx);
 
     static void on_rollback(int threadid);
 
-public:
-    // Global timestamp
-    static uint64_t ts;
-
-    static uint128_t aborted[4*MAX_THREADS];
-    static uint128_t timestamp[4*MAX_THREADS];
-    static uint128_t write_set_size[4*MAX_THREADS];
-    static uint128_t abort_count[4*MAX_THREADS];
-    static uint128_t version[4*MAX_THREADS];
-    static uint128_t seed[4*MAX_THREADS];
-};
+    // resizes the per-thread state (see TThread::set_max_threads)
+    static void set_max_threads(int n);
 
+    struct __attribute__((aligned(CACHE_LINE_SIZE))) thread_state {
+        // set by a conflicting transaction that wounds this one
+        volatile bool aborted;
+        // set while waiting for a lock (greedy)
+        volatile bool waiting;
+        unsigned seed;
+        uint64_t timestamp;
+        // karma: writes by this transaction, including its aborted attempts
+        uint64_t karma;
+        uint32_t write_set_size;
+        // consecutive aborts, at most SUCC_ABORTS_MAX
+        uint32_t abort_count;
+        // attempts on the lock this transaction is waiting for
+        uint32_t wait_attempts;
+        // exponential moving average of aborts per start, in 1/1024ths
+        uint32_t abort_rate;
+    };
+
+private:
+    static policy_type policy_;
+    static thread_state* state_;
+};
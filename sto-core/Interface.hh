@@ -9,6 +9,7 @@
 
 class Transaction;
 class TransItem;
+class TLogRecord;
 
 class TObject {
 public:
@@ -26,7 +27,34 @@ public:
     virtual void cleanup(TransItem& item, bool committed) {
         (void) item, (void) committed;
     }
+    // prefetch what lock() or check() will read for item; called on
+    // batches of items ahead of those calls so their cache misses overlap
+    virtual void prefetch(const TransItem& item) const {
+        (void) item;
+    }
+    // redo logging: append the after-image of a written item to the commit
+    // record; called with the write set locked, right before install()
+    virtual void log_redo(TransItem& item, TLogRecord& rec) {
+        (void) item, (void) rec;
+    }
     virtual void print(std::ostream& w, const TransItem& item) const;
+
+    // Commit calls on a run of items whose owners all have this object's
+    // batch_type() (which is not null; see TObjectBatched). lock_items and
+    // check_items stop at the first item that fails and return it, or last.
+    virtual void prefetch_items(TransItem* const* first, TransItem* const* last) const;
+    virtual TransItem** lock_items(TransItem** first, TransItem** last, Transaction& txn);
+    virtual TransItem** check_items(TransItem** first, TransItem** last, Transaction& txn);
+    virtual void install_items(TransItem** first, TransItem** last, Transaction& txn);
+    virtual void cleanup_items(TransItem** first, TransItem** last, bool committed);
+
+    // objects with the same non-null batch type have the same dynamic type
+    const void* batch_type() const {
+        return batch_type_;
+    }
+
+protected:
+    const void* batch_type_ = nullptr;
 };
 
 typedef TObject Shared;
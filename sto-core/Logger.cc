@@ -0,0 +1,249 @@
+#include "Logger.hh"
+#include "Transaction.hh"
+
+#include <condition_variable>
+#include <mutex>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+bool Logger::enabled_ = false;
+unsigned Logger::log_id_gen_ = 0;
+std::function<void(Logger::epoch_type)> Logger::durable_callback;
+
+namespace {
+
+typedef Logger::epoch_type epoch_type;
+
+struct __attribute__((aligned(128))) thread_log {
+    unsigned lock;
+    TLogBuffer buf;
+
+    thread_log()
+        : lock(0) {
+    }
+
+    void acquire() {
+        while (lock || !bool_cmpxchg(&lock, 0, 1))
+            relax_fence();
+        acquire_fence();
+    }
+    void release() {
+        release_fence();
+        lock = 0;
+    }
+};
+
+struct logger_state {
+    int id;
+    int fd;
+    pthread_t thread;
+    epoch_type flushed_epoch;
+    TLogBuffer spare;
+    uint64_t bytes;
+    uint64_t flushes;
+};
+
+// one per thread id, sized when logging starts
+thread_log* tlogs = nullptr;
+int ntlogs = 0;
+std::vector<logger_state*> loggers;
+
+std::mutex lmutex;
+std::condition_variable wake_cv;
+std::condition_variable durable_cv;
+epoch_type wake_epoch = 0;
+volatile epoch_type persisted_epoch = 0;
+bool stopping = false;
+bool callback_installed = false;
+std::function<void(epoch_type)> chained_callback;
+
+uint64_t total_bytes = 0;
+uint64_t total_flushes = 0;
+int total_loggers = 0;
+
+void write_all(int fd, const char* data, size_t len) {
+    while (len) {
+        ssize_t r = ::write(fd, data, len);
+        always_assert(r > 0, "log write failed");
+        data += r;
+        len -= r;
+    }
+}
+
+void flush_logger(logger_state& ls, epoch_type g) {
+    int nloggers = loggers.size();
+    // Every thread's log must be locked at least once after the global epoch
+    // became g: a worker still committing in an earlier epoch holds its log
+    // lock from begin_commit to end_commit.
+    for (int i = ls.id; i < ntlogs; i += nloggers) {
+        thread_log& tl = tlogs[i];
+        tl.acquire();
+        ls.spare.swap(tl.buf);
+        tl.release();
+        if (!ls.spare.empty()) {
+            write_all(ls.fd, ls.spare.data(), ls.spare.size());
+            ls.bytes += ls.spare.size();
+            ls.spare.clear();
+        }
+    }
+
+    TLogRecordHeader marker;
+    marker.epoch = g - 1;
+    marker.tid = 0;
+    marker.nentries = 0;
+    marker.length = 0;
+    write_all(ls.fd, reinterpret_cast<const char*>(&marker), sizeof(marker));
+    fdatasync(ls.fd);
+    ls.bytes += sizeof(marker);
+    ++ls.flushes;
+
+    std::function<void(epoch_type)> cb;
+    epoch_type durable;
+    {
+        std::lock_guard<std::mutex> lk(lmutex);
+        ls.flushed_epoch = g - 1;
+        durable = ls.flushed_epoch;
+        for (auto l : loggers)
+            durable = std::min(durable, l->flushed_epoch);
+        if (durable <= persisted_epoch)
+            return;
+        persisted_epoch = durable;
+        cb = Logger::durable_callback;
+    }
+    durable_cv.notify_all();
+    if (cb)
+        cb(durable);
+}
+
+} // anonymous namespace
+
+void* Logger::logger_thread(void* arg) {
+    logger_state& ls = *reinterpret_cast<logger_state*>(arg);
+    while (true) {
+        epoch_type g;
+        bool stop;
+        {
+            std::unique_lock<std::mutex> lk(lmutex);
+            wake_cv.wait(lk, [&] {
+                return stopping || wake_epoch > ls.flushed_epoch + 1;
+            });
+            g = wake_epoch;
+            stop = stopping;
+        }
+        flush_logger(ls, g);
+        if (stop)
+            break;
+    }
+    return nullptr;
+}
+
+void Logger::start(const std::string& dir, int nloggers) {
+    always_assert(!enabled_, "logger already started");
+    always_assert(nloggers > 0 && nloggers <= TThread::max_threads(), "bad number of loggers");
+
+    if (ntlogs != TThread::max_threads()) {
+        for (int i = 0; i != ntlogs; ++i)
+            tlogs[i].~thread_log();
+        free(tlogs);
+        ntlogs = TThread::max_threads();
+        void* mem = nullptr;
+        always_assert(posix_memalign(&mem, alignof(thread_log), ntlogs * sizeof(thread_log)) == 0,
+                      "cannot allocate thread logs");
+        tlogs = static_cast<thread_log*>(mem);
+        for (int i = 0; i != ntlogs; ++i)
+            new (&tlogs[i]) thread_log;
+    }
+
+    stopping = false;
+    wake_epoch = Transaction::global_epochs.global_epoch;
+    persisted_epoch = wake_epoch - 1;
+    for (int i = 0; i < nloggers; ++i) {
+        auto ls = new logger_state();
+        std::string fname = dir + "/sto_log." + std::to_string(i);
+        ls->id = i;
+        ls->fd = ::open(fname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        always_assert(ls->fd >= 0, "cannot open log file");
+        ls->flushed_epoch = persisted_epoch;
+        ls->bytes = ls->flushes = 0;
+        loggers.push_back(ls);
+    }
+
+    if (!callback_installed) {
+        chained_callback = Transaction::epoch_advance_callback;
+        Transaction::epoch_advance_callback = [] (threadinfo_t::epoch_type g) {
+            if (chained_callback)
+                chained_callback(g);
+            {
+                std::lock_guard<std::mutex> lk(lmutex);
+                wake_epoch = g;
+            }
+            wake_cv.notify_all();
+        };
+        callback_installed = true;
+    }
+
+    enabled_ = true;
+    for (auto ls : loggers)
+        pthread_create(&ls->thread, nullptr, logger_thread, ls);
+}
+
+void Logger::stop() {
+    if (!enabled_)
+        return;
+    {
+        std::lock_guard<std::mutex> lk(lmutex);
+        // workers are done: everything up to the current epoch is buffered
+        wake_epoch = Transaction::global_epochs.global_epoch + 1;
+        stopping = true;
+    }
+    wake_cv.notify_all();
+    for (auto ls : loggers) {
+        pthread_join(ls->thread, nullptr);
+        ::close(ls->fd);
+        total_bytes += ls->bytes;
+        total_flushes += ls->flushes;
+        delete ls;
+    }
+    total_loggers = loggers.size();
+    loggers.clear();
+    {
+        std::lock_guard<std::mutex> lk(lmutex);
+        enabled_ = false;
+    }
+    durable_cv.notify_all();
+}
+
+Logger::epoch_type Logger::begin_commit(int threadid) {
+    tlogs[threadid].acquire();
+    return Transaction::global_epochs.global_epoch;
+}
+
+TLogBuffer& Logger::buffer(int threadid) {
+    return tlogs[threadid].buf;
+}
+
+void Logger::end_commit(int threadid) {
+    tlogs[threadid].release();
+}
+
+void Logger::abort_commit(int threadid) {
+    tlogs[threadid].release();
+}
+
+Logger::epoch_type Logger::durable_epoch() {
+    return persisted_epoch;
+}
+
+void Logger::wait_durable(epoch_type e) {
+    std::unique_lock<std::mutex> lk(lmutex);
+    durable_cv.wait(lk, [&] {
+        return !enabled_ || persisted_epoch >= e;
+    });
+}
+
+void Logger::print_stats() {
+    fprintf(stderr, "$ log: %llu bytes in %llu flushes by %d loggers, durable epoch %llu\n",
+            (unsigned long long) total_bytes, (unsigned long long) total_flushes,
+            total_loggers, (unsigned long long) persisted_epoch);
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "compiler.hh"
+#include "TRcu.hh"
+
+// Epoch-based group-commit redo logging.
+//
+// Committing transactions serialize the after-images of their writes into a
+// per-thread log buffer (see TObject::log_redo). Logger threads swap these
+// buffers out at epoch boundaries (driven by Transaction::epoch_advancer),
+// write them to per-logger files and fsync. Once every logger has persisted
+// epoch E, all transactions that committed in epochs <= E are durable.
+//
+// On-disk format (native byte order), a sequence of records:
+// |epoch 8|commit tid 8|nentries 4|payload length 4|entries...|
+// A record with nentries == 0 and tid == 0 is an epoch marker; it is written
+// right before each fsync and means the file contains every record of every
+// epoch <= marker epoch handled by this logger.
+// Each entry is:
+// |log id 4|type 2|cell 2|key length 4|value length 4|key|value|
+
+struct TLogRecordHeader {
+    uint64_t epoch;
+    uint64_t tid;
+    uint32_t nentries;
+    uint32_t length;
+};
+
+struct TLogEntryHeader {
+    enum : uint16_t { put_row = 0, put_cell = 1, remove = 2 };
+
+    uint32_t log_id;
+    uint16_t type;
+    uint16_t cell;
+    uint32_t key_length;
+    uint32_t value_length;
+};
+
+class TLogBuffer {
+public:
+    char* extend(size_t n) {
+        size_t off = buf_.size();
+        buf_.resize(off + n);
+        return buf_.data() + off;
+    }
+    char* at(size_t off) {
+        return buf_.data() + off;
+    }
+    const char* data() const {
+        return buf_.data();
+    }
+    size_t size() const {
+        return buf_.size();
+    }
+    bool empty() const {
+        return buf_.empty();
+    }
+    void clear() {
+        buf_.clear();
+    }
+    void truncate(size_t n) {
+        buf_.resize(n);
+    }
+    void swap(TLogBuffer& other) {
+        buf_.swap(other.buf_);
+    }
+
+private:
+    std::vector<char> buf_;
+};
+
+// Writer handed to TObject::log_redo for the duration of one commit.
+class TLogRecord {
+public:
+    TLogRecord(TLogBuffer& buf, uint64_t epoch, uint64_t tid)
+        : buf_(buf), hoff_(buf.size()) {
+        auto h = reinterpret_cast<TLogRecordHeader*>(buf_.extend(sizeof(TLogRecordHeader)));
+        h->epoch = epoch;
+        h->tid = tid;
+        h->nentries = 0;
+        h->length = 0;
+    }
+
+    void put_row(uint32_t log_id, const void* key, uint32_t klen,
+                 const void* value, uint32_t vlen) {
+        append(log_id, TLogEntryHeader::put_row, 0, key, klen, value, vlen);
+    }
+    void put_cell(uint32_t log_id, int cell, const void* key, uint32_t klen,
+                  const void* value, uint32_t vlen) {
+        append(log_id, TLogEntryHeader::put_cell, cell, key, klen, value, vlen);
+    }
+    void remove(uint32_t log_id, const void* key, uint32_t klen) {
+        append(log_id, TLogEntryHeader::remove, 0, key, klen, nullptr, 0);
+    }
+
+    template <typename K, typename V>
+    void put_row(uint32_t log_id, const K& key, const V& value) {
+        put_row(log_id, &key, sizeof(K), &value, sizeof(V));
+    }
+    template <typename K, typename V>
+    void put_cell(uint32_t log_id, int cell, const K& key, const V& value) {
+        put_cell(log_id, cell, &key, sizeof(K), &value, sizeof(V));
+    }
+    template <typename K>
+    void remove(uint32_t log_id, const K& key) {
+        remove(log_id, &key, sizeof(K));
+    }
+
+    uint32_t nentries() const {
+        return header()->nentries;
+    }
+    // drops the record if no object logged anything
+    void finish() {
+        if (!header()->nentries)
+            buf_.truncate(hoff_);
+    }
+
+private:
+    TLogBuffer& buf_;
+    size_t hoff_;
+
+    TLogRecordHeader* header() const {
+        return reinterpret_cast<TLogRecordHeader*>(buf_.at(hoff_));
+    }
+
+    void append(uint32_t log_id, uint16_t type, int cell, const void* key, uint32_t klen,
+                const void* value, uint32_t vlen) {
+        size_t n = sizeof(TLogEntryHeader) + klen + vlen;
+        char* p = buf_.extend(n);
+        auto eh = reinterpret_cast<TLogEntryHeader*>(p);
+        eh->log_id = log_id;
+        eh->type = type;
+        eh->cell = static_cast<uint16_t>(cell);
+        eh->key_length = klen;
+        eh->value_length = vlen;
+        memcpy(p + sizeof(TLogEntryHeader), key, klen);
+        if (vlen)
+            memcpy(p + sizeof(TLogEntryHeader) + klen, value, vlen);
+        TLogRecordHeader* h = header();
+        ++h->nentries;
+        h->length += n;
+    }
+};
+
+class Logger {
+public:
+    typedef TRcuSet::epoch_type epoch_type;
+
+    static bool enabled() {
+        return enabled_;
+    }
+
+    // returns a fresh id for a loggable object; ids are assigned in
+    // construction order so they are stable across runs of the same program
+    static uint32_t next_log_id() {
+        return fetch_and_add(&log_id_gen_, 1);
+    }
+
+    // starts nloggers logger threads writing to dir/sto_log.<n>
+    static void start(const std::string& dir, int nloggers);
+    // flushes everything buffered so far and stops the logger threads
+    static void stop();
+
+    // Commit protocol (called from Transaction::try_commit). begin_commit
+    // locks the thread's log and fixes the commit epoch; it must be called
+    // after the write set is locked and before read validation. The thread's
+    // log stays locked until end_commit or abort_commit.
+    static epoch_type begin_commit(int threadid);
+    static TLogBuffer& buffer(int threadid);
+    static void end_commit(int threadid);
+    static void abort_commit(int threadid);
+
+    static epoch_type durable_epoch();
+    // blocks until epoch e is durable (or logging is stopped)
+    static void wait_durable(epoch_type e);
+    // called by a logger thread every time the durable epoch advances
+    static std::function<void(epoch_type)> durable_callback;
+
+    static void print_stats();
+
+private:
+    static bool enabled_;
+    static unsigned log_id_gen_;
+
+    static void* logger_thread(void* arg);
+};
@@ -19,6 +19,8 @@ public:
         return check_version(item.read_value<TVersion>());
     }
 
+    inline bool cp_try_lock_impl(TransItem& item, int threadid);
+
     inline bool observe_read_impl(TransItem& item, bool add_read);
 
     inline type snapshot(const TransItem& item, const Transaction& txn);
@@ -55,6 +57,32 @@ public:
     inline type cp_commit_tid_impl(Transaction& txn);
 };
 
+// STO OCC version for multi-versioned records (no opacity). Reads that go
+// through the latest version are validated at commit like nonopaque reads;
+// snapshot reads served from older versions are recorded separately by the
+// data structure (see DB_mvcc.hh).
+class TMvccVersion : public BasicVersion<TMvccVersion> {
+public:
+    TMvccVersion() = default;
+    explicit TMvccVersion(type v)
+            : BasicVersion(v) {}
+    TMvccVersion(type v, bool insert)
+            : BasicVersion(v) {(void)insert;}
+
+    bool cp_check_version_impl(Transaction& txn, TransItem& item) {
+        (void)txn;
+        assert(item.has_read());
+        if (TransactionTid::is_locked(v_) && !item.has_write())
+            return false;
+        return check_version(item.read_value<TMvccVersion>());
+    }
+
+    inline bool observe_read_impl(TransItem& item, bool add_read);
+
+    static inline type& cp_access_tid_impl(Transaction& txn);
+    inline type cp_commit_tid_impl(Transaction& txn);
+};
+
 // XXX not sure if it's really used anywhere
 class TCommutativeVersion : BasicVersion<TCommutativeVersion> {
 public:
@@ -25,17 +25,42 @@ class TThread {
     static __thread int the_id;
     static __thread bool always_allocate_;
     static __thread int hashsize_;
+    static int max_threads_;
 public:
+    // Thread ids are stored in the lock bits of version words (see
+    // TransactionTid::threadid_mask), which bounds the number of threads.
+    static constexpr int id_bits = 10;
+    static constexpr int max_threads_limit = 1 << id_bits;
+    static constexpr int default_max_threads = 128;
+
     static __thread Transaction* txn;
-    static PercentGen gen[];
+    static PercentGen* gen;
 
     static int id() {
         return the_id;
     }
     static void set_id(int id) {
-        assert(id >= 0 && id < 128);
+        assert(id >= 0 && id < max_threads_);
         the_id = id;
     }
+
+    // Number of usable thread ids. Per-thread state (Transaction::tinfo,
+    // ContentionManager, TThread::gen, redo log buffers) has one slot per id.
+    static int max_threads() {
+        return max_threads_;
+    }
+    // Resizes per-thread state to n ids, discarding its contents. Must be
+    // called at startup, before any thread runs transactions or logging
+    // starts.
+    static void set_max_threads(int n);
+
+    // Claims the lowest unused id in [0, max_threads()) and makes it this
+    // thread's id. Ids assigned with set_id are not tracked; don't mix the
+    // two on overlapping ranges.
+    static int register_thread();
+    // Releases this thread's id for reuse; the thread must not be inside a
+    // transaction. Its RCU garbage is reclaimed by the next owner of the id.
+    static void unregister_thread();
     static bool always_allocate() {
         return always_allocate_;
     }
@@ -93,10 +93,10 @@ public:
     // TTid bits: compatibility bits as defined in TransactionTid
 
     // |-----WTS value-----|-delta-|--TTid bits--|
-    //        44 bits       8 bits    12 bits
+    //        41 bits       8 bits    15 bits
 
-    static constexpr type delta_shift = type(12);
-    static constexpr type wts_shift = type(20);
+    static constexpr type delta_shift = type(TransactionTid::mask_width + 5);
+    static constexpr type wts_shift = delta_shift + 8;
     static constexpr type delta_mask = type(0xff) << delta_shift;
 
     static type wts_value(type t) {
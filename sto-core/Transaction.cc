@@ -1,33 +1,94 @@
 #include "Sto.hh"
+#include "Logger.hh"
 #include <typeinfo>
 #include <bitset>
 #include <fstream>
+#include <mutex>
 
 #include <sys/resource.h>
 #include <sys/time.h>
 
+namespace {
+// per-thread state until TThread::set_max_threads replaces it
+threadinfo_t default_tinfo[TThread::default_max_threads];
+PercentGen default_gen[TThread::default_max_threads];
+
+std::mutex thread_ids_lock;
+std::vector<bool> thread_ids_used;
+}
+
 Transaction::testing_type Transaction::testing;
-threadinfo_t Transaction::tinfo[MAX_THREADS];
+threadinfo_t* Transaction::tinfo = default_tinfo;
 __thread int TThread::the_id;
-PercentGen TThread::gen[MAX_THREADS];
+int TThread::max_threads_ = TThread::default_max_threads;
+PercentGen* TThread::gen = default_gen;
 
+// prepopulated records carry initialized_tid, which precedes every epoch
 Transaction::epoch_state __attribute__((aligned(128))) Transaction::global_epochs = {
-    1, 0, TransactionTid::increment_value, true
+    1, 0, TransactionTid::epoch_tid(1), TransactionTid::epoch_tid(1), true
 };
 __thread Transaction *TThread::txn = nullptr;
 std::function<void(threadinfo_t::epoch_type)> Transaction::epoch_advance_callback;
-TransactionTid::type __attribute__((aligned(128))) Transaction::_TID = 2 * TransactionTid::increment_value;
-   // reserve TransactionTid::increment_value for prepopulated
 
 static void __attribute__((used)) check_static_assertions() {
     static_assert(sizeof(threadinfo_t) % 128 == 0, "threadinfo is 2-cache-line aligned");
 }
 
+void TThread::set_max_threads(int n) {
+    always_assert(n > 0 && n <= max_threads_limit, "too many threads for the version lock bits");
+    always_assert(!Logger::enabled(), "set_max_threads called while logging");
+    if (n == max_threads_)
+        return;
+
+    void* mem = nullptr;
+    always_assert(posix_memalign(&mem, alignof(threadinfo_t), n * sizeof(threadinfo_t)) == 0,
+                  "cannot allocate thread state");
+    threadinfo_t* tinfo = static_cast<threadinfo_t*>(mem);
+    for (int i = 0; i != n; ++i)
+        new (&tinfo[i]) threadinfo_t;
+    if (Transaction::tinfo != default_tinfo) {
+        for (int i = 0; i != max_threads_; ++i)
+            Transaction::tinfo[i].~threadinfo_t();
+        free(Transaction::tinfo);
+    }
+    Transaction::tinfo = tinfo;
+
+    if (gen != default_gen)
+        delete[] gen;
+    gen = new PercentGen[n];
+
+    ContentionManager::set_max_threads(n);
+
+    std::lock_guard<std::mutex> lk(thread_ids_lock);
+    max_threads_ = n;
+    thread_ids_used.assign(n, false);
+}
+
+int TThread::register_thread() {
+    std::lock_guard<std::mutex> lk(thread_ids_lock);
+    thread_ids_used.resize(max_threads_, false);
+    auto it = std::find(thread_ids_used.begin(), thread_ids_used.end(), false);
+    always_assert(it != thread_ids_used.end(), "out of thread ids");
+    *it = true;
+    the_id = int(it - thread_ids_used.begin());
+    return the_id;
+}
+
+void TThread::unregister_thread() {
+    Transaction::rcu_quiesce();
+    std::lock_guard<std::mutex> lk(thread_ids_lock);
+    assert(the_id < int(thread_ids_used.size()) && thread_ids_used[the_id]);
+    thread_ids_used[the_id] = false;
+}
+
 void Transaction::initialize() {
     static_assert(tset_initial_capacity % tset_chunk == 0, "tset_initial_capacity not an even multiple of tset_chunk");
-    hash_base_ = 32768;
     tset_size_ = 0;
+    hashtable_ = nullptr;
+    hash_size_ = hash_capacity_ = hash_gen_ = hash_hint_ = 0;
+    hash_shift_ = 64;
     lrng_state_ = 12897;
+    last_commit_tid_ = 0;
     for (unsigned i = 0; i != tset_initial_capacity / tset_chunk; ++i)
         tset_[i] = &tset0_[i * tset_chunk];
     for (unsigned i = tset_initial_capacity / tset_chunk; i != arraysize(tset_); ++i)
@@ -41,6 +102,7 @@ Transaction::~Transaction() {
     for (unsigned i = 0; i != arraysize(tset_); ++i, live += tset_chunk)
         if (live != tset_[i])
             delete[] tset_[i];
+    delete[] hashtable_;
 }
 
 void Transaction::refresh_tset_chunk() {
@@ -51,6 +113,33 @@ void Transaction::refresh_tset_chunk() {
     tset_next_ = tset_[tset_size_ / tset_chunk];
 }
 
+void Transaction::grow_item_index() {
+    static_assert(tset_max_capacity < 65536, "item index entries hold 16-bit tset indexes");
+    unsigned nsize = item_index_size(tset_size_);
+    if (!hash_size_)
+        nsize = std::max(nsize, hash_hint_);
+    if (nsize > hash_capacity_) {
+        delete[] hashtable_;
+        hashtable_ = new uint32_t[nsize]();
+        hash_capacity_ = nsize;
+        hash_gen_ = 0;
+    }
+    if (++hash_gen_ == 65536) {
+        memset(hashtable_, 0, hash_capacity_ * sizeof(hashtable_[0]));
+        hash_gen_ = 1;
+    }
+    hash_size_ = nsize;
+    hash_shift_ = 64 - __builtin_ctz(nsize);
+    TXP_INCREMENT(txp_hash_grow);
+
+    // items are reinserted in set order, so a probe sequence meets the
+    // earliest of several items with the same key first
+    for (unsigned tidx = 0; tidx != tset_size_; ++tidx) {
+        const TransItem* it = item_at(tidx);
+        insert_item_index(tidx, it->owner(), it->key_);
+    }
+}
+
 void* Transaction::epoch_advancer(void*) {
     static int num_epoch_advancers = 0;
     if (fetch_and_add(&num_epoch_advancers, 1) != 0)
@@ -61,13 +150,24 @@ void* Transaction::epoch_advancer(void*) {
     while (global_epochs.run) {
         epoch_type g = global_epochs.global_epoch;
         epoch_type e = g;
-        for (auto& t : tinfo) {
-            if (t.epoch != 0 && signed_epoch_type(t.epoch - e) < 0)
-                e = t.epoch;
+        // snapshots published after this point are at least snap: they
+        // check that recent_tid did not change after publishing
+        TransactionTid::type snap = global_epochs.recent_tid;
+        fence();
+        for (int i = 0; i != TThread::max_threads(); ++i) {
+            epoch_type te = tinfo[i].epoch;
+            if (te != 0 && signed_epoch_type(te - e) < 0)
+                e = te;
+            TransactionTid::type ts = tinfo[i].snapshot_tid;
+            if (ts != 0 && ts < snap)
+                snap = ts;
         }
         global_epochs.global_epoch = std::max(g + 1, epoch_type(1));
         global_epochs.active_epoch = e;
-        global_epochs.recent_tid = Transaction::_TID;
+        // commits that read an older epoch have locked their write sets
+        release_fence();
+        global_epochs.recent_tid = TransactionTid::epoch_tid(global_epochs.global_epoch);
+        global_epochs.min_snapshot_tid = snap;
 
         if (epoch_advance_callback)
             epoch_advance_callback(global_epochs.global_epoch);
@@ -78,6 +178,44 @@ void* Transaction::epoch_advancer(void*) {
     return NULL;
 }
 
+// Commit TIDs are assigned per thread, Silo-style: a TID is the commit
+// epoch followed by a sequence number (TransactionTid::epoch_tid), greater
+// than the thread's previous TID and than every version the transaction
+// locked for writing. Dependencies across threads are ordered by epoch:
+// the commit epoch is read after the write set is locked and before the
+// read set is validated, so a transaction that reads or overwrites another's
+// writes has an epoch no smaller than it, as does a transaction that
+// overwrites something another one read. Commits with TIDs below
+// epoch_tid(e) therefore form a consistent state, and each of them locked
+// its write set before the global epoch became e.
+//
+// Opacity checks need more: a version older than the transaction's start
+// TID must have been committed before the transaction started. Commits
+// that write opaque versions therefore also follow opacity_clock (the TL2
+// global version clock), read while the write set is locked. Consistency
+// checkers replay commits in TID order, which must then be a serial order,
+// so with CONSISTENCY_CHECK every commit follows the clock.
+TransactionTid::type __attribute__((aligned(128))) Transaction::opacity_clock = TransactionTid::epoch_tid(1);
+
+TransactionTid::type Transaction::assign_commit_tid() const {
+    epoch_type e = commit_epoch_ ? commit_epoch_ : global_epochs.global_epoch;
+    tid_type t = std::max(last_commit_tid_, tid_floor_) + TransactionTid::increment_value;
+    t = std::max(t & ~(TransactionTid::increment_value - 1), TransactionTid::epoch_tid(e));
+    if (CONSISTENCY_CHECK || any_opaque_writes_) {
+        while (true) {
+            tid_type c = opacity_clock;
+            tid_type next = std::max(t, c);
+            if (bool_cmpxchg(&opacity_clock, c, next + TransactionTid::increment_value)) {
+                t = next;
+                break;
+            }
+        }
+    } else
+        always_assert(t < TransactionTid::epoch_tid(e + 1), "commit TID sequence overflow");
+    last_commit_tid_ = t;
+    return t;
+}
+
 bool Transaction::preceding_duplicate_read(TransItem* needle) const {
     const TransItem* it = nullptr;
     for (unsigned tidx = 0; ; ++tidx) {
@@ -121,10 +259,12 @@ bool Transaction::hard_check_opacity(TransItem* item, TransactionTid::type t) {
         TXP_INCREMENT(txp_hco_invalid);
 
     state_ = s_opacity_check;
-    start_tid_ = _TID;
+    start_tid_ = opacity_clock;
     release_fence();
     TransItem* it = nullptr;
     for (unsigned tidx = 0; tidx != tset_size_; ++tidx) {
+        if (tidx % commit_batch == 0)
+            prefetch_items(tidx, std::min(tidx + commit_batch, tset_size_), TransItem::read_bit);
         it = (tidx % tset_chunk ? it + 1 : tset_[tidx / tset_chunk]);
         if (it->has_read()) {
             TXP_INCREMENT(txp_total_check_read);
@@ -149,6 +289,89 @@ void Transaction::callCMstart() {
     ContentionManager::start(this);
 }
 
+namespace {
+// Applies op to the items in [first, last). A run of items whose owners
+// share a batch type takes one call to the owner's *_items function; other
+// items take one virtual call each. Returns the first item op failed on,
+// or last.
+template <typename Op>
+inline TransItem** for_batched(TransItem** first, TransItem** last, const Op& op) {
+    while (first != last) {
+        TObject* owner = (*first)->owner();
+        const void* type = owner->batch_type();
+        if (!type) {
+            if (!op.one(owner, **first))
+                return first;
+            ++first;
+        } else {
+            TransItem** run_end = first + 1;
+            while (run_end != last && (*run_end)->owner()->batch_type() == type)
+                ++run_end;
+            TransItem** failed = op.run(owner, first, run_end);
+            if (failed != run_end)
+                return failed;
+            first = run_end;
+        }
+    }
+    return last;
+}
+
+struct prefetch_op {
+    bool one(TObject* owner, TransItem& item) const {
+        owner->prefetch(item);
+        return true;
+    }
+    TransItem** run(TObject* owner, TransItem** first, TransItem** last) const {
+        owner->prefetch_items(first, last);
+        return last;
+    }
+};
+
+struct lock_op {
+    Transaction& txn;
+    bool one(TObject* owner, TransItem& item) const {
+        return owner->lock(item, txn);
+    }
+    TransItem** run(TObject* owner, TransItem** first, TransItem** last) const {
+        return owner->lock_items(first, last, txn);
+    }
+};
+
+struct check_op {
+    Transaction& txn;
+    bool one(TObject* owner, TransItem& item) const {
+        return owner->check(item, txn);
+    }
+    TransItem** run(TObject* owner, TransItem** first, TransItem** last) const {
+        return owner->check_items(first, last, txn);
+    }
+};
+
+struct install_op {
+    Transaction& txn;
+    bool one(TObject* owner, TransItem& item) const {
+        owner->install(item, txn);
+        return true;
+    }
+    TransItem** run(TObject* owner, TransItem** first, TransItem** last) const {
+        owner->install_items(first, last, txn);
+        return last;
+    }
+};
+
+struct cleanup_op {
+    bool committed;
+    bool one(TObject* owner, TransItem& item) const {
+        owner->cleanup(item, committed);
+        return true;
+    }
+    TransItem** run(TObject* owner, TransItem** first, TransItem** last) const {
+        owner->cleanup_items(first, last, committed);
+        return last;
+    }
+};
+}
+
 void Transaction::stop(bool committed, unsigned* writeset, unsigned nwriteset) {
 #if STO_TSC_PROFILE
     TimeKeeper<tc_cleanup> tk;
@@ -180,7 +403,7 @@ void Transaction::stop(bool committed, unsigned* writeset, unsigned nwriteset) {
     if (!any_writes_)
         goto unlock_all;
 
-    if (committed && !STO_SORT_WRITESET) {
+    if (committed) {
 /*
         for (unsigned* idxit = writeset + nwriteset; idxit != writeset; ) {
             --idxit;
@@ -192,14 +415,16 @@ void Transaction::stop(bool committed, unsigned* writeset, unsigned nwriteset) {
                 it->owner()->unlock(*it);
         }
 */
+        TransItem* batch[commit_batch];
         for (unsigned* idxit = writeset + nwriteset; idxit != writeset; ) {
-            --idxit;
-            if (*idxit < tset_initial_capacity)
-                it = &tset0_[*idxit];
-            else
-                it = &tset_[*idxit / tset_chunk][*idxit % tset_chunk];
-            if (it->has_write()) // always true unless a user turns it off in install()/check()
-                it->owner()->cleanup(*it, committed);
+            unsigned n = 0;
+            while (idxit != writeset && n != commit_batch) {
+                --idxit;
+                it = item_at(*idxit);
+                if (it->has_write()) // always true unless a user turns it off in install()/check()
+                    batch[n++] = it;
+            }
+            for_batched(batch, batch + n, cleanup_op{committed});
         }
     } else {
 /*
@@ -234,6 +459,10 @@ unlock_all:
 
     // TODO: this will probably mess up with nested transactions
     threadinfo_t& thr = tinfo[TThread::id()];
+    if (snapshot_tid_) {
+        thr.snapshot_tid = 0;
+        snapshot_tid_ = 0;
+    }
     if (thr.trans_end_callback)
         thr.trans_end_callback();
     // XXX should reset trans_end_callback after calling it...
@@ -257,6 +486,16 @@ unlock_all:
     //COZ_PROGRESS;
 }
 
+void Transaction::prefetch_items(unsigned first, unsigned last, TransItem::flags_type which) const {
+    const TransItem* it = nullptr;
+    for (unsigned tidx = first; tidx != last; ++tidx) {
+        it = (tidx % tset_chunk && it ? it + 1 : &tset_[tidx / tset_chunk][tidx % tset_chunk]);
+        if (it->flags() & which)
+            it->owner()->prefetch(*it);
+    }
+}
+
+
 bool Transaction::try_commit() {
 #if STO_TSC_PROFILE
     TimeKeeper<tc_commit> tk;
@@ -279,8 +518,10 @@ bool Transaction::try_commit() {
 
     if (any_nonopaque_)
         TXP_INCREMENT(txp_commit_time_nonopaque);
+    always_assert(!readonly_snapshot_ || !any_writes_, "write in a read-only snapshot transaction");
 #if !CONSISTENCY_CHECK
-    // commit immediately if read-only transaction with opacity
+    // commit immediately if read-only transaction with opacity (or a
+    // snapshot transaction that only read MVCC data structures)
     if (!any_writes_ && !any_nonopaque_) {
         stop(true, nullptr, 0);
         return true;
@@ -292,24 +533,23 @@ bool Transaction::try_commit() {
     unsigned writeset[tset_size_];
     unsigned nwriteset = 0;
     writeset[0] = tset_size_;
+    // items handed to lock, check and install together (see for_batched)
+    TransItem* batch[commit_batch];
+    unsigned nbatch;
+    TransItem** failed;
+    bool logging = false;
+    epoch_type log_epoch = 0;
+#if STO_TSC_PROFILE
+    uint64_t phase_tsc = tk.init_tsc_val();
+#endif
 
     TransItem* it = nullptr;
     for (unsigned tidx = 0; tidx != tset_size_; ++tidx) {
         it = (tidx % tset_chunk ? it + 1 : tset_[tidx / tset_chunk]);
         if (it->has_write()) {
             writeset[nwriteset++] = tidx;
-#if !STO_SORT_WRITESET
-            if (nwriteset == 1) {
+            if (nwriteset == 1)
                 first_write_ = writeset[0];
-                state_ = s_committing_locked;
-            }
-            if (!it->needs_unlock() && !it->owner()->lock(*it, *this)) {
-                mark_abort_because(it, "commit lock");
-                goto abort;
-            }
-            it->__or_flags(TransItem::lock_bit);
-            it->__or_flags(TransItem::cl_bit);
-#endif
         }
         if (it->has_read()) {
             TXP_INCREMENT(txp_total_r);
@@ -341,22 +581,54 @@ bool Transaction::try_commit() {
         TransItem* tj = &tset_[j / tset_chunk][j % tset_chunk];
         return *ti < *tj;
     });
+#endif
 
     if (nwriteset) {
         state_ = s_committing_locked;
         auto writeset_end = writeset + nwriteset;
-        for (auto it = writeset; it != writeset_end; ) {
-            TransItem* me = &tset_[*it / tset_chunk][*it % tset_chunk];
-            if (!me->owner()->lock(*me, *this)) {
-                mark_abort_because(me, "commit lock");
+        for (auto idxit = writeset; idxit != writeset_end; ) {
+            // items locked during execution only need the flags
+            nbatch = 0;
+            for (; idxit != writeset_end && nbatch != commit_batch; ++idxit) {
+                it = item_at(*idxit);
+                if (it->needs_unlock())
+                    it->__or_flags(TransItem::cl_bit);
+                else
+                    batch[nbatch++] = it;
+            }
+            for_batched(batch, batch + nbatch, prefetch_op());
+            failed = for_batched(batch, batch + nbatch, lock_op{*this});
+            for (auto b = batch; b != failed; ++b)
+                (*b)->__or_flags(TransItem::lock_bit | TransItem::cl_bit);
+            if (failed != batch + nbatch) {
+                mark_abort_because(*failed, "commit lock");
                 goto abort;
             }
-            me->__or_flags(TransItem::lock_bit);
-            ++it;
         }
     }
+
+#if STO_TSC_PROFILE
+    {
+        uint64_t now = read_tsc();
+        TSC_ACCOUNT(tc_commit_lock, now - phase_tsc);
+        phase_tsc = now;
+    }
 #endif
 
+    // fix the commit epoch (and the epoch for redo logging) while the
+    // write set is locked and before the read set is validated; the lock
+    // instructions order this read after the locks
+    if (nwriteset) {
+        if (Logger::enabled()) {
+            log_epoch = Logger::begin_commit(threadid_);
+            logging = true;
+            commit_epoch_ = log_epoch;
+        } else {
+            acquire_fence();
+            commit_epoch_ = global_epochs.global_epoch;
+        }
+    }
+
 #if CONSISTENCY_CHECK
     fence();
     commit_tid();
@@ -364,42 +636,57 @@ bool Transaction::try_commit() {
 #endif
 
     //phase2
-    for (unsigned tidx = 0; tidx != tset_size_; ++tidx) {
-        it = (tidx % tset_chunk ? it + 1 : tset_[tidx / tset_chunk]);
-        if (it->has_read() && (it->locked_at_commit() || !it->needs_unlock())) {
-            TXP_INCREMENT(txp_total_check_read);
-            if (!it->owner()->check(*it, *this)
-                && (!may_duplicate_items_ || !preceding_duplicate_read(it))) {
-                mark_abort_because(it, "commit check");
+    for (unsigned tidx = 0; tidx != tset_size_; ) {
+        nbatch = 0;
+        for (unsigned end = std::min(tidx + commit_batch, tset_size_); tidx != end; ++tidx) {
+            it = (tidx % tset_chunk ? it + 1 : tset_[tidx / tset_chunk]);
+            if (it->has_read() && (it->locked_at_commit() || !it->needs_unlock())) {
+                TXP_INCREMENT(txp_total_check_read);
+                batch[nbatch++] = it;
+            }
+        }
+        for_batched(batch, batch + nbatch, prefetch_op());
+        for (auto b = batch; (failed = for_batched(b, batch + nbatch, check_op{*this})) != batch + nbatch; ) {
+            if (!may_duplicate_items_ || !preceding_duplicate_read(*failed)) {
+                mark_abort_because(*failed, "commit check");
                 goto abort;
             }
+            b = failed + 1;
         }
     }
 
+#if STO_TSC_PROFILE
+    TSC_ACCOUNT(tc_commit_check, read_tsc() - phase_tsc);
+#endif
+
     // fence();
 
     //phase3
-#if STO_SORT_WRITESET
-    for (unsigned tidx = first_write_; tidx != tset_size_; ++tidx) {
-        it = &tset_[tidx / tset_chunk][tidx % tset_chunk];
-        if (it->has_write()) {
-            TXP_INCREMENT(txp_total_w);
-            it->owner()->install(*it, *this);
-        }
-    }
-#else
-    if (nwriteset) {
+    if (logging) {
+        TLogRecord rec(Logger::buffer(threadid_), log_epoch, commit_tid());
         auto writeset_end = writeset + nwriteset;
         for (auto idxit = writeset; idxit != writeset_end; ++idxit) {
             if (likely(*idxit < tset_initial_capacity))
                 it = &tset0_[*idxit];
             else
                 it = &tset_[*idxit / tset_chunk][*idxit % tset_chunk];
-            TXP_INCREMENT(txp_total_w);
-            it->owner()->install(*it, *this);
+            it->owner()->log_redo(*it, rec);
+        }
+        rec.finish();
+        Logger::end_commit(threadid_);
+    }
+
+    if (nwriteset) {
+        auto writeset_end = writeset + nwriteset;
+        for (auto idxit = writeset; idxit != writeset_end; ) {
+            nbatch = 0;
+            for (; idxit != writeset_end && nbatch != commit_batch; ++idxit) {
+                TXP_INCREMENT(txp_total_w);
+                batch[nbatch++] = item_at(*idxit);
+            }
+            for_batched(batch, batch + nbatch, install_op{*this});
         }
     }
-#endif
 
     // fence();
     stop(true, writeset, nwriteset);
@@ -411,6 +698,8 @@ abort:
     //outfile.close();
     // fence();
     TXP_INCREMENT(txp_commit_time_aborts);
+    if (logging)
+        Logger::abort_commit(threadid_);
     // scan the whole read set for locks if aborting
     // XXX this can be optimized later
     stop(false, nullptr, 0);
@@ -461,14 +750,19 @@ void Transaction::print_stats() {
         fprintf(stderr, "$ %llu HCO (%llu lock, %llu invalid, %llu aborts) out of %llu check attempts (%.3f%%)\n",
                 out.p(txp_hco), out.p(txp_hco_lock), out.p(txp_hco_invalid), out.p(txp_hco_abort), out.p(txp_tco),
                 100.0 * (double) out.p(txp_hco) / out.p(txp_tco));
-    if (txp_count >= txp_hash_collision)
-        fprintf(stderr, "$ %llu (%.3f%%) hash collisions, %llu second level\n", out.p(txp_hash_collision),
-                100.0 * (double) out.p(txp_hash_collision) / out.p(txp_hash_find),
-                out.p(txp_hash_collision2));
+    if (txp_count >= txp_leaf_false_conflicts && out.p(txp_leaf_conflicts))
+        fprintf(stderr, "$ %llu changed leaves rechecked by key range, %llu (%.3f%%) false conflicts\n",
+                out.p(txp_leaf_conflicts), out.p(txp_leaf_false_conflicts),
+                100.0 * (double) out.p(txp_leaf_false_conflicts) / out.p(txp_leaf_conflicts));
+    if (txp_count >= txp_hash_grow)
+        fprintf(stderr, "$ item lookups: %llu linear (%llu items compared), %llu hashed (%.3f extra probes per lookup), %llu index builds/resizes\n",
+                out.p(txp_hash_linear), out.p(txp_total_searched), out.p(txp_hash_find),
+                (double) out.p(txp_hash_probe) / std::max(out.p(txp_hash_find), 1ULL),
+                out.p(txp_hash_grow));
     if (txp_count >= txp_total_transbuffer)
         fprintf(stderr, "$ %llu max buffer per txn, %llu total buffer\n",
                 out.p(txp_max_transbuffer), out.p(txp_total_transbuffer));
-    fprintf(stderr, "$ %llu next commit-tid\n", (unsigned long long) _TID);
+    fprintf(stderr, "$ epoch %llu\n", (unsigned long long) global_epochs.global_epoch);
 
 #if STO_TSC_PROFILE
     tc_counters out_tcs = tc_counters_combined();
@@ -480,6 +774,8 @@ void Transaction::print_stats() {
     ss << "   time_abort: " << out_tcs.to_realtime(tc_abort) << std::endl;
     ss << "   time_cleanup: " << out_tcs.to_realtime(tc_cleanup) << std::endl;
     ss << "   time_opacity: " << out_tcs.to_realtime(tc_opacity) << std::endl;
+    ss << "   time_commit_lock: " << out_tcs.to_realtime(tc_commit_lock) << std::endl;
+    ss << "   time_commit_check: " << out_tcs.to_realtime(tc_commit_check) << std::endl;
 
     fprintf(stderr, "%s\n", ss.str().c_str());
 #endif
@@ -509,6 +805,35 @@ void Transaction::print() const {
     print(std::cerr);
 }
 
+void TObject::prefetch_items(TransItem* const* first, TransItem* const* last) const {
+    for (; first != last; ++first)
+        (*first)->owner()->prefetch(**first);
+}
+
+TransItem** TObject::lock_items(TransItem** first, TransItem** last, Transaction& txn) {
+    for (; first != last; ++first)
+        if (!(*first)->owner()->lock(**first, txn))
+            break;
+    return first;
+}
+
+TransItem** TObject::check_items(TransItem** first, TransItem** last, Transaction& txn) {
+    for (; first != last; ++first)
+        if (!(*first)->owner()->check(**first, txn))
+            break;
+    return first;
+}
+
+void TObject::install_items(TransItem** first, TransItem** last, Transaction& txn) {
+    for (; first != last; ++first)
+        (*first)->owner()->install(**first, txn);
+}
+
+void TObject::cleanup_items(TransItem** first, TransItem** last, bool committed) {
+    for (; first != last; ++first)
+        (*first)->owner()->cleanup(**first, committed);
+}
+
 void TObject::print(std::ostream& w, const TransItem& item) const {
     w << "{" << typeid(*this).name() << " " << (void*) this << "." << item.key<void*>();
     if (item.has_read())
@@ -87,7 +87,6 @@
 
 #define CONSISTENCY_CHECK 0
 #define ASSERT_TX_SIZE 0
-#define TRANSACTION_HASHTABLE 1
 //#define TRANSACTION_FILTER 0
 
 #if ASSERT_TX_SIZE
@@ -101,8 +100,6 @@
 
 #include "config.h"
 
-#define MAX_THREADS 128
-
 // TRANSACTION macros that can be used to wrap transactional code
 #define TRANSACTION                               \
     do {                                          \
@@ -113,6 +110,20 @@
         while (1) {                               \
             __txn_guard.start();
 
+// like TRANSACTION, for read-only transactions that read at a snapshot
+// (see Transaction::start_readonly_snapshot) if snapshot is true; ends
+// with RETRY
+#define TRANSACTION_SNAPSHOT_IF(snapshot)         \
+    do {                                          \
+        __label__ abort_in_progress;              \
+        __label__ try_commit;                     \
+        __label__ after_commit;                   \
+        TransactionLoopGuard __txn_guard;         \
+        while (1) {                               \
+            __txn_guard.start((snapshot));
+
+#define TRANSACTION_SNAPSHOT TRANSACTION_SNAPSHOT_IF(true)
+
 #define RETRY(retry)                              \
             goto try_commit;                      \
 abort_in_progress:                                \
@@ -174,6 +185,8 @@ enum txp {
     txp_hco_lock,
     txp_hco_invalid,
     txp_hco_abort,
+    txp_leaf_conflicts,
+    txp_leaf_false_conflicts,
     // STO_PROFILE_COUNTERS > 1 only
     txp_total_n,
     txp_total_r,
@@ -186,13 +199,14 @@ enum txp {
     txp_total_check_read,
     txp_total_check_predicate,
     txp_hash_find,
-    txp_hash_collision,
-    txp_hash_collision2,
+    txp_hash_probe,
+    txp_hash_linear,
+    txp_hash_grow,
     txp_total_searched,
 #if !STO_PROFILE_COUNTERS
     txp_count = 0
 #elif STO_PROFILE_COUNTERS == 1
-    txp_count = txp_hco_abort + 1
+    txp_count = txp_leaf_false_conflicts + 1
 #else
     txp_count
 #endif
@@ -246,6 +260,8 @@ enum TimingCounters {
     tc_abort,
     tc_cleanup,
     tc_opacity,
+    tc_commit_lock,
+    tc_commit_check,
     tc_count
 };
 
@@ -294,6 +310,8 @@ void reportPerf();
 struct __attribute__((aligned(128))) threadinfo_t {
     using epoch_type = TRcuSet::epoch_type;
     epoch_type epoch;
+    // MVCC snapshot held by the running transaction, 0 if none
+    TransactionTid::type snapshot_tid;
     TRcuSet rcu_set;
     // XXX(NH): these should be vectors so multiple data structures can register
     // callbacks for these
@@ -302,7 +320,7 @@ struct __attribute__((aligned(128))) threadinfo_t {
     txp_counters p_;
     tc_counters tcs_;
     threadinfo_t()
-        : epoch(0) {
+        : epoch(0), snapshot_tid(0) {
     }
 };
 
@@ -342,28 +360,36 @@ class Transaction {
 public:
     static constexpr unsigned tset_initial_capacity = 512;
 
-    static constexpr unsigned hash_size = 32768;
-    static constexpr unsigned hash_step = 5;
+    // item index: sets of up to tset_linear_max items are searched linearly;
+    // larger sets use an open-addressed table kept at most half full
+    static constexpr unsigned tset_linear_max = 8;
+    static constexpr unsigned hash_initial_size = 64;
     using epoch_type = TRcuSet::epoch_type;
     using signed_epoch_type = TRcuSet::signed_epoch_type;
 
-    static threadinfo_t tinfo[MAX_THREADS];
+    // one entry per thread id, see TThread::set_max_threads
+    static threadinfo_t* tinfo;
     static struct epoch_state {
         epoch_type global_epoch; // != 0
         epoch_type active_epoch; // no thread is before this epoch
+        // TransactionTid::epoch_tid(global_epoch), set after global_epoch
         TransactionTid::type recent_tid;
+        // no running transaction holds an MVCC snapshot older than this
+        TransactionTid::type min_snapshot_tid;
         bool run;
     } global_epochs;
     typedef TransactionTid::type tid_type;
-private:
-    static TransactionTid::type _TID;
-public:
+
+    // Opacity clock: a lower bound on the commit TIDs not yet assigned to
+    // transactions that write opaque versions (see assign_commit_tid).
+    // Opacity checks take it as the start TID.
+    static tid_type opacity_clock;
 
     static std::function<void(threadinfo_t::epoch_type)> epoch_advance_callback;
 
     static txp_counters txp_counters_combined() {
         txp_counters out;
-        for (int i = 0; i != MAX_THREADS; ++i)
+        for (int i = 0; i != TThread::max_threads(); ++i)
             for (int p = 0; p != txp_count; ++p) {
                 if (txp_is_max(p))
                     out.p_[p] = std::max(out.p_[p], tinfo[i].p_.p_[p]);
@@ -375,7 +401,7 @@ public:
 
     static tc_counters tc_counters_combined() {
         tc_counters ret;
-        for (int i = 0; i < MAX_THREADS; ++i) {
+        for (int i = 0; i < TThread::max_threads(); ++i) {
             for (int t = 0; t < tc_count; ++t) {
                 ret.tcs_[t] += tinfo[i].tcs_.tcs_[t];
             }
@@ -386,7 +412,7 @@ public:
     static void print_stats();
 
     static void clear_stats() {
-        for (int i = 0; i != MAX_THREADS; ++i) {
+        for (int i = 0; i != TThread::max_threads(); ++i) {
             tinfo[i].p_.reset();
             tinfo[i].tcs_.reset();
         }
@@ -436,6 +462,8 @@ public:
 private:
     static constexpr unsigned tset_chunk = 512;
     static constexpr unsigned tset_max_capacity = 32768;
+    // items prefetched, locked and checked together at commit
+    static constexpr unsigned commit_batch = 16;
 
     void initialize();
 
@@ -477,24 +505,25 @@ private:
         thr.rcu_set.clean_until(global_epochs.active_epoch);
         if (thr.trans_start_callback)
             thr.trans_start_callback();
-        hash_base_ += tset_size_ + 1;
+        if (hash_size_ | hash_hint_) {
+            // size the next index after this transaction (retries and
+            // similar transactions skip the intermediate resizes); larger
+            // transactions are forgotten gradually
+            unsigned need = hash_size_ ? item_index_size(tset_size_) : 0;
+            hash_hint_ = std::max(need, hash_hint_ / 2);
+            hash_size_ = 0;
+        }
         tset_size_ = 0;
         tset_next_ = tset0_;
-#if TRANSACTION_HASHTABLE
-        if (hash_base_ >= 32768) {
-            memset(hashtable_, 0, sizeof(hashtable_));
-            /*if (TThread::always_allocate()) {
-                memset(hashtable_1024_, 0, sizeof(hashtable_1024_)); 
-            } else {
-                memset(hashtable_32768_, 0, sizeof(hashtable_32768_));
-            }*/
-            hash_base_ = 0;
-        }
-#endif
         any_writes_ = any_nonopaque_ = may_duplicate_items_ = false;
+        any_opaque_writes_ = false;
         first_write_ = 0;
         start_tid_ = commit_tid_ = 0;
+        tid_floor_ = 0;
+        commit_epoch_ = 0;
         tictoc_tid_ = 0;
+        snapshot_tid_ = 0;
+        past_snapshot_ = readonly_snapshot_ = false;
         buf_.clear();
 #if STO_DEBUG_ABORTS
         abort_item_ = nullptr;
@@ -506,42 +535,44 @@ private:
         callCMstart();
     }
 
-#if TRANSACTION_HASHTABLE
-    static int hash_int_array_index(const TObject* obj, void* key) {
-	(void) obj;
-	return (reinterpret_cast<uintptr_t>(key)) % hash_size;
-    }
-
-    static int hash_int_array_ptr(const TObject* obj, void* key) {
- 	(void) obj;
-	return (reinterpret_cast<uintptr_t>(key) >> 2) % hash_size;
-    }
-
-    static int hash_regular(const TObject* obj, void* key) {
-        auto n = reinterpret_cast<uintptr_t>(key) + 0x4000000;
-        n += -uintptr_t(n < 0x8000000) & (reinterpret_cast<uintptr_t>(obj) >> 4);
-        //2654435761
-        return (n + (n >> 16) * 9) % hash_size;
+    unsigned hash(const TObject* obj, void* key) const {
+        uint64_t n = reinterpret_cast<uintptr_t>(key)
+            + (reinterpret_cast<uintptr_t>(obj) >> 4) * 0x100000001b3ULL;
+        return (n * 0x9E3779B97F4A7C15ULL) >> hash_shift_;
     }
 
-    static int hash(const TObject* obj, void* key) {
-        return hash_regular(obj, key);
-    }
-#endif
-
     void refresh_tset_chunk();
+    void grow_item_index();
+    // prefetch for the items in [first, last) with any of the flags in which
+    void prefetch_items(unsigned first, unsigned last, TransItem::flags_type which) const;
+
+    static unsigned item_index_size(unsigned nitems) {
+        unsigned n = hash_initial_size;
+        while (n < 2 * nitems)
+            n *= 2;
+        return n;
+    }
+    // index entries are |generation 16|tset index + 1 16|; entries of older
+    // generations are empty, so the table is never cleared between uses
+    bool item_index_used(unsigned hi) const {
+        return (hashtable_[hi] >> 16) == hash_gen_;
+    }
+    void insert_item_index(unsigned tidx, const TObject* obj, void* xkey) {
+        unsigned mask = hash_size_ - 1;
+        unsigned hi = hash(obj, xkey);
+        while (item_index_used(hi))
+            hi = (hi + 1) & mask;
+        hashtable_[hi] = (hash_gen_ << 16) | (tidx + 1);
+    }
 
     void allocate_item_update_hash(const TObject* obj, void* xkey) {
-#if TRANSACTION_HASHTABLE
-        unsigned hi = hash(obj, xkey);
-        //bitvector_[hi % bv_size] = true;
-        # if TRANSACTION_HASHTABLE > 1
-        if (hashtable_[hi] > hash_base_)
-            hi = (hi + hash_step) % hash_size;
-# endif
-        if (hashtable_[hi] <= hash_base_)
-            hashtable_[hi] = hash_base_ + tset_size_;
-#endif
+        if (hash_size_) {
+            if (tset_size_ * 2 > hash_size_)
+                grow_item_index();
+            else
+                insert_item_index(tset_size_ - 1, obj, xkey);
+        } else if (tset_size_ > tset_linear_max)
+            grow_item_index();
     }
 
     TransItem* allocate_item(const TObject* obj, void* xkey) {
@@ -588,48 +619,10 @@ private:
 
     template <typename T>
     TransProxy item_inlined(const TObject* obj, T key) {
-        bool found = false;
-        TransItem* ti;
         void* xkey = Packer<T>::pack_unique(buf_, std::move(key));
-#if TRANSACTION_HASHTABLE
-        TXP_INCREMENT(txp_hash_find);
-        unsigned hi = hash(obj, xkey);
-        if (hashtable_[hi] > hash_base_) {
-            unsigned tidx =  hashtable_[hi] - hash_base_ - 1;
-            if (likely(tidx < tset_initial_capacity))
-                ti = &tset0_[tidx];
-            else
-                ti = &tset_[tidx / tset_chunk][tidx % tset_chunk];
-            if (ti->owner() == obj && ti->key_ == xkey) {
-                found = true;
-            } else {
-#endif
-	        //std::cout << "Hash not found!" << std::endl;
-                for (unsigned tidx = 0; tidx != tset_size_; ++tidx) {
-                    ti = (tidx % tset_chunk ? ti + 1 : tset_[tidx / tset_chunk]);
-                    TXP_INCREMENT(txp_total_searched);
-                    if (ti->owner() == obj && ti->key_ == xkey) {
-                        found = true;
-                        break;
-                    }
-                }
-#if TRANSACTION_HASHTABLE
-            }
-        }
-#endif
-        
-        if (!found) {
-            if (tset_size_ && tset_size_ % tset_chunk == 0)
-                refresh_tset_chunk();
-            ++tset_size_;
-            new(reinterpret_cast<void*>(tset_next_)) TransItem(const_cast<TObject*>(obj), xkey);
- #if TRANSACTION_HASHTABLE
-            if (hashtable_[hi] <= hash_base_)
-                hashtable_[hi] = hash_base_ + tset_size_;
-#endif	
-            ti = tset_next_++;
-        }
- 
+        TransItem* ti = find_item(const_cast<TObject*>(obj), xkey);
+        if (!ti)
+            ti = allocate_item(obj, xkey);
         return TransProxy(*this, *ti);
     }
 
@@ -658,53 +651,52 @@ private:
     }
 
 private:
-    TransItem* find_item_scan(TObject* obj, void* xkey) const {
-        const TransItem* it = nullptr;
-        for (unsigned tidx = 0; tidx != tset_size_; ++tidx) {
-            it = (tidx % tset_chunk ? it + 1 : tset_[tidx / tset_chunk]);
-            TXP_INCREMENT(txp_total_searched);
-            if (it->owner() == obj && it->key_ == xkey)
-                return const_cast<TransItem*>(it);
-        }
-        return nullptr;
+    const TransItem* item_at(unsigned tidx) const {
+        if (likely(tidx < tset_initial_capacity))
+            return &tset0_[tidx];
+        else
+            return &tset_[tidx / tset_chunk][tidx % tset_chunk];
+    }
+    TransItem* item_at(unsigned tidx) {
+        return const_cast<TransItem*>(const_cast<const Transaction*>(this)->item_at(tidx));
     }
     // tries to find an existing item with this key, returns NULL if not found
+    // (finds the earliest item if the key was added more than once)
     TransItem* find_item(TObject* obj, void* xkey) const {
 #if STO_TSC_PROFILE
         TimeKeeper<tc_find_item> tk;
 #endif
-#if TRANSACTION_HASHTABLE
+        if (!hash_size_) {
+            TXP_INCREMENT(txp_hash_linear);
+            for (unsigned tidx = 0; tidx != tset_size_; ++tidx) {
+                TXP_INCREMENT(txp_total_searched);
+                const TransItem* ti = &tset0_[tidx];
+                if (ti->owner() == obj && ti->key_ == xkey)
+                    return const_cast<TransItem*>(ti);
+            }
+            return nullptr;
+        }
+
         TXP_INCREMENT(txp_hash_find);
+        unsigned mask = hash_size_ - 1;
         unsigned hi = hash(obj, xkey);
-        for (int steps = 0; steps < TRANSACTION_HASHTABLE; ++steps) {
-            if (hashtable_[hi] <= hash_base_)
-                return nullptr;
-            unsigned tidx = hashtable_[hi] - hash_base_ - 1;
-            const TransItem* ti;
-            if (likely(tidx < tset_initial_capacity))
-                ti = &tset0_[tidx];
-            else
-                ti = &tset_[tidx / tset_chunk][tidx % tset_chunk];
+        while (item_index_used(hi)) {
+            const TransItem* ti = item_at((hashtable_[hi] & 0xFFFF) - 1);
             if (ti->owner() == obj && ti->key_ == xkey)
                 return const_cast<TransItem*>(ti);
-            if (!steps) {
-                TXP_INCREMENT(txp_hash_collision);
+            TXP_INCREMENT(txp_hash_probe);
 # if STO_DEBUG_HASH_COLLISIONS
-                if (local_random() <= uint32_t(0xFFFFFFFF * STO_DEBUG_HASH_COLLISIONS_FRACTION)) {
-                    std::ostringstream buf;
-                    TransItem fake_item(obj, xkey);
-                    buf << "$ STO hash collision: search " << fake_item << ", find " << *ti << '\n';
-                    std::cerr << buf.str();
-                }
+            if (local_random() <= uint32_t(0xFFFFFFFF * STO_DEBUG_HASH_COLLISIONS_FRACTION)) {
+                std::ostringstream buf;
+                TransItem fake_item(obj, xkey);
+                buf << "$ STO hash collision: search " << fake_item << ", find " << *ti << '\n';
+                std::cerr << buf.str();
+            }
 # endif
-            } else
-                TXP_INCREMENT(txp_hash_collision2);
-            hi = (hi + hash_step) % hash_size;
+            hi = (hi + 1) & mask;
         }
-#endif
-	// std::cout << "Hash not found!" << std::endl;
-	return find_item_scan(obj, xkey); 
-   }
+        return nullptr;
+    }
 
     bool preceding_duplicate_read(TransItem *it) const;
 
@@ -780,7 +772,7 @@ public:
         assert(state_ <= s_committing_locked);
         TXP_INCREMENT(txp_tco);
         if (!start_tid_)
-            start_tid_ = _TID;
+            start_tid_ = opacity_clock;
         if (!TransactionTid::try_check_opacity(start_tid_, v)
             && state_ < s_committing)
             return hard_check_opacity(&item, v);
@@ -799,7 +791,7 @@ public:
     bool check_opacity(TransactionTid::type v) {
         assert(state_ <= s_committing_locked);
         if (!start_tid_)
-            start_tid_ = _TID;
+            start_tid_ = opacity_clock;
         if (!TransactionTid::try_check_opacity(start_tid_, v)
             && state_ < s_committing)
             return hard_check_opacity(nullptr, v);
@@ -807,7 +799,7 @@ public:
     }
 
     bool check_opacity() {
-        return check_opacity(_TID);
+        return check_opacity(opacity_clock);
     }
 
     // committing
@@ -816,12 +808,64 @@ public:
         assert(state_ == s_committing_locked || state_ == s_committing);
 #endif
         if (!commit_tid_)
-            commit_tid_ = fetch_and_add(&_TID, TransactionTid::increment_value);
+            commit_tid_ = assign_commit_tid();
         return commit_tid_;
     }
 
+    // The commit TID will be greater than v. Called for every version the
+    // transaction locks for writing, so versions of a record increase.
+    void commit_after(tid_type v) const {
+        assert(!commit_tid_);
+        if (v > tid_floor_)
+            tid_floor_ = v;
+    }
+
     inline tid_type compute_tictoc_commit_ts() const;
 
+    // MVCC snapshot: exactly the commits with TIDs below the snapshot TID
+    // are visible, i.e. those of epochs before the one the snapshot was
+    // taken in. Taken on first use and held until the transaction ends.
+    tid_type snapshot_tid() const {
+        if (!snapshot_tid_)
+            snapshot_tid_ = global_epochs.recent_tid;
+        return snapshot_tid_;
+    }
+    // Called when a read returns a value committed at or after the
+    // snapshot; such reads are validated.
+    void read_past_snapshot() {
+        past_snapshot_ = true;
+    }
+    // true if everything read at the snapshot can be trusted without
+    // validation: the transaction holds a snapshot, read nothing newer and
+    // writes nothing
+    bool read_only_at_snapshot() const {
+        return snapshot_tid_ && !past_snapshot_ && !any_writes_;
+    }
+    // true in transactions started by start_readonly_snapshot(). MVCC data
+    // structures serve their reads from the snapshot without adding items;
+    // others track reads as usual and are validated at commit.
+    bool readonly_snapshot() const {
+        return readonly_snapshot_;
+    }
+
+    // Starts a transaction that only reads, at a snapshot taken from
+    // global_epochs.recent_tid. The snapshot is published so that MVCC
+    // history it may need is kept: the epoch advancer keeps
+    // min_snapshot_tid at or below the recent_tid it replaces, so the
+    // snapshot is safe once recent_tid is unchanged after publishing it.
+    void start_readonly_snapshot() {
+        start();
+        threadinfo_t& thr = tinfo[TThread::id()];
+        tid_type s;
+        do {
+            s = global_epochs.recent_tid;
+            thr.snapshot_tid = s;
+            fence();
+        } while (global_epochs.recent_tid != s);
+        snapshot_tid_ = s;
+        readonly_snapshot_ = true;
+    }
+
     template <typename VersImpl>
     void set_version(VersionBase<VersImpl>& version, typename VersionBase<VersImpl>::type flags = 0) const {
         assert(state_ == s_committing_locked || state_ == s_committing);
@@ -941,13 +985,13 @@ private:
     };
 
     int threadid_;
-    uint16_t hash_base_;
     uint16_t first_write_;
     uint8_t state_;
     bool any_writes_;
 public:
     bool any_nonopaque_;
 private:
+    bool any_opaque_writes_;
     bool may_duplicate_items_;
     bool is_test_;
     bool restarted;
@@ -955,7 +999,13 @@ private:
     unsigned tset_size_;
     mutable tid_type start_tid_;
     mutable tid_type commit_tid_;
+    mutable tid_type tid_floor_; // see commit_after()
+    mutable tid_type last_commit_tid_;
+    epoch_type commit_epoch_;
     mutable tid_type tictoc_tid_; // commit tid reserved for TicToc
+    mutable tid_type snapshot_tid_;
+    bool past_snapshot_;
+    bool readonly_snapshot_;
 public:
     mutable TransactionBuffer buf_;
     mutable TransScratch scratch_;
@@ -970,12 +1020,17 @@ private:
     mutable tc_counter_type start_tsc_;
 #endif
     TransItem* tset_[tset_max_capacity / tset_chunk];
-#if TRANSACTION_HASHTABLE
-    uint16_t hashtable_[hash_size];
-#endif
+    // item index, active while hash_size_ != 0
+    uint32_t* hashtable_;
+    unsigned hash_size_;
+    unsigned hash_shift_;
+    unsigned hash_capacity_;
+    unsigned hash_gen_;
+    unsigned hash_hint_;
     TransItem tset0_[tset_initial_capacity];
 
     bool hard_check_opacity(TransItem* item, TransactionTid::type t);
+    tid_type assign_commit_tid() const;
     void stop(bool committed, unsigned* writes, unsigned nwrites);
 
     friend class TransProxy;
@@ -1014,6 +1069,12 @@ public:
         t->start();
     }
 
+    static void start_readonly_snapshot() {
+        Transaction* t = transaction();
+        always_assert(!t->in_progress());
+        t->start_readonly_snapshot();
+    }
+
 		static void delete_transaction() {
 				delete TThread::txn;
 				TThread::txn = nullptr;
@@ -1149,6 +1210,56 @@ private:
     //Transaction* base_;
 };
 
+// Base class for TObject types whose commit calls should not go through
+// virtual dispatch: T derives from TObjectBatched<T>. At commit, runs of
+// items owned by objects of type T are handed to one of the *_items
+// functions, which call T's functions directly.
+template <typename T>
+class TObjectBatched : public TObject {
+public:
+    TObjectBatched() {
+        batch_type_ = &type_tag;
+    }
+    TObjectBatched(const TObjectBatched&) : TObject() {
+        batch_type_ = &type_tag;
+    }
+
+    void prefetch_items(TransItem* const* first, TransItem* const* last) const override {
+        for (; first != last; ++first)
+            owner(*first)->T::prefetch(**first);
+    }
+    TransItem** lock_items(TransItem** first, TransItem** last, Transaction& txn) override {
+        for (; first != last; ++first)
+            if (!owner(*first)->T::lock(**first, txn))
+                break;
+        return first;
+    }
+    TransItem** check_items(TransItem** first, TransItem** last, Transaction& txn) override {
+        for (; first != last; ++first)
+            if (!owner(*first)->T::check(**first, txn))
+                break;
+        return first;
+    }
+    void install_items(TransItem** first, TransItem** last, Transaction& txn) override {
+        for (; first != last; ++first)
+            owner(*first)->T::install(**first, txn);
+    }
+    void cleanup_items(TransItem** first, TransItem** last, bool committed) override {
+        for (; first != last; ++first)
+            owner(*first)->T::cleanup(**first, committed);
+    }
+
+private:
+    static const char type_tag;
+
+    static T* owner(const TransItem* item) {
+        return static_cast<T*>(item->owner());
+    }
+};
+
+template <typename T>
+const char TObjectBatched<T>::type_tag = 0;
+
 class TransactionGuard {
   public:
     TransactionGuard() {
@@ -1185,6 +1296,12 @@ class TransactionLoopGuard {
     void start() {
         Sto::start_transaction();
     }
+    void start(bool readonly_snapshot) {
+        if (readonly_snapshot)
+            Sto::start_readonly_snapshot();
+        else
+            Sto::start_transaction();
+    }
     void silent_abort() {
         TThread::txn->silent_abort();
     }
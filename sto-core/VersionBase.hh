@@ -16,12 +16,12 @@ public:
     // Common layout definition
 
     // |-----VALUE-----|O|D|U|N|L|--MASK--|
-    //       52 bits    1 1 1 1 1  7 bits
+    //       49 bits    1 1 1 1 1  10 bits
 
-    static constexpr signed_type mask_width = 7;
+    static constexpr signed_type mask_width = TThread::id_bits;
 
     // bits holding thread id of the thread holding the exclusive lock
-    static constexpr type threadid_mask = type(0x7F);
+    static constexpr type threadid_mask = (type(1) << mask_width) - 1;
     // the exclusive lock bit, used for write locks
     static constexpr type lock_bit = type(0x1 << mask_width);
     // Used for data structures that don't use opacity. When they increment
@@ -39,6 +39,19 @@ public:
     // start of te actual version (Tid) value
     static constexpr type increment_value = type(0x1 << (mask_width + 5));
 
+    // Commit TIDs (Transaction::commit_tid) split the value into the epoch
+    // of the commit and a sequence number within that epoch:
+    // |--EPOCH--|--SEQUENCE--|--FLAGS+MASK--|
+    //   24 bits     25 bits       15 bits
+    static constexpr int epoch_shift = 40;
+    // the smallest TID of epoch e
+    static constexpr type epoch_tid(uint64_t e) {
+        return type(e) << epoch_shift;
+    }
+    static uint64_t tid_epoch(type v) {
+        return v >> epoch_shift;
+    }
+
     static bool is_locked(type v) {
         return (v & lock_bit) != 0;
     }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <tuple>
+
 #include "VersionBase.hh"
 
 namespace ver_sel {
@@ -68,6 +70,18 @@ private:
     version_type vers_;
 };
 
+// Column layout of a row type. Row types are stored row-major by default;
+// a spec with "@layout: column" makes the codegen emit a specialization
+// that lists the row's column groups (its version cells), each as a struct
+// with store(group, row) and load(row, group) to move it in and out of a
+// row. Indexes keep a column-major copy of such rows (see
+// bench::column_store).
+template <typename RowType>
+struct ColGroups {
+    static constexpr int num_groups = 0;
+    typedef std::tuple<> group_types;
+};
+
 }; // namespace ver_sel
 
 // This is the actual "value type" to be put into the index
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <cstdlib>
@@ -129,6 +130,11 @@ bool type_check_single(StructSpec &result) {
     assert(group_fname_set.size() == field_name_set.size());
     assert(group_fname_set.size() == gfields);
 
+    if (result.layout != "row" && result.layout != "column") {
+        std::cerr << "Error: Struct " << struct_name << " has an unknown layout \"" << result.layout << "\"" << std::endl;
+        return false;
+    }
+
     return true;
 }
 
@@ -228,6 +234,47 @@ void generate_code_single_versel(StructSpec &result) {
 }
 
 
+// Column groups of a struct with "@layout: column" (see ColGroups in
+// VersionSelector.hh): group i holds the fields of version cell i.
+void generate_code_single_colgroups(StructSpec &result) {
+    std::stringstream ss;
+    const std::string idt = "    ";
+    auto& struct_name = result.struct_name;
+    auto& groups = result.groups;
+
+    std::map<std::string, FieldType> field_types;
+    for (auto& f : result.fields)
+        field_types[f.name] = f.t;
+
+    ss << "template <>" << std::endl;
+    ss << "struct ColGroups<" << struct_name << "> {" << std::endl;
+    ss << idt << "static constexpr int num_groups = " << groups.size() << ';' << std::endl << std::endl;
+
+    for (size_t gidx = 0; gidx < groups.size(); ++gidx) {
+        ss << idt << "struct group" << gidx << " {" << std::endl;
+        for (auto& fn : groups[gidx])
+            ss << idt << idt << cxx_type_name(field_types[fn]) << ' ' << fn << ';' << std::endl;
+        ss << idt << "};" << std::endl;
+    }
+    ss << idt << "typedef std::tuple<";
+    for (size_t gidx = 0; gidx < groups.size(); ++gidx)
+        ss << (gidx ? ", " : "") << "group" << gidx;
+    ss << "> group_types;" << std::endl << std::endl;
+
+    for (size_t gidx = 0; gidx < groups.size(); ++gidx) {
+        ss << idt << "static void store(group" << gidx << "& dst, const " << struct_name << "& src) {" << std::endl;
+        for (auto& fn : groups[gidx])
+            ss << idt << idt << "dst." << fn << " = src." << fn << ';' << std::endl;
+        ss << idt << '}' << std::endl;
+        ss << idt << "static void load(" << struct_name << "& dst, const group" << gidx << "& src) {" << std::endl;
+        for (auto& fn : groups[gidx])
+            ss << idt << idt << "dst." << fn << " = src." << fn << ';' << std::endl;
+        ss << idt << '}' << std::endl;
+    }
+
+    ss << "};" << std::endl << std::endl;
+    std::cout << ss.str() << std::endl;
+}
 
 void generate_code(std::vector<StructSpec> &result) {
     std::cout << "#pragma once" << std::endl << std::endl;
@@ -243,6 +290,8 @@ void generate_code(std::vector<StructSpec> &result) {
     std::cout << std::endl << "namespace ver_sel {" << std::endl << std::endl;
     for (auto &spec : result) {
         generate_code_single_versel(spec);
+        if (spec.layout == "column")
+            generate_code_single_colgroups(spec);
     }
     std::cout << "}; // namespace ver_sel" << std::endl;
 }
@@ -39,6 +39,7 @@
 	std::string struct_name;
 	std::vector<Field> fields;
 	std::vector<std::vector<std::string>> groups;
+	std::string layout;
   };
 }
 
@@ -61,7 +62,7 @@
 %define api.value.type variant
 %define parse.assert
 
-%token NAME FIELDS GROUPS LBRACE RBRACE COLON COMMA AT
+%token NAME FIELDS GROUPS LAYOUT LBRACE RBRACE COLON COMMA AT
 %token BIGINT SMALLINT FLOAT VARCHAR CHAR LPAREN RPAREN
 %token END 0 "end of file"
 %token <std::string> IDENTIFIER
@@ -77,6 +78,7 @@
 %type <std::vector<std::vector<std::string>>> group_list
 %type <std::vector<std::vector<std::string>>> group_spec
 %type <std::string> name_spec
+%type <std::string> layout_spec
 %type <StructSpec> spec
 %type <std::vector<StructSpec>> spec_list
 
@@ -101,8 +103,8 @@ spec_list
   ;
 
 spec
-  : AT AT AT name_spec field_spec group_spec AT AT AT 
-	{ $$ = { $4, $5, $6 }; }
+  : AT AT AT name_spec field_spec group_spec layout_spec AT AT AT
+	{ $$ = { $4, $5, $6, $7 }; }
   ;
 
 name_spec
@@ -120,6 +122,13 @@ group_spec
 	{ $$ = $4; }
   ;
 
+layout_spec
+  : %empty
+	{ $$ = "row"; }
+  | LAYOUT COLON IDENTIFIER
+	{ $$ = $3; }
+  ;
+
 field_list
   : field
 	{ $$ = std::vector<Field>(1, $1); }
@@ -807,19 +807,14 @@ struct HotspotRW : public DSTester<DS> {
     typedef typename DSTester<DS>::container_type container_type;
     typedef std::vector<RWOperation> query_type;
     typedef std::vector<query_type> workload_type;
-    HotspotRW() {
-        for (int i = 0; i < MAX_THREADS; ++i) {
-            progress[i].reserve(100000);
-            optimistic_rate[i].reserve(100000);
-        }
-    }
+    HotspotRW() = default;
     void run(int me, uint64_t start_tsc) override;
     bool prepopulate() override;
     void report() override;
 
     std::vector<workload_type> workloads;
-    std::vector<uint64_t> progress[MAX_THREADS];
-    std::vector<double> optimistic_rate[MAX_THREADS];
+    std::vector<std::vector<uint64_t>> progress;
+    std::vector<std::vector<double>> optimistic_rate;
     virtual void per_thread_workload_init(int thread_id);
 
 #if DEBUG_SKEW
@@ -902,6 +897,12 @@ template <int DS>
 bool HotspotRW<DS>::prepopulate() {
     std::cout << "Generating workload..." << std::endl;
     workloads.resize(nthreads);
+    progress.resize(nthreads);
+    optimistic_rate.resize(nthreads);
+    for (int i = 0; i < nthreads; ++i) {
+        progress[i].reserve(100000);
+        optimistic_rate[i].reserve(100000);
+    }
 
     std::vector<std::thread> thrs;
     for (int i = 0; i < nthreads; ++i)
@@ -2004,10 +2005,12 @@ int main(int argc, char *argv[]) {
     help(argv[0]);
   }
 
-  if (nthreads > MAX_THREADS) {
-    printf("Asked for %d threads but MAX_THREADS is %d\n", nthreads, MAX_THREADS);
+  if (nthreads > TThread::max_threads_limit) {
+    printf("Asked for %d threads but the limit is %d\n", nthreads, TThread::max_threads_limit);
     exit(1);
   }
+  if (nthreads > TThread::max_threads())
+    TThread::set_max_threads(nthreads);
 
   if (!strcmp(tests[test].name, "zipfrw") && (zipf_skew < 0.0 || zipf_skew >= 1000.0)) {
     printf("Please enter a skew parameter between 0 and 1000 (currently entered %f)\n", zipf_skew);
@@ -111,7 +111,7 @@ void *randomRWs(void *p) {
     bool done = false;
     while (1) {
       try{
-      uint32_t seed = transseed*3 + (uint32_t)me*N*7 + (uint32_t)GLOBAL_SEED*MAX_THREADS*N*11;
+      uint32_t seed = transseed*3 + (uint32_t)me*N*7 + (uint32_t)GLOBAL_SEED*TThread::default_max_threads*N*11;
       auto seedlow = seed & 0xffff;
       auto seedhigh = seed >> 16;
       Rand transgen(seed, seedlow << 16 | seedhigh);
@@ -382,10 +382,12 @@ int main(int argc, char *argv[]) {
     help(argv[0]);
   }
   
-  if (nthreads > MAX_THREADS) {
-    printf("Asked for %d threads but MAX_THREADS is %d\n", nthreads, MAX_THREADS);
+  if (nthreads > TThread::max_threads_limit) {
+    printf("Asked for %d threads but the limit is %d\n", nthreads, TThread::max_threads_limit);
     exit(1);
   }
+  if (nthreads > TThread::max_threads())
+    TThread::set_max_threads(nthreads);
 
   struct timeval tv1,tv2;
   struct rusage ru1,ru2;
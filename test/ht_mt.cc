@@ -33,7 +33,7 @@ void run(ds& h) {
     std::uniform_int_distribution<long> slotdist(0, MAX_VALUE);
     for (int i = 0; i < NTRANS; ++i) {
         auto transseed = i;
-        uint32_t seed = transseed*3;// + (uint32_t)me*NTRANS*7 + (uint32_t)GLOBAL_SEED*MAX_THREADS*NTRANS*11;
+        uint32_t seed = transseed*3;// + (uint32_t)me*NTRANS*7 + (uint32_t)GLOBAL_SEED*TThread::default_max_threads*NTRANS*11;
         auto seedlow = seed & 0xffff;
         auto seedhigh = seed >> 16;
         Rand transgen(seed, seedlow << 16 | seedhigh);
@@ -65,7 +65,7 @@ void run(T* q, int me) {
         while (1) {
         Sto::start_transaction();
         try {
-            uint32_t seed = transseed*3 + (uint32_t)me*ntrans*7 + (uint32_t)global_seed*MAX_THREADS*ntrans*11;
+            uint32_t seed = transseed*3 + (uint32_t)me*ntrans*7 + (uint32_t)global_seed*TThread::default_max_threads*ntrans*11;
             auto seedlow = seed & 0xffff;
             auto seedhigh = seed >> 16;
             Rand transgen(seed, seedlow << 16 | seedhigh);
@@ -42,7 +42,7 @@ void run(T* q, int me) {
         try {
             tr->ops.clear();
             
-            uint32_t seed = transseed*3 + (uint32_t)me*NTRANS*7 + (uint32_t)GLOBAL_SEED*MAX_THREADS*NTRANS*11;
+            uint32_t seed = transseed*3 + (uint32_t)me*NTRANS*7 + (uint32_t)GLOBAL_SEED*TThread::default_max_threads*NTRANS*11;
             auto seedlow = seed & 0xffff;
             auto seedhigh = seed >> 16;
             Rand transgen(seed, seedlow << 16 | seedhigh);
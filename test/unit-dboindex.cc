@@ -1,3 +1,5 @@
+#include <thread>
+
 #include "DB_index.hh"
 #include "DB_structs.hh"
 #include "DB_params.hh"
@@ -19,6 +21,10 @@ struct key_type {
     uint64_t id;
 
     explicit key_type(uint64_t key) : id(bench::bswap(key)) {}
+    explicit key_type(const lcdf::Str& mt_key) {
+        assert(mt_key.length() == sizeof(*this));
+        memcpy(this, mt_key.data(), sizeof(*this));
+    }
     operator lcdf::Str() const {
         return lcdf::Str((const char *)this, sizeof(*this));
     }
@@ -29,6 +35,58 @@ struct key_type {
 using CoarseIndex = bench::ordered_index<key_type, coarse_grained_row, db_params::db_default_params>;
 using FineIndex = bench::ordered_index<key_type, example_row, db_params::db_default_params>;
 
+// indexes rows by bb
+struct bb_extract {
+    key_type operator()(const key_type&, const coarse_grained_row& row) const {
+        return key_type(row.bb);
+    }
+};
+using BbIndex = bench::secondary_index<key_type, CoarseIndex, bb_extract>;
+
+// a row with a column layout, as the codegen emits it for "@layout: column"
+struct column_row {
+    enum class NamedColumn : int { qty = 0, amount, note };
+
+    int64_t qty;
+    int64_t amount;
+    int64_t note;
+};
+
+namespace ver_sel {
+
+template <>
+struct ColGroups<column_row> {
+    static constexpr int num_groups = 2;
+
+    struct group0 {
+        int64_t qty;
+        int64_t amount;
+    };
+    struct group1 {
+        int64_t note;
+    };
+    typedef std::tuple<group0, group1> group_types;
+
+    static void store(group0& dst, const column_row& src) {
+        dst.qty = src.qty;
+        dst.amount = src.amount;
+    }
+    static void load(column_row& dst, const group0& src) {
+        dst.qty = src.qty;
+        dst.amount = src.amount;
+    }
+    static void store(group1& dst, const column_row& src) {
+        dst.note = src.note;
+    }
+    static void load(column_row& dst, const group1& src) {
+        dst.note = src.note;
+    }
+};
+
+}; // namespace ver_sel
+
+using ColumnIndex = bench::ordered_index<key_type, column_row, db_params::db_default_params>;
+
 void init_cindex(CoarseIndex& ci) {
     for (uint64_t i = 1; i <= 10; ++i)
         ci.nontrans_put(key_type(i), coarse_grained_row(i, i, i));
@@ -184,6 +242,66 @@ void test_coarse_conflict1() {
     printf("pass %s\n", __FUNCTION__);
 }
 
+void test_coarse_select_rows() {
+    typedef CoarseIndex::NamedColumn nc;
+    CoarseIndex ci;
+    ci.thread_init();
+
+    init_cindex(ci);
+    bool success, found;
+    uintptr_t row;
+    const coarse_grained_row *value;
+
+    {
+        // results follow the order of the keys; absent keys are observed
+        std::vector<key_type> keys = {key_type(3), key_type(1), key_type(20), key_type(7)};
+        CoarseIndex::sel_return_type results[4];
+        TestTransaction t1(0);
+        assert(ci.select_rows(keys.data(), 4, {{nc::aa, false}}, results));
+        for (int i = 0; i != 4; ++i) {
+            std::tie(success, found, row, value) = results[i];
+            assert(success && found == (i != 2));
+        }
+        assert(std::get<3>(results[0])->aa == 3);
+        assert(std::get<3>(results[1])->aa == 1);
+        assert(std::get<3>(results[3])->aa == 7);
+
+        TestTransaction t2(1);
+        coarse_grained_row row_value(20, 20, 20);
+        std::tie(success, found) = ci.insert_row(key_type(20), &row_value);
+        assert(success && !found);
+        assert(t2.try_commit());
+
+        t1.use();
+        assert(!t1.try_commit());
+    }
+
+    {
+        // more keys than one batch, selected for update
+        std::vector<key_type> keys;
+        for (uint64_t i = 40; i != 0; --i)
+            keys.emplace_back(key_type(i));
+        std::vector<CoarseIndex::sel_return_type> results(keys.size());
+        TestTransaction t(0);
+        assert(ci.select_rows(keys.data(), int(keys.size()), bench::RowAccess::UpdateValue, results.data()));
+        for (uint64_t i = 40; i != 0; --i) {
+            std::tie(success, found, row, value) = results[40 - i];
+            assert(success && found == (i <= 10 || i == 20));
+            if (found) {
+                assert(value->aa == i);
+                auto new_row = Sto::tx_alloc(value);
+                new_row->bb = i + 1;
+                ci.update_row(row, new_row);
+            }
+        }
+        assert(t.try_commit());
+        for (uint64_t i = 1; i <= 10; ++i)
+            assert(ci.nontrans_get(key_type(i))->bb == i + 1);
+    }
+
+    printf("pass %s\n", __FUNCTION__);
+}
+
 void test_fine_conflict0() {
     typedef FineIndex::NamedColumn nc;
     FineIndex fi;
@@ -284,14 +402,497 @@ void test_fine_conflict2() {
     printf("pass %s\n", __FUNCTION__);
 }
 
+void test_fine_scan_filter() {
+    typedef FineIndex::NamedColumn nc;
+    FineIndex fi;
+    fi.thread_init();
+
+    // d_tax (cell 1) is 10 for even keys and 20 for odd keys
+    for (uint64_t i = 1; i <= 10; ++i) {
+        example_row row;
+        row.d_ytd = 1000 * i;
+        row.d_tax = i % 2 ? 20 : 10;
+        row.d_date = row.d_payment_cnt = row.d_next_oid = 0;
+        fi.nontrans_put(key_type(i), row);
+    }
+
+    bool success, found;
+    uintptr_t row;
+    const example_row *value;
+    auto filter = [] (const key_type&, const example_row& r) {
+        return r.d_tax == 10;
+    };
+    auto update_ytd = [&] (uint64_t k) {
+        TestTransaction t(1);
+        std::tie(success, found, row, value) = fi.select_row(key_type(k), {{nc::ytd, true}});
+        assert(success && found);
+        auto new_row = Sto::tx_alloc(value);
+        new_row->d_ytd += 1;
+        fi.update_row(row, new_row);
+        assert(t.try_commit());
+    };
+
+    {
+        // rows the filter rejects are not tracked by their projected cells
+        uint64_t total = 0;
+        int n = 0;
+        auto callback = [&] (const key_type&, const example_row& r) {
+            total += r.d_ytd;
+            ++n;
+            return true;
+        };
+        TestTransaction t1(0);
+        success = fi.template range_scan<decltype(filter), decltype(callback), false>(
+                key_type(1), key_type(10), filter, callback, {{nc::tax, false}}, {{nc::ytd, false}});
+        assert(success && n == 4 && total == 2000 + 4000 + 6000 + 8000);
+
+        update_ytd(3);
+
+        t1.use();
+        assert(t1.try_commit());
+    }
+
+    {
+        // but accepted rows are
+        auto callback = [&] (const key_type&, const example_row&) {
+            return true;
+        };
+        TestTransaction t1(0);
+        success = fi.template range_scan<decltype(filter), decltype(callback), false>(
+                key_type(1), key_type(10), filter, callback, {{nc::tax, false}}, {{nc::ytd, false}});
+        assert(success);
+
+        update_ytd(4);
+
+        t1.use();
+        assert(!t1.try_commit());
+    }
+
+    {
+        // a row that starts to pass the filter is a conflict
+        auto callback = [&] (const key_type&, const example_row&) {
+            return true;
+        };
+        TestTransaction t1(0);
+        success = fi.template range_scan<decltype(filter), decltype(callback), false>(
+                key_type(1), key_type(10), filter, callback, {{nc::tax, false}}, {{nc::ytd, false}});
+        assert(success);
+
+        TestTransaction t2(1);
+        std::tie(success, found, row, value) = fi.select_row(key_type(5), {{nc::tax, true}});
+        assert(success && found);
+        auto new_row = Sto::tx_alloc(value);
+        new_row->d_tax = 10;
+        fi.update_row(row, new_row);
+        assert(t2.try_commit());
+
+        t1.use();
+        assert(!t1.try_commit());
+    }
+
+    printf("pass %s\n", __FUNCTION__);
+}
+
+void test_coarse_secondary_index() {
+    typedef CoarseIndex::NamedColumn nc;
+    CoarseIndex ci;
+    BbIndex bi(ci);
+    ci.thread_init();
+
+    init_cindex(ci);
+    for (uint64_t i = 1; i <= 10; ++i)
+        assert(bi.nontrans_get(key_type(i)));
+    bool success, found;
+    uintptr_t row;
+    const coarse_grained_row *value;
+
+    {
+        // bb of row 3 changes, row 5 is deleted and row 20 inserted
+        TestTransaction t(0);
+        std::tie(success, found, row, value) = bi.select_base_row(key_type(3), {{nc::bb, true}});
+        assert(success && found);
+        assert(value->aa == 3);
+        auto new_row = Sto::tx_alloc(value);
+        new_row->bb = 103;
+        assert(ci.update_row(row, new_row));
+
+        std::tie(success, found) = ci.delete_row(key_type(5));
+        assert(success && found);
+        coarse_grained_row row20(20, 120, 20);
+        std::tie(success, found) = ci.insert_row(key_type(20), &row20);
+        assert(success && !found);
+
+        assert(t.try_commit());
+    }
+
+    {
+        TestTransaction t(0);
+        std::tie(success, found, row, value) = bi.select_base_row(key_type(103), bench::RowAccess::ObserveValue);
+        assert(success && found && value->aa == 3 && value->bb == 103);
+        std::tie(success, found, row, value) = bi.select_base_row(key_type(3), bench::RowAccess::ObserveValue);
+        assert(success && !found);
+        assert(t.try_commit());
+    }
+
+    auto entry = bi.nontrans_get(key_type(103));
+    assert(entry && CoarseIndex::row_key(entry->rid).id == key_type(3).id);
+    assert(!bi.nontrans_get(key_type(3)));
+    assert(!bi.nontrans_get(key_type(5)));
+    entry = bi.nontrans_get(key_type(120));
+    assert(entry && CoarseIndex::row_key(entry->rid).id == key_type(20).id);
+
+    {
+        // index keys are unique
+        TestTransaction t(0);
+        std::tie(success, found, row, value) = ci.select_row(key_type(1), bench::RowAccess::UpdateValue);
+        assert(success && found);
+        auto new_row = Sto::tx_alloc(value);
+        new_row->bb = 2;
+        assert(!ci.update_row(row, new_row));
+        t.get_tx().silent_abort();
+    }
+    assert(bi.nontrans_get(key_type(1)) && bi.nontrans_get(key_type(2)));
+
+    {
+        // moving an index entry conflicts with an absent lookup of its new key
+        TestTransaction t1(1);
+        std::tie(success, found, row, value) = bi.select_base_row(key_type(107), bench::RowAccess::ObserveValue);
+        assert(success && !found);
+
+        TestTransaction t2(2);
+        std::tie(success, found, row, value) = ci.select_row(key_type(7), bench::RowAccess::UpdateValue);
+        assert(success && found);
+        auto new_row = Sto::tx_alloc(value);
+        new_row->bb = 107;
+        assert(ci.update_row(row, new_row));
+        assert(t2.try_commit());
+
+        t1.use();
+        assert(!t1.try_commit());
+    }
+    assert(!bi.nontrans_get(key_type(7)) && bi.nontrans_get(key_type(107)));
+
+    printf("pass %s\n", __FUNCTION__);
+}
+
+void test_coarse_deferred_remove() {
+    typedef CoarseIndex::NamedColumn nc;
+    CoarseIndex ci;
+    ci.thread_init();
+
+    init_cindex(ci);
+    bool success, found;
+    uintptr_t row;
+    const coarse_grained_row *value;
+
+    {
+        TestTransaction t(0);
+        for (uint64_t i = 2; i <= 4; ++i) {
+            std::tie(success, found) = ci.delete_row(key_type(i));
+            assert(success && found);
+        }
+        assert(t.try_commit());
+    }
+
+    {
+        // deleted rows stay in the tree until reclaimed, but are absent
+        TestTransaction t(0);
+        std::tie(success, found, row, value) = ci.select_row(key_type(3), bench::RowAccess::ObserveValue);
+        assert(success && !found);
+        std::tie(success, found) = ci.delete_row(key_type(4));
+        assert(success && !found);
+        int n = 0;
+        auto callback = [&] (const key_type&, const coarse_grained_row&) {
+            ++n;
+            return true;
+        };
+        success = ci.template range_scan<decltype(callback), false>(
+                key_type(1), key_type(10), callback, {{nc::aa, false}});
+        assert(success && n == 6);
+
+        // nor do they count toward a scan's limit
+        uint64_t first = 0;
+        auto first_callback = [&] (const key_type& k, const coarse_grained_row&) {
+            first = bench::bswap(k.id);
+            return true;
+        };
+        success = ci.template range_scan<decltype(first_callback), false>(
+                key_type(2), key_type(10), first_callback, bench::RowAccess::ObserveExists, true, 1);
+        assert(success && first == 5);
+        assert(t.try_commit());
+    }
+    assert(!ci.nontrans_get(key_type(2)));
+
+    {
+        // an insert replaces a deleted row, conflicting with absent reads of it
+        TestTransaction t1(0);
+        std::tie(success, found, row, value) = ci.select_row(key_type(3), bench::RowAccess::ObserveValue);
+        assert(success && !found);
+
+        TestTransaction t2(0);
+        coarse_grained_row row3(30, 30, 30);
+        std::tie(success, found) = ci.insert_row(key_type(3), &row3);
+        assert(success && !found);
+        assert(t2.try_commit());
+
+        t1.use();
+        std::tie(success, found) = ci.delete_row(key_type(1));
+        assert(success && found);
+        assert(!t1.try_commit());
+    }
+    assert(ci.nontrans_get(key_type(3)) && ci.nontrans_get(key_type(3))->aa == 30);
+    {
+        // an aborted insert is retired too
+        TestTransaction t(0);
+        coarse_grained_row row50(50, 50, 50);
+        std::tie(success, found) = ci.insert_row(key_type(50), &row50);
+        assert(success && !found);
+        t.get_tx().silent_abort();
+    }
+    assert(!ci.nontrans_get(key_type(50)));
+
+    // The retired rows (2, 4, the old 3 and the aborted 50) go to RCU with
+    // the first retire of a later epoch, are unlinked when that epoch ends
+    // and freed an epoch later.
+    auto advance_epoch = [] {
+        auto& ge = Transaction::global_epochs;
+        ge.global_epoch = ge.active_epoch = ge.global_epoch + 1;
+    };
+    auto live = bench::slab_pool::stats().live();
+    advance_epoch();
+    {
+        TestTransaction t(0);
+        std::tie(success, found) = ci.delete_row(key_type(6));
+        assert(success && found);
+        assert(t.try_commit());
+    }
+    for (int i = 0; i != 2; ++i) {
+        advance_epoch();
+        TestTransaction t(0);
+        assert(t.try_commit());
+    }
+    // five rows and their garbage list
+    assert(bench::slab_pool::stats().live() == live - 6);
+    assert(ci.nontrans_get(key_type(3)) && ci.nontrans_get(key_type(3))->aa == 30);
+    for (uint64_t i : {2, 4, 6, 50})
+        assert(!ci.nontrans_get(key_type(i)));
+
+    printf("pass %s\n", __FUNCTION__);
+}
+
+void test_coarse_range_conflict() {
+    typedef CoarseIndex::NamedColumn nc;
+    CoarseIndex ci;
+    ci.thread_init();
+
+    init_cindex(ci);
+    bool success, found;
+    uintptr_t row;
+    const coarse_grained_row *value;
+    int n;
+    auto callback = [&] (const key_type&, const coarse_grained_row&) {
+        ++n;
+        return true;
+    };
+    auto insert = [&] (uint64_t k) {
+        TestTransaction t(1);
+        coarse_grained_row r(k, k, k);
+        std::tie(success, found) = ci.insert_row(key_type(k), &r);
+        assert(success && !found);
+        assert(t.try_commit());
+    };
+    auto update = [&] (uint64_t k) {
+        std::tie(success, found, row, value) = ci.select_row(key_type(k), {{nc::cc, true}});
+        assert(success && found);
+        auto new_row = Sto::tx_alloc(value);
+        new_row->cc += 1;
+        ci.update_row(row, new_row);
+    };
+
+    {
+        // inserts into the scanned leaf, but outside the range, do not abort
+        TestTransaction t1(0);
+        n = 0;
+        success = ci.template range_scan<decltype(callback), false>(
+                key_type(20), key_type(30), callback, {{nc::aa, false}});
+        assert(success && n == 0);
+        update(1);
+        insert(30);
+        insert(19);
+        t1.use();
+        assert(t1.try_commit());
+    }
+    {
+        TestTransaction t1(0);
+        n = 0;
+        success = ci.template range_scan<decltype(callback), false>(
+                key_type(20), key_type(30), callback, {{nc::aa, false}});
+        assert(success && n == 0);
+        update(1);
+        insert(25);
+        t1.use();
+        assert(!t1.try_commit());
+    }
+    {
+        // a scan cut short by its limit covers the keys it reached; the
+        // transaction's own inserts in the range are no conflict
+        TestTransaction t1(0);
+        n = 0;
+        success = ci.template range_scan<decltype(callback), true>(
+                key_type(30), key_type(0), callback, {{nc::aa, false}}, true, 2);
+        assert(success && n == 2);
+        coarse_grained_row r(29, 29, 29);
+        std::tie(success, found) = ci.insert_row(key_type(29), &r);
+        assert(success && !found);
+        insert(11);
+        t1.use();
+        assert(t1.try_commit());
+    }
+    {
+        // absent keys are ranges of one key
+        TestTransaction t1(0);
+        std::tie(success, found, row, value) = ci.select_row(key_type(40), {{nc::aa, false}});
+        assert(success && !found);
+        update(1);
+        insert(41);
+        t1.use();
+        assert(t1.try_commit());
+    }
+
+    printf("pass %s\n", __FUNCTION__);
+}
+
+void test_column_layout() {
+    typedef ColumnIndex::NamedColumn nc;
+    ColumnIndex ci;
+    ci.thread_init();
+    assert(!CoarseIndex().columns());
+
+    for (uint64_t i = 1; i <= 10; ++i)
+        ci.nontrans_put(key_type(i), column_row{int64_t(i), int64_t(10 * i), 0});
+    bool success, found;
+    uintptr_t row;
+    const column_row *value;
+
+    {
+        TestTransaction t(0);
+        column_row r20{20, 200, 1};
+        std::tie(success, found) = ci.insert_row(key_type(20), &r20);
+        assert(success && !found);
+        std::tie(success, found, row, value) = ci.select_row(key_type(3), {{nc::amount, true}});
+        assert(success && found);
+        auto new_row = Sto::tx_alloc(value);
+        new_row->amount = 1000;
+        ci.update_row(row, new_row);
+        std::tie(success, found) = ci.delete_row(key_type(5));
+        assert(success && found);
+        assert(t.try_commit());
+    }
+    {
+        // an aborted insert never shows in the columns
+        TestTransaction t(0);
+        column_row r30{30, 300, 1};
+        std::tie(success, found) = ci.insert_row(key_type(30), &r30);
+        assert(success && !found);
+        t.get_tx().silent_abort();
+    }
+
+    // scans read one group of the committed rows
+    const ColumnIndex::column_store_type *cs = ci.columns();
+    int64_t qty = 0, amount = 0;
+    int n = 0;
+    cs->scan<0>([&] (const ColumnIndex::column_store_type::group_type<0>& g) {
+        qty += g.qty;
+        amount += g.amount;
+        ++n;
+    });
+    assert(n == 10 && qty == 55 - 5 + 20 && amount == 550 - 50 - 30 + 1000 + 200);
+    int64_t notes = 0;
+    cs->scan<1>([&] (const ColumnIndex::column_store_type::group_type<1>& g) {
+        notes += g.note;
+    });
+    assert(notes == 1);
+
+    // point reads still go through the index, and find the row's slot
+    {
+        TestTransaction t(0);
+        std::tie(success, found, row, value) = ci.select_row(key_type(3), bench::RowAccess::ObserveValue);
+        assert(success && found);
+        column_row copy;
+        cs->load(ColumnIndex::column_slot_of(row), copy);
+        assert(copy.qty == 3 && copy.amount == 1000 && copy.note == 0);
+        assert(t.try_commit());
+    }
+
+    printf("pass %s\n", __FUNCTION__);
+}
+
+void test_bulk_load() {
+    typedef CoarseIndex::NamedColumn nc;
+    CoarseIndex ci;
+    BbIndex bi(ci);
+    bench::load_report report;
+
+    // two loaders split the keys; index keys descend as base keys ascend
+    std::vector<std::thread> threads;
+    for (int id = 0; id != 2; ++id) {
+        threads.emplace_back([&ci, id] {
+            TThread::set_id(id);
+            ci.thread_init();
+            CoarseIndex::bulk_loader loader(ci);
+            for (uint64_t i = 1 + 500 * uint64_t(id); i != 501 + 500 * uint64_t(id); ++i)
+                loader.add(key_type(i), coarse_grained_row(i, 2000 - i, 0));
+            assert(loader.finish() == 500);
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+    assert(report.rows_loaded() == 2000);
+
+    for (uint64_t i = 1; i <= 1000; ++i) {
+        assert(ci.nontrans_get(key_type(i)) && ci.nontrans_get(key_type(i))->aa == i);
+        auto entry = bi.nontrans_get(key_type(2000 - i));
+        assert(entry && CoarseIndex::row_key(entry->rid).id == key_type(i).id);
+    }
+
+    // loaded rows are ordinary rows
+    bool success, found;
+    uintptr_t row;
+    const coarse_grained_row *value;
+    {
+        TestTransaction t(0);
+        std::tie(success, found, row, value) = bi.select_base_row(key_type(1990), {{nc::cc, true}});
+        assert(success && found && value->aa == 10);
+        auto new_row = Sto::tx_alloc(value);
+        new_row->cc = 1;
+        assert(ci.update_row(row, new_row));
+        coarse_grained_row r0(0, 2000, 0);
+        std::tie(success, found) = ci.insert_row(key_type(0), &r0);
+        assert(success && !found);
+        assert(t.try_commit());
+    }
+    assert(ci.nontrans_get(key_type(10))->cc == 1);
+    assert(bi.nontrans_get(key_type(2000)));
+
+    printf("pass %s\n", __FUNCTION__);
+}
+
 int main() {
+    // first: advancing the epoch reclaims rows retired by earlier tests
+    test_coarse_deferred_remove();
     test_coarse_basic();
     test_coarse_read_my_split();
     test_coarse_conflict0();
     test_coarse_conflict1();
+    test_coarse_select_rows();
+    test_coarse_secondary_index();
+    test_coarse_range_conflict();
     test_fine_conflict0();
     test_fine_conflict1();
     test_fine_conflict2();
+    test_fine_scan_filter();
+    test_column_layout();
+    test_bulk_load();
     printf("All tests pass!\n");
     return 0;
 }
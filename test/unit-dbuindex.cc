@@ -0,0 +1,302 @@
+#undef NDEBUG
+#include <cassert>
+#include <thread>
+#include <vector>
+
+#include "DB_index.hh"
+#include "DB_params.hh"
+
+struct simple_row {
+    uint64_t v;
+
+    simple_row() : v() {}
+    explicit simple_row(uint64_t x) : v(x) {}
+};
+
+using UIndex = bench::unordered_index<uint64_t, simple_row, db_params::db_default_params>;
+
+static simple_row *new_row(uint64_t v) {
+    simple_row *row = Sto::tx_alloc<simple_row>();
+    row->v = v;
+    return row;
+}
+
+static bool lookup(UIndex& ui, uint64_t k, uint64_t& v) {
+    bool success, found;
+    uintptr_t row;
+    const simple_row *value;
+    std::tie(success, found, row, value) = ui.select_row(k);
+    assert(success);
+    if (found)
+        v = value->v;
+    return found;
+}
+
+void test_grow() {
+    UIndex ui(4);
+    for (uint64_t k = 0; k != 1000; ++k) {
+        TRANSACTION {
+            bool success, found;
+            std::tie(success, found) = ui.insert_row(k, new_row(k));
+            TXN_DO(success);
+            assert(!found);
+        } RETRY(false);
+    }
+    assert(ui.nbuckets() > 4);
+    ui.finish_resize();
+
+    TestTransaction t(0);
+    for (uint64_t k = 0; k != 1000; ++k) {
+        uint64_t v = 0;
+        assert(lookup(ui, k, v) && v == k);
+    }
+    uint64_t v;
+    assert(!lookup(ui, 1000, v));
+    assert(t.try_commit());
+
+    printf("pass %s\n", __FUNCTION__);
+}
+
+void test_shrink() {
+    UIndex ui(64);
+    for (uint64_t k = 0; k != 40; ++k)
+        ui.nontrans_put(k, simple_row(k));
+
+    assert(ui.resize(32));
+    assert(!ui.resize(16)); // already resizing
+    {
+        // operations move buckets
+        TestTransaction t(0);
+        uint64_t v = 0;
+        assert(lookup(ui, 7, v) && v == 7);
+        assert(t.try_commit());
+    }
+    ui.finish_resize();
+    assert(!ui.resizing() && ui.nbuckets() == 32);
+
+    for (uint64_t k = 0; k != 40; ++k)
+        assert(ui.nontrans_get(k) && ui.nontrans_get(k)->v == k);
+    assert(!ui.nontrans_get(40));
+
+    printf("pass %s\n", __FUNCTION__);
+}
+
+void test_bucket_overflow() {
+    // one bucket: five rows inline, the rest chained
+    UIndex ui(1);
+    for (uint64_t k = 0; k != 12; ++k)
+        ui.nontrans_put(k, simple_row(k));
+
+    TRANSACTION {
+        bool success, found;
+        std::tie(success, found) = ui.delete_row(2);
+        TXN_DO(success);
+        assert(found);
+        std::tie(success, found) = ui.delete_row(9);
+        TXN_DO(success);
+        assert(found);
+    } RETRY(false);
+
+    {
+        // an insert into the freed slot conflicts with an absent read
+        TestTransaction t1(1);
+        uint64_t v;
+        assert(!lookup(ui, 100, v));
+
+        TestTransaction t2(2);
+        bool success, found;
+        std::tie(success, found) = ui.insert_row(100, new_row(100));
+        assert(success && !found);
+        assert(t2.try_commit());
+
+        t1.use();
+        std::tie(success, found) = ui.insert_row(101, new_row(101));
+        assert(success && !found);
+        assert(!t1.try_commit());
+    }
+
+    for (uint64_t k = 0; k != 12; ++k) {
+        if (k == 2 || k == 9)
+            assert(!ui.nontrans_get(k));
+        else
+            assert(ui.nontrans_get(k) && ui.nontrans_get(k)->v == k);
+    }
+    assert(ui.nontrans_get(100) && ui.nontrans_get(100)->v == 100);
+    assert(!ui.nontrans_get(101));
+    assert(ui.nbuckets() == 1);
+
+    printf("pass %s\n", __FUNCTION__);
+}
+
+void test_select_rows() {
+    UIndex ui(16);
+    for (uint64_t k = 0; k != 40; ++k)
+        ui.nontrans_put(k, simple_row(k));
+
+    std::vector<uint64_t> keys;
+    for (uint64_t k = 0; k != 50; k += 2)
+        keys.push_back(49 - k);
+    std::vector<UIndex::sel_return_type> results(keys.size());
+    {
+        TestTransaction t1(1);
+        assert(ui.select_rows(keys.data(), int(keys.size()), true, results.data()));
+        for (size_t i = 0; i != keys.size(); ++i) {
+            bool success, found;
+            uintptr_t row;
+            const simple_row *value;
+            std::tie(success, found, row, value) = results[i];
+            assert(success && found == (keys[i] < 40));
+            if (found) {
+                assert(value->v == keys[i]);
+                ui.update_row(row, new_row(keys[i] + 100));
+            }
+        }
+
+        // an absent key of the batch is inserted
+        TestTransaction t2(2);
+        bool success, found;
+        std::tie(success, found) = ui.insert_row(41, new_row(41));
+        assert(success && !found);
+        assert(t2.try_commit());
+
+        t1.use();
+        assert(!t1.try_commit());
+    }
+    {
+        TestTransaction t1(1);
+        assert(ui.select_rows(keys.data(), int(keys.size()), true, results.data()));
+        for (size_t i = 0; i != keys.size(); ++i)
+            if (std::get<1>(results[i]))
+                ui.update_row(std::get<2>(results[i]), new_row(keys[i] + 100));
+        assert(t1.try_commit());
+    }
+
+    std::vector<simple_row *> values(keys.size());
+    ui.nontrans_get(keys.data(), int(keys.size()), values.data());
+    for (size_t i = 0; i != keys.size(); ++i) {
+        if (keys[i] < 40 || keys[i] == 41)
+            assert(values[i] && values[i]->v == keys[i] + 100);
+        else
+            assert(!values[i]);
+    }
+
+    printf("pass %s\n", __FUNCTION__);
+}
+
+void test_absent_read_during_resize() {
+    UIndex ui(8);
+    for (uint64_t k = 0; k != 8; ++k)
+        ui.nontrans_put(k, simple_row(k));
+
+    {
+        // an absent key inserted into the new table after its bucket moved
+        TestTransaction t1(1);
+        uint64_t v;
+        assert(!lookup(ui, 100, v));
+
+        assert(ui.resize(16));
+        ui.finish_resize();
+
+        TestTransaction t2(2);
+        bool success, found;
+        std::tie(success, found) = ui.insert_row(100, new_row(100));
+        assert(success && !found);
+        assert(t2.try_commit());
+
+        t1.use();
+        std::tie(success, found) = ui.insert_row(101, new_row(101));
+        assert(success && !found);
+        assert(!t1.try_commit());
+    }
+
+    {
+        // rows found before the move stay valid
+        TestTransaction t1(1);
+        bool success, found;
+        uintptr_t row;
+        const simple_row *value;
+        std::tie(success, found, row, value) = ui.select_row(3, true);
+        assert(success && found);
+        ui.update_row(row, new_row(33));
+
+        assert(ui.resize(32));
+        ui.finish_resize();
+
+        assert(t1.try_commit());
+        assert(ui.nontrans_get(3)->v == 33);
+    }
+
+    printf("pass %s\n", __FUNCTION__);
+}
+
+void test_concurrent_resize() {
+    constexpr int nthreads = 4;
+    constexpr uint64_t nkeys = 4000;
+    UIndex ui(2);
+
+    std::vector<std::thread> threads;
+    for (int id = 0; id != nthreads; ++id) {
+        threads.emplace_back([&ui, id] {
+            TThread::set_id(id);
+            for (uint64_t k = id; k < nkeys; k += nthreads) {
+                TRANSACTION {
+                    bool success, found;
+                    std::tie(success, found) = ui.insert_row(k, new_row(k));
+                    TXN_DO(success);
+                    // this thread's previous key
+                    if (k >= nthreads) {
+                        const simple_row *value;
+                        uintptr_t row;
+                        std::tie(success, found, row, value) = ui.select_row(k - nthreads);
+                        TXN_DO(success);
+                        assert(found && value->v == k - nthreads);
+                    }
+                } RETRY(true);
+            }
+            Transaction::rcu_quiesce();
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+    ui.finish_resize();
+
+    for (uint64_t k = 0; k != nkeys; ++k)
+        assert(ui.nontrans_get(k) && ui.nontrans_get(k)->v == k);
+    assert(ui.nbuckets() * 2 * UIndex::bucket_slots >= nkeys);
+
+    printf("pass %s\n", __FUNCTION__);
+}
+
+void test_element_reuse() {
+    typedef bench::slab_pool pool;
+    auto before = pool::stats();
+    UIndex ui(16);
+    for (uint64_t k = 0; k != 8; ++k)
+        ui.nontrans_put(k, simple_row(k));
+    assert(pool::stats().allocs == before.allocs + 8);
+
+    // a freed object is the next one handed out in its size class
+    simple_row *r = pool::make<simple_row>(1);
+    pool::destroy(r);
+    before = pool::stats();
+    simple_row *r2 = pool::make<simple_row>(2);
+    assert(r2 == r && r2->v == 2);
+    auto after = pool::stats();
+    assert(after.allocs == before.allocs + 1 && after.reuses == before.reuses + 1);
+    assert(after.live() == before.live() + 1);
+    pool::destroy(r2);
+
+    printf("pass %s\n", __FUNCTION__);
+}
+
+int main() {
+    test_grow();
+    test_shrink();
+    test_bucket_overflow();
+    test_select_rows();
+    test_absent_read_during_resize();
+    test_concurrent_resize();
+    test_element_reuse();
+    printf("All tests pass!\n");
+    return 0;
+}
@@ -66,10 +66,12 @@ int main(int argc, char* argv[]) {
     }
     Clp_DeleteParser(clp);
 
-    if (nthreads > MAX_THREADS) {
-        printf("Asked for %d threads but MAX_THREADS is %d\n", nthreads, MAX_THREADS);
+    if (nthreads > TThread::max_threads_limit) {
+        printf("Asked for %d threads but the limit is %d\n", nthreads, TThread::max_threads_limit);
         exit(1);
     }
+    if (nthreads > TThread::max_threads())
+        TThread::set_max_threads(nthreads);
 
     pthread_t tids[nthreads];
     for (uintptr_t i = 0; i < nthreads; ++i)